@@ -71,15 +71,18 @@ def validate_jobspec(jobspec, require_version=None):
     `require_version` is included to override this behavior and force a
     particular class to be used.
 
-    :param jobspec: a Jobspec object or JSON string
+    :param jobspec: a Jobspec object, JSON string, or decoded JSON mapping
     :param require_version: jobspec version to use, if not provided,
                             the value of jobspec['version'] is used
     :raises ValueError:
     :raises TypeError:
     :raises EnvironmentError:
     """
-    jobspec_str = _convert_jobspec_arg_to_string(jobspec)
-    jobspec_obj = json.loads(jobspec_str)
+    if isinstance(jobspec, abc.Mapping):
+        jobspec_obj = jobspec
+    else:
+        jobspec_str = _convert_jobspec_arg_to_string(jobspec)
+        jobspec_obj = json.loads(jobspec_str)
     if jobspec_obj is None:
         return (1, "Unable to parse JSON")
     _validate_keys(Jobspec.top_level_keys, jobspec_obj.keys())
@@ -9,10 +9,12 @@
 ###############################################################
 import errno
 
+import six
+
 from flux import constants
 from flux.util import check_future_error
 from flux.future import Future
-from flux.job.Jobspec import _convert_jobspec_arg_to_string
+from flux.job.Jobspec import Jobspec, _convert_jobspec_arg_to_string
 from flux.job._wrapper import _RAW as RAW
 from _flux._core import ffi, lib
 
@@ -124,3 +126,117 @@ def submit(
     """
     future = submit_async(flux_handle, jobspec, priority, waitable, debug, pre_signed)
     return future.get_id()
+
+
+class SubmitBulkFuture(Future):
+    def get_ids(self):
+        return submit_bulk_get_ids(self)
+
+
+def submit_bulk_async(
+    flux_handle,
+    jobspecs,
+    count=1,
+    priority=lib.FLUX_JOB_PRIORITY_DEFAULT,
+    waitable=False,
+    debug=False,
+    pre_signed=False,
+):
+    """Ask Flux to run many jobs in one request, without waiting for a response
+
+    Submit ``count`` instances of each jobspec in ``jobspecs`` to Flux.
+    All jobs are accepted, or none are.  This method returns immediately
+    with a Flux Future, which can be used obtain the job IDs later.
+
+    :param flux_handle: handle for Flux broker from flux.Flux()
+    :type flux_handle: Flux
+    :param jobspecs: jobspecs defining the job requests
+    :type jobspecs: list of Jobspec or their string encodings
+    :param count: number of jobs to submit per jobspec (default is 1)
+    :type count: int
+    :param priority: job priority 0 (lowest) through 31 (highest)
+        (default is 16).  Priorities 0 through 15 are restricted to
+        the instance owner.
+    :type priority: int
+    :param waitable: allow results to be fetched with job.wait()
+        (default is False).  Waitable=True is restricted to the
+        instance owner.
+    :type waitable: bool
+    :param debug: enable job manager debugging events to job eventlogs
+        (default is False)
+    :type debug: bool
+    :param pre_signed: jobspecs are already signed
+        (default is False)
+    :type pre_signed: bool
+    :returns: a Flux Future object for obtaining the assigned jobids
+    :rtype: SubmitBulkFuture
+    """
+    if isinstance(jobspecs, (Jobspec, six.string_types, six.binary_type)):
+        raise TypeError("jobspecs must be a list")
+    cstrings = [
+        ffi.new("char[]", _convert_jobspec_arg_to_string(jobspec))
+        for jobspec in jobspecs
+    ]
+    if not cstrings:
+        raise EnvironmentError(errno.EINVAL, "jobspecs must not be empty")
+    flags = 0
+    if waitable:
+        flags |= constants.FLUX_JOB_WAITABLE
+    if debug:
+        flags |= constants.FLUX_JOB_DEBUG
+    if pre_signed:
+        flags |= constants.FLUX_JOB_PRE_SIGNED
+    future_handle = RAW.submit_bulk(
+        flux_handle,
+        ffi.new("const char *[]", cstrings),
+        len(cstrings),
+        count,
+        priority,
+        flags,
+    )
+    return SubmitBulkFuture(future_handle)
+
+
+@check_future_error
+def submit_bulk_get_ids(future):
+    """Get job IDs from a Future returned by job.submit_bulk_async()
+
+    This method blocks until the response is received, then decodes the
+    result to obtain the assigned job IDs: all instances of the first
+    jobspec in order, then those of the second, and so on.
+
+    :param future: a Flux future object returned by job.submit_bulk_async()
+    :type future: Future
+    :returns: list of job IDs
+    :rtype: list of int
+    """
+    if future is None or future == ffi.NULL:
+        raise EnvironmentError(errno.EINVAL, "future must not be None/NULL")
+    future.wait_for()  # ensure the future is fulfilled
+    ids = ffi.new("const flux_jobid_t **")
+    count = ffi.new("int *")
+    RAW.submit_bulk_get_ids(future, ids, count)
+    return [int(ids[0][i]) for i in range(count[0])]
+
+
+def submit_bulk(
+    flux_handle,
+    jobspecs,
+    count=1,
+    priority=lib.FLUX_JOB_PRIORITY_DEFAULT,
+    waitable=False,
+    debug=False,
+    pre_signed=False,
+):
+    """Submit many jobs to Flux in one request
+
+    Submit ``count`` instances of each jobspec in ``jobspecs``, blocking
+    until job IDs are assigned.  See submit_bulk_async() for parameters.
+
+    :returns: list of job IDs
+    :rtype: list of int
+    """
+    future = submit_bulk_async(
+        flux_handle, jobspecs, count, priority, waitable, debug, pre_signed
+    )
+    return future.get_ids()
@@ -0,0 +1,106 @@
+###############################################################
+# Copyright 2020 Lawrence Livermore National Security, LLC
+# (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+#
+# This file is part of the Flux resource manager framework.
+# For details, see https://github.com/flux-framework.
+#
+# SPDX-License-Identifier: LGPL-3.0
+###############################################################
+
+"""
+Worker side of the job-ingest validator protocol
+
+A validator is a program that job-ingest runs as a coprocess.  It reads
+requests from stdin and writes one JSON result per line to stdout.  See
+src/modules/job-ingest/worker.c for the protocol.  Validators written in
+Python only need to supply a function that checks one jobspec, e.g.
+
+    def validate(jobspec):
+        if "tasks" not in jobspec:
+            raise ValueError("no tasks")
+
+    ValidatorWorker(validate).run()
+"""
+
+import os
+import sys
+import json
+
+PROTOCOL_VERSION = 2
+
+
+class ValidatorWorker:
+    """
+    Run a validation function over jobspec received from job-ingest.
+
+    :param validate: function called with each jobspec, decoded from JSON.
+                     It should raise ValueError, TypeError, or
+                     EnvironmentError if the jobspec is invalid.
+    """
+
+    def __init__(self, validate, infile=None, outfile=None):
+        self.validate = validate
+        self.infile = infile if infile is not None else sys.stdin
+        self.outfile = outfile if outfile is not None else sys.stdout
+        self.protocol = None
+
+    @staticmethod
+    def _encode(result):
+        return json.dumps(result, separators=(",", ":")) + "\n"
+
+    def _check(self, jobspec):
+        try:
+            self.validate(jobspec)
+        except (ValueError, TypeError, EnvironmentError) as e:
+            return {"errnum": 1, "errstr": str(e)}
+        return {"errnum": 0}
+
+    def handle(self, line):
+        """Return the response to one line of input"""
+        try:
+            request = json.loads(line)
+        except ValueError as e:
+            request = None
+            error = {"errnum": 1, "errstr": str(e)}
+        if self.protocol is None:
+            if request == {"protocol": PROTOCOL_VERSION}:
+                self.protocol = PROTOCOL_VERSION
+                return self._encode(request)
+            self.protocol = 1
+        if self.protocol == 1:
+            result = self._check(request) if request is not None else error
+            return self._encode(result)
+        if not isinstance(request, dict) or "id" not in request:
+            #  A request without an id cannot be answered, so skip it.
+            return ""
+        if "data" in request:
+            result = self._check(request["data"])
+        else:
+            result = {"errnum": 1, "errstr": "malformed validator request"}
+        result["id"] = request["id"]
+        return self._encode(result)
+
+    def run(self):
+        """
+        Process requests until EOF.  Requests are read in whatever amount
+        is available, and the responses to all complete lines read are
+        written with a single flush, so a batch of requests costs one
+        read and one write.
+        """
+        fd = self.infile.fileno()
+        buf = b""
+        while True:
+            data = os.read(fd, 65536)
+            if not data:
+                break
+            lines = (buf + data).split(b"\n")
+            buf = lines.pop()
+            if lines:
+                self.outfile.write(
+                    "".join(
+                        self.handle(line.decode("utf-8", errors="replace"))
+                        for line in lines
+                    )
+                )
+                self.outfile.flush()
@@ -20,12 +20,12 @@
 #include <flux/core.h>
 
 #include "src/common/libutil/log.h"
-#include "src/common/libutil/kary.h"
 #include "src/common/libutil/errno_safe.h"
 #include "src/common/libidset/idset.h"
 
 #include "attr.h"
 #include "overlay.h"
+#include "topology.h"
 #include "boot_config.h"
 
 
@@ -254,6 +254,43 @@ int boot_config_getrankbyname (json_t *hosts, const char *name, uint32_t *rank)
     return -1;
 }
 
+/* Apply the optional 'parent' key of each host entry to the topology.
+ * The value is the host name of the parent, which must appear in hosts.
+ * Return 0 on success, -1 on failure.
+ */
+int boot_config_set_parents (json_t *hosts, struct topology *topo)
+{
+    size_t index;
+    json_t *entry;
+
+    json_array_foreach (hosts, index, entry) {
+        const char *host;
+        const char *parent = NULL;
+        uint32_t parent_rank;
+
+        if (json_unpack (entry,
+                         "{s:s s?:s}",
+                         "host", &host,
+                         "parent", &parent) < 0) {
+            log_msg ("Config file error [bootstrap]: rank %u bad hosts entry",
+                     (unsigned int)index);
+            log_msg ("Hint: parent key, if present, is type string");
+            return -1;
+        }
+        if (!parent)
+            continue;
+        if (boot_config_getrankbyname (hosts, parent, &parent_rank) < 0)
+            return -1;
+        if (topology_set_parent (topo, index, parent_rank) < 0) {
+            log_msg ("Config file error [bootstrap]: %s cannot be parent of %s",
+                     parent, host);
+            log_msg ("Hint: rank 0 has no parent and cycles are not allowed");
+            return -1;
+        }
+    }
+    return 0;
+}
+
 static int gethostentry (json_t *hosts,
                          struct boot_conf *conf,
                          uint32_t rank,
@@ -356,9 +393,13 @@ int boot_config_geturibyrank (json_t *hosts,
     return 0;
 }
 
-int boot_config (flux_t *h, struct overlay *overlay, attr_t *attrs, int tbon_k)
+int boot_config (flux_t *h,
+                 struct overlay *overlay,
+                 attr_t *attrs,
+                 const char *topo_spec)
 {
     struct boot_conf conf;
+    struct topology *topo;
     uint32_t rank;
     uint32_t size;
     json_t *hosts = NULL;
@@ -399,9 +440,17 @@ int boot_config (flux_t *h, struct overlay *overlay, attr_t *attrs, int tbon_k)
         rank = 0;
     }
 
-    /* Tell overlay network this broker's rank, size, and branching factor.
+    /* Tell overlay network this broker's rank, size, and topology.
      */
-    if (overlay_init (overlay, size, rank, tbon_k) < 0)
+    if (!(topo = topology_create (topo_spec, size))) {
+        log_err ("invalid TBON topology '%s'", topo_spec);
+        goto error;
+    }
+    if (hosts && boot_config_set_parents (hosts, topo) < 0) {
+        topology_destroy (topo);
+        goto error;
+    }
+    if (overlay_init (overlay, size, rank, topo) < 0)
         goto error;
 
     /* If broker has "downstream" peers, determine the URI to bind to
@@ -409,7 +458,7 @@ int boot_config (flux_t *h, struct overlay *overlay, attr_t *attrs, int tbon_k)
      * attribute to the URI peers will connect to.  If broker has no
      * downstream peers, set tbon.endpoint to NULL.
      */
-    if (kary_childof (tbon_k, size, rank, 0) != KARY_NONE) {
+    if (topology_get_child_count (topo, rank) > 0) {
         char bind_uri[MAX_URI + 1];
         char my_uri[MAX_URI + 1];
 
@@ -459,7 +508,7 @@ int boot_config (flux_t *h, struct overlay *overlay, attr_t *attrs, int tbon_k)
         char parent_uri[MAX_URI + 1];
         if (boot_config_geturibyrank (hosts,
                                       &conf,
-                                      kary_parentof (tbon_k, rank),
+                                      topology_get_parent (topo, rank),
                                       parent_uri,
                                       sizeof (parent_uri)) < 0)
             goto error;
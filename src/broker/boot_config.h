@@ -19,8 +19,13 @@
 /* Broker attributes read/written directly by this method:
  *   tbon.endpoint (w)
  *   instance-level (w)
+ * The TBON topology is created from 'topo_spec' (see topology.h), then
+ * modified by any 'parent' keys in the hosts array.
  */
-int boot_config (flux_t *h, struct overlay *overlay, attr_t *attrs, int tbon_k);
+int boot_config (flux_t *h,
+                 struct overlay *overlay,
+                 attr_t *attrs,
+                 const char *topo_spec);
 
 /* The following is exported for unit testing.
  */
@@ -46,6 +51,7 @@ int boot_config_getbindbyrank (json_t *hosts,
 int boot_config_getrankbyname (json_t *hosts,
                                const char *name,
                                uint32_t *rank);
+int boot_config_set_parents (json_t *hosts, struct topology *topo);
 int boot_config_parse (const flux_conf_t *cf,
                        struct boot_conf *conf,
                        json_t **hosts);
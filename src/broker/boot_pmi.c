@@ -18,12 +18,12 @@
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/cleanup.h"
 #include "src/common/libutil/ipaddr.h"
-#include "src/common/libutil/kary.h"
 #include "src/common/libpmi/pmi.h"
 #include "src/common/libpmi/pmi_strerror.h"
 
 #include "attr.h"
 #include "overlay.h"
+#include "topology.h"
 #include "boot_pmi.h"
 #include "pmiutil.h"
 
@@ -177,8 +177,9 @@ static int set_instance_level_attr (struct pmi_handle *pmi,
     return 0;
 }
 
-int boot_pmi (struct overlay *overlay, attr_t *attrs, int tbon_k)
+int boot_pmi (struct overlay *overlay, attr_t *attrs, const char *topo_spec)
 {
+    struct topology *topo;
     int parent_rank;
     const char *child_uri;
     char key[64];
@@ -207,18 +208,17 @@ int boot_pmi (struct overlay *overlay, attr_t *attrs, int tbon_k)
         log_err ("set_instance_level_attr");
         goto error;
     }
-    if (overlay_init (overlay, pmi_params.size, pmi_params.rank, tbon_k) < 0)
+    if (!(topo = topology_create (topo_spec, pmi_params.size))) {
+        log_err ("invalid TBON topology '%s'", topo_spec);
+        goto error;
+    }
+    if (overlay_init (overlay, pmi_params.size, pmi_params.rank, topo) < 0)
         goto error;
 
     /* If there are to be downstream peers, then bind to socket and share the
      * concretized URI with other ranks via PMI KVS key=cmbd.<rank>.uri.
-     * N.B. there are no downstream peers if the 0th child of this rank
-     * in k-ary tree does not exist.
      */
-    if (kary_childof (tbon_k,
-                      pmi_params.size,
-                      pmi_params.rank,
-                      0) != KARY_NONE) {
+    if (topology_get_child_count (topo, pmi_params.rank) > 0) {
 
         if (update_endpoint_attr (attrs,
                                   "tbon.endpoint",
@@ -283,7 +283,7 @@ int boot_pmi (struct overlay *overlay, attr_t *attrs, int tbon_k)
      * N.B. only rank 0 has no upstream peer.
      */
     if (pmi_params.rank > 0) {
-        parent_rank = kary_parentof (tbon_k, pmi_params.rank);
+        parent_rank = topology_get_parent (topo, pmi_params.rank);
         if (snprintf (key, sizeof (key),
                       "cmbd.%d.uri", parent_rank) >= sizeof (key)) {
             log_msg ("pmi key string overflow");
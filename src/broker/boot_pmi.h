@@ -16,7 +16,10 @@
 #include "attr.h"
 #include "overlay.h"
 
-int boot_pmi (struct overlay *overlay, attr_t *attrs, int tbon_k);
+/* Create the TBON topology described by 'topo_spec' once the instance
+ * size is known (see topology.h).
+ */
+int boot_pmi (struct overlay *overlay, attr_t *attrs, const char *topo_spec);
 
 #endif /* BROKER_BOOT_PMI_H */
 
@@ -50,7 +50,6 @@
 #include "src/common/libutil/cleanup.h"
 #include "src/common/libidset/idset.h"
 #include "src/common/libutil/ipaddr.h"
-#include "src/common/libutil/kary.h"
 #include "src/common/libutil/monotime.h"
 #include "src/common/libutil/zsecurity.h"
 #include "src/common/libpmi/pmi.h"
@@ -62,6 +61,7 @@
 #include "module.h"
 #include "brokercfg.h"
 #include "overlay.h"
+#include "topology.h"
 #include "service.h"
 #include "attr.h"
 #include "log.h"
@@ -136,7 +136,7 @@ static void usage (void)
 " -v,--verbose                 Be annoyingly verbose\n"
 " -X,--module-path PATH        Set module search path (colon separated)\n"
 " -s,--security=plain|curve|none    Select security mode (default: curve)\n"
-" -k,--k-ary K                 Wire up in a k-ary tree\n"
+" -k,--k-ary K                 Wire up in a k-ary tree (-Stbon.topo=kary:K)\n"
 " -H,--heartrate SECS          Set heartrate in seconds (rank 0 only)\n"
 " -S,--setattr ATTR=VAL        Set broker attribute\n"
 " -c,--config-path PATH        Set broker config directory (default: none)\n"
@@ -254,6 +254,8 @@ int main (int argc, char *argv[])
     struct sigaction old_sigact_term;
     flux_msg_handler_t **handlers = NULL;
     const flux_conf_t *conf;
+    const char *topo_spec;
+    char kary_spec[32];
 
     memset (&ctx, 0, sizeof (ctx));
     log_init (argv[0]);
@@ -392,12 +394,21 @@ int main (int argc, char *argv[])
      */
     overlay_set_init_callback (ctx.overlay, create_broker_rundir, ctx.attrs);
 
+    /* Select TBON topology.  The tbon.topo attribute takes precedence
+     * over the --k-ary option (default k=2).
+     */
+    if (attr_get (ctx.attrs, "tbon.topo", &topo_spec, NULL) < 0
+                                                    || topo_spec == NULL) {
+        snprintf (kary_spec, sizeof (kary_spec), "kary:%d", ctx.tbon_k);
+        topo_spec = kary_spec;
+    }
+
     /* Execute broker network bootstrap.
      * Default method is pmi.
      * If [bootstrap] is defined in configuration, use static configuration.
      */
     if (flux_conf_unpack (conf, NULL, "{s:{}}", "bootstrap") == 0) {
-        if (boot_config (ctx.h, ctx.overlay, ctx.attrs, ctx.tbon_k) < 0) {
+        if (boot_config (ctx.h, ctx.overlay, ctx.attrs, topo_spec) < 0) {
             log_msg ("bootstrap failed");
             goto cleanup;
         }
@@ -406,7 +417,7 @@ int main (int argc, char *argv[])
         double elapsed_sec;
         struct timespec start_time;
         monotime (&start_time);
-        if (boot_pmi (ctx.overlay, ctx.attrs, ctx.tbon_k) < 0) {
+        if (boot_pmi (ctx.overlay, ctx.attrs, topo_spec) < 0) {
             log_msg ("bootstrap failed");
             goto cleanup;
         }
@@ -1507,16 +1518,47 @@ done:
     flux_msg_destroy (msg);
 }
 
+/* Deliver an event to subscribers on this rank.
+ */
+static int deliver_event (const flux_msg_t *msg, void *arg)
+{
+    broker_ctx_t *ctx = arg;
+    const char *topic, *s;
+
+    if (flux_msg_get_topic (msg, &topic) < 0) {
+        flux_log (ctx->h, LOG_ERR, "dropping malformed event");
+        return -1;
+    }
+    /* Internal services may install message handlers for events.
+     */
+    s = zlist_first (ctx->subscriptions);
+    while (s) {
+        if (!strncmp (s, topic, strlen (s))) {
+            if (flux_requeue (ctx->h, msg, FLUX_RQ_TAIL) < 0)
+                flux_log_error (ctx->h, "%s: flux_requeue\n", __FUNCTION__);
+            break;
+        }
+        s = zlist_next (ctx->subscriptions);
+    }
+    /* Finally, route to local module subscribers.
+     */
+    return module_event_mcast (ctx->modhash, msg);
+}
+
 /* Handle events received by parent_cb.
  * On rank 0, publisher is wired to send events here also.
+ * An event bundle covers sequence numbers (seq - count + 1) through seq.
+ * It is forwarded to children intact, then unpacked for local delivery.
  */
 static int handle_event (broker_ctx_t *ctx, const flux_msg_t *msg)
 {
     uint32_t seq;
-    const char *topic, *s;
+    int count = 1;
+    bool bundle = publisher_is_bundle (msg);
 
     if (flux_msg_get_seq (msg, &seq) < 0
-            || flux_msg_get_topic (msg, &topic) < 0) {
+            || (bundle && (count = publisher_bundle_count (msg)) < 0)
+            || (uint32_t)count > seq) {
         flux_log (ctx->h, LOG_ERR, "dropping malformed event");
         return -1;
     }
@@ -1526,10 +1568,11 @@ static int handle_event (broker_ctx_t *ctx, const flux_msg_t *msg)
     }
     if (ctx->event_recv_seq > 0) { /* don't log initial missed events */
         int first = ctx->event_recv_seq + 1;
-        int count = seq - first;
-        if (count > 1)
-            flux_log (ctx->h, LOG_ERR, "lost events %d-%d", first, seq - 1);
-        else if (count == 1)
+        int lost = (seq - count + 1) - first;
+        if (lost > 1)
+            flux_log (ctx->h, LOG_ERR, "lost events %d-%d",
+                      first, first + lost - 1);
+        else if (lost == 1)
             flux_log (ctx->h, LOG_ERR, "lost event %d", first);
     }
     ctx->event_recv_seq = seq;
@@ -1539,20 +1582,9 @@ static int handle_event (broker_ctx_t *ctx, const flux_msg_t *msg)
     if (overlay_mcast_child (ctx->overlay, msg) < 0)
         flux_log_error (ctx->h, "%s: overlay_mcast_child", __FUNCTION__);
 
-    /* Internal services may install message handlers for events.
-     */
-    s = zlist_first (ctx->subscriptions);
-    while (s) {
-        if (!strncmp (s, topic, strlen (s))) {
-            if (flux_requeue (ctx->h, msg, FLUX_RQ_TAIL) < 0)
-                flux_log_error (ctx->h, "%s: flux_requeue\n", __FUNCTION__);
-            break;
-        }
-        s = zlist_next (ctx->subscriptions);
-    }
-    /* Finally, route to local module subscribers.
-     */
-    return module_event_mcast (ctx->modhash, msg);
+    if (bundle)
+        return publisher_unbundle (msg, deliver_event, ctx);
+    return deliver_event (msg, ctx);
 }
 
 /* Handle messages from one or more parents.
@@ -1817,8 +1849,10 @@ static int broker_request_sendmsg_internal (broker_ctx_t *ctx,
      */
     else {
         uint32_t down_rank;
-        down_rank = kary_child_route (ctx->tbon_k, ctx->size, ctx->rank, nodeid);
-        if (down_rank == KARY_NONE) { // up
+        down_rank = topology_get_child_route (overlay_get_topology (ctx->overlay),
+                                              ctx->rank,
+                                              nodeid);
+        if (down_rank == TOPOLOGY_NONE) { // up
             if (overlay_sendmsg_parent (ctx->overlay, msg) < 0)
                 return -1;
         }
@@ -1881,7 +1915,8 @@ static bool uuid_to_rank (const char *s, uint32_t size, uint32_t *rank)
  */
 static bool is_my_parent (broker_ctx_t *ctx, uint32_t rank)
 {
-    if (kary_parentof (ctx->tbon_k, ctx->rank) == rank)
+    if (topology_get_parent (overlay_get_topology (ctx->overlay),
+                             ctx->rank) == rank)
         return true;
     return false;
 }
@@ -21,12 +21,12 @@
 #include "src/common/libutil/xzmalloc.h"
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/iterators.h"
-#include "src/common/libutil/kary.h"
 #include "src/common/libutil/cleanup.h"
 #include "src/common/libutil/zsecurity.h"
 
 #include "heartbeat.h"
 #include "overlay.h"
+#include "topology.h"
 #include "attr.h"
 
 struct endpoint {
@@ -45,10 +45,7 @@ struct overlay {
 
     uint32_t size;
     uint32_t rank;
-    int tbon_k;
-    int tbon_level;
-    int tbon_maxlevel;
-    int tbon_descendants;
+    struct topology *topo;
 
     struct endpoint *parent;    /* DEALER - requests to parent */
     overlay_sock_cb_f parent_cb;
@@ -107,14 +104,17 @@ void overlay_set_init_callback (struct overlay *ov,
 int overlay_init (struct overlay *overlay,
                   uint32_t size,
                   uint32_t rank,
-                  int tbon_k)
+                  struct topology *topo)
 {
+    if (!topo || topology_get_size (topo) != size || rank >= size) {
+        topology_destroy (topo);
+        errno = EINVAL;
+        return -1;
+    }
     overlay->size = size;
     overlay->rank = rank;
-    overlay->tbon_k = tbon_k;
-    overlay->tbon_level = kary_levelof (tbon_k, rank);
-    overlay->tbon_maxlevel = kary_levelof (tbon_k, size - 1);
-    overlay->tbon_descendants = kary_sum_descendants (tbon_k, size, rank);
+    topology_destroy (overlay->topo);
+    overlay->topo = topo;
     if (overlay->init_cb)
         return (*overlay->init_cb) (overlay, overlay->init_arg);
     return 0;
@@ -130,6 +130,11 @@ uint32_t overlay_get_size (struct overlay *ov)
     return ov->size;
 }
 
+struct topology *overlay_get_topology (struct overlay *ov)
+{
+    return ov->topo;
+}
+
 int overlay_get_child_peer_count (struct overlay *ov)
 {
     return ov->child_peer_count;
@@ -559,16 +564,28 @@ int overlay_register_attrs (struct overlay *overlay, attr_t *attrs)
     if (attr_add_uint32 (attrs, "size", overlay->size,
                          FLUX_ATTRFLAG_IMMUTABLE) < 0)
         return -1;
-    if (attr_add_int (attrs, "tbon.arity", overlay->tbon_k,
+    /* tbon.topo may have been set on the command line to select
+     * the topology.  Replace it with the effective value.
+     */
+    (void)attr_delete (attrs, "tbon.topo", true);
+    if (attr_add (attrs, "tbon.topo", topology_get_spec (overlay->topo),
+                  FLUX_ATTRFLAG_IMMUTABLE) < 0)
+        return -1;
+    if (attr_add_int (attrs, "tbon.arity",
+                      topology_get_arity (overlay->topo),
                       FLUX_ATTRFLAG_IMMUTABLE) < 0)
         return -1;
-    if (attr_add_int (attrs, "tbon.level", overlay->tbon_level,
+    if (attr_add_int (attrs, "tbon.level",
+                      topology_get_level (overlay->topo, overlay->rank),
                       FLUX_ATTRFLAG_IMMUTABLE) < 0)
         return -1;
-    if (attr_add_int (attrs, "tbon.maxlevel", overlay->tbon_maxlevel,
+    if (attr_add_int (attrs, "tbon.maxlevel",
+                      topology_get_maxlevel (overlay->topo),
                       FLUX_ATTRFLAG_IMMUTABLE) < 0)
         return -1;
-    if (attr_add_int (attrs, "tbon.descendants", overlay->tbon_descendants,
+    if (attr_add_int (attrs, "tbon.descendants",
+                      topology_get_descendant_count (overlay->topo,
+                                                     overlay->rank),
                       FLUX_ATTRFLAG_IMMUTABLE) < 0)
         return -1;
 
@@ -583,6 +600,21 @@ void overlay_set_monitor_cb (struct overlay *ov,
     ov->child_monitor_arg = arg;
 }
 
+/* Child peers identify themselves by rank (see connect_parent()),
+ * so the topology can tell us how many brokers are reached through each.
+ */
+static int child_descendant_count (struct overlay *ov, const char *uuid)
+{
+    char *endptr;
+    unsigned long rank;
+
+    errno = 0;
+    rank = strtoul (uuid, &endptr, 10);
+    if (errno != 0 || *endptr != '\0' || endptr == uuid)
+        return -1;
+    return topology_get_descendant_count (ov->topo, rank);
+}
+
 static json_t *lspeer_object_create (struct overlay *ov)
 {
     json_t *o = NULL;
@@ -593,9 +625,11 @@ static json_t *lspeer_object_create (struct overlay *ov)
     if (!(o = json_object ()))
         goto nomem;
     FOREACH_ZHASH (ov->children, uuid, child) {
-        if (!(child_o = json_pack ("{s:i}",
+        if (!(child_o = json_pack ("{s:i s:i}",
                                    "idle",
-                                   ov->epoch - child->lastseen)))
+                                   ov->epoch - child->lastseen,
+                                   "descendants",
+                                   child_descendant_count (ov, uuid))))
             goto nomem;
         if (json_object_set_new (o, uuid, child_o) < 0) {
             json_decref (child_o);
@@ -647,6 +681,7 @@ void overlay_destroy (struct overlay *ov)
         endpoint_destroy (ov->parent);
         endpoint_destroy (ov->child);
         zhash_destroy (&ov->children);
+        topology_destroy (ov->topo);
         free (ov);
         errno = saved_errno;
     }
@@ -12,6 +12,7 @@
 #define _BROKER_OVERLAY_H
 
 #include "attr.h"
+#include "topology.h"
 #include "src/common/libutil/zsecurity.h"
 
 struct overlay;
@@ -32,17 +33,20 @@ void overlay_set_init_callback (struct overlay *ov,
                                 void *arg);
 
 /* These need to be called before connect/bind.
+ * The overlay takes ownership of 'topo', which must describe 'size' ranks,
+ * even if overlay_init() fails.
  */
 int overlay_init (struct overlay *ov,
                   uint32_t size,
                   uint32_t rank,
-                  int tbon_k);
+                  struct topology *topo);
 void overlay_set_idle_warning (struct overlay *ov, int heartbeats);
 
 /* Accessors
  */
 uint32_t overlay_get_rank (struct overlay *ov);
 uint32_t overlay_get_size (struct overlay *ov);
+struct topology *overlay_get_topology (struct overlay *ov);
 int overlay_get_child_peer_count (struct overlay *ov);
 
 /* All ranks but rank 0 connect to a parent to form the main TBON.
@@ -90,6 +94,7 @@ int overlay_connect (struct overlay *ov);
  * Passive attrs:
  *   rank
  *   size
+ *   tbon.topo
  *   tbon.arity
  *   tbon.level
  *   tbon.maxlevel
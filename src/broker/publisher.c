@@ -8,12 +8,25 @@
  * SPDX-License-Identifier: LGPL-3.0
 \************************************************************/
 
-/* publisher.c - event publishing service on rank 0 */
+/* publisher.c - event publishing service on rank 0
+ *
+ * Events published during one reactor loop iteration are queued, then
+ * sent from a prepare watcher just before the reactor blocks.  If more than
+ * one event is queued, they are sent as a single "bundle" event message
+ * covering a range of sequence numbers, which each broker unpacks
+ * (after forwarding it to its TBON children) before delivering the
+ * individual events locally.  Responses to event.pub requests are deferred
+ * until the event has been sent, preserving the original ordering of the
+ * event and the response.
+ */
 
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
 #include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <arpa/inet.h>
 #include <flux/core.h>
 #include <czmq.h>
 #include <sodium.h>
@@ -28,18 +41,54 @@ struct sender {
     char name[32];
 };
 
+struct pending {
+    flux_msg_t *event;
+    const flux_msg_t *request;  // event.pub request, if any
+};
+
 struct publisher {
     flux_t *h;
     flux_msg_handler_t **handlers;
     int seq;
     zlist_t *senders;
+    zlist_t *pending;
+    flux_watcher_t *prep;
 };
 
+static void pending_destroy (struct pending *p)
+{
+    if (p) {
+        int saved_errno = errno;
+        flux_msg_destroy (p->event);
+        flux_msg_decref (p->request);
+        free (p);
+        errno = saved_errno;
+    }
+}
+
 void publisher_destroy (struct publisher *pub)
 {
     if (pub) {
         int saved_errno = errno;
         flux_msg_handler_delvec (pub->handlers);
+        flux_watcher_destroy (pub->prep);
+        if (pub->pending) {
+            struct pending *p;
+            while ((p = zlist_pop (pub->pending))) {
+                /* Event was never sent, so fail the request that
+                 * published it rather than leave the requestor hanging.
+                 */
+                if (p->request
+                    && flux_respond_error (pub->h,
+                                           p->request,
+                                           ENOSYS,
+                                           NULL) < 0)
+                    flux_log_error (pub->h, "%s: flux_respond_error",
+                                    __FUNCTION__);
+                pending_destroy (p);
+            }
+            zlist_destroy (&pub->pending);
+        }
         if (pub->senders) {
             struct sender *sender;
             while ((sender = zlist_pop (pub->senders)))
@@ -59,7 +108,7 @@ struct publisher *publisher_create (void)
         errno = ENOMEM;
         return NULL;
     }
-    if (!(pub->senders = zlist_new ())) {
+    if (!(pub->senders = zlist_new ()) || !(pub->pending = zlist_new ())) {
         publisher_destroy (pub);
         errno = ENOMEM;
         return NULL;
@@ -131,6 +180,159 @@ static void send_event (struct publisher *pub, const flux_msg_t *msg)
     }
 }
 
+/* Bundle payload: a 4 byte event count, followed by each event as a 4 byte
+ * length and flux_msg_encode() output.  All integers are in network order.
+ * The bundle's sequence number is that of the last event.
+ * N.B. integers in the payload need not be aligned, so copy them.
+ */
+static void put_uint32 (uint8_t *buf, uint32_t val)
+{
+    uint32_t nval = htonl (val);
+    memcpy (buf, &nval, sizeof (nval));
+}
+
+static uint32_t get_uint32 (const uint8_t *buf)
+{
+    uint32_t nval;
+    memcpy (&nval, buf, sizeof (nval));
+    return ntohl (nval);
+}
+
+static flux_msg_t *encode_bundle (zlist_t *pending)
+{
+    struct pending *p;
+    flux_msg_t *msg = NULL;
+    uint8_t *buf = NULL;
+    size_t size = 4;
+    size_t offset;
+    uint32_t seq = 0;
+    int saved_errno;
+
+    p = zlist_first (pending);
+    while (p) {
+        size += 4 + flux_msg_encode_size (p->event);
+        p = zlist_next (pending);
+    }
+    if (size > INT_MAX) {
+        errno = EOVERFLOW;
+        return NULL;
+    }
+    if (!(buf = malloc (size)))
+        goto error;
+    put_uint32 (buf, zlist_size (pending));
+    offset = 4;
+    p = zlist_first (pending);
+    while (p) {
+        size_t n = flux_msg_encode_size (p->event);
+        put_uint32 (buf + offset, n);
+        offset += 4;
+        if (flux_msg_encode (p->event, buf + offset, n) < 0)
+            goto error;
+        offset += n;
+        if (flux_msg_get_seq (p->event, &seq) < 0)
+            goto error;
+        p = zlist_next (pending);
+    }
+    if (!(msg = flux_msg_create (FLUX_MSGTYPE_EVENT)))
+        goto error;
+    if (flux_msg_set_topic (msg, PUBLISHER_BUNDLE_TOPIC) < 0)
+        goto error;
+    if (flux_msg_set_seq (msg, seq) < 0)
+        goto error;
+    if (flux_msg_set_payload (msg, buf, size) < 0)
+        goto error;
+    free (buf);
+    return msg;
+error:
+    saved_errno = errno;
+    free (buf);
+    flux_msg_destroy (msg);
+    errno = saved_errno;
+    return NULL;
+}
+
+static void respond_pending (struct publisher *pub, struct pending *p)
+{
+    uint32_t seq;
+
+    if (!p->request)
+        return;
+    if (flux_msg_get_seq (p->event, &seq) < 0) {
+        if (flux_respond_error (pub->h, p->request, errno, NULL) < 0)
+            flux_log_error (pub->h, "%s: flux_respond_error", __FUNCTION__);
+        return;
+    }
+    if (flux_respond_pack (pub->h, p->request, "{s:i}", "seq", seq) < 0)
+        flux_log_error (pub->h, "%s: flux_respond", __FUNCTION__);
+}
+
+/* Send all queued events, as a bundle if there is more than one,
+ * then respond to any event.pub requests that published them.
+ */
+static void publisher_flush (struct publisher *pub)
+{
+    struct pending *p;
+    flux_msg_t *bundle = NULL;
+
+    if (zlist_size (pub->pending) == 0)
+        return;
+    if (zlist_size (pub->pending) > 1) {
+        if (!(bundle = encode_bundle (pub->pending)))
+            flux_log_error (pub->h, "%s: encode_bundle", __FUNCTION__);
+    }
+    if (bundle) {
+        send_event (pub, bundle);
+        flux_msg_destroy (bundle);
+    }
+    else { // a single event, or bundle encoding failed
+        p = zlist_first (pub->pending);
+        while (p) {
+            send_event (pub, p->event);
+            p = zlist_next (pub->pending);
+        }
+    }
+    while ((p = zlist_pop (pub->pending))) {
+        respond_pending (pub, p);
+        pending_destroy (p);
+    }
+}
+
+static void prep_cb (flux_reactor_t *r,
+                     flux_watcher_t *w,
+                     int revents,
+                     void *arg)
+{
+    struct publisher *pub = arg;
+
+    publisher_flush (pub);
+    flux_watcher_stop (pub->prep);
+}
+
+/* Queue an event for sending at the end of this reactor loop iteration.
+ * The publisher takes ownership of 'event' on success.
+ */
+static int publisher_enqueue (struct publisher *pub,
+                              flux_msg_t *event,
+                              const flux_msg_t *request)
+{
+    struct pending *p;
+
+    if (!(p = calloc (1, sizeof (*p))))
+        return -1;
+    if (zlist_append (pub->pending, p) < 0) {
+        free (p);
+        errno = ENOMEM;
+        return -1;
+    }
+    p->event = event;
+    p->request = flux_msg_incref (request);
+    if (pub->prep)
+        flux_watcher_start (pub->prep);
+    if (!pub->prep || zlist_size (pub->pending) >= PUBLISHER_BUNDLE_MAX)
+        publisher_flush (pub);
+    return 0;
+}
+
 void pub_cb (flux_t *h, flux_msg_handler_t *mh,
              const flux_msg_t *msg, void *arg)
 {
@@ -154,10 +356,8 @@ void pub_cb (flux_t *h, flux_msg_handler_t *mh,
         goto error;
     if (!(event = encode_event (topic, flags, cred, ++pub->seq, payload)))
         goto error_restore_seq;
-    send_event (pub, event);
-    if (flux_respond_pack (h, msg, "{s:i}", "seq", pub->seq) < 0)
-        flux_log_error (h, "%s: flux_respond", __FUNCTION__);
-    flux_msg_destroy (event);
+    if (publisher_enqueue (pub, event, msg) < 0)
+        goto error_restore_seq;
     return;
 error_restore_seq:
     pub->seq--;
@@ -177,8 +377,8 @@ int publisher_send (struct publisher *pub, const flux_msg_t *msg)
         goto error;
     if (flux_msg_set_seq (cpy, ++pub->seq) < 0)
         goto error_restore_seq;
-    send_event (pub, cpy);
-    flux_msg_destroy (cpy);
+    if (publisher_enqueue (pub, cpy, NULL) < 0)
+        goto error_restore_seq;
     return 0;
 error_restore_seq:
     pub->seq--;
@@ -187,6 +387,77 @@ error:
     return -1;
 }
 
+bool publisher_is_bundle (const flux_msg_t *msg)
+{
+    const char *topic;
+
+    if (flux_msg_get_topic (msg, &topic) < 0)
+        return false;
+    return !strcmp (topic, PUBLISHER_BUNDLE_TOPIC);
+}
+
+int publisher_bundle_count (const flux_msg_t *msg)
+{
+    const void *buf;
+    int size;
+    uint32_t count;
+
+    if (flux_msg_get_payload (msg, &buf, &size) < 0)
+        return -1;
+    if (size < 4) {
+        errno = EPROTO;
+        return -1;
+    }
+    count = get_uint32 (buf);
+    if (count == 0 || count > INT_MAX) {
+        errno = EPROTO;
+        return -1;
+    }
+    return count;
+}
+
+int publisher_unbundle (const flux_msg_t *msg,
+                        publisher_unbundle_f cb,
+                        void *arg)
+{
+    const void *buf;
+    const uint8_t *p;
+    int size;
+    int count;
+    int i;
+    int rc = 0;
+
+    if ((count = publisher_bundle_count (msg)) < 0)
+        return -1;
+    if (flux_msg_get_payload (msg, &buf, &size) < 0)
+        return -1;
+    p = (const uint8_t *)buf + 4;
+    size -= 4;
+    for (i = 0; i < count; i++) {
+        flux_msg_t *event;
+        uint32_t n;
+
+        if (size < 4)
+            goto eproto;
+        n = get_uint32 (p);
+        p += 4;
+        size -= 4;
+        if (n > size)
+            goto eproto;
+        if (!(event = flux_msg_decode (p, n)))
+            return -1;
+        if (cb (event, arg) < 0)
+            rc = -1;
+        flux_msg_destroy (event);
+        p += n;
+        size -= n;
+    }
+    return rc;
+eproto:
+    errno = EPROTO;
+    return -1;
+}
+
 static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST, "event.pub",  pub_cb, FLUX_ROLE_USER },
     FLUX_MSGHANDLER_TABLE_END,
@@ -198,6 +469,10 @@ int publisher_set_flux (struct publisher *pub, flux_t *h)
     pub->h = h;
     if (flux_msg_handler_addvec (h, htab, pub, &pub->handlers) < 0)
         return -1;
+    if (!(pub->prep = flux_prepare_watcher_create (flux_get_reactor (h),
+                                                   prep_cb,
+                                                   pub)))
+        return -1;
     return 0;
 }
 
@@ -11,7 +11,19 @@
 #ifndef _BROKER_PUBLISHER_H
 #define _BROKER_PUBLISHER_H
 
+#include <stdbool.h>
+#include <flux/core.h>
+
 typedef int (*publisher_send_f)(void *arg, const flux_msg_t *msg);
+typedef int (*publisher_unbundle_f)(const flux_msg_t *msg, void *arg);
+
+/* Events published in the same reactor loop iteration are sent to senders
+ * as one "bundle" event with this topic, whose sequence number is that of
+ * the last event it contains.  At most PUBLISHER_BUNDLE_MAX events are
+ * bundled together.
+ */
+#define PUBLISHER_BUNDLE_TOPIC "broker.event-bundle"
+#define PUBLISHER_BUNDLE_MAX 256
 
 struct publisher *publisher_create (void);
 void publisher_destroy (struct publisher *pub);
@@ -29,6 +41,18 @@ int publisher_set_sender (struct publisher *pub, const char *name,
  */
 int publisher_send (struct publisher *pub, const flux_msg_t *msg);
 
+/* Event bundle helpers for receivers.
+ * publisher_bundle_count() returns the number of events in a bundle,
+ * or -1 with errno set if it is malformed.  publisher_unbundle() calls
+ * 'cb' for each event in order.  It returns -1 if the bundle is malformed
+ * or any callback returned -1.
+ */
+bool publisher_is_bundle (const flux_msg_t *msg);
+int publisher_bundle_count (const flux_msg_t *msg);
+int publisher_unbundle (const flux_msg_t *msg,
+                        publisher_unbundle_f cb,
+                        void *arg);
+
 #endif /* !_BROKER_PUBLISHER_H */
 
 /*
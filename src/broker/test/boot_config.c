@@ -18,6 +18,7 @@
 
 #include "src/common/libtap/tap.h"
 #include "src/broker/boot_config.h"
+#include "src/broker/topology.h"
 
 
 static void
@@ -383,6 +384,82 @@ void test_empty_hosts (const char *dir)
     flux_conf_decref (cf);
 }
 
+void test_parents (const char *dir)
+{
+    char path[PATH_MAX + 1];
+    json_t *hosts;
+    flux_conf_t *cf;
+    struct boot_conf conf;
+    struct topology *topo;
+    const char *input = \
+"[bootstrap]\n" \
+"default_bind = \"tcp://en0:%p\"\n" \
+"default_connect = \"tcp://%h:%p\"\n" \
+"hosts = [\n" \
+"  { host = \"foo0\" },\n" \
+"  { host = \"foo[1-2]\" },\n" \
+"  { host = \"foo[3-5]\", parent = \"foo2\" },\n" \
+"]\n";
+
+    create_test_file (dir, "boot", path, sizeof (path), input);
+    if (!(cf = flux_conf_parse (dir, NULL)))
+        BAIL_OUT ("flux_conf_parse failed");
+    ok (boot_config_parse (cf, &conf, &hosts) == 0 && hosts != NULL,
+        "boot_config_parse works with parent keys");
+    if (!(topo = topology_create ("kary:2", json_array_size (hosts))))
+        BAIL_OUT ("topology_create failed");
+    ok (boot_config_set_parents (hosts, topo) == 0,
+        "boot_config_set_parents works");
+    ok (topology_get_parent (topo, 1) == 0
+        && topology_get_parent (topo, 2) == 0
+        && topology_get_parent (topo, 3) == 2
+        && topology_get_parent (topo, 4) == 2
+        && topology_get_parent (topo, 5) == 2,
+        "hosts without parent key keep their kary:2 parent");
+    ok (topology_get_child_count (topo, 2) == 3
+        && topology_get_child_count (topo, 1) == 0,
+        "foo2 has three children and foo1 has none");
+    topology_destroy (topo);
+    json_decref (hosts);
+
+    if (unlink (path) < 0)
+        BAIL_OUT ("could not cleanup test file %s", path);
+    flux_conf_decref (cf);
+}
+
+void test_bad_parents (const char *dir)
+{
+    char path[PATH_MAX + 1];
+    json_t *hosts;
+    flux_conf_t *cf;
+    struct boot_conf conf;
+    struct topology *topo;
+    const char *input = \
+"[bootstrap]\n" \
+"hosts = [\n" \
+"  { host = \"foo0\" },\n" \
+"  { host = \"foo1\", parent = \"foo2\" },\n" \
+"  { host = \"foo2\", parent = \"foo1\" },\n" \
+"  { host = \"foo3\", parent = \"bar\" },\n" \
+"]\n";
+
+    create_test_file (dir, "boot", path, sizeof (path), input);
+    if (!(cf = flux_conf_parse (dir, NULL)))
+        BAIL_OUT ("flux_conf_parse failed");
+    ok (boot_config_parse (cf, &conf, &hosts) == 0 && hosts != NULL,
+        "boot_config_parse works with bad parent keys");
+    if (!(topo = topology_create ("flat", json_array_size (hosts))))
+        BAIL_OUT ("topology_create failed");
+    ok (boot_config_set_parents (hosts, topo) < 0,
+        "boot_config_set_parents fails on parent cycle");
+    topology_destroy (topo);
+    json_decref (hosts);
+
+    if (unlink (path) < 0)
+        BAIL_OUT ("could not cleanup test file %s", path);
+    flux_conf_decref (cf);
+}
+
 void test_format (void)
 {
     char buf[MAX_URI + 1];
@@ -451,6 +528,8 @@ int main (int argc, char **argv)
     test_empty_hosts (dir);
     test_missing_info (dir);
     test_toml_mixed_array (dir);
+    test_parents (dir);
+    test_bad_parents (dir);
 
     if (rmdir (dir) < 0)
         BAIL_OUT ("could not cleanup test dir %s", dir);
@@ -0,0 +1,263 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <flux/core.h>
+#include <czmq.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libtestutil/util.h"
+
+#include "src/broker/publisher.h"
+
+static zlist_t *sent;
+
+static void clear_sent (void)
+{
+    flux_msg_t *msg;
+    while ((msg = zlist_pop (sent)))
+        flux_msg_destroy (msg);
+}
+
+static int sender (void *arg, const flux_msg_t *msg)
+{
+    flux_msg_t *cpy;
+
+    if (!(cpy = flux_msg_copy (msg, true)))
+        BAIL_OUT ("flux_msg_copy failed");
+    if (zlist_append (sent, cpy) < 0)
+        BAIL_OUT ("zlist_append failed");
+    return 0;
+}
+
+static void publish (struct publisher *pub, const char *topic)
+{
+    flux_msg_t *msg;
+
+    if (!(msg = flux_event_encode (topic, NULL)))
+        BAIL_OUT ("flux_event_encode failed");
+    if (publisher_send (pub, msg) < 0)
+        BAIL_OUT ("publisher_send failed");
+    flux_msg_destroy (msg);
+}
+
+struct unbundle_ctx {
+    int count;
+    uint32_t next_seq;
+    int errors;
+};
+
+static int unbundle_cb (const flux_msg_t *msg, void *arg)
+{
+    struct unbundle_ctx *ctx = arg;
+    uint32_t seq;
+    const char *topic;
+    char expected[32];
+
+    snprintf (expected, sizeof (expected), "test.%u",
+              (unsigned int)ctx->next_seq);
+    if (flux_msg_get_seq (msg, &seq) < 0
+        || flux_msg_get_topic (msg, &topic) < 0
+        || seq != ctx->next_seq
+        || strcmp (topic, expected) != 0)
+        ctx->errors++;
+    ctx->next_seq++;
+    ctx->count++;
+    return 0;
+}
+
+void test_bundle (flux_t *h, struct publisher *pub)
+{
+    flux_reactor_t *r = flux_get_reactor (h);
+    struct unbundle_ctx ctx = { .next_seq = 1 };
+    flux_msg_t *msg;
+    uint32_t seq;
+    char topic[32];
+    int i;
+
+    for (i = 1; i <= 3; i++) {
+        snprintf (topic, sizeof (topic), "test.%d", i);
+        publish (pub, topic);
+    }
+    ok (zlist_size (sent) == 0,
+        "events are not sent immediately");
+    ok (flux_reactor_run (r, FLUX_REACTOR_NOWAIT) >= 0,
+        "reactor ran one iteration");
+    ok (zlist_size (sent) == 1,
+        "one message was sent");
+    msg = zlist_first (sent);
+    ok (msg != NULL && publisher_is_bundle (msg),
+        "message is a bundle");
+    ok (publisher_bundle_count (msg) == 3,
+        "bundle contains 3 events");
+    ok (flux_msg_get_seq (msg, &seq) == 0 && seq == 3,
+        "bundle seq is that of the last event");
+    ok (publisher_unbundle (msg, unbundle_cb, &ctx) == 0
+        && ctx.count == 3 && ctx.errors == 0,
+        "publisher_unbundle returned events in order");
+    clear_sent ();
+
+    publish (pub, "test.4");
+    ok (flux_reactor_run (r, FLUX_REACTOR_NOWAIT) >= 0
+        && zlist_size (sent) == 1,
+        "a single event was sent");
+    msg = zlist_first (sent);
+    ok (msg != NULL && !publisher_is_bundle (msg)
+        && flux_msg_get_seq (msg, &seq) == 0 && seq == 4,
+        "single event is not bundled");
+    clear_sent ();
+}
+
+void test_bundle_max (flux_t *h, struct publisher *pub)
+{
+    flux_reactor_t *r = flux_get_reactor (h);
+    struct unbundle_ctx ctx = { .next_seq = 5 };
+    flux_msg_t *msg;
+    char topic[32];
+    int i;
+
+    for (i = 0; i < PUBLISHER_BUNDLE_MAX + 10; i++) {
+        snprintf (topic, sizeof (topic), "test.%d", 5 + i);
+        publish (pub, topic);
+    }
+    ok (zlist_size (sent) == 1,
+        "bundle was sent when PUBLISHER_BUNDLE_MAX was reached");
+    ok (flux_reactor_run (r, FLUX_REACTOR_NOWAIT) >= 0
+        && zlist_size (sent) == 2,
+        "remaining events were sent at end of loop iteration");
+    msg = zlist_first (sent);
+    ok (publisher_bundle_count (msg) == PUBLISHER_BUNDLE_MAX,
+        "first bundle contains PUBLISHER_BUNDLE_MAX events");
+    msg = zlist_next (sent);
+    ok (publisher_bundle_count (msg) == 10,
+        "second bundle contains 10 events");
+    msg = zlist_first (sent);
+    while (msg) {
+        (void)publisher_unbundle (msg, unbundle_cb, &ctx);
+        msg = zlist_next (sent);
+    }
+    ok (ctx.count == PUBLISHER_BUNDLE_MAX + 10 && ctx.errors == 0,
+        "all events were unbundled in order");
+    clear_sent ();
+}
+
+void test_malformed (void)
+{
+    struct unbundle_ctx ctx = { .next_seq = 1 };
+    flux_msg_t *msg;
+    uint32_t count;
+
+    if (!(msg = flux_msg_create (FLUX_MSGTYPE_EVENT))
+        || flux_msg_set_topic (msg, PUBLISHER_BUNDLE_TOPIC) < 0)
+        BAIL_OUT ("failed to create bundle message");
+    ok (publisher_is_bundle (msg),
+        "publisher_is_bundle works on hand-made bundle");
+    errno = 0;
+    ok (publisher_bundle_count (msg) < 0 && errno == EPROTO,
+        "publisher_bundle_count with no payload fails with EPROTO");
+
+    count = htonl (0);
+    if (flux_msg_set_payload (msg, &count, sizeof (count)) < 0)
+        BAIL_OUT ("flux_msg_set_payload failed");
+    errno = 0;
+    ok (publisher_bundle_count (msg) < 0 && errno == EPROTO,
+        "publisher_bundle_count with zero count fails with EPROTO");
+
+    count = htonl (2);
+    if (flux_msg_set_payload (msg, &count, sizeof (count)) < 0)
+        BAIL_OUT ("flux_msg_set_payload failed");
+    errno = 0;
+    ok (publisher_unbundle (msg, unbundle_cb, &ctx) < 0 && errno == EPROTO
+        && ctx.count == 0,
+        "publisher_unbundle with truncated bundle fails with EPROTO");
+    flux_msg_destroy (msg);
+}
+
+/* An event.pub request whose event is still queued when the publisher
+ * is destroyed receives an error response.
+ */
+void test_destroy_pending (flux_t *h)
+{
+    flux_reactor_t *r = flux_get_reactor (h);
+    struct publisher *pub;
+    flux_future_t *f;
+
+    if (!(pub = publisher_create ())
+        || publisher_set_flux (pub, h) < 0
+        || publisher_set_sender (pub, "test", sender, NULL) < 0)
+        BAIL_OUT ("failed to create publisher");
+    if (!(f = flux_rpc_pack (h,
+                             "event.pub",
+                             FLUX_NODEID_ANY,
+                             0,
+                             "{s:s s:i}",
+                             "topic", "test.pending",
+                             "flags", 0)))
+        BAIL_OUT ("flux_rpc_pack failed");
+    ok (flux_reactor_run (r, FLUX_REACTOR_NOWAIT) >= 0
+        && zlist_size (sent) == 0,
+        "event.pub request was received and its event queued");
+    publisher_destroy (pub);
+    ok (zlist_size (sent) == 0,
+        "publisher_destroy did not send the queued event");
+    errno = 0;
+    ok (flux_future_get (f, NULL) < 0 && errno == ENOSYS,
+        "event.pub request failed with ENOSYS");
+    flux_future_destroy (f);
+}
+
+int main (int argc, char *argv[])
+{
+    flux_t *h;
+    flux_reactor_t *r;
+    struct publisher *pub;
+
+    plan (NO_PLAN);
+
+    if (!(sent = zlist_new ()))
+        BAIL_OUT ("zlist_new failed");
+    if (!(r = flux_reactor_create (0)))
+        BAIL_OUT ("flux_reactor_create failed");
+    if (!(h = loopback_create (0)))
+        BAIL_OUT ("loopback_create failed");
+    if (flux_set_reactor (h, r) < 0)
+        BAIL_OUT ("flux_set_reactor failed");
+    if (!(pub = publisher_create ()))
+        BAIL_OUT ("publisher_create failed");
+    ok (publisher_set_flux (pub, h) == 0,
+        "publisher_set_flux works");
+    ok (publisher_set_sender (pub, "test", sender, NULL) == 0,
+        "publisher_set_sender works");
+
+    test_bundle (h, pub);
+    test_bundle_max (h, pub);
+    test_malformed ();
+
+    publisher_destroy (pub);
+
+    test_destroy_pending (h);
+
+    flux_close (h);
+    flux_reactor_destroy (r);
+    zlist_destroy (&sent);
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
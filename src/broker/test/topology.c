@@ -0,0 +1,213 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <string.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/kary.h"
+
+#include "src/broker/topology.h"
+
+/* Compare every derived quantity of a kary:K topology with libutil/kary.
+ */
+void check_kary (int k, uint32_t size)
+{
+    char spec[32];
+    struct topology *topo;
+    uint32_t i;
+    int errors = 0;
+
+    snprintf (spec, sizeof (spec), "kary:%d", k);
+    if (!(topo = topology_create (spec, size)))
+        BAIL_OUT ("topology_create %s failed", spec);
+    for (i = 0; i < size; i++) {
+        int j;
+        if (topology_get_parent (topo, i) != kary_parentof (k, i))
+            errors++;
+        if (topology_get_level (topo, i) != kary_levelof (k, i))
+            errors++;
+        if (topology_get_descendant_count (topo, i)
+                != kary_sum_descendants (k, size, i))
+            errors++;
+        for (j = 0; j < k; j++) {
+            uint32_t child = kary_childof (k, size, i, j);
+            if (topology_get_child (topo, i, j) != child)
+                errors++;
+        }
+        if (i > 0 && topology_get_child_route (topo, 0, i)
+                        != kary_child_route (k, size, 0, i))
+            errors++;
+    }
+    ok (errors == 0,
+        "%s size=%u matches kary functions", spec, (unsigned int)size);
+    ok (topology_get_arity (topo) == k,
+        "%s size=%u arity is %d", spec, (unsigned int)size, k);
+    ok (topology_get_maxlevel (topo) == kary_levelof (k, size - 1),
+        "%s size=%u maxlevel is %d",
+        spec, (unsigned int)size, kary_levelof (k, size - 1));
+    topology_destroy (topo);
+}
+
+void test_kary (void)
+{
+    check_kary (1, 8);
+    check_kary (2, 1);
+    check_kary (2, 15);
+    check_kary (3, 100);
+    check_kary (16, 1000);
+}
+
+void test_binomial (void)
+{
+    struct topology *topo;
+
+    if (!(topo = topology_create ("binomial", 8)))
+        BAIL_OUT ("topology_create binomial failed");
+    ok (!strcmp (topology_get_spec (topo), "binomial"),
+        "binomial: spec is binomial");
+    ok (topology_get_parent (topo, 0) == TOPOLOGY_NONE,
+        "binomial: rank 0 has no parent");
+    ok (topology_get_parent (topo, 7) == 6
+        && topology_get_parent (topo, 6) == 4
+        && topology_get_parent (topo, 5) == 4
+        && topology_get_parent (topo, 4) == 0,
+        "binomial: parents follow lowest set bit");
+    ok (topology_get_child_count (topo, 0) == 3
+        && topology_get_child (topo, 0, 0) == 1
+        && topology_get_child (topo, 0, 1) == 2
+        && topology_get_child (topo, 0, 2) == 4
+        && topology_get_child (topo, 0, 3) == TOPOLOGY_NONE,
+        "binomial: rank 0 has children 1,2,4");
+    ok (topology_get_level (topo, 7) == 3
+        && topology_get_maxlevel (topo) == 3,
+        "binomial: rank 7 is at level 3 which is maxlevel");
+    ok (topology_get_descendant_count (topo, 0) == 7
+        && topology_get_descendant_count (topo, 4) == 3
+        && topology_get_descendant_count (topo, 7) == 0,
+        "binomial: descendant counts are correct");
+    ok (topology_get_child_route (topo, 0, 7) == 4
+        && topology_get_child_route (topo, 4, 7) == 6
+        && topology_get_child_route (topo, 6, 7) == 7
+        && topology_get_child_route (topo, 2, 7) == TOPOLOGY_NONE,
+        "binomial: child routes are correct");
+    ok (topology_get_arity (topo) == 3,
+        "binomial: arity is max fanout of 3");
+    topology_destroy (topo);
+}
+
+void test_flat (void)
+{
+    struct topology *topo;
+
+    if (!(topo = topology_create ("flat", 100)))
+        BAIL_OUT ("topology_create flat failed");
+    ok (topology_get_child_count (topo, 0) == 99
+        && topology_get_arity (topo) == 99,
+        "flat: rank 0 has 99 children");
+    ok (topology_get_maxlevel (topo) == 1
+        && topology_get_level (topo, 99) == 1,
+        "flat: maxlevel is 1");
+    ok (topology_get_child_route (topo, 0, 42) == 42,
+        "flat: rank 42 is routed directly");
+    topology_destroy (topo);
+}
+
+void test_custom (void)
+{
+    struct topology *topo;
+
+    if (!(topo = topology_create ("flat", 6)))
+        BAIL_OUT ("topology_create flat failed");
+
+    /*   0
+     *  / \
+     * 1   2
+     *    /|\
+     *   3 4 5
+     */
+    ok (topology_set_parent (topo, 3, 2) == 0
+        && topology_set_parent (topo, 4, 2) == 0
+        && topology_set_parent (topo, 5, 2) == 0,
+        "topology_set_parent works");
+    ok (!strcmp (topology_get_spec (topo), "custom"),
+        "spec is now custom");
+    ok (topology_get_child_count (topo, 0) == 2
+        && topology_get_child_count (topo, 2) == 3,
+        "child counts were updated");
+    ok (topology_get_descendant_count (topo, 0) == 5
+        && topology_get_descendant_count (topo, 2) == 3
+        && topology_get_descendant_count (topo, 1) == 0,
+        "descendant counts were updated");
+    ok (topology_get_maxlevel (topo) == 2,
+        "maxlevel was updated");
+    ok (topology_get_arity (topo) == 3,
+        "arity is max fanout of 3");
+    ok (topology_get_child_route (topo, 0, 5) == 2,
+        "child route was updated");
+
+    errno = 0;
+    ok (topology_set_parent (topo, 2, 4) < 0 && errno == EINVAL,
+        "topology_set_parent refuses to create a cycle");
+    errno = 0;
+    ok (topology_set_parent (topo, 2, 2) < 0 && errno == EINVAL,
+        "topology_set_parent refuses self as parent");
+    errno = 0;
+    ok (topology_set_parent (topo, 0, 1) < 0 && errno == EINVAL,
+        "topology_set_parent refuses to give rank 0 a parent");
+    errno = 0;
+    ok (topology_set_parent (topo, 1, 6) < 0 && errno == EINVAL,
+        "topology_set_parent refuses out of range parent");
+    topology_destroy (topo);
+}
+
+void test_invalid (void)
+{
+    const char *bad[] = { "kary:0", "kary:", "kary:x", "kary", "foo", "", NULL };
+    int i;
+
+    for (i = 0; bad[i] != NULL; i++) {
+        errno = 0;
+        ok (topology_create (bad[i], 4) == NULL && errno == EINVAL,
+            "topology_create spec=\"%s\" fails with EINVAL", bad[i]);
+    }
+    errno = 0;
+    ok (topology_create ("binomial", 0) == NULL && errno == EINVAL,
+        "topology_create size=0 fails with EINVAL");
+    errno = 0;
+    ok (topology_create (NULL, 4) == NULL && errno == EINVAL,
+        "topology_create spec=NULL fails with EINVAL");
+    ok (topology_get_parent (NULL, 0) == TOPOLOGY_NONE
+        && topology_get_level (NULL, 0) == -1
+        && topology_get_descendant_count (NULL, 0) == -1,
+        "accessors handle topo=NULL");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    test_kary ();
+    test_binomial ();
+    test_flat ();
+    test_custom ();
+    test_invalid ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
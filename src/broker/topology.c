@@ -0,0 +1,318 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* topology.c - tree based overlay network shapes
+ *
+ * Every shape is reduced to a parent map.  Child lists, levels, and
+ * descendant counts are derived from the parent map on demand, in O(size),
+ * and cached until the next topology_set_parent().
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdbool.h>
+
+#include "src/common/libutil/kary.h"
+
+#include "topology.h"
+
+struct topology {
+    char *spec;
+    int k;                  // kary:K, or 0 if not (or no longer) k-ary
+    uint32_t size;
+    uint32_t *parent;
+
+    /* Derived from 'parent' by topology_update().
+     * Children of rank r are children[child_index[r]..child_index[r+1]-1].
+     */
+    bool dirty;
+    uint32_t *child_index;
+    uint32_t *children;
+    int *level;
+    int *descendants;
+    uint32_t *scratch;
+    int maxlevel;
+    int maxfanout;
+};
+
+static int parse_kary (const char *spec, int *k)
+{
+    char *endptr;
+    unsigned long n;
+
+    if (strncmp (spec, "kary:", 5) != 0)
+        return -1;
+    errno = 0;
+    n = strtoul (spec + 5, &endptr, 10);
+    if (errno != 0 || *endptr != '\0' || endptr == spec + 5 || n < 1
+                                                          || n > INT32_MAX)
+        return -1;
+    *k = n;
+    return 0;
+}
+
+/* Parent of rank in a binomial tree rooted at 0 is rank with its
+ * lowest set bit cleared.
+ */
+static uint32_t binomial_parentof (uint32_t rank)
+{
+    if (rank == 0)
+        return TOPOLOGY_NONE;
+    return rank & (rank - 1);
+}
+
+static int topology_init_parents (struct topology *topo, const char *spec)
+{
+    uint32_t i;
+    int k;
+
+    if (parse_kary (spec, &k) == 0) {
+        topo->k = k;
+        for (i = 0; i < topo->size; i++)
+            topo->parent[i] = kary_parentof (k, i);
+    }
+    else if (!strcmp (spec, "binomial")) {
+        for (i = 0; i < topo->size; i++)
+            topo->parent[i] = binomial_parentof (i);
+    }
+    else if (!strcmp (spec, "flat")) {
+        for (i = 0; i < topo->size; i++)
+            topo->parent[i] = i == 0 ? TOPOLOGY_NONE : 0;
+    }
+    else {
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+void topology_destroy (struct topology *topo)
+{
+    if (topo) {
+        int saved_errno = errno;
+        free (topo->spec);
+        free (topo->parent);
+        free (topo->child_index);
+        free (topo->children);
+        free (topo->level);
+        free (topo->descendants);
+        free (topo->scratch);
+        free (topo);
+        errno = saved_errno;
+    }
+}
+
+struct topology *topology_create (const char *spec, uint32_t size)
+{
+    struct topology *topo;
+
+    if (!spec || size == 0 || size == TOPOLOGY_NONE) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(topo = calloc (1, sizeof (*topo))))
+        return NULL;
+    topo->size = size;
+    topo->dirty = true;
+    if (!(topo->spec = strdup (spec))
+        || !(topo->parent = calloc (size, sizeof (topo->parent[0])))
+        || !(topo->child_index = calloc (size + 1,
+                                         sizeof (topo->child_index[0])))
+        || !(topo->children = calloc (size, sizeof (topo->children[0])))
+        || !(topo->level = calloc (size, sizeof (topo->level[0])))
+        || !(topo->descendants = calloc (size,
+                                         sizeof (topo->descendants[0])))
+        || !(topo->scratch = calloc (size, sizeof (topo->scratch[0]))))
+        goto error;
+    if (topology_init_parents (topo, spec) < 0)
+        goto error;
+    return topo;
+error:
+    topology_destroy (topo);
+    return NULL;
+}
+
+/* Return true if 'a' is 'b' or an ancestor of 'b'.
+ */
+static bool is_ancestor_or_self (struct topology *topo, uint32_t a, uint32_t b)
+{
+    while (b != TOPOLOGY_NONE) {
+        if (b == a)
+            return true;
+        b = topo->parent[b];
+    }
+    return false;
+}
+
+int topology_set_parent (struct topology *topo, uint32_t rank, uint32_t parent)
+{
+    char *cpy;
+
+    if (!topo || rank == 0 || rank >= topo->size || parent >= topo->size
+              || is_ancestor_or_self (topo, rank, parent)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (topo->parent[rank] == parent)
+        return 0;
+    if (strcmp (topo->spec, "custom") != 0) {
+        if (!(cpy = strdup ("custom")))
+            return -1;
+        free (topo->spec);
+        topo->spec = cpy;
+    }
+    topo->parent[rank] = parent;
+    topo->k = 0;
+    topo->dirty = true;
+    return 0;
+}
+
+/* Rebuild child lists (counting sort on parent, so each list is in
+ * rank order), then walk the tree breadth first from the root to assign
+ * levels, and in reverse breadth first order to sum descendants.
+ * Since the parent map is acyclic and rooted at 0, every rank is reachable.
+ */
+static void topology_update (struct topology *topo)
+{
+    uint32_t *scratch = topo->scratch;
+    uint32_t i, j, head, tail;
+
+    if (!topo->dirty)
+        return;
+    memset (topo->child_index, 0, sizeof (uint32_t) * (topo->size + 1));
+    for (i = 1; i < topo->size; i++)
+        topo->child_index[topo->parent[i] + 1]++;
+    topo->maxfanout = 0;
+    for (i = 0; i < topo->size; i++) {
+        if ((int)topo->child_index[i + 1] > topo->maxfanout)
+            topo->maxfanout = topo->child_index[i + 1];
+        topo->child_index[i + 1] += topo->child_index[i];
+    }
+    for (i = 0; i < topo->size; i++)    // per-parent fill pointers
+        scratch[i] = topo->child_index[i];
+    for (i = 1; i < topo->size; i++)
+        topo->children[scratch[topo->parent[i]]++] = i;
+
+    head = tail = 0;                    // scratch is now the BFS queue
+    scratch[tail++] = 0;
+    topo->level[0] = 0;
+    topo->maxlevel = 0;
+    while (head < tail) {
+        uint32_t r = scratch[head++];
+        for (j = topo->child_index[r]; j < topo->child_index[r + 1]; j++) {
+            uint32_t c = topo->children[j];
+            topo->level[c] = topo->level[r] + 1;
+            if (topo->level[c] > topo->maxlevel)
+                topo->maxlevel = topo->level[c];
+            scratch[tail++] = c;
+        }
+    }
+    memset (topo->descendants, 0, sizeof (int) * topo->size);
+    for (i = tail - 1; i > 0; i--) {
+        uint32_t r = scratch[i];
+        topo->descendants[topo->parent[r]] += 1 + topo->descendants[r];
+    }
+    topo->dirty = false;
+}
+
+const char *topology_get_spec (struct topology *topo)
+{
+    return topo ? topo->spec : NULL;
+}
+
+uint32_t topology_get_size (struct topology *topo)
+{
+    return topo ? topo->size : 0;
+}
+
+uint32_t topology_get_parent (struct topology *topo, uint32_t rank)
+{
+    if (!topo || rank >= topo->size)
+        return TOPOLOGY_NONE;
+    return topo->parent[rank];
+}
+
+int topology_get_child_count (struct topology *topo, uint32_t rank)
+{
+    if (!topo || rank >= topo->size)
+        return -1;
+    topology_update (topo);
+    return topo->child_index[rank + 1] - topo->child_index[rank];
+}
+
+uint32_t topology_get_child (struct topology *topo, uint32_t rank, int i)
+{
+    if (!topo || rank >= topo->size || i < 0)
+        return TOPOLOGY_NONE;
+    topology_update (topo);
+    if (i >= topo->child_index[rank + 1] - topo->child_index[rank])
+        return TOPOLOGY_NONE;
+    return topo->children[topo->child_index[rank] + i];
+}
+
+int topology_get_level (struct topology *topo, uint32_t rank)
+{
+    if (!topo || rank >= topo->size)
+        return -1;
+    topology_update (topo);
+    return topo->level[rank];
+}
+
+int topology_get_maxlevel (struct topology *topo)
+{
+    if (!topo)
+        return -1;
+    topology_update (topo);
+    return topo->maxlevel;
+}
+
+int topology_get_arity (struct topology *topo)
+{
+    if (!topo)
+        return -1;
+    if (topo->k > 0)
+        return topo->k;
+    topology_update (topo);
+    return topo->maxfanout;
+}
+
+int topology_get_descendant_count (struct topology *topo, uint32_t rank)
+{
+    if (!topo || rank >= topo->size)
+        return -1;
+    topology_update (topo);
+    return topo->descendants[rank];
+}
+
+uint32_t topology_get_child_route (struct topology *topo,
+                                   uint32_t src,
+                                   uint32_t dst)
+{
+    uint32_t gw;
+
+    if (!topo || src >= topo->size || dst >= topo->size || src == dst)
+        return TOPOLOGY_NONE;
+    gw = dst;
+    while (gw != TOPOLOGY_NONE) {
+        uint32_t p = topo->parent[gw];
+        if (p == src)
+            return gw;
+        gw = p;
+    }
+    return TOPOLOGY_NONE;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
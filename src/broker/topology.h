@@ -0,0 +1,92 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _BROKER_TOPOLOGY_H
+#define _BROKER_TOPOLOGY_H
+
+#include <stdint.h>
+
+/* topology - describe the shape of the tree based overlay network
+ *
+ * The tree is always rooted at rank 0.  A topology is created from a
+ * specification string, which may be one of:
+ *
+ *   kary:K     complete k-ary tree with fanout K (K >= 1)
+ *   binomial   binomial tree (parent of rank r is r with lowest bit cleared)
+ *   flat       all ranks are children of rank 0
+ *
+ * The parent of individual ranks may then be overridden with
+ * topology_set_parent(), for example from an explicit parent map
+ * in the [bootstrap] configuration.
+ */
+
+#define TOPOLOGY_NONE   (~(uint32_t)0)
+
+struct topology;
+
+struct topology *topology_create (const char *spec, uint32_t size);
+void topology_destroy (struct topology *topo);
+
+/* Override the parent of 'rank'.  Rank 0 may not be given a parent,
+ * and 'parent' may not be 'rank' or one of its descendants.
+ * Returns 0 on success, -1 with errno set on failure.
+ */
+int topology_set_parent (struct topology *topo, uint32_t rank, uint32_t parent);
+
+/* Return the specification string the topology was created from,
+ * or "custom" if topology_set_parent() has modified it.
+ */
+const char *topology_get_spec (struct topology *topo);
+
+uint32_t topology_get_size (struct topology *topo);
+
+/* Return the parent of 'rank', or TOPOLOGY_NONE for rank 0.
+ */
+uint32_t topology_get_parent (struct topology *topo, uint32_t rank);
+
+/* Return the number of children of 'rank', or -1 on invalid rank.
+ */
+int topology_get_child_count (struct topology *topo, uint32_t rank);
+
+/* Return the ith child of 'rank' (children are in rank order),
+ * or TOPOLOGY_NONE if there is no such child.
+ */
+uint32_t topology_get_child (struct topology *topo, uint32_t rank, int i);
+
+/* Return the level of 'rank' (root is level 0), or -1 on invalid rank.
+ */
+int topology_get_level (struct topology *topo, uint32_t rank);
+
+/* Return the maximum level of any rank in the tree.
+ */
+int topology_get_maxlevel (struct topology *topo);
+
+/* Return the branching factor: K for a kary:K topology that has not been
+ * modified, otherwise the largest number of children of any rank.
+ */
+int topology_get_arity (struct topology *topo);
+
+/* Return the number of descendants of 'rank', not including 'rank',
+ * or -1 on invalid rank.
+ */
+int topology_get_descendant_count (struct topology *topo, uint32_t rank);
+
+/* Return the child of 'src' that 'dst' is routed through, which may be
+ * 'dst' itself, or TOPOLOGY_NONE if 'dst' is not a descendant of 'src'.
+ */
+uint32_t topology_get_child_route (struct topology *topo,
+                                   uint32_t src,
+                                   uint32_t dst);
+
+#endif /* !_BROKER_TOPOLOGY_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -73,43 +73,79 @@ static struct idset *ranks_to_idset (flux_t *h, const char *ranks)
 /*  Topology kvs helpers:
  */
 
-static void lookup_continuation (flux_future_t *f, void *arg)
+/*  Maximum number of topology lookups outstanding at once
+ */
+#define LOOKUP_WINDOW 256
+
+struct topo_lookup {
+    flux_t *h;
+    struct idset *idset;
+    int rank;
+    char **xmls;
+    int next;
+};
+
+static flux_future_t *lookup_produce (flux_future_t *pf, void *arg)
+{
+    struct topo_lookup *tl = arg;
+    flux_future_t *f;
+    char key [1024];
+
+    if (tl->rank == IDSET_INVALID_ID) {
+        errno = ENODATA;
+        return NULL;
+    }
+    snprintf (key, sizeof (key), "%s.%d", XML_BASEDIR, tl->rank);
+    if (!(f = flux_kvs_lookup (tl->h, NULL, 0, key)))
+        return NULL;
+    if (flux_future_aux_set (f, "xmlp", &tl->xmls[tl->next++], NULL) < 0) {
+        flux_future_destroy (f);
+        return NULL;
+    }
+    tl->rank = idset_next (tl->idset, tl->rank);
+    return f;
+}
+
+static int lookup_consume (flux_future_t *pf, flux_future_t *f, void *arg)
 {
-    char **valp = arg;
+    char **valp = flux_future_aux_get (f, "xmlp");
     const char *xml;
 
     if (flux_kvs_lookup_get_unpack (f, "s", &xml) < 0)
         log_err_exit ("unable to unpack rank xml");
 
-    *valp = strdup (xml);
-
-    flux_future_destroy (f);
+    if (!(*valp = strdup (xml)))
+        return -1;
+    return 0;
 }
 
 /*  Send lookup request for topology XML for all ranks in idset, returning
  *   copies of each XML in xmls array (The array must have space for
- *   idset_count (idset) members).
- *  There should be no other watchers registered on the main handle reactor
- *   here, so it is safe to drop into the handle reactor and return when
- *   all lookup handlers have completed.
+ *   idset_count (idset) members).  At most LOOKUP_WINDOW requests are
+ *   outstanding at once.
  */
 static int lookup_all_topo_xml (flux_t *h, char **xmls, struct idset *idset)
 {
-    flux_future_t *f = NULL;
-    char key [1024];
-    int rank = idset_first (idset);
-    int i = 0;
-
-    while (rank != IDSET_INVALID_ID) {
-        snprintf (key, sizeof (key), "%s.%d", XML_BASEDIR, rank);
-        if (!(f = flux_kvs_lookup (h, NULL, 0, key))
-            || (flux_future_then (f, -1., lookup_continuation, &xmls[i]) < 0))
-            log_err_exit ("kvs lookup");
+    struct topo_lookup tl = {
+        .h = h,
+        .idset = idset,
+        .rank = idset_first (idset),
+        .xmls = xmls,
+        .next = 0,
+    };
+    flux_future_t *f;
+    int rc;
 
-        rank = idset_next (idset, rank);
-        i++;
-    }
-    return (flux_reactor_run (flux_get_reactor (h), 0));
+    if (!(f = flux_rpc_pipeline (h,
+                                 LOOKUP_WINDOW,
+                                 0,
+                                 lookup_produce,
+                                 lookup_consume,
+                                 &tl)))
+        log_err_exit ("kvs lookup");
+    rc = flux_future_get (f, NULL);
+    flux_future_destroy (f);
+    return rc;
 }
 
 /*  Lookup topo XML for a single rank using degenerate case of
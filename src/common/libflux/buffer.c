@@ -8,6 +8,24 @@
  * SPDX-License-Identifier: LGPL-3.0
 \************************************************************/
 
+/* buffer.c - single threaded ring buffer
+ *
+ * Data is stored in a power of 2 sized ring that grows on demand up to
+ * the size requested at creation.  Read and write offsets are free
+ * running 32 bit counters, masked to index the ring, so the number of
+ * bytes stored is simply (wr - rd).
+ *
+ * When the data being returned by a peek or read is contiguous in the
+ * ring, a pointer into the ring is returned rather than a copy.  The ring
+ * is allocated with one extra byte so there is always room to NUL
+ * terminate a span that reaches the end of the ring.  Wrapped data is
+ * copied to a separate return buffer.
+ *
+ * The offset of the first newline is cached, along with how far the data
+ * has been searched without finding one, so repeated line checks do not
+ * rescan data.
+ */
+
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
@@ -17,12 +35,14 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/uio.h>
 
 #include "buffer.h"
 #include "buffer_private.h"
 
-#include "src/common/liblsd/cbuf.h"
-
 #define FLUX_BUFFER_MIN   4096
 #define FLUX_BUFFER_MAGIC 0xeb4feb4f
 
@@ -37,8 +57,14 @@ struct flux_buffer {
     int magic;
     int size;
     bool readonly;
-    cbuf_t cbuf;
-    char *buf;                  /* internal buffer for user reads */
+    char *data;                 /* ring, cap + 1 bytes */
+    uint32_t cap;               /* ring capacity, a power of 2 */
+    uint32_t rd;                /* offset of first unread byte */
+    uint32_t wr;                /* offset of next byte to write */
+    bool nl_valid;
+    uint32_t nl;                /* offset of first newline, if nl_valid */
+    uint32_t scanned;           /* [rd, scanned) contains no newline */
+    char *buf;                  /* return buffer for wrapped data */
     int buflen;
     int cb_type;
     flux_buffer_cb cb;
@@ -46,10 +72,109 @@ struct flux_buffer {
     void *cb_arg;
 };
 
+static uint32_t pow2_roundup (uint32_t n)
+{
+    uint32_t x = 1;
+    while (x < n)
+        x <<= 1;
+    return x;
+}
+
+static inline uint32_t ring_used (flux_buffer_t *fb)
+{
+    return fb->wr - fb->rd;
+}
+
+static inline uint32_t ring_index (flux_buffer_t *fb, uint32_t offset)
+{
+    return offset & (fb->cap - 1);
+}
+
+/* Copy 'len' bytes starting at ring offset 'offset' to 'dst'.
+ */
+static void ring_copy_out (flux_buffer_t *fb,
+                           uint32_t offset,
+                           char *dst,
+                           uint32_t len)
+{
+    uint32_t i = ring_index (fb, offset);
+    uint32_t first = len < fb->cap - i ? len : fb->cap - i;
+
+    memcpy (dst, fb->data + i, first);
+    memcpy (dst + first, fb->data, len - first);
+}
+
+/* Make room for 'len' more bytes in the ring, growing it if necessary.
+ * The caller ensures that the result does not exceed fb->size.
+ */
+static int ring_reserve (flux_buffer_t *fb, uint32_t len)
+{
+    uint32_t used = ring_used (fb);
+    uint32_t newcap;
+    char *data;
+
+    if (fb->cap - used >= len)
+        return 0;
+    newcap = pow2_roundup (used + len);
+    if (!(data = malloc (newcap + 1))) {
+        errno = ENOMEM;
+        return -1;
+    }
+    ring_copy_out (fb, fb->rd, data, used);
+    free (fb->data);
+    fb->data = data;
+    fb->cap = newcap;
+    fb->nl -= fb->rd;
+    fb->scanned -= fb->rd;
+    fb->rd = 0;
+    fb->wr = used;
+    return 0;
+}
+
+static void ring_copy_in (flux_buffer_t *fb, const char *src, uint32_t len)
+{
+    uint32_t i = ring_index (fb, fb->wr);
+    uint32_t first = len < fb->cap - i ? len : fb->cap - i;
+
+    memcpy (fb->data + i, src, first);
+    memcpy (fb->data, src + first, len - first);
+    fb->wr += len;
+}
+
+static void ring_consume (flux_buffer_t *fb, uint32_t len)
+{
+    if (fb->nl_valid && fb->nl - fb->rd < len)
+        fb->nl_valid = false;
+    if (fb->scanned - fb->rd < len)
+        fb->scanned = fb->rd + len;
+    fb->rd += len;
+}
+
+/* Return the length of the first line, including its newline, or 0 if
+ * there is no complete line.
+ */
+static uint32_t ring_find_line (flux_buffer_t *fb)
+{
+    while (!fb->nl_valid && fb->scanned != fb->wr) {
+        uint32_t i = ring_index (fb, fb->scanned);
+        uint32_t len = fb->wr - fb->scanned;
+        char *p;
+
+        if (len > fb->cap - i)
+            len = fb->cap - i;
+        if ((p = memchr (fb->data + i, '\n', len))) {
+            fb->nl = fb->scanned + (p - (fb->data + i));
+            fb->nl_valid = true;
+        }
+        else
+            fb->scanned += len;
+    }
+    return fb->nl_valid ? fb->nl - fb->rd + 1 : 0;
+}
+
 flux_buffer_t *flux_buffer_create (int size)
 {
     flux_buffer_t *fb = NULL;
-    int minsize = FLUX_BUFFER_MIN;
 
     if (size <= 0) {
         errno = EINVAL;
@@ -63,23 +188,11 @@ flux_buffer_t *flux_buffer_create (int size)
 
     fb->magic = FLUX_BUFFER_MAGIC;
     fb->size = size;
-    if (size < FLUX_BUFFER_MIN)
-        minsize = size;
-    else
-        minsize = FLUX_BUFFER_MIN;
     fb->readonly = false;
 
-    /* buffer can grow to size specified by user */
-    if (!(fb->cbuf = cbuf_create (minsize, fb->size)))
-        goto cleanup;
-
-    if (cbuf_opt_set (fb->cbuf, CBUF_OPT_OVERWRITE, CBUF_NO_DROP) < 0)
-        goto cleanup;
-
-    /* +1 for possible NUL on line reads */
-    fb->buflen = minsize + 1;
-
-    if (!(fb->buf = malloc (fb->buflen))) {
+    /* ring can grow to size specified by user */
+    fb->cap = pow2_roundup (size < FLUX_BUFFER_MIN ? size : FLUX_BUFFER_MIN);
+    if (!(fb->data = malloc (fb->cap + 1))) {
         errno = ENOMEM;
         goto cleanup;
     }
@@ -98,7 +211,7 @@ void flux_buffer_destroy (void *data)
     flux_buffer_t *fb = data;
     if (fb && fb->magic == FLUX_BUFFER_MAGIC) {
         fb->magic = ~FLUX_BUFFER_MAGIC;
-        cbuf_destroy (fb->cbuf);
+        free (fb->data);
         free (fb->buf);
         free (fb);
     }
@@ -121,7 +234,7 @@ int flux_buffer_bytes (flux_buffer_t *fb)
         return -1;
     }
 
-    return cbuf_used (fb->cbuf);
+    return ring_used (fb);
 }
 
 int flux_buffer_space (flux_buffer_t *fb)
@@ -131,7 +244,7 @@ int flux_buffer_space (flux_buffer_t *fb)
         return -1;
     }
 
-    return cbuf_free (fb->cbuf);
+    return fb->size - ring_used (fb);
 }
 
 int flux_buffer_readonly (flux_buffer_t *fb)
@@ -259,37 +372,35 @@ void check_read_cb (flux_buffer_t *fb)
 
 int flux_buffer_drop (flux_buffer_t *fb, int len)
 {
-    int ret;
-
-    if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
+    if (!fb || fb->magic != FLUX_BUFFER_MAGIC || len < -1) {
         errno = EINVAL;
         return -1;
     }
 
-    if ((ret = cbuf_drop (fb->cbuf, len)) < 0)
-        return -1;
-
-    check_write_cb (fb);
+    if (len < 0 || len > ring_used (fb))
+        len = ring_used (fb);
+    if (len > 0) {
+        ring_consume (fb, len);
+        check_write_cb (fb);
+    }
 
-    return ret;
+    return len;
 }
 
-/* check if internal buffer can hold data from user */
-static int return_buffer_check (flux_buffer_t *fb)
+/* check if internal buffer can hold [len] bytes of data plus NUL */
+static int return_buffer_check (flux_buffer_t *fb, int len)
 {
-    int used = cbuf_used (fb->cbuf);
-
-    if (used < 0)
-        return -1;
-
-    assert (used <= fb->size);
+    assert (len <= fb->size);
 
-    /* +1 for potential NUL char */
-    if (fb->buflen < (used + 1)) {
+    if (fb->buflen < (len + 1)) {
         size_t newsize = fb->buflen;
         char *newbuf;
 
-        while ((newsize < (used + 1))) {
+        if (newsize == 0)
+            newsize = (fb->size < FLUX_BUFFER_MIN ? fb->size
+                                                  : FLUX_BUFFER_MIN) + 1;
+
+        while ((newsize < (len + 1))) {
             newsize = (newsize - 1) * 2 + 1;
             if (newsize > (fb->size + 1))
                 newsize = fb->size + 1;
@@ -304,67 +415,77 @@ static int return_buffer_check (flux_buffer_t *fb)
     return 0;
 }
 
+/* Return a NUL terminated pointer to the first [len] bytes of unread
+ * data.  If the data is contiguous in the ring and is followed by free
+ * space (or the spare byte at the end of the ring), point into the ring,
+ * otherwise copy it to the return buffer.  Unread data in the ring is
+ * never modified.
+ */
+static const char *get_data (flux_buffer_t *fb, uint32_t len)
+{
+    uint32_t i = ring_index (fb, fb->rd);
+    char *ptr;
+
+    if (len > 0 && i + len <= fb->cap && len == ring_used (fb))
+        ptr = fb->data + i;
+    else {
+        if (return_buffer_check (fb, len) < 0)
+            return NULL;
+        ptr = fb->buf;
+        ring_copy_out (fb, fb->rd, ptr, len);
+    }
+    ptr[len] = '\0';
+    return ptr;
+}
+
 const void *flux_buffer_peek (flux_buffer_t *fb, int len, int *lenp)
 {
-    int ret;
+    const char *ptr;
 
     if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
         errno = EINVAL;
         return NULL;
     }
 
-    if (return_buffer_check (fb) < 0)
-        return NULL;
-
-    if (len < 0)
-        len = cbuf_used (fb->cbuf);
-
-    if (len > fb->buflen)
-        len = fb->buflen;
+    if (len < 0 || len > ring_used (fb))
+        len = ring_used (fb);
 
-    if ((ret = cbuf_peek (fb->cbuf, fb->buf, len)) < 0)
+    if (!(ptr = get_data (fb, len)))
         return NULL;
-    fb->buf[ret] = '\0';
 
     if (lenp)
-        (*lenp) = ret;
+        (*lenp) = len;
 
-    return fb->buf;
+    return ptr;
 }
 
 const void *flux_buffer_read (flux_buffer_t *fb, int len, int *lenp)
 {
-    int ret;
+    const char *ptr;
 
     if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
         errno = EINVAL;
         return NULL;
     }
 
-    if (return_buffer_check (fb) < 0)
-        return NULL;
-
-    if (len < 0)
-        len = cbuf_used (fb->cbuf);
-
-    if (len > fb->buflen)
-        len = fb->buflen;
+    if (len < 0 || len > ring_used (fb))
+        len = ring_used (fb);
 
-    if ((ret = cbuf_read (fb->cbuf, fb->buf, len)) < 0)
+    if (!(ptr = get_data (fb, len)))
         return NULL;
-    fb->buf[ret] = '\0';
+    ring_consume (fb, len);
 
     if (lenp)
-        (*lenp) = ret;
+        (*lenp) = len;
 
     check_write_cb (fb);
 
-    return fb->buf;
+    return ptr;
 }
 
 int flux_buffer_write (flux_buffer_t *fb, const void *data, int len)
 {
-    int ret;
+    int space;
 
     if (!fb
         || fb->magic != FLUX_BUFFER_MAGIC
@@ -379,136 +500,139 @@ int flux_buffer_write (flux_buffer_t *fb, const void *data, int len)
         return -1;
     }
 
-    if ((ret = cbuf_write (fb->cbuf, (void *)data, len, NULL)) < 0)
+    if (len == 0)
+        return 0;
+
+    if (!(space = fb->size - ring_used (fb))) {
+        errno = ENOSPC;
+        return -1;
+    }
+    if (len > space)
+        len = space;
+    if (ring_reserve (fb, len) < 0)
         return -1;
+    ring_copy_in (fb, data, len);
 
     check_read_cb (fb);
 
-    return ret;
+    return len;
 }
 
 int flux_buffer_lines (flux_buffer_t *fb)
 {
+    uint32_t offset;
+    int lines = 0;
+
     if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
         errno = EINVAL;
         return -1;
     }
 
-    return cbuf_lines_used (fb->cbuf);
+    offset = fb->rd;
+    while (offset != fb->wr) {
+        uint32_t i = ring_index (fb, offset);
+        uint32_t len = fb->wr - offset;
+        char *p = fb->data + i;
+        char *end;
+
+        if (len > fb->cap - i)
+            len = fb->cap - i;
+        end = p + len;
+        while ((p = memchr (p, '\n', end - p))) {
+            lines++;
+            p++;
+        }
+        offset += len;
+    }
+    return lines;
 }
 
 bool flux_buffer_has_line (flux_buffer_t *fb)
 {
-    char buf[1];
     if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
         errno = EINVAL;
         return false;
     }
-    return (cbuf_peek_line (fb->cbuf, buf, 0, 1) > 0);
+    return ring_find_line (fb) > 0;
 }
 
 int flux_buffer_drop_line (flux_buffer_t *fb)
 {
-    int ret;
+    uint32_t len;
 
     if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
         errno = EINVAL;
         return -1;
     }
 
-    if ((ret = cbuf_drop_line (fb->cbuf, fb->buflen, 1)) < 0)
-        return -1;
-
-    check_write_cb (fb);
+    if ((len = ring_find_line (fb)) > 0) {
+        ring_consume (fb, len);
+        check_write_cb (fb);
+    }
 
-    return ret;
+    return len;
 }
 
-const void *flux_buffer_peek_line (flux_buffer_t *fb, int *lenp)
+/* Return the first line, or an empty string if there is no complete line.
+ */
+static const void *get_line (flux_buffer_t *fb,
+                             bool consume,
+                             bool trim,
+                             int *lenp)
 {
-    int ret;
+    uint32_t linelen;
+    uint32_t len;
+    const char *ptr;
 
     if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
         errno = EINVAL;
         return NULL;
     }
 
-    if (return_buffer_check (fb) < 0)
-        return NULL;
-
-    if ((ret = cbuf_peek_line (fb->cbuf, fb->buf, fb->buflen, 1)) < 0)
+    /* A trimmed line is the line without its newline.  Since the newline
+     * is still unread, the trimmed data is never the last byte in the ring
+     * and get_data() returns a copy, leaving the ring untouched.
+     */
+    len = linelen = ring_find_line (fb);
+    if (trim && linelen > 0)
+        len--;
+    if (!(ptr = get_data (fb, len)))
         return NULL;
+    if (consume && linelen > 0) {
+        ring_consume (fb, linelen);
+        check_write_cb (fb);
+    }
 
     if (lenp)
-        (*lenp) = ret;
+        (*lenp) = len;
 
-    return fb->buf;
+    return ptr;
 }
 
-const void *flux_buffer_peek_trimmed_line (flux_buffer_t *fb, int *lenp)
+const void *flux_buffer_peek_line (flux_buffer_t *fb, int *lenp)
 {
-    int tmp_lenp = 0;
-
-    if (!flux_buffer_peek_line (fb, &tmp_lenp))
-        return NULL;
-
-    if (tmp_lenp) {
-        if (fb->buf[tmp_lenp - 1] == '\n') {
-            fb->buf[tmp_lenp - 1] = '\0';
-            tmp_lenp--;
-        }
-    }
-    if (lenp)
-        (*lenp) = tmp_lenp;
+    return get_line (fb, false, false, lenp);
+}
 
-    return fb->buf;
+const void *flux_buffer_peek_trimmed_line (flux_buffer_t *fb, int *lenp)
+{
+    return get_line (fb, false, true, lenp);
 }
 
 const void *flux_buffer_read_line (flux_buffer_t *fb, int *lenp)
 {
-    int ret;
-
-    if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
-        errno = EINVAL;
-        return NULL;
-    }
-
-    if (return_buffer_check (fb) < 0)
-        return NULL;
-
-    if ((ret = cbuf_read_line (fb->cbuf, fb->buf, fb->buflen, 1)) < 0)
-        return NULL;
-
-    if (lenp)
-        (*lenp) = ret;
-
-    check_write_cb (fb);
-
-    return fb->buf;
+    return get_line (fb, true, false, lenp);
 }
 
 const void *flux_buffer_read_trimmed_line (flux_buffer_t *fb, int *lenp)
 {
-    int tmp_lenp = 0;
-
-    if (!flux_buffer_read_line (fb, &tmp_lenp))
-        return NULL;
-
-    if (tmp_lenp) {
-        if (fb->buf[tmp_lenp - 1] == '\n') {
-            fb->buf[tmp_lenp - 1] = '\0';
-            tmp_lenp--;
-        }
-    }
-    if (lenp)
-        (*lenp) = tmp_lenp;
-
-    return fb->buf;
+    return get_line (fb, true, true, lenp);
 }
 
 int flux_buffer_write_line (flux_buffer_t *fb, const char *data)
 {
-    int ret;
+    int len;
+    int total;
 
     if (!fb
         || fb->magic != FLUX_BUFFER_MAGIC
@@ -522,35 +646,77 @@ int flux_buffer_write_line (flux_buffer_t *fb, const char *data)
         return -1;
     }
 
-    if ((ret = cbuf_write_line (fb->cbuf, (char *)data, NULL)) < 0)
+    len = strlen (data);
+    total = len;
+    if (len == 0 || data[len - 1] != '\n')
+        total++;
+    if (total > fb->size - ring_used (fb)) {
+        errno = ENOSPC;
+        return -1;
+    }
+    if (ring_reserve (fb, total) < 0)
         return -1;
+    ring_copy_in (fb, data, len);
+    if (total > len)
+        ring_copy_in (fb, "\n", 1);
 
     check_read_cb (fb);
 
-    return ret;
+    return total;
+}
+
+/* Fill [iov] with up to [len] bytes of the ring starting at [offset].
+ * Returns the number of iovecs used.
+ */
+static int ring_iov (flux_buffer_t *fb,
+                     uint32_t offset,
+                     uint32_t len,
+                     struct iovec iov[2])
+{
+    uint32_t i = ring_index (fb, offset);
+    uint32_t first = len < fb->cap - i ? len : fb->cap - i;
+
+    iov[0].iov_base = fb->data + i;
+    iov[0].iov_len = first;
+    if (first == len)
+        return 1;
+    iov[1].iov_base = fb->data;
+    iov[1].iov_len = len - first;
+    return 2;
 }
 
 int flux_buffer_peek_to_fd (flux_buffer_t *fb, int fd, int len)
 {
-    if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
+    struct iovec iov[2];
+    int iovcnt;
+    int ret;
+
+    if (!fb || fb->magic != FLUX_BUFFER_MAGIC || fd < 0 || len < -1) {
         errno = EINVAL;
         return -1;
     }
 
-    return cbuf_peek_to_fd (fb->cbuf, fd, len);
+    if (len < 0 || len > ring_used (fb))
+        len = ring_used (fb);
+    if (len == 0)
+        return 0;
+
+    iovcnt = ring_iov (fb, fb->rd, len, iov);
+    do {
+        ret = writev (fd, iov, iovcnt);
+    } while (ret < 0 && errno == EINTR);
+
+    return ret;
 }
 
 int flux_buffer_read_to_fd (flux_buffer_t *fb, int fd, int len)
 {
     int ret;
 
-    if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
-        errno = EINVAL;
-        return -1;
-    }
+    if ((ret = flux_buffer_peek_to_fd (fb, fd, len)) <= 0)
+        return ret;
 
-    if ((ret = cbuf_read_to_fd (fb->cbuf, fd, len)) < 0)
-        return -1;
+    ring_consume (fb, ret);
 
     check_write_cb (fb);
 
@@ -559,6 +725,9 @@ int flux_buffer_read_to_fd (flux_buffer_t *fb, int fd, int len)
 
 int flux_buffer_write_from_fd (flux_buffer_t *fb, int fd, int len)
 {
+    struct iovec iov[2];
+    int iovcnt;
+    int space;
     int ret;
 
     if (!fb || fb->magic != FLUX_BUFFER_MAGIC) {
@@ -571,8 +740,41 @@ int flux_buffer_write_from_fd (flux_buffer_t *fb, int fd, int len)
         return -1;
     }
 
-    if ((ret = cbuf_write_from_fd (fb->cbuf, fd, len, NULL)) < 0)
+    if (fd < 0 || len < -1) {
+        errno = EINVAL;
         return -1;
+    }
+
+    space = fb->size - ring_used (fb);
+    if (len < 0)
+        len = space;
+    if (len == 0)
+        return 0;
+    if (space == 0) {
+        errno = ENOSPC;
+        return -1;
+    }
+    if (len > space)
+        len = space;
+
+    /* Read into the free part of the ring.  Double it only once it is
+     * at least half full, so the ring size tracks how much data is
+     * actually buffered rather than how much could be.
+     */
+    if (ring_used (fb) >= fb->cap / 2) {
+        if (ring_reserve (fb, len < fb->cap ? len : fb->cap) < 0)
+            return -1;
+    }
+    if (len > fb->cap - ring_used (fb))
+        len = fb->cap - ring_used (fb);
+
+    iovcnt = ring_iov (fb, fb->wr, len, iov);
+    do {
+        ret = readv (fd, iov, iovcnt);
+    } while (ret < 0 && errno == EINTR);
+    if (ret <= 0)
+        return ret;
+    fb->wr += ret;
 
     check_read_cb (fb);
 
@@ -15,6 +15,13 @@
 
 typedef struct flux_buffer flux_buffer_t;
 
+/* A flux_buffer_t is not thread safe.
+ *
+ * Pointers returned by the peek and read functions below may point
+ * directly into the buffer's storage, and are only valid until the next
+ * call that writes to or reads from the buffer.
+ */
+
 /* Create buffer.
  */
 flux_buffer_t *flux_buffer_create (int size);
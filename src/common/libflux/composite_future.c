@@ -14,6 +14,7 @@
 #include <czmq.h>
 
 #include "future.h"
+#include "rpc.h"
 
 /*  Type-specific data for a composite future:
  */
@@ -250,6 +251,190 @@ const char *flux_future_next_child (flux_future_t *f)
     return (zhash_cursor (cf->children));
 }
 
+/*  Pipelined futures support:
+ *
+ *  A pipeline is a future with up to 'window' child futures outstanding.
+ *   Children are obtained from the 'produce' callback and are kept in
+ *   submission order on the 'inflight' list.  When a child is fulfilled
+ *   it is passed to 'consume' and destroyed, then the window is
+ *   refilled.  In ordered mode, fulfilled children wait on the list
+ *   until all children submitted before them have been consumed.
+ */
+struct pipeline {
+    int window;
+    int flags;
+    flux_pipeline_produce_f produce;
+    flux_pipeline_consume_f consume;
+    void *arg;
+    zlist_t *inflight;
+    bool done;
+};
+
+static void pipeline_destroy (struct pipeline *pl)
+{
+    if (pl) {
+        int saved_errno = errno;
+        if (pl->inflight) {
+            flux_future_t *child;
+            while ((child = zlist_pop (pl->inflight)))
+                flux_future_destroy (child);
+            zlist_destroy (&pl->inflight);
+        }
+        free (pl);
+        errno = saved_errno;
+    }
+}
+
+static struct pipeline *pipeline_get (flux_future_t *f)
+{
+    return flux_future_aux_get (f, "flux::pipeline");
+}
+
+static void pipeline_fail (flux_future_t *f, struct pipeline *pl, int errnum)
+{
+    flux_future_t *child;
+
+    pl->done = true;
+    while ((child = zlist_pop (pl->inflight)))
+        flux_future_destroy (child);
+    flux_future_fulfill_error (f, errnum, NULL);
+}
+
+static int pipeline_consume (flux_future_t *f,
+                             struct pipeline *pl,
+                             flux_future_t *child)
+{
+    int rc = 0;
+
+    if (pl->consume)
+        rc = pl->consume (f, child, pl->arg);
+    else if (flux_future_get (child, NULL) < 0)
+        rc = -1;
+    flux_future_destroy (child);
+    return rc;
+}
+
+static void pipeline_child_cb (flux_future_t *child, void *arg);
+
+/*  Start children until the window is full or 'produce' runs dry.
+ *   Fulfill the pipeline once there is no more work outstanding.
+ */
+static void pipeline_fill (flux_future_t *f, struct pipeline *pl)
+{
+    flux_future_t *child;
+
+    while (!pl->done && zlist_size (pl->inflight) < pl->window) {
+        errno = 0;
+        if (!(child = pl->produce (f, pl->arg))) {
+            if (errno == ENODATA)
+                break;
+            goto error;
+        }
+        if (zlist_append (pl->inflight, child) < 0) {
+            flux_future_destroy (child);
+            errno = ENOMEM;
+            goto error;
+        }
+        future_propagate_context (f, child);
+        if (flux_future_then (child, -1., pipeline_child_cb, f) < 0)
+            goto error;
+    }
+    if (!pl->done && zlist_size (pl->inflight) == 0) {
+        pl->done = true;
+        flux_future_fulfill (f, NULL, NULL);
+    }
+    return;
+error:
+    pipeline_fail (f, pl, errno ? errno : EINVAL);
+}
+
+static void pipeline_child_cb (flux_future_t *child, void *arg)
+{
+    flux_future_t *f = arg;
+    struct pipeline *pl = pipeline_get (f);
+
+    if (!pl || pl->done)
+        return;
+    if ((pl->flags & FLUX_PIPELINE_ORDERED)) {
+        while ((child = zlist_first (pl->inflight))
+               && flux_future_is_ready (child)) {
+            zlist_remove (pl->inflight, child);
+            if (pipeline_consume (f, pl, child) < 0)
+                goto error;
+        }
+    }
+    else {
+        zlist_remove (pl->inflight, child);
+        if (pipeline_consume (f, pl, child) < 0)
+            goto error;
+    }
+    pipeline_fill (f, pl);
+    return;
+error:
+    pipeline_fail (f, pl, errno ? errno : EINVAL);
+}
+
+static void pipeline_init (flux_future_t *f, void *arg)
+{
+    struct pipeline *pl = arg;
+    flux_future_t *child;
+
+    /*  If the pipeline was started in another context (e.g. after
+     *   flux_future_wait_for(3) timed out), move any outstanding
+     *   children to the current one.
+     */
+    child = zlist_first (pl->inflight);
+    while (child) {
+        future_propagate_context (f, child);
+        if (flux_future_then (child, -1., pipeline_child_cb, f) < 0) {
+            pipeline_fail (f, pl, errno);
+            return;
+        }
+        child = zlist_next (pl->inflight);
+    }
+    pipeline_fill (f, pl);
+}
+
+flux_future_t *flux_rpc_pipeline (flux_t *h,
+                                  int window,
+                                  int flags,
+                                  flux_pipeline_produce_f produce,
+                                  flux_pipeline_consume_f consume,
+                                  void *arg)
+{
+    struct pipeline *pl;
+    flux_future_t *f;
+
+    if (!h || window < 1 || (flags & ~FLUX_PIPELINE_ORDERED) || !produce) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(pl = calloc (1, sizeof (*pl))))
+        return NULL;
+    pl->window = window;
+    pl->flags = flags;
+    pl->produce = produce;
+    pl->consume = consume;
+    pl->arg = arg;
+    if (!(pl->inflight = zlist_new ())) {
+        pipeline_destroy (pl);
+        errno = ENOMEM;
+        return NULL;
+    }
+    if (!(f = flux_future_create (pipeline_init, pl))) {
+        pipeline_destroy (pl);
+        return NULL;
+    }
+    if (flux_future_aux_set (f, "flux::pipeline", pl,
+                             (flux_free_f) pipeline_destroy) < 0) {
+        pipeline_destroy (pl);
+        flux_future_destroy (f);
+        return NULL;
+    }
+    flux_future_set_flux (f, h);
+    return f;
+}
+
 /*  Chained futures support: */
 
 /*
@@ -26,6 +26,11 @@
 #include "src/common/libutil/log.h"
 #include "src/common/libutil/iterators.h"
 
+/* Destroyed message handlers are kept on a per-handle freelist for reuse,
+ * since RPCs create and destroy a response handler each.
+ */
+#define HANDLER_CACHE_SIZE 256
+
 struct dispatch {
     flux_t *h;
     zlist_t *handlers;
@@ -36,6 +41,8 @@ struct dispatch {
     int running_count;
     int usecount;
     zlist_t *unmatched;
+    flux_msg_handler_t *cache[HANDLER_CACHE_SIZE];
+    int cache_count;
 #if HAVE_CALIPER
     cali_id_t prof_msg_type;
     cali_id_t prof_msg_topic;
@@ -57,6 +64,7 @@ struct flux_msg_handler {
 static void handle_cb (flux_reactor_t *r, flux_watcher_t *w,
                        int revents, void *arg);
 static void free_msg_handler (flux_msg_handler_t *mh);
+static void release_msg_handler (struct dispatch *d, flux_msg_handler_t *mh);
 
 static size_t matchtag_hasher (const void *key);
 static int matchtag_cmp (const void *key1, const void *key2);
@@ -101,6 +109,8 @@ static void dispatch_usecount_decr (struct dispatch *d)
             assert (zlist_size (d->handlers_new) == 0);
             zlist_destroy (&d->handlers_new);
         }
+        while (d->cache_count > 0)
+            free (d->cache[--d->cache_count]);
         flux_watcher_destroy (d->w);
         zhashx_destroy (&d->handlers_rpc);
         zhashx_destroy (&d->handlers_method);
@@ -480,10 +490,44 @@ static void free_msg_handler (flux_msg_handler_t *mh)
     }
 }
 
+/* Like free_msg_handler(), but put 'mh' on the dispatch freelist if
+ * there is room.  'd' must remain valid, so call this before dropping
+ * the handler's reference on it.
+ */
+static void release_msg_handler (struct dispatch *d, flux_msg_handler_t *mh)
+{
+    if (mh) {
+        assert (mh->magic == HANDLER_MAGIC);
+        if (d->cache_count < HANDLER_CACHE_SIZE) {
+            int saved_errno = errno;
+            flux_match_free (mh->match);
+            mh->magic = ~HANDLER_MAGIC;
+            d->cache[d->cache_count++] = mh;
+            errno = saved_errno;
+        }
+        else
+            free_msg_handler (mh);
+    }
+}
+
+static flux_msg_handler_t *alloc_msg_handler (struct dispatch *d)
+{
+    flux_msg_handler_t *mh;
+
+    if (d->cache_count > 0) {
+        mh = d->cache[--d->cache_count];
+        memset (mh, 0, sizeof (*mh));
+    }
+    else if (!(mh = calloc (1, sizeof (*mh))))
+        return NULL;
+    return mh;
+}
+
 void flux_msg_handler_destroy (flux_msg_handler_t *mh)
 {
     if (mh) {
         int saved_errno = errno;
+        struct dispatch *d;
         assert (mh->magic == HANDLER_MAGIC);
         if (mh->match.typemask == FLUX_MSGTYPE_RESPONSE
                             && mh->match.matchtag != FLUX_MATCHTAG_NONE) {
@@ -498,8 +542,9 @@ void flux_msg_handler_destroy (flux_msg_handler_t *mh)
             zlist_remove (mh->d->handlers, mh);
         }
         flux_msg_handler_stop (mh);
-        dispatch_usecount_decr (mh->d);
-        free_msg_handler (mh);
+        d = mh->d;
+        release_msg_handler (d, mh);
+        dispatch_usecount_decr (d);
         errno = saved_errno;
     }
 }
@@ -517,7 +562,7 @@ flux_msg_handler_t *flux_msg_handler_create (flux_t *h,
     }
     if (!(d = dispatch_get (h)))
         return NULL;
-    if (!(mh = calloc (1, sizeof (*mh))))
+    if (!(mh = alloc_msg_handler (d)))
         return NULL;
     mh->magic = HANDLER_MAGIC;
     if (copy_match (&mh->match, match) < 0)
@@ -563,7 +608,7 @@ flux_msg_handler_t *flux_msg_handler_create (flux_t *h,
     dispatch_usecount_incr (d);
     return mh;
 error:
-    free_msg_handler (mh);
+    release_msg_handler (d, mh);
     return NULL;
 }
 
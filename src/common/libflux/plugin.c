@@ -33,6 +33,7 @@ struct flux_plugin {
     struct aux_item *aux;
     void *dso;
     zlistx_t *handlers;
+    unsigned int generation;
     char last_error [128];
 };
 
@@ -282,6 +283,7 @@ int flux_plugin_remove_handler (flux_plugin_t *p,
     if (find_handler (p, topic)) {
         if (zlistx_delete (p->handlers, zlistx_cursor (p->handlers)) < 0)
             return plugin_seterror (p, errno, NULL);
+        p->generation++;
     }
     return 0;
 }
@@ -332,10 +334,15 @@ int flux_plugin_add_handler (flux_plugin_t *p,
         flux_plugin_handler_destroy (h);
         return plugin_seterror (p, errno, NULL);
     }
-
+    p->generation++;
     return 0;
 }
 
+unsigned int flux_plugin_get_generation (flux_plugin_t *p)
+{
+    return p ? p->generation : 0;
+}
+
 int flux_plugin_register (flux_plugin_t *p,
                           const char *name,
                           const struct flux_plugin_handler t[])
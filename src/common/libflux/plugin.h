@@ -72,6 +72,13 @@ flux_plugin_f flux_plugin_get_handler (flux_plugin_t *p, const char *topic);
  */
 flux_plugin_f flux_plugin_match_handler (flux_plugin_t *p, const char *topic);
 
+/*  Return a counter that is incremented each time a handler is added to
+ *   or removed from plugin 'p'. A host which caches the result of
+ *   flux_plugin_match_handler() may compare this value to detect that
+ *   its cache is out of date.
+ */
+unsigned int flux_plugin_get_generation (flux_plugin_t *p);
+
 /*  Convenience function to register a table of handlers along with
  *   a plugin name for the plugin 'p'.
  */
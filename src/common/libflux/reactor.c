@@ -12,6 +12,7 @@
 #include "config.h"
 #endif
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <stdbool.h>
@@ -69,15 +70,64 @@ void flux_reactor_destroy (flux_reactor_t *r)
     reactor_usecount_decr (r);
 }
 
+struct backend {
+    const char *name;
+    unsigned int flag;
+};
+
+static const struct backend backends[] = {
+    { "select",     EVBACKEND_SELECT },
+    { "poll",       EVBACKEND_POLL },
+    { "epoll",      EVBACKEND_EPOLL },
+    { "linuxaio",   EVBACKEND_LINUXAIO },
+    { NULL,         0 },
+};
+
+/* Choose a libev backend.  FLUX_REACTOR_BACKEND in the environment
+ * overrides the FLUX_REACTOR_LINUXAIO flag, so the backend of an existing
+ * program (e.g. the broker) can be changed without recompiling it.
+ * Return 0 (libev default) if there is no preference, or if the requested
+ * backend was not compiled into libev.
+ */
+static unsigned int backend_flags (int flags)
+{
+    unsigned int flag = 0;
+    const char *s;
+
+    if ((s = getenv ("FLUX_REACTOR_BACKEND"))) {
+        int i;
+        for (i = 0; backends[i].name != NULL; i++) {
+            if (!strcmp (s, backends[i].name)) {
+                flag = backends[i].flag;
+                break;
+            }
+        }
+    }
+    else if ((flags & FLUX_REACTOR_LINUXAIO))
+        flag = EVBACKEND_LINUXAIO;
+    return flag & ev_supported_backends ();
+}
+
+static struct ev_loop *loop_create (int flags, unsigned int backend)
+{
+    if ((flags & FLUX_REACTOR_SIGCHLD))
+        return ev_default_loop (EVFLAG_SIGNALFD | backend);
+    return ev_loop_new (EVFLAG_NOSIGMASK | backend);
+}
+
 flux_reactor_t *flux_reactor_create (int flags)
 {
-    flux_reactor_t *r = calloc (1, sizeof (*r));
-    if (!r)
+    flux_reactor_t *r;
+    unsigned int backend;
+
+    if (!(r = calloc (1, sizeof (*r))))
         return NULL;
-    if ((flags & FLUX_REACTOR_SIGCHLD))
-        r->loop = ev_default_loop (EVFLAG_SIGNALFD);
-    else
-        r->loop = ev_loop_new (EVFLAG_NOSIGMASK);
+    /* If the chosen backend cannot be initialized at runtime, e.g. the
+     * kernel lacks AIO poll support, fall back to the libev default.
+     */
+    backend = backend_flags (flags);
+    if (!(r->loop = loop_create (flags, backend)) && backend != 0)
+        r->loop = loop_create (flags, 0);
     if (!r->loop) {
         errno = ENOMEM;
         flux_reactor_destroy (r);
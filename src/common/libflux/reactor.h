@@ -40,6 +40,9 @@ enum {
 enum {
     FLUX_REACTOR_SIGCHLD = 1,  /* enable use of child watchers */
                                /*    only one thread can do this per program */
+    FLUX_REACTOR_LINUXAIO = 2, /* poll fds with Linux AIO, which batches */
+                               /*    submissions and reaps events from a */
+                               /*    shared ring, if available */
 };
 
 /* Flags for buffer watchers */
@@ -178,7 +178,6 @@ static void response_cb (flux_t *h, flux_msg_handler_t *mh,
                          const flux_msg_t *msg, void *arg)
 {
     flux_future_t *f = arg;
-    flux_msg_t *cpy;
     int saved_errno;
     const char *errstr;
 
@@ -190,9 +189,11 @@ static void response_cb (flux_t *h, flux_msg_handler_t *mh,
 #endif
     if (flux_response_decode (msg, NULL, NULL) < 0)
         goto error;
-    if (!(cpy = flux_msg_copy (msg, true)))
-        goto error;
-    flux_future_fulfill (f, cpy, (flux_free_f)flux_msg_destroy);
+    /* Take a reference on the response rather than copying it.
+     */
+    flux_future_fulfill (f,
+                         (flux_msg_t *)flux_msg_incref (msg),
+                         (flux_free_f)flux_msg_decref);
     return;
 error:
     saved_errno = errno;
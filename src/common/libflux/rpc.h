@@ -52,6 +52,36 @@ int flux_rpc_get_raw (flux_future_t *f, const void **data, int *len);
  */
 uint32_t flux_rpc_get_matchtag (flux_future_t *f);
 
+/* RPC pipeline - keep up to 'window' futures outstanding.
+ * 'produce' is called to start the next RPC whenever there is room in
+ * the window.  It returns a future, or NULL with errno set to ENODATA
+ * if there is no more work.  ENODATA with no futures outstanding ends
+ * the pipeline for good: it is fulfilled and 'produce' is never called
+ * again.  While futures are outstanding, 'produce' is retried after
+ * each one is consumed, so 'consume' may add work.  'consume' (if
+ * non-NULL) is called with each fulfilled future, in completion order,
+ * or in submission order if FLUX_PIPELINE_ORDERED is set.  The pipeline
+ * destroys each future after it is consumed.  The returned future fails
+ * if 'produce' or 'consume' fails.  If 'consume' is NULL, an RPC error
+ * fails the pipeline.  See flux_rpc_pipeline(3).
+ */
+enum {
+    FLUX_PIPELINE_ORDERED = 1,
+};
+
+typedef flux_future_t *(*flux_pipeline_produce_f)(flux_future_t *pf,
+                                                  void *arg);
+typedef int (*flux_pipeline_consume_f)(flux_future_t *pf,
+                                       flux_future_t *f,
+                                       void *arg);
+
+flux_future_t *flux_rpc_pipeline (flux_t *h,
+                                  int window,
+                                  int flags,
+                                  flux_pipeline_produce_f produce,
+                                  flux_pipeline_consume_f consume,
+                                  void *arg);
+
 #ifdef __cplusplus
 }
 #endif
@@ -13,6 +13,13 @@
 /* Matchtags are used to match requests and responses in RPC's.
  *
  * Requests that receive no response use FLUX_MATCHTAG_NONE (0).
+ *
+ * Allocation and free are O(1).  Freed tags are pushed on a stack and
+ * reused most recently freed first.  When the stack is empty, a tag is
+ * taken from the never-allocated range [next, size).  The pool doubles
+ * in size (up to TAGPOOL_COUNT) only when all tags below 'size' are in
+ * use, so a client with N outstanding RPCs uses tags < 2N.  A bitmap of
+ * allocated tags makes freeing an unallocated tag harmless.
  */
 
 #if HAVE_CONFIG_H
@@ -27,31 +34,48 @@
 #include "tagpool.h"
 #include "message.h"
 
-#include "src/common/libutil/veb.h"
-#include "src/common/libutil/log.h"
-
 #define TAGPOOL_COUNT (1UL<<20)
 #define TAGPOOL_START (1UL<<10)
 
+#define BITS_PER_WORD   (8 * sizeof (uint64_t))
+#define WORD_INDEX(tag) ((tag) / BITS_PER_WORD)
+#define WORD_BIT(tag)   ((uint64_t)1 << ((tag) % BITS_PER_WORD))
+
 #define TAGPOOL_MAGIC   0x34447ff2
 struct tagpool {
     int             magic;
-    Veb             veb;
+    uint32_t        size;       // tags [0, size) may be allocated
+    uint32_t        next;       // tags [next, size) never allocated
+    uint32_t        *stack;     // freed tags, capacity 'size'
+    uint32_t        count;      // number of tags on 'stack'
+    uint64_t        *used;      // bitmap of allocated tags
     int             avail;
     tagpool_grow_f  grow_cb;
     void            *grow_arg;
     int             grow_depth;
 };
 
-static void pool_set (Veb veb, uint32_t from, uint32_t to, uint8_t value)
+static bool tag_is_used (struct tagpool *t, uint32_t tag)
 {
-    while (from < to) {
-        if (value)
-            vebput (veb, from);
-        else
-            vebdel (veb, from);
-        from++;
-    }
+    return (t->used[WORD_INDEX (tag)] & WORD_BIT (tag)) != 0;
+}
+
+static int pool_resize (struct tagpool *t, uint32_t newsize)
+{
+    uint32_t *stack;
+    uint64_t *used;
+    size_t oldwords = WORD_INDEX (t->size + BITS_PER_WORD - 1);
+    size_t newwords = WORD_INDEX (newsize + BITS_PER_WORD - 1);
+
+    if (!(stack = realloc (t->stack, newsize * sizeof (stack[0]))))
+        return -1;
+    t->stack = stack;
+    if (!(used = realloc (t->used, newwords * sizeof (used[0]))))
+        return -1;
+    memset (used + oldwords, 0, (newwords - oldwords) * sizeof (used[0]));
+    t->used = used;
+    t->size = newsize;
+    return 0;
 }
 
 struct tagpool *tagpool_create (void)
@@ -60,10 +84,10 @@ struct tagpool *tagpool_create (void)
     if (!t)
         goto nomem;
     t->magic = TAGPOOL_MAGIC;
-    t->veb = vebnew (TAGPOOL_START, 1);
-    if (!t->veb.D)
+    if (pool_resize (t, TAGPOOL_START) < 0)
         goto nomem;
-    vebdel (t->veb, FLUX_MATCHTAG_NONE); /* allocate reserved value */
+    t->used[0] |= WORD_BIT (FLUX_MATCHTAG_NONE); /* allocate reserved value */
+    t->next = FLUX_MATCHTAG_NONE + 1;
     t->avail = TAGPOOL_COUNT - 1;
     return t;
 nomem:
@@ -76,7 +100,8 @@ void tagpool_destroy (struct tagpool *t)
 {
     if (t) {
         assert (t->magic == TAGPOOL_MAGIC);
-        free (t->veb.D);
+        free (t->stack);
+        free (t->used);
         t->magic = ~TAGPOOL_MAGIC;
         free (t);
     }
@@ -88,33 +113,22 @@ void tagpool_set_grow_cb (struct tagpool *t, tagpool_grow_f cb, void *arg)
     t->grow_arg = arg;
 }
 
-static uint32_t alloc_with_resize (struct tagpool *t)
+/* Called when all tags below t->size are in use.
+ * Returns 0 if the pool was grown, -1 if at maximum size or out of memory.
+ */
+static int pool_grow (struct tagpool *t)
 {
-    uint32_t max = TAGPOOL_COUNT;
-    uint32_t oldsize, newsize, tag;
-
-    oldsize = t->veb.M;
-    newsize = oldsize << 1;
-    tag = vebsucc (t->veb, 0);
-
-    if (tag == t->veb.M && newsize <= max) {
-        if (t->grow_cb && t->grow_depth == 0) {
-            t->grow_depth++;
-            t->grow_cb (t->grow_arg, oldsize, newsize);
-            t->grow_depth--;
-        }
-        Veb new = vebnew (newsize, 0);
-        if (new.D) {
-            pool_set (new, oldsize, newsize, 1);
-            free (t->veb.D);
-            t->veb = new;
-            tag = vebsucc (t->veb, oldsize);
-            assert (tag == oldsize);
-        }
+    uint32_t oldsize = t->size;
+    uint32_t newsize = oldsize << 1;
+
+    if (newsize > TAGPOOL_COUNT)
+        return -1;
+    if (t->grow_cb && t->grow_depth == 0) {
+        t->grow_depth++;
+        t->grow_cb (t->grow_arg, oldsize, newsize);
+        t->grow_depth--;
     }
-    if (tag < t->veb.M)
-        vebdel (t->veb, tag);
-    return tag;
+    return pool_resize (t, newsize);
 }
 
 uint32_t tagpool_alloc (struct tagpool *t)
@@ -122,22 +136,24 @@ uint32_t tagpool_alloc (struct tagpool *t)
     assert (t->magic == TAGPOOL_MAGIC);
     uint32_t tag;
 
-    tag = alloc_with_resize (t);
-    if (tag < t->veb.M) {
-        t->avail--;
-        return tag;
-    }
-    return FLUX_MATCHTAG_NONE;
+    if (t->count > 0)
+        tag = t->stack[--t->count];
+    else if (t->next < t->size || pool_grow (t) == 0)
+        tag = t->next++;
+    else
+        return FLUX_MATCHTAG_NONE;
+    t->used[WORD_INDEX (tag)] |= WORD_BIT (tag);
+    t->avail--;
+    return tag;
 }
 
 void tagpool_free (struct tagpool *t, uint32_t tag)
 {
     assert (t->magic == TAGPOOL_MAGIC);
-    if (tag != FLUX_MATCHTAG_NONE) {
-        if (tag < t->veb.M) {
-            vebput (t->veb, tag);
-            t->avail++;
-        }
+    if (tag != FLUX_MATCHTAG_NONE && tag < t->next && tag_is_used (t, tag)) {
+        t->used[WORD_INDEX (tag)] &= ~WORD_BIT (tag);
+        t->stack[t->count++] = tag;
+        t->avail++;
     }
 }
 
@@ -1209,6 +1209,206 @@ void large_data (void)
     flux_buffer_destroy (fb);
 }
 
+/* Small buffer sizes force data to wrap around the end of the ring.
+ */
+void wrap_buffer (void)
+{
+    flux_buffer_t *fb;
+    int pipefds[2];
+    const char *ptr;
+    char buf[64];
+    int len;
+
+    ok ((fb = flux_buffer_create (16)) != NULL,
+        "wrap: flux_buffer_create works");
+
+    ok (flux_buffer_write (fb, "0123456789", 10) == 10
+        && flux_buffer_drop (fb, 8) == 8,
+        "wrap: write 10 bytes, drop 8");
+    ok (flux_buffer_write (fb, "abc\ndef\nghi", 11) == 11,
+        "wrap: write 11 bytes that wrap");
+    ok (flux_buffer_bytes (fb) == 13 && flux_buffer_space (fb) == 3,
+        "wrap: 13 bytes stored, 3 bytes space");
+    ok (flux_buffer_write (fb, "0123456789", 10) == 3
+        && flux_buffer_drop (fb, -1) == 16,
+        "wrap: short write fills buffer and buffer can be emptied");
+
+    ok (flux_buffer_write (fb, "0123456789", 10) == 10
+        && flux_buffer_drop (fb, 8) == 8
+        && flux_buffer_write (fb, "abc\ndef\nghi", 11) == 11,
+        "wrap: wrapped data written again");
+    ok ((ptr = flux_buffer_peek (fb, -1, &len)) != NULL
+        && len == 13
+        && !strcmp (ptr, "89abc\ndef\nghi"),
+        "wrap: flux_buffer_peek returns wrapped data NUL terminated");
+    ok (flux_buffer_lines (fb) == 2,
+        "wrap: flux_buffer_lines counts lines across wrap");
+    ok ((ptr = flux_buffer_read_line (fb, &len)) != NULL
+        && len == 6
+        && !strcmp (ptr, "89abc\n"),
+        "wrap: flux_buffer_read_line works");
+    ok ((ptr = flux_buffer_peek_trimmed_line (fb, &len)) != NULL
+        && len == 3
+        && !strcmp (ptr, "def"),
+        "wrap: flux_buffer_peek_trimmed_line works");
+    ok ((ptr = flux_buffer_read_trimmed_line (fb, &len)) != NULL
+        && len == 3
+        && !strcmp (ptr, "def"),
+        "wrap: flux_buffer_read_trimmed_line works");
+    ok (!flux_buffer_has_line (fb)
+        && (ptr = flux_buffer_read_line (fb, &len)) != NULL
+        && len == 0,
+        "wrap: no line left");
+    ok (flux_buffer_write_line (fb, "jkl") == 4
+        && flux_buffer_has_line (fb)
+        && (ptr = flux_buffer_read_trimmed_line (fb, &len)) != NULL
+        && len == 6
+        && !strcmp (ptr, "ghijkl"),
+        "wrap: line completed by later write is found");
+
+    ok (pipe (pipefds) == 0,
+        "wrap: pipe succeeded");
+    ok (flux_buffer_write (fb, "0123456789", 10) == 10
+        && flux_buffer_drop (fb, 4) == 4
+        && flux_buffer_write (fb, "abcdefghij", 10) == 10,
+        "wrap: 16 bytes of wrapped data written");
+    ok (flux_buffer_read_to_fd (fb, pipefds[1], -1) == 16,
+        "wrap: flux_buffer_read_to_fd writes wrapped data");
+    ok (read (pipefds[0], buf, sizeof (buf)) == 16
+        && !memcmp (buf, "456789abcdefghij", 16),
+        "wrap: pipe contains expected data");
+    ok (flux_buffer_write (fb, "0123456789", 10) == 10
+        && flux_buffer_drop (fb, 10) == 10
+        && write (pipefds[1], "0123456789abcdef", 16) == 16
+        && flux_buffer_write_from_fd (fb, pipefds[0], -1) == 16,
+        "wrap: flux_buffer_write_from_fd reads into wrapped space");
+    ok ((ptr = flux_buffer_read (fb, -1, &len)) != NULL
+        && len == 16
+        && !strcmp (ptr, "0123456789abcdef"),
+        "wrap: flux_buffer_read returns expected data");
+
+    close (pipefds[0]);
+    close (pipefds[1]);
+    flux_buffer_destroy (fb);
+}
+
+/* Write and read a large amount of data in odd sized chunks so the
+ * ring grows, wraps, and returns both contiguous and copied spans.
+ */
+void grow_buffer (void)
+{
+    flux_buffer_t *fb;
+    int total = 1000000;
+    int written = 0;
+    int readn = 0;
+    int errors = 0;
+    char chunk[7001];
+    const char *ptr;
+    int len;
+    int i;
+
+    ok ((fb = flux_buffer_create (FLUX_BUFFER_TEST_MAXSIZE)) != NULL,
+        "grow: flux_buffer_create works");
+
+    while (readn < total) {
+        int n = (written % 3 + 1) * 2333;
+        if (n > total - written)
+            n = total - written;
+        for (i = 0; i < n; i++)
+            chunk[i] = 'a' + (written + i) % 26;
+        if (n > 0 && flux_buffer_write (fb, chunk, n) != n)
+            break;
+        written += n;
+        if (!(ptr = flux_buffer_read (fb, 4999, &len)))
+            break;
+        for (i = 0; i < len; i++) {
+            if (ptr[i] != 'a' + (readn + i) % 26)
+                errors++;
+        }
+        if (ptr[len] != '\0')
+            errors++;
+        readn += len;
+    }
+    ok (written == total && readn == total && errors == 0,
+        "grow: %d bytes passed through buffer intact", total);
+
+    flux_buffer_destroy (fb);
+}
+
+/* Empty lines must be consumed by trimmed reads, and the newline left
+ * in the ring must not be modified by a trimmed peek or read.
+ */
+void empty_lines (void)
+{
+    flux_buffer_t *fb;
+    const char *ptr;
+    int len;
+
+    ok ((fb = flux_buffer_create (16)) != NULL,
+        "empty: flux_buffer_create works");
+
+    ok (flux_buffer_write (fb, "\n", 1) == 1,
+        "empty: wrote \"\\n\"");
+    ok ((ptr = flux_buffer_peek_trimmed_line (fb, &len)) != NULL
+        && len == 0
+        && !strcmp (ptr, "")
+        && flux_buffer_bytes (fb) == 1
+        && flux_buffer_has_line (fb),
+        "empty: flux_buffer_peek_trimmed_line returns empty line, unconsumed");
+    ok ((ptr = flux_buffer_read_trimmed_line (fb, &len)) != NULL
+        && len == 0
+        && !strcmp (ptr, ""),
+        "empty: flux_buffer_read_trimmed_line returns empty line");
+    ok (flux_buffer_bytes (fb) == 0 && !flux_buffer_has_line (fb),
+        "empty: empty line was consumed");
+
+    ok (flux_buffer_write (fb, "\r\n", 2) == 2,
+        "empty: wrote \"\\r\\n\"");
+    ok ((ptr = flux_buffer_read_trimmed_line (fb, &len)) != NULL
+        && len == 1
+        && !strcmp (ptr, "\r"),
+        "empty: flux_buffer_read_trimmed_line trims only the newline");
+    ok (flux_buffer_bytes (fb) == 0 && !flux_buffer_has_line (fb),
+        "empty: line was consumed");
+
+    ok (flux_buffer_write (fb, "\n\n\nabc\n", 7) == 7,
+        "empty: wrote three empty lines followed by a line");
+    ok (flux_buffer_lines (fb) == 4,
+        "empty: flux_buffer_lines returns 4");
+    ok ((ptr = flux_buffer_read_trimmed_line (fb, &len)) != NULL
+        && len == 0
+        && flux_buffer_bytes (fb) == 6
+        && (ptr = flux_buffer_read_trimmed_line (fb, &len)) != NULL
+        && len == 0
+        && flux_buffer_bytes (fb) == 5,
+        "empty: back-to-back empty lines are each consumed");
+    ok ((ptr = flux_buffer_peek_line (fb, &len)) != NULL
+        && len == 1
+        && !strcmp (ptr, "\n"),
+        "empty: newline of next empty line is intact in the buffer");
+    ok ((ptr = flux_buffer_read_trimmed_line (fb, &len)) != NULL
+        && len == 0
+        && (ptr = flux_buffer_read_trimmed_line (fb, &len)) != NULL
+        && len == 3
+        && !strcmp (ptr, "abc"),
+        "empty: last empty line and following line read");
+    ok (flux_buffer_bytes (fb) == 0 && !flux_buffer_has_line (fb),
+        "empty: buffer is empty");
+
+    ok (flux_buffer_write (fb, "\nabc\n", 5) == 5
+        && (ptr = flux_buffer_read_trimmed_line (fb, &len)) != NULL
+        && len == 0
+        && (ptr = flux_buffer_read_trimmed_line (fb, &len)) != NULL
+        && len == 3
+        && !strcmp (ptr, "abc")
+        && (ptr = flux_buffer_read_trimmed_line (fb, &len)) != NULL
+        && len == 0
+        && flux_buffer_bytes (fb) == 0,
+        "empty: \"\\nabc\\n\" reads an empty line, abc, then nothing");
+
+    flux_buffer_destroy (fb);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -1221,6 +1421,9 @@ int main (int argc, char *argv[])
     full_buffer ();
     readonly_buffer ();
     large_data ();
+    wrap_buffer ();
+    grow_buffer ();
+    empty_lines ();
 
     done_testing();
 
@@ -381,6 +381,33 @@ void test_register ()
     flux_plugin_destroy (p);
 }
 
+void test_generation ()
+{
+    unsigned int gen;
+    flux_plugin_t *p = flux_plugin_create ();
+    if (!p)
+        BAIL_OUT ("flux_plugin_create failed");
+
+    ok (flux_plugin_get_generation (NULL) == 0,
+        "flux_plugin_get_generation (NULL) returns 0");
+    gen = flux_plugin_get_generation (p);
+    ok (flux_plugin_add_handler (p, "op.*", op1, NULL) == 0
+        && flux_plugin_get_generation (p) == gen + 1,
+        "flux_plugin_add_handler increments generation");
+    gen = flux_plugin_get_generation (p);
+    ok (flux_plugin_remove_handler (p, "foo.*") == 0
+        && flux_plugin_get_generation (p) == gen,
+        "removing a nonexistent handler does not change generation");
+    ok (flux_plugin_match_handler (p, "op.add") == op1
+        && flux_plugin_get_generation (p) == gen,
+        "flux_plugin_match_handler does not change generation");
+    ok (flux_plugin_add_handler (p, "op.*", NULL, NULL) == 0
+        && flux_plugin_get_generation (p) == gen + 1,
+        "removing a handler increments generation");
+
+    flux_plugin_destroy (p);
+}
+
 void test_load ()
 {
     char *out;
@@ -446,6 +473,7 @@ int main (int argc, char *argv[])
     test_invalid_args ();
     test_plugin_args ();
     test_basic ();
+    test_generation ();
     test_register ();
     test_load ();
     done_testing();
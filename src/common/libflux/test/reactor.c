@@ -140,6 +140,8 @@ static void fdwriter (flux_reactor_t *r, flux_watcher_t *w,
             if (count == fdwriter_bufsize) {
                 flux_watcher_stop (w);
                 free (buf);
+                buf = NULL;
+                count = 0;
             }
         }
     }
@@ -173,6 +175,8 @@ static void fdreader (flux_reactor_t *r, flux_watcher_t *w,
             if (count == fdwriter_bufsize) {
                 flux_watcher_stop (w);
                 free (buf);
+                buf = NULL;
+                count = 0;
             }
         }
     }
@@ -1442,6 +1446,38 @@ static void reactor_destroy_early (void)
     flux_watcher_destroy (w);
 }
 
+/* Run fd and buffer watcher tests with each backend.  Backends that
+ * are not available on this system fall back to the default.
+ */
+static void test_backend (void)
+{
+    const char *names[] = { "epoll", "poll", "select", "linuxaio", "badname",
+                            NULL };
+    flux_reactor_t *r;
+    int i;
+
+    ok ((r = flux_reactor_create (FLUX_REACTOR_LINUXAIO)) != NULL,
+        "created reactor with LINUXAIO flag");
+    if (!r)
+        BAIL_OUT ("can't continue without reactor");
+    test_fd (r);
+    test_buffer (r);
+    flux_reactor_destroy (r);
+
+    for (i = 0; names[i] != NULL; i++) {
+        if (setenv ("FLUX_REACTOR_BACKEND", names[i], 1) < 0)
+            BAIL_OUT ("setenv failed");
+        ok ((r = flux_reactor_create (0)) != NULL,
+            "created reactor with FLUX_REACTOR_BACKEND=%s", names[i]);
+        if (!r)
+            BAIL_OUT ("can't continue without reactor");
+        test_fd (r);
+        test_buffer (r);
+        flux_reactor_destroy (r);
+    }
+    unsetenv ("FLUX_REACTOR_BACKEND");
+}
+
 int main (int argc, char *argv[])
 {
     flux_reactor_t *reactor;
@@ -1474,6 +1510,8 @@ int main (int argc, char *argv[])
     lives_ok ({ reactor_destroy_early ();},
         "destroying reactor then watcher doesn't segfault");
 
+    test_backend ();
+
     done_testing();
     return (0);
 }
@@ -789,6 +789,226 @@ void test_rpc_message (flux_t *h)
 
 /* Bit of code to test the test framework.
  */
+#define PIPELINE_COUNT 100
+
+struct pipetest {
+    flux_t *h;
+    int next;           // next value to send
+    int count;          // total number of RPCs to send
+    int inflight;
+    int max_inflight;
+    int nresults;
+    int results[PIPELINE_COUNT];
+    int consume_fail_at;
+    int extra;          // RPCs to add from consume after ENODATA
+    bool errors;        // send rpctest.echoerr requests
+};
+
+static flux_future_t *pipetest_produce (flux_future_t *pf, void *arg)
+{
+    struct pipetest *pt = arg;
+    flux_future_t *f;
+
+    if (pt->next == pt->count) {
+        errno = ENODATA;
+        return NULL;
+    }
+    if (pt->errors)
+        f = flux_rpc_pack (pt->h, "rpctest.echoerr", FLUX_NODEID_ANY, 0,
+                           "{s:i}", "errnum", EPERM);
+    else
+        f = flux_rpc_pack (pt->h, "rpctest.incr", FLUX_NODEID_ANY, 0,
+                           "{s:i}", "n", pt->next);
+    if (f) {
+        pt->next++;
+        if (++pt->inflight > pt->max_inflight)
+            pt->max_inflight = pt->inflight;
+    }
+    return f;
+}
+
+static int pipetest_consume (flux_future_t *pf, flux_future_t *f, void *arg)
+{
+    struct pipetest *pt = arg;
+    int n;
+
+    pt->inflight--;
+    if (flux_rpc_get_unpack (f, "{s:i}", "n", &n) < 0)
+        return -1;
+    if (pt->nresults == pt->consume_fail_at) {
+        errno = EEXIST;
+        return -1;
+    }
+    if (pt->nresults < PIPELINE_COUNT)
+        pt->results[pt->nresults] = n - 1;
+    pt->nresults++;
+    if (pt->extra > 0 && pt->next == pt->count) {
+        pt->count++;
+        pt->extra--;
+    }
+    return 0;
+}
+
+static void pipetest_init (struct pipetest *pt, flux_t *h, int count)
+{
+    memset (pt, 0, sizeof (*pt));
+    pt->h = h;
+    pt->count = count;
+    pt->consume_fail_at = -1;
+}
+
+static bool pipetest_results_ordered (struct pipetest *pt)
+{
+    int i;
+    for (i = 0; i < pt->nresults; i++) {
+        if (pt->results[i] != i)
+            return false;
+    }
+    return true;
+}
+
+static bool pipetest_results_complete (struct pipetest *pt)
+{
+    int seen[PIPELINE_COUNT] = { 0 };
+    int i;
+
+    for (i = 0; i < pt->nresults; i++) {
+        if (pt->results[i] < 0
+            || pt->results[i] >= PIPELINE_COUNT
+            || seen[pt->results[i]]++)
+            return false;
+    }
+    return pt->nresults == pt->count;
+}
+
+static void pipeline_then_cb (flux_future_t *f, void *arg)
+{
+    int *rc = arg;
+
+    *rc = flux_future_get (f, NULL);
+    flux_reactor_stop (flux_future_get_reactor (f));
+}
+
+void test_pipeline (flux_t *h)
+{
+    struct pipetest pt;
+    flux_future_t *f;
+    int rc;
+
+    errno = 0;
+    ok (flux_rpc_pipeline (NULL, 1, 0, pipetest_produce, NULL, NULL) == NULL
+        && errno == EINVAL,
+        "flux_rpc_pipeline h=NULL fails with EINVAL");
+    errno = 0;
+    ok (flux_rpc_pipeline (h, 0, 0, pipetest_produce, NULL, NULL) == NULL
+        && errno == EINVAL,
+        "flux_rpc_pipeline window=0 fails with EINVAL");
+    errno = 0;
+    ok (flux_rpc_pipeline (h, 1, 0x10, pipetest_produce, NULL, NULL) == NULL
+        && errno == EINVAL,
+        "flux_rpc_pipeline flags=0x10 fails with EINVAL");
+    errno = 0;
+    ok (flux_rpc_pipeline (h, 1, 0, NULL, NULL, NULL) == NULL
+        && errno == EINVAL,
+        "flux_rpc_pipeline produce=NULL fails with EINVAL");
+
+    /* No work */
+    pipetest_init (&pt, h, 0);
+    f = flux_rpc_pipeline (h, 8, 0, pipetest_produce, pipetest_consume, &pt);
+    ok (f != NULL,
+        "flux_rpc_pipeline with no work works");
+    ok (flux_future_get (f, NULL) == 0,
+        "pipeline with no work is fulfilled");
+    flux_future_destroy (f);
+
+    /* Completion order */
+    pipetest_init (&pt, h, PIPELINE_COUNT);
+    f = flux_rpc_pipeline (h, 8, 0, pipetest_produce, pipetest_consume, &pt);
+    ok (f != NULL,
+        "flux_rpc_pipeline window=8 works");
+    ok (flux_future_get (f, NULL) == 0,
+        "pipeline is fulfilled");
+    ok (pipetest_results_complete (&pt),
+        "all %d responses were consumed exactly once", PIPELINE_COUNT);
+    ok (pt.max_inflight <= 8 && pt.max_inflight > 1,
+        "RPCs in flight (max %d) were bounded by window", pt.max_inflight);
+    flux_future_destroy (f);
+
+    /* Submission order */
+    pipetest_init (&pt, h, PIPELINE_COUNT);
+    f = flux_rpc_pipeline (h, 16, FLUX_PIPELINE_ORDERED,
+                           pipetest_produce, pipetest_consume, &pt);
+    ok (f != NULL,
+        "flux_rpc_pipeline FLUX_PIPELINE_ORDERED works");
+    ok (flux_future_get (f, NULL) == 0,
+        "pipeline is fulfilled");
+    ok (pt.nresults == PIPELINE_COUNT && pipetest_results_ordered (&pt),
+        "responses were consumed in submission order");
+    ok (pt.max_inflight <= 16,
+        "RPCs in flight (max %d) were bounded by window", pt.max_inflight);
+    flux_future_destroy (f);
+
+    /* Window of one */
+    pipetest_init (&pt, h, 10);
+    f = flux_rpc_pipeline (h, 1, 0, pipetest_produce, pipetest_consume, &pt);
+    ok (f != NULL && flux_future_get (f, NULL) == 0,
+        "pipeline window=1 is fulfilled");
+    ok (pt.nresults == 10 && pt.max_inflight == 1
+        && pipetest_results_ordered (&pt),
+        "RPCs were sent one at a time");
+    flux_future_destroy (f);
+
+    /* Work added by consume after produce ran dry */
+    pipetest_init (&pt, h, 1);
+    pt.extra = 9;
+    f = flux_rpc_pipeline (h, 4, 0, pipetest_produce, pipetest_consume, &pt);
+    ok (f != NULL && flux_future_get (f, NULL) == 0,
+        "pipeline with work added by consume is fulfilled");
+    ok (pt.nresults == 10,
+        "produce was called again after returning ENODATA");
+    flux_future_destroy (f);
+
+    /* Asynchronous */
+    pipetest_init (&pt, h, PIPELINE_COUNT);
+    f = flux_rpc_pipeline (h, 8, 0, pipetest_produce, pipetest_consume, &pt);
+    rc = -1;
+    ok (f != NULL && flux_future_then (f, -1., pipeline_then_cb, &rc) == 0,
+        "flux_future_then on pipeline works");
+    ok (flux_reactor_run (flux_get_reactor (h), 0) >= 0,
+        "reactor ran");
+    ok (rc == 0 && pipetest_results_complete (&pt),
+        "pipeline continuation ran after all responses were consumed");
+    flux_future_destroy (f);
+
+    /* consume fails */
+    pipetest_init (&pt, h, PIPELINE_COUNT);
+    pt.consume_fail_at = 50;
+    f = flux_rpc_pipeline (h, 8, 0, pipetest_produce, pipetest_consume, &pt);
+    errno = 0;
+    ok (f != NULL && flux_future_get (f, NULL) < 0 && errno == EEXIST,
+        "pipeline fails with errno from consume");
+    ok (pt.next < PIPELINE_COUNT,
+        "no more RPCs were sent after failure");
+    flux_future_destroy (f);
+
+    /* RPC error without consume */
+    pipetest_init (&pt, h, 10);
+    pt.errors = true;
+    f = flux_rpc_pipeline (h, 8, 0, pipetest_produce, NULL, &pt);
+    errno = 0;
+    ok (f != NULL && flux_future_get (f, NULL) < 0 && errno == EPERM,
+        "pipeline without consume fails with RPC errno");
+    flux_future_destroy (f);
+
+    /* Destroy pipeline with RPCs in flight */
+    pipetest_init (&pt, h, PIPELINE_COUNT);
+    f = flux_rpc_pipeline (h, 8, 0, pipetest_produce, pipetest_consume, &pt);
+    ok (f != NULL && flux_future_wait_for (f, 0.) < 0 && errno == ETIMEDOUT,
+        "pipeline is not ready before it is started");
+    flux_future_destroy (f);
+    diag ("destroyed pipeline before completion");
+}
+
 static int fake_server (flux_t *h, void *arg)
 {
     flux_msg_t *msg;
@@ -862,6 +1082,7 @@ int main (int argc, char *argv[])
     test_multi_response_then_chain (h);
     test_rpc_message_inval (h);
     test_rpc_message (h);
+    test_pipeline (h);
 
     ok (test_server_stop (h) == 0,
         "stopped test server thread");
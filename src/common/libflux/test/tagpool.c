@@ -12,6 +12,72 @@
 #include "src/common/libflux/tagpool.h"
 #include "src/common/libtap/tap.h"
 
+static int grow_count;
+static uint32_t grow_newsize;
+
+static void grow_cb (void *arg, uint32_t oldsize, uint32_t newsize)
+{
+    grow_count++;
+    grow_newsize = newsize;
+}
+
+void test_free_invalid (void)
+{
+    struct tagpool *t;
+    uint32_t tag;
+    uint32_t size;
+
+    if (!(t = tagpool_create ()))
+        BAIL_OUT ("tagpool_create failed");
+    size = tagpool_getattr (t, TAGPOOL_ATTR_SIZE);
+
+    tag = tagpool_alloc (t);
+    ok (tag != FLUX_MATCHTAG_NONE,
+        "invalid: allocated a tag");
+    tagpool_free (t, tag);
+    tagpool_free (t, tag);
+    ok (tagpool_getattr (t, TAGPOOL_ATTR_AVAIL) == size,
+        "invalid: double free does not change avail count");
+    ok (tagpool_alloc (t) == tag && tagpool_alloc (t) != tag,
+        "invalid: double freed tag is only handed out once");
+
+    tagpool_free (t, 1000);
+    tagpool_free (t, 1UL<<24);
+    tagpool_free (t, FLUX_MATCHTAG_NONE);
+    ok (tagpool_getattr (t, TAGPOOL_ATTR_AVAIL) == size - 2,
+        "invalid: freeing unallocated tags does not change avail count");
+
+    tagpool_destroy (t);
+}
+
+void test_grow (void)
+{
+    struct tagpool *t;
+    uint32_t tag;
+    int i;
+
+    if (!(t = tagpool_create ()))
+        BAIL_OUT ("tagpool_create failed");
+    tagpool_set_grow_cb (t, grow_cb, NULL);
+
+    for (i = 0; i < 100000; i++) {
+        if ((tag = tagpool_alloc (t)) == FLUX_MATCHTAG_NONE)
+            break;
+        tagpool_free (t, tag);
+    }
+    ok (i == 100000 && grow_count == 0,
+        "grow: alloc/free cycle does not grow the pool");
+
+    for (i = 0; i < 2000; i++) {
+        if (tagpool_alloc (t) == FLUX_MATCHTAG_NONE)
+            break;
+    }
+    ok (i == 2000 && grow_count == 1 && grow_newsize == 2048,
+        "grow: pool grew once to 2048 with 2000 tags outstanding");
+
+    tagpool_destroy (t);
+}
+
 int main (int argc, char *argv[])
 {
     struct tagpool *t;
@@ -89,6 +155,9 @@ int main (int argc, char *argv[])
 
     tagpool_destroy (t);
 
+    test_free_invalid ();
+    test_grow ();
+
     done_testing ();
     return (0);
 }
@@ -128,6 +128,133 @@ int flux_job_submit_get_id (flux_future_t *f, flux_jobid_t *jobid)
     return 0;
 }
 
+flux_future_t *flux_job_submit_bulk (flux_t *h,
+                                     const char **jobspecs,
+                                     int njobs,
+                                     int count,
+                                     int priority,
+                                     int flags)
+{
+    flux_future_t *f = NULL;
+    json_t *jobs;
+    int saved_errno;
+    int i;
+
+    if (!h || !jobspecs || njobs < 1 || count < 1) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(jobs = json_array ())) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    for (i = 0; i < njobs; i++) {
+        const char *J;
+        char *s = NULL;
+        json_t *o;
+
+        if (!jobspecs[i]) {
+            errno = EINVAL;
+            goto error;
+        }
+        if (!(flags & FLUX_JOB_PRE_SIGNED)) {
+#if HAVE_FLUX_SECURITY
+            flux_security_t *sec;
+            if (!(sec = get_security_ctx (h, &f)))
+                goto error;
+            if (!(J = flux_sign_wrap (sec, jobspecs[i], strlen (jobspecs[i]),
+                                      NULL, 0))) {
+                f = get_security_error (sec);
+                goto error;
+            }
+#else
+            if (!(s = sign_none_wrap (jobspecs[i], strlen (jobspecs[i]),
+                                      getuid ())))
+                goto error;
+            J = s;
+#endif
+        }
+        else
+            J = jobspecs[i];
+        o = json_string (J);
+        free (s);
+        if (!o || json_array_append_new (jobs, o) < 0) {
+            json_decref (o);
+            errno = ENOMEM;
+            goto error;
+        }
+    }
+    flags &= ~FLUX_JOB_PRE_SIGNED; // client only flag
+    if (!(f = flux_rpc_pack (h, "job-ingest.submit-bulk", FLUX_NODEID_ANY, 0,
+                             "{s:O s:i s:i s:i}",
+                             "jobs", jobs,
+                             "count", count,
+                             "priority", priority,
+                             "flags", flags)))
+        goto error;
+    json_decref (jobs);
+    return f;
+error:
+    /* N.B. 'f' may hold a textual security error.
+     */
+    saved_errno = errno;
+    json_decref (jobs);
+    errno = saved_errno;
+    return f;
+}
+
+struct submit_bulk_ids {
+    int count;
+    flux_jobid_t ids[];
+};
+
+int flux_job_submit_bulk_get_ids (flux_future_t *f,
+                                  const flux_jobid_t **ids,
+                                  int *count)
+{
+    const char *auxkey = "flux::job_submit_bulk_ids";
+    struct submit_bulk_ids *result;
+
+    if (!f) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(result = flux_future_aux_get (f, auxkey))) {
+        json_t *a;
+        json_t *entry;
+        size_t index;
+
+        if (flux_rpc_get_unpack (f, "{s:o}", "ids", &a) < 0)
+            return -1;
+        if (!json_is_array (a)) {
+            errno = EPROTO;
+            return -1;
+        }
+        if (!(result = calloc (1, sizeof (*result)
+                                  + json_array_size (a)
+                                    * sizeof (result->ids[0]))))
+            return -1;
+        json_array_foreach (a, index, entry) {
+            if (!json_is_integer (entry)) {
+                free (result);
+                errno = EPROTO;
+                return -1;
+            }
+            result->ids[index] = json_integer_value (entry);
+        }
+        result->count = json_array_size (a);
+        if (flux_future_aux_set (f, auxkey, result, free) < 0) {
+            free (result);
+            return -1;
+        }
+    }
+    if (ids)
+        *ids = result->ids;
+    if (count)
+        *count = result->count;
+    return 0;
+}
+
 flux_future_t *flux_job_wait (flux_t *h, flux_jobid_t id)
 {
     if (!h) {
@@ -102,6 +102,27 @@ flux_future_t *flux_job_submit (flux_t *h, const char *jobspec,
  */
 int flux_job_submit_get_id (flux_future_t *f, flux_jobid_t *id);
 
+/* Submit 'count' instances of each of the 'njobs' jobspecs in 'jobspecs'
+ * with one request.  Each jobspec is signed once, and all instances share
+ * 'priority' and 'flags'.  Either all jobs are accepted, or none are.
+ */
+flux_future_t *flux_job_submit_bulk (flux_t *h,
+                                     const char **jobspecs,
+                                     int njobs,
+                                     int count,
+                                     int priority,
+                                     int flags);
+
+/* Parse jobids from response to flux_job_submit_bulk() request.
+ * The 'ids' array, valid for the life of 'f', holds 'count' jobids:
+ * the instances of jobspecs[0] in order, then those of jobspecs[1], etc.
+ * Returns 0 on success, -1 on failure with errno set - and an extended
+ * error message may be available with flux_future_error_string().
+ */
+int flux_job_submit_bulk_get_ids (flux_future_t *f,
+                                  const flux_jobid_t **ids,
+                                  int *count);
+
 /* Wait for jobid to enter INACTIVE state.
  * If jobid=FLUX_JOBID_ANY, wait for the next waitable job.
  * Fails with ECHILD if there is nothing to wait for.
@@ -114,6 +114,33 @@ void check_corner_case (void)
     ok (flux_job_submit_get_id (NULL, NULL) < 0 && errno == EINVAL,
         "flux_job_submit_get_id with NULL args fails with EINVAL");
 
+    /* flux_job_submit_bulk */
+
+    const char *jobspecs[] = { "{}" };
+
+    errno = 0;
+    ok (flux_job_submit_bulk (NULL, jobspecs, 1, 1, 0, 0) == NULL
+        && errno == EINVAL,
+        "flux_job_submit_bulk h=NULL fails with EINVAL");
+
+    errno = 0;
+    ok (flux_job_submit_bulk (h, NULL, 1, 1, 0, 0) == NULL && errno == EINVAL,
+        "flux_job_submit_bulk jobspecs=NULL fails with EINVAL");
+
+    errno = 0;
+    ok (flux_job_submit_bulk (h, jobspecs, 0, 1, 0, 0) == NULL
+        && errno == EINVAL,
+        "flux_job_submit_bulk njobs=0 fails with EINVAL");
+
+    errno = 0;
+    ok (flux_job_submit_bulk (h, jobspecs, 1, 0, 0, 0) == NULL
+        && errno == EINVAL,
+        "flux_job_submit_bulk count=0 fails with EINVAL");
+
+    errno = 0;
+    ok (flux_job_submit_bulk_get_ids (NULL, NULL, NULL) < 0 && errno == EINVAL,
+        "flux_job_submit_bulk_get_ids f=NULL fails with EINVAL");
+
     /* flux_job_list */
 
     errno = 0;
@@ -32,13 +32,10 @@ static const char *parse_val (const char *s, const char *key)
     return NULL;
 }
 
-int keyval_parse_uint (const char *s, const char *key, unsigned int *val)
+static int parse_uint (const char *cp, unsigned int *val)
 {
-    const char *cp = parse_val (s, key);
     char *endptr;
     unsigned int i;
-    if (!cp)
-        return EKV_NOKEY;
     errno = 0;
     i = strtoul (cp, &endptr, 10);
     if (errno != 0 || (*endptr && !isspace (*endptr)))
@@ -47,13 +44,10 @@ int keyval_parse_uint (const char *s, const char *key, unsigned int *val)
     return EKV_SUCCESS;
 }
 
-int keyval_parse_int (const char *s, const char *key, int *val)
+static int parse_int (const char *cp, int *val)
 {
-    const char *cp = parse_val (s, key);
     char *endptr;
     int i;
-    if (!cp)
-        return EKV_NOKEY;
     errno = 0;
     i = strtol (cp, &endptr, 10);
     if (errno != 0 || (*endptr && !isspace (*endptr)))
@@ -62,11 +56,8 @@ int keyval_parse_int (const char *s, const char *key, int *val)
     return EKV_SUCCESS;
 }
 
-int keyval_parse_word (const char *s, const char *key, char *val, int len)
+static int parse_word (const char *cp, char *val, int len)
 {
-    const char *cp = parse_val (s, key);
-    if (!cp)
-        return EKV_NOKEY;
     while (len > 0 && *cp && !isspace (*cp)) {
         *val++ = *cp++;
         len--;
@@ -77,12 +68,9 @@ int keyval_parse_word (const char *s, const char *key, char *val, int len)
     return EKV_SUCCESS;
 }
 
-int keyval_parse_isword (const char *s, const char *key, const char *match)
+static int parse_isword (const char *cp, const char *match)
 {
     int len = strlen (match);
-    const char *cp = parse_val (s, key);
-    if (!cp)
-        return EKV_NOKEY;
     while (len > 0 && *cp && *cp++ == *match++)
         len--;
     if (len > 0)
@@ -90,11 +78,8 @@ int keyval_parse_isword (const char *s, const char *key, const char *match)
     return EKV_SUCCESS;
 }
 
-int keyval_parse_string (const char *s, const char *key, char *val, int len)
+static int parse_string (const char *cp, char *val, int len)
 {
-    const char *cp = parse_val (s, key);
-    if (!cp)
-        return EKV_NOKEY;
     while (len > 0 && *cp && *cp != '\n') {
         *val++ = *cp++;
         len--;
@@ -105,6 +90,145 @@ int keyval_parse_string (const char *s, const char *key, char *val, int len)
     return EKV_SUCCESS;
 }
 
+int keyval_parse_uint (const char *s, const char *key, unsigned int *val)
+{
+    const char *cp = parse_val (s, key);
+    if (!cp)
+        return EKV_NOKEY;
+    return parse_uint (cp, val);
+}
+
+int keyval_parse_int (const char *s, const char *key, int *val)
+{
+    const char *cp = parse_val (s, key);
+    if (!cp)
+        return EKV_NOKEY;
+    return parse_int (cp, val);
+}
+
+int keyval_parse_word (const char *s, const char *key, char *val, int len)
+{
+    const char *cp = parse_val (s, key);
+    if (!cp)
+        return EKV_NOKEY;
+    return parse_word (cp, val, len);
+}
+
+int keyval_parse_isword (const char *s, const char *key, const char *match)
+{
+    const char *cp = parse_val (s, key);
+    if (!cp)
+        return EKV_NOKEY;
+    return parse_isword (cp, match);
+}
+
+int keyval_parse_string (const char *s, const char *key, char *val, int len)
+{
+    const char *cp = parse_val (s, key);
+    if (!cp)
+        return EKV_NOKEY;
+    return parse_string (cp, val, len);
+}
+
+int keyval_split (struct keyval *kv, const char *s)
+{
+    const char *cp = s;
+
+    kv->count = 0;
+    while (*cp && kv->count < KEYVAL_MAX_FIELDS) {
+        const char *key;
+        const char *eq = NULL;
+
+        while (isspace (*cp))
+            cp++;
+        key = cp;
+        while (*cp && !isspace (*cp)) {
+            if (*cp == '=' && !eq)
+                eq = cp;
+            cp++;
+        }
+        if (eq && eq > key) {
+            struct keyval_field *f = &kv->field[kv->count++];
+            f->key = key;
+            f->keylen = eq - key;
+            f->val = eq + 1;
+            f->vallen = cp - f->val;
+        }
+    }
+    return kv->count;
+}
+
+static const struct keyval_field *lookup (const struct keyval *kv,
+                                          const char *key)
+{
+    int keylen = strlen (key);
+    int i;
+
+    for (i = 0; i < kv->count; i++) {
+        const struct keyval_field *f = &kv->field[i];
+        if (f->keylen == keylen && !memcmp (f->key, key, keylen))
+            return f;
+    }
+    return NULL;
+}
+
+int keyval_get_uint (const struct keyval *kv,
+                     const char *key,
+                     unsigned int *val)
+{
+    const struct keyval_field *f = lookup (kv, key);
+    if (!f)
+        return EKV_NOKEY;
+    return parse_uint (f->val, val);
+}
+
+int keyval_get_int (const struct keyval *kv, const char *key, int *val)
+{
+    const struct keyval_field *f = lookup (kv, key);
+    if (!f)
+        return EKV_NOKEY;
+    return parse_int (f->val, val);
+}
+
+int keyval_get_word (const struct keyval *kv,
+                     const char *key,
+                     char *val,
+                     int len)
+{
+    const struct keyval_field *f = lookup (kv, key);
+    if (!f)
+        return EKV_NOKEY;
+    if (f->vallen >= len)
+        return EKV_VAL_LEN;
+    memcpy (val, f->val, f->vallen);
+    val[f->vallen] = '\0';
+    return EKV_SUCCESS;
+}
+
+int keyval_get_isword (const struct keyval *kv,
+                       const char *key,
+                       const char *match)
+{
+    const struct keyval_field *f = lookup (kv, key);
+    int len = strlen (match);
+    if (!f)
+        return EKV_NOKEY;
+    if (f->vallen != len || memcmp (f->val, match, len))
+        return EKV_VAL_NOMATCH;
+    return EKV_SUCCESS;
+}
+
+int keyval_get_string (const struct keyval *kv,
+                       const char *key,
+                       char *val,
+                       int len)
+{
+    const struct keyval_field *f = lookup (kv, key);
+    if (!f)
+        return EKV_NOKEY;
+    return parse_string (f->val, val, len);
+}
+
 /*
  * vi: ts=4 sw=4 expandtab
  */
@@ -43,6 +43,48 @@ int keyval_parse_word (const char *s, const char *key, char *val, int len);
 int keyval_parse_isword (const char *s, const char *key, const char *match);
 int keyval_parse_string (const char *s, const char *key, char *val, int len);
 
+/* Split a null-terminated input string once into references to its
+ * key=value tuples, so that several keys may be looked up without
+ * rescanning the string.  Tuples beyond KEYVAL_MAX_FIELDS and words
+ * without an = are ignored.  The input string must remain valid while
+ * 'kv' is in use.  Returns the number of tuples found.
+ *
+ * The keyval_get functions behave like their keyval_parse counterparts,
+ * except keyval_get_isword() requires the value to match exactly.
+ * A string value runs from its = to the end of the input line.
+ */
+#define KEYVAL_MAX_FIELDS 16
+
+struct keyval_field {
+    const char *key;
+    int keylen;
+    const char *val;
+    int vallen;
+};
+
+struct keyval {
+    int count;
+    struct keyval_field field[KEYVAL_MAX_FIELDS];
+};
+
+int keyval_split (struct keyval *kv, const char *s);
+
+int keyval_get_int (const struct keyval *kv, const char *key, int *val);
+int keyval_get_uint (const struct keyval *kv,
+                     const char *key,
+                     unsigned int *val);
+int keyval_get_word (const struct keyval *kv,
+                     const char *key,
+                     char *val,
+                     int len);
+int keyval_get_isword (const struct keyval *kv,
+                       const char *key,
+                       const char *match);
+int keyval_get_string (const struct keyval *kv,
+                       const char *key,
+                       char *val,
+                       int len);
+
 #endif /* !_FLUX_PMI_KEYVAL_H */
 
 /*
@@ -173,10 +173,12 @@ static int barrier_exit (struct pmi_simple_server *pmi, int rc)
     struct client *cli;
     int ret = 0;
 
+    /* Same response for every client: format it once.
+     */
+    snprintf (resp, sizeof (resp), "cmd=barrier_out rc=%d\n", rc);
     pmi->local_barrier_count = 0;
     cli = zhashx_first (pmi->clients);
     while (cli) {
-        snprintf (resp, sizeof (resp), "cmd=barrier_out rc=%d\n", rc);
         trace (pmi, cli->arg, "S: %s", resp);
         if (pmi->ops.response_send (cli->arg, resp) < 0)
             ret = -1;
@@ -202,6 +204,7 @@ int pmi_simple_server_request (struct pmi_simple_server *pmi,
     char resp[SIMPLE_MAX_PROTO_LINE+1];
     int rc = 0;
     struct client *cli;
+    struct keyval kv;
 
     if (!(cli = client_hash_lookup (pmi->clients, rank))) {
         if (!(cli = client_create (rank, client)))
@@ -215,6 +218,11 @@ int pmi_simple_server_request (struct pmi_simple_server *pmi,
     resp[0] = '\0';
     trace (pmi, client, "C: %s", buf);
 
+    /* Split the request into key=value references once, rather than
+     * rescanning the whole line for each command and argument.
+     */
+    keyval_split (&kv, buf);
+
     /* spawn continuation (unimplemented) */
     if (cli->mcmd_started) {
         if (strcmp (buf, "endcmd\n") != 0)
@@ -223,11 +231,11 @@ int pmi_simple_server_request (struct pmi_simple_server *pmi,
         cli->mcmd_started = false;
     }
     /* init */
-    else if (keyval_parse_isword (buf, "cmd", "init") == 0) {
+    else if (keyval_get_isword (&kv, "cmd", "init") == 0) {
         unsigned int pmi_version, pmi_subversion;
-        if (keyval_parse_uint (buf, "pmi_version", &pmi_version) < 0)
+        if (keyval_get_uint (&kv, "pmi_version", &pmi_version) < 0)
             goto proto;
-        if (keyval_parse_uint (buf, "pmi_subversion", &pmi_subversion) < 0)
+        if (keyval_get_uint (&kv, "pmi_subversion", &pmi_subversion) < 0)
             goto proto;
         if (pmi_version < 1 || (pmi_version == 1 && pmi_subversion < 1))
             snprintf (resp, sizeof (resp), "cmd=response_to_init rc=-1\n");
@@ -236,13 +244,13 @@ int pmi_simple_server_request (struct pmi_simple_server *pmi,
                       "pmi_version=1 pmi_subversion=1\n");
     }
     /* maxes */
-    else if (keyval_parse_isword (buf, "cmd", "get_maxes") == 0) {
+    else if (keyval_get_isword (&kv, "cmd", "get_maxes") == 0) {
         snprintf (resp, sizeof (resp), "cmd=maxes rc=0 "
                   "kvsname_max=%d keylen_max=%d vallen_max=%d\n",
                   SIMPLE_KVS_NAME_MAX, SIMPLE_KVS_KEY_MAX, SIMPLE_KVS_VAL_MAX);
     }
     /* abort */
-    else if (keyval_parse_isword (buf, "cmd", "abort") == 0) {
+    else if (keyval_get_isword (&kv, "cmd", "abort") == 0) {
         unsigned int code;
         char *msg = "aborted";
         char error_msg[SIMPLE_KVS_VAL_MAX];
@@ -252,9 +260,9 @@ int pmi_simple_server_request (struct pmi_simple_server *pmi,
          *  Older mpich and derivatives just exit from the task,
          *   sending nothing.
          */
-        if (keyval_parse_uint (buf, "exit_code", &code) < 0)
+        if (keyval_get_uint (&kv, "exit_code", &code) < 0)
             goto proto;
-        if (keyval_parse_string (buf,
+        if (keyval_get_string (&kv,
                                  "error_msg",
                                  error_msg,
                                  sizeof (error_msg)) == 0)
@@ -265,31 +273,31 @@ int pmi_simple_server_request (struct pmi_simple_server *pmi,
         /*  Abort call above should kill program, o/w continue as before */
     }
     /* finalize */
-    else if (keyval_parse_isword (buf, "cmd", "finalize") == 0) {
+    else if (keyval_get_isword (&kv, "cmd", "finalize") == 0) {
         snprintf (resp, sizeof (resp), "cmd=finalize_ack rc=0\n");
         rc = 1; /* Indicates fd should be closed */
     }
     /* universe */
-    else if (keyval_parse_isword (buf, "cmd", "get_universe_size") == 0) {
+    else if (keyval_get_isword (&kv, "cmd", "get_universe_size") == 0) {
         snprintf (resp, sizeof (resp), "cmd=universe_size rc=0 size=%d\n",
                   pmi->universe_size);
     }
     /* appnum */
-    else if (keyval_parse_isword (buf, "cmd", "get_appnum") == 0) {
+    else if (keyval_get_isword (&kv, "cmd", "get_appnum") == 0) {
         snprintf (resp, sizeof (resp), "cmd=appnum rc=0 appnum=%d\n",
                   pmi->appnum);
     }
     /* kvsname */
-    else if (keyval_parse_isword (buf, "cmd", "get_my_kvsname") == 0) {
+    else if (keyval_get_isword (&kv, "cmd", "get_my_kvsname") == 0) {
         snprintf (resp, sizeof (resp), "cmd=my_kvsname rc=0 kvsname=%s\n",
                   pmi->kvsname);
     }
     /* put */
-    else if (keyval_parse_isword (buf, "cmd", "put") == 0) {
+    else if (keyval_get_isword (&kv, "cmd", "put") == 0) {
         char name[SIMPLE_KVS_NAME_MAX];
         char key[SIMPLE_KVS_KEY_MAX];
         char val[SIMPLE_KVS_VAL_MAX];
-        int result = keyval_parse_word (buf, "kvsname", name, sizeof (name));
+        int result = keyval_get_word (&kv, "kvsname", name, sizeof (name));
         if (result < 0) {
             if (result == EKV_VAL_LEN) {
                 result = PMI_ERR_INVALID_LENGTH;
@@ -297,7 +305,7 @@ int pmi_simple_server_request (struct pmi_simple_server *pmi,
             }
             goto proto;
         }
-        result = keyval_parse_word (buf, "key", key, sizeof (key));
+        result = keyval_get_word (&kv, "key", key, sizeof (key));
         if (result < 0) {
             if (result == EKV_VAL_LEN) {
                 result = PMI_ERR_INVALID_KEY_LENGTH;
@@ -305,7 +313,7 @@ int pmi_simple_server_request (struct pmi_simple_server *pmi,
             }
             goto proto;
         }
-        result = keyval_parse_string (buf, "value", val, sizeof (val));
+        result = keyval_get_string (&kv, "value", val, sizeof (val));
         if (result < 0) {
             if (result == EKV_VAL_LEN) {
                 result = PMI_ERR_INVALID_VAL_LENGTH;
@@ -319,10 +327,10 @@ put_respond:
         snprintf (resp, sizeof (resp), "cmd=put_result rc=%d\n", result);
     }
     /* get */
-    else if (keyval_parse_isword (buf, "cmd", "get") == 0) {
+    else if (keyval_get_isword (&kv, "cmd", "get") == 0) {
         char name[SIMPLE_KVS_NAME_MAX];
         char key[SIMPLE_KVS_KEY_MAX];
-        int result = keyval_parse_word (buf, "kvsname", name, sizeof (name));
+        int result = keyval_get_word (&kv, "kvsname", name, sizeof (name));
         if (result < 0) {
             if (result == EKV_VAL_LEN) {
                 result = PMI_ERR_INVALID_LENGTH;
@@ -330,7 +338,7 @@ put_respond:
             }
             goto proto;
         }
-        result = keyval_parse_word (buf, "key", key, sizeof (key));
+        result = keyval_get_word (&kv, "key", key, sizeof (key));
         if (result < 0) {
             if (result == EKV_VAL_LEN) {
                 result = PMI_ERR_INVALID_KEY_LENGTH;
@@ -345,7 +353,7 @@ get_respond:
         return (pmi_simple_server_kvs_get_error (pmi, client, result));
     }
     /* barrier */
-    else if (keyval_parse_isword (buf, "cmd", "barrier_in") == 0) {
+    else if (keyval_get_isword (&kv, "cmd", "barrier_in") == 0) {
         if (++pmi->local_barrier_count == pmi->local_size) {
             if (pmi->ops.barrier_enter) {
                 if (pmi->ops.barrier_enter (pmi->arg) < 0)
@@ -357,25 +365,25 @@ get_respond:
         }
     }
     /* publish */
-    else if (keyval_parse_isword (buf, "cmd", "publish_name") == 0) {
+    else if (keyval_get_isword (&kv, "cmd", "publish_name") == 0) {
         /* FIXME - not implemented */
         snprintf (resp, sizeof (resp), "cmd=publish_result rc=-1 msg=%s\n",
                   "command not implemented");
     }
     /* unpublish */
-    else if (keyval_parse_isword (buf, "cmd", "unpublish_name") == 0) {
+    else if (keyval_get_isword (&kv, "cmd", "unpublish_name") == 0) {
         /* FIXME - not implemented */
         snprintf (resp, sizeof (resp), "cmd=unpublish_result rc=-1 msg=%s\n",
                   "command not implemented");
     }
     /* lookup */
-    else if (keyval_parse_isword (buf, "cmd", "lookup_name") == 0) {
+    else if (keyval_get_isword (&kv, "cmd", "lookup_name") == 0) {
         /* FIXME - not implemented */
         snprintf (resp, sizeof (resp), "cmd=lookup_result rc=-1 msg=%s\n",
                   "command not implemented");
     }
     /* spawn */
-    else if (keyval_parse_isword (buf, "mcmd", "spawn") == 0) {
+    else if (keyval_get_isword (&kv, "mcmd", "spawn") == 0) {
         /* FIXME - not implemented */
         cli->mcmd_started = true;
         goto out_noresponse;
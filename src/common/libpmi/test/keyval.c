@@ -79,6 +79,65 @@ static char *spawn[] = {
     NULL,
 };
 
+static void test_split (void)
+{
+    struct keyval kv;
+    char val[42];
+    int i;
+    unsigned int ui;
+
+    ok (keyval_split (&kv, "") == 0,
+        "keyval_split found no tuples in empty string");
+    ok (keyval_split (&kv, "endcmd\n") == 0,
+        "keyval_split ignored word without =");
+    ok (keyval_split (&kv, valid[6]) == 6,
+        "keyval_split found 6 tuples");
+    ok (keyval_get_word (&kv, "key5", val, sizeof (val)) == EKV_SUCCESS
+        && !strcmp (val, "foo=bar"),
+        "keyval_get_word handled value containing an equals");
+    ok (keyval_get_word (&kv, "key6", val, sizeof (val)) == EKV_SUCCESS
+        && !strcmp (val, "baz"),
+        "keyval_get_word parsed last word, ignoring trailing newline");
+    ok (keyval_get_word (&kv, "key6", val, 3) == EKV_VAL_LEN,
+        "keyval_get_word failed with EKV_VAL_LEN on short buffer");
+    ok (keyval_get_int (&kv, "key4", &i) == EKV_SUCCESS && i == -42,
+        "keyval_get_int worked on negative integer");
+    ok (keyval_get_uint (&kv, "key3", &ui) == EKV_SUCCESS && ui == 42,
+        "keyval_get_uint worked");
+    ok (keyval_get_int (&kv, "key1", &i) == EKV_VAL_PARSE,
+        "keyval_get_int failed with EKV_VAL_PARSE on non-integer");
+    ok (keyval_get_word (&kv, "key", val, sizeof (val)) == EKV_NOKEY,
+        "keyval_get_word failed on key that is prefix of another key");
+
+    ok (keyval_split (&kv, valid[7]) == 8,
+        "keyval_split found 8 tuples (including one inside string value)");
+    ok (keyval_get_string (&kv, "key7", val, sizeof (val)) == EKV_SUCCESS
+        && !strcmp (val, "x y z="),
+        "keyval_get_string parsed string containing space and equals");
+
+    ok (keyval_split (&kv, valid[9]) == 1
+        && keyval_get_word (&kv, "key1", val, sizeof (val)) == EKV_NOKEY,
+        "keyval_get_word failed on key that is substring of another key");
+
+    ok (keyval_split (&kv, pmi[2]) == 1
+        && keyval_get_isword (&kv, "cmd", "get_maxes") == EKV_SUCCESS
+        && keyval_get_isword (&kv, "cmd", "get") == EKV_VAL_NOMATCH
+        && keyval_get_isword (&kv, "mcmd", "get") == EKV_NOKEY,
+        "keyval_get_isword requires exact match");
+    ok (keyval_split (&kv, pmi[14]) == 4
+        && keyval_get_isword (&kv, "cmd", "put") == EKV_SUCCESS
+        && keyval_get_word (&kv, "kvsname", val, sizeof (val)) == EKV_SUCCESS
+        && !strcmp (val, "lwj.1.pmi")
+        && keyval_get_word (&kv, "key", val, sizeof (val)) == EKV_SUCCESS
+        && !strcmp (val, "PM")
+        && keyval_get_string (&kv, "value", val, sizeof (val)) == EKV_SUCCESS
+        && !strcmp (val, "/dev/shm/mpich_shar_tmpYbGKbb"),
+        "split and parsed pmi-1 put request");
+    ok (keyval_split (&kv, spawn[0]) == 1
+        && keyval_get_isword (&kv, "mcmd", "spawn") == EKV_SUCCESS,
+        "split and parsed pmi-1 spawn mcmd request");
+}
+
 int main(int argc, char** argv)
 {
     char val[42];
@@ -302,6 +361,8 @@ int main(int argc, char** argv)
         && !strcmp (val, "0,0"),
         "parsed pmi-1 spawn response");
 
+    test_split ();
+
     done_testing();
 }
 
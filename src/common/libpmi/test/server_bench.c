@@ -0,0 +1,215 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* server_bench - measure PMI-1 simple server protocol overhead
+ *
+ * Usage: test_server_bench [--ranks N] [--cycles N] [--keys N]
+ *
+ * Simulate N local ranks talking to one simple server, as in a job shell
+ * during MPI init: each rank does init, get_maxes and get_my_kvsname,
+ * then each cycle every rank puts 'keys' values, enters a barrier, and
+ * gets the values put by its neighbor.  The KVS is a local hash and the
+ * barrier completes immediately, so the time reported is spent in the
+ * protocol engine and its callbacks.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <czmq.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libpmi/simple_server.h"
+
+#define OPTIONS "r:c:k:"
+static const struct option longopts[] = {
+    {"ranks",   required_argument,  0, 'r'},
+    {"cycles",  required_argument,  0, 'c'},
+    {"keys",    required_argument,  0, 'k'},
+    {0, 0, 0, 0},
+};
+
+struct bench {
+    struct pmi_simple_server *server;
+    zhashx_t *kvs;
+    int responses;
+    int errors;
+};
+
+struct client {
+    struct bench *b;
+    int rank;
+};
+
+static int bench_kvs_put (void *arg,
+                          const char *kvsname,
+                          const char *key,
+                          const char *val)
+{
+    struct bench *b = arg;
+
+    zhashx_update (b->kvs, key, (char *)val);
+    return 0;
+}
+
+static int bench_kvs_get (void *arg,
+                          void *cli,
+                          const char *kvsname,
+                          const char *key)
+{
+    struct bench *b = arg;
+
+    return pmi_simple_server_kvs_get_complete (b->server,
+                                               cli,
+                                               zhashx_lookup (b->kvs, key));
+}
+
+static int bench_response_send (void *client, const char *buf)
+{
+    struct client *cli = client;
+
+    cli->b->responses++;
+    if (!strstr (buf, "rc=0"))
+        cli->b->errors++;
+    return 0;
+}
+
+static void *value_duplicator (const void *item)
+{
+    return strdup (item);
+}
+
+static void value_destructor (void **item)
+{
+    if (*item) {
+        free (*item);
+        *item = NULL;
+    }
+}
+
+static void request (struct bench *b, struct client *cli, const char *fmt, ...)
+{
+    char buf[SIMPLE_MAX_PROTO_LINE + 1];
+    va_list ap;
+
+    va_start (ap, fmt);
+    vsnprintf (buf, sizeof (buf), fmt, ap);
+    va_end (ap);
+    if (pmi_simple_server_request (b->server, buf, cli, cli->rank) < 0)
+        log_err_exit ("pmi_simple_server_request: %s", buf);
+}
+
+int main (int argc, char *argv[])
+{
+    struct pmi_simple_ops ops = {
+        .kvs_put = bench_kvs_put,
+        .kvs_get = bench_kvs_get,
+        .response_send = bench_response_send,
+    };
+    struct bench b = { 0 };
+    struct client *clients;
+    struct timespec t0;
+    double elapsed;
+    int ranks = 128;
+    int cycles = 4;
+    int keys = 16;
+    int expected;
+    int ch;
+    int i, j, k;
+
+    log_init ("test_server_bench");
+
+    while ((ch = getopt_long (argc, argv, OPTIONS, longopts, NULL)) != -1) {
+        switch (ch) {
+            case 'r':   /* --ranks N */
+                ranks = strtoul (optarg, NULL, 10);
+                break;
+            case 'c':   /* --cycles N */
+                cycles = strtoul (optarg, NULL, 10);
+                break;
+            case 'k':   /* --keys N */
+                keys = strtoul (optarg, NULL, 10);
+                break;
+            default:
+                log_msg_exit ("Usage: test_server_bench "
+                              "[--ranks N] [--cycles N] [--keys N]");
+        }
+    }
+    if (ranks < 2 || cycles < 1 || keys < 1)
+        log_msg_exit ("invalid argument");
+
+    if (!(b.kvs = zhashx_new ()))
+        log_msg_exit ("zhashx_new failed");
+    zhashx_set_destructor (b.kvs, value_destructor);
+    zhashx_set_duplicator (b.kvs, value_duplicator);
+    if (!(b.server = pmi_simple_server_create (ops,
+                                               0,
+                                               ranks,
+                                               ranks,
+                                               "bench",
+                                               0,
+                                               &b)))
+        log_err_exit ("pmi_simple_server_create");
+    if (!(clients = calloc (ranks, sizeof (*clients))))
+        log_err_exit ("calloc");
+
+    monotime (&t0);
+    for (i = 0; i < ranks; i++) {
+        clients[i].b = &b;
+        clients[i].rank = i;
+        request (&b, &clients[i],
+                 "cmd=init pmi_version=1 pmi_subversion=1\n");
+        request (&b, &clients[i], "cmd=get_maxes\n");
+        request (&b, &clients[i], "cmd=get_my_kvsname\n");
+    }
+    for (j = 0; j < cycles; j++) {
+        for (i = 0; i < ranks; i++) {
+            for (k = 0; k < keys; k++)
+                request (&b, &clients[i],
+                         "cmd=put kvsname=bench key=%d.%d.%d "
+                         "value=business-card-%d-%d-%d\n",
+                         j, i, k, j, i, k);
+        }
+        for (i = 0; i < ranks; i++)
+            request (&b, &clients[i], "cmd=barrier_in\n");
+        for (i = 0; i < ranks; i++) {
+            for (k = 0; k < keys; k++)
+                request (&b, &clients[i],
+                         "cmd=get kvsname=bench key=%d.%d.%d\n",
+                         j, (i + 1) % ranks, k);
+        }
+    }
+    elapsed = monotime_since (t0) / 1000.;
+
+    expected = ranks * (3 + cycles * (keys * 2 + 1));
+    if (b.responses != expected || b.errors > 0)
+        log_msg_exit ("got %d responses (%d errors), expected %d",
+                      b.responses, b.errors, expected);
+    printf ("%d ranks x %d cycles x %d keys: %d requests in %.3fs (%.0f/s)\n",
+            ranks, cycles, keys,
+            expected, elapsed, elapsed > 0. ? expected / elapsed : 0.);
+
+    free (clients);
+    pmi_simple_server_destroy (b.server);
+    zhashx_destroy (&b.kvs);
+    log_fini ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -13,9 +13,14 @@
 #endif
 
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <wait.h>
 #include <unistd.h>
 #include <errno.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <czmq.h>
 
@@ -498,8 +503,8 @@ static int local_child (flux_subprocess_t *p)
             _exit (1);
     }
 
-    // Send ready to parent
-    if (local_child_ready (p) < 0)
+    // Send ready to parent, if parent has a post_fork hook to run
+    if (p->hooks.post_fork && local_child_ready (p) < 0)
         _exit (1);
 
     // Close fds
@@ -618,10 +623,9 @@ static int local_fork (flux_subprocess_t *p)
 
     flux_watcher_start (p->child_w);
 
-    if (subprocess_parent_wait_on_child (p) < 0)
-        return -1;
-
     if (p->hooks.post_fork) {
+        if (subprocess_parent_wait_on_child (p) < 0)
+            return -1;
         /* always a chance caller may destroy subprocess in callback */
         flux_subprocess_ref (p);
         p->in_hook = true;
@@ -633,9 +637,10 @@ static int local_fork (flux_subprocess_t *p)
     return (0);
 }
 
-/*  Signal child to proceed with exec(2) and read any error from exec
- *   back on sync_fds.  Return < 0 on failure to signal, or > 0 errnum if
- *   an exec error was returned from child.
+/*  Signal child to proceed with exec(2), if it is waiting for the
+ *   post_fork hook, and read any error from exec back on sync_fds.
+ *   Return < 0 on failure to signal, or > 0 errnum if an exec error
+ *   was returned from child.
  */
 static int local_release_child (flux_subprocess_t *p)
 {
@@ -644,7 +649,7 @@ static int local_release_child (flux_subprocess_t *p)
     int e = 0;
     ssize_t n;
 
-    if (write (fd, &c, sizeof (c)) != 1)
+    if (p->hooks.post_fork && write (fd, &c, sizeof (c)) != 1)
         return -1;
     if ((n = read (fd, &e, sizeof (e))) < 0)
         return -1;
@@ -706,16 +711,215 @@ static int start_local_watchers (flux_subprocess_t *p)
     return 0;
 }
 
+/*  posix_spawn(3) can replace fork(2) and the child code above when
+ *   nothing has to run between fork and exec: no hooks and no working
+ *   directory to change to (local_child() falls back to /tmp, which
+ *   posix_spawn cannot do).  It avoids copying the parent's page tables
+ *   and the two round trips on sync_fds, which dominate launch time
+ *   for many small tasks from a large parent.
+ */
+static bool local_spawn_ok (flux_subprocess_t *p)
+{
+    return (!p->hooks.pre_exec
+            && !p->hooks.post_fork
+            && !flux_cmd_getcwd (p->cmd));
+}
+
+struct spawn_fds {
+    flux_subprocess_t *p;
+    posix_spawn_file_actions_t *fa;
+    int rc;
+};
+
+/*  Called in the parent for each open fd.  Close in the child all but
+ *   stdio and the child side of channels, as closefd_child() does.
+ */
+static void spawn_closefd (void *arg, int fd)
+{
+    struct spawn_fds *sf = arg;
+    struct subprocess_channel *c;
+
+    if (fd < 3 || sf->rc != 0)
+        return;
+    c = zhash_first (sf->p->channels);
+    while (c) {
+        if (c->child_fd == fd)
+            return;
+        c = zhash_next (sf->p->channels);
+    }
+    sf->rc = posix_spawn_file_actions_addclose (sf->fa, fd);
+}
+
+static int spawn_setup_stdio (flux_subprocess_t *p,
+                              posix_spawn_file_actions_t *fa)
+{
+    struct subprocess_channel *c;
+    int rc;
+
+    if (p->flags & FLUX_SUBPROCESS_FLAGS_STDIO_FALLTHROUGH)
+        return 0;
+    if ((c = zhash_lookup (p->channels, "stdin"))
+        && (rc = posix_spawn_file_actions_adddup2 (fa,
+                                                   c->child_fd,
+                                                   STDIN_FILENO)))
+        return rc;
+    if ((c = zhash_lookup (p->channels, "stdout")))
+        rc = posix_spawn_file_actions_adddup2 (fa, c->child_fd, STDOUT_FILENO);
+    else
+        rc = posix_spawn_file_actions_addclose (fa, STDOUT_FILENO);
+    if (rc)
+        return rc;
+    if ((c = zhash_lookup (p->channels, "stderr")))
+        rc = posix_spawn_file_actions_adddup2 (fa, c->child_fd, STDERR_FILENO);
+    else
+        rc = posix_spawn_file_actions_addclose (fa, STDERR_FILENO);
+    return rc;
+}
+
+/*  Search for 'name' in the command's PATH, as execvp(3) in the child
+ *   would after environ is replaced with the command environment.
+ *   posix_spawnp(3) would search the parent's PATH instead.
+ *  Return a malloc'd path, or NULL with errno set to ENOENT or EACCES
+ *   (or ENOMEM).
+ */
+static char *spawn_resolve_path (flux_subprocess_t *p, const char *name)
+{
+    const char *path;
+    const char *dir;
+    bool eacces = false;
+
+    if (strchr (name, '/'))
+        return strdup (name);
+    if (!(path = flux_cmd_getenv (p->cmd, "PATH")))
+        path = "/bin:/usr/bin";
+    dir = path;
+    while (dir) {
+        const char *end = strchr (dir, ':');
+        int dirlen = end ? end - dir : strlen (dir);
+        struct stat sb;
+        char *file;
+
+        /* An empty PATH element means the current directory */
+        if (asprintf (&file,
+                      "%.*s%s%s",
+                      dirlen,
+                      dir,
+                      dirlen > 0 ? "/" : "",
+                      name) < 0) {
+            errno = ENOMEM;
+            return NULL;
+        }
+        if (stat (file, &sb) == 0 && S_ISREG (sb.st_mode)) {
+            if (access (file, X_OK) == 0)
+                return file;
+            eacces = true;
+        }
+        else if (errno == EACCES)
+            eacces = true;
+        free (file);
+        dir = end ? end + 1 : NULL;
+    }
+    errno = eacces ? EACCES : ENOENT;
+    return NULL;
+}
+
+static int local_spawn (flux_subprocess_t *p)
+{
+    posix_spawn_file_actions_t fa;
+    posix_spawnattr_t attr;
+    struct spawn_fds sf = { .p = p, .fa = &fa, .rc = 0 };
+    short attr_flags = POSIX_SPAWN_SETSIGMASK;
+    sigset_t mask;
+    char **env = NULL;
+    char **argv = NULL;
+    char *file = NULL;
+    int rc = -1;
+    int e;
+
+    if ((e = posix_spawn_file_actions_init (&fa))) {
+        errno = e;
+        return -1;
+    }
+    if ((e = posix_spawnattr_init (&attr))) {
+        posix_spawn_file_actions_destroy (&fa);
+        errno = e;
+        return -1;
+    }
+    sigemptyset (&mask);
+    if (p->flags & FLUX_SUBPROCESS_FLAGS_SETPGRP)
+        attr_flags |= POSIX_SPAWN_SETPGROUP;
+    if ((e = posix_spawnattr_setsigmask (&attr, &mask))
+        || (e = posix_spawnattr_setflags (&attr, attr_flags))
+        || (e = spawn_setup_stdio (p, &fa)))
+        goto out;
+    if (fdwalk (spawn_closefd, &sf) < 0) {
+        e = errno;
+        goto out;
+    }
+    if ((e = sf.rc))
+        goto out;
+    if (!(env = flux_cmd_env_expand (p->cmd))
+        || !(argv = flux_cmd_argv_expand (p->cmd))) {
+        e = ENOMEM;
+        goto out;
+    }
+    if (!(file = spawn_resolve_path (p, argv[0]))) {
+        e = errno;
+        if (e != ENOMEM)
+            p->exec_failed_errno = e;
+        goto out;
+    }
+    if ((e = posix_spawn (&p->pid, file, &fa, &attr, argv, env))) {
+        /*  exec(2) failed in the child, which has been reaped.
+         *   Spiritually FLUX_SUBPROCESS_EXEC_FAILED, as in local_exec().
+         */
+        p->exec_failed_errno = e;
+        goto out;
+    }
+    p->pid_set = true;
+    close_child_fds (p);
+    close (p->sync_fds[0]);
+    p->sync_fds[0] = -1;
+
+    if (!(p->child_w = flux_child_watcher_create (p->reactor,
+                                                  p->pid,
+                                                  true,
+                                                  child_watch_cb,
+                                                  p))) {
+        e = errno;
+        flux_log_error (p->h, "flux_child_watcher_create");
+        goto out;
+    }
+    flux_watcher_start (p->child_w);
+    p->state = FLUX_SUBPROCESS_RUNNING;
+    rc = 0;
+out:
+    free (file);
+    free (env);
+    free (argv);
+    posix_spawnattr_destroy (&attr);
+    posix_spawn_file_actions_destroy (&fa);
+    if (rc < 0)
+        errno = e;
+    return rc;
+}
+
 int subprocess_local_setup (flux_subprocess_t *p)
 {
     if (local_setup_stdio (p) < 0)
         return -1;
     if (local_setup_channels (p) < 0)
         return -1;
-    if (local_fork (p) < 0)
-        return -1;
-    if (local_exec (p) < 0)
-        return -1;
+    if (local_spawn_ok (p)) {
+        if (local_spawn (p) < 0)
+            return -1;
+    }
+    else {
+        if (local_fork (p) < 0)
+            return -1;
+        if (local_exec (p) < 0)
+            return -1;
+    }
     if (start_local_watchers (p) < 0)
         return -1;
     return 0;
@@ -16,6 +16,7 @@
 #include <wait.h>
 #include <unistd.h>
 #include <errno.h>
+#include <string.h>
 
 #include <czmq.h>
 #include <sodium.h>
@@ -573,32 +574,21 @@ static int remote_state (flux_subprocess_t *p, flux_future_t *f,
     return 0;
 }
 
-static int remote_output (flux_subprocess_t *p, flux_future_t *f,
-                          int rank, pid_t pid)
+static int remote_output_buffer (flux_subprocess_t *p,
+                                 const char *stream,
+                                 const char *data,
+                                 int len,
+                                 bool eof,
+                                 int rank,
+                                 pid_t pid)
 {
     struct subprocess_channel *c;
-    const char *stream = NULL;
-    char *data = NULL;
-    int len = 0;
-    bool eof = false;
-    json_t *io = NULL;
-    int rv = -1;
-
-    if (flux_rpc_get_unpack (f, "{ s:o }", "io", &io)) {
-        flux_log_error (p->h, "flux_rpc_get_unpack EPROTO io");
-        goto cleanup;
-    }
-
-    if (iodecode (io, &stream, NULL, &data, &len, &eof) < 0) {
-        flux_log_error (p->h, "iodecode");
-        goto cleanup;
-    }
 
     if (!(c = zhash_lookup (p->channels, stream))) {
         flux_log_error (p->h, "invalid channel received: rank = %d, pid = %d, stream = %s",
                  rank, pid, stream);
         errno = EPROTO;
-        goto cleanup;
+        return -1;
     }
 
     if (data && len) {
@@ -606,7 +596,7 @@ static int remote_output (flux_subprocess_t *p, flux_future_t *f,
 
         if ((tmp = flux_buffer_write (c->read_buffer, data, len)) < 0) {
             flux_log_error (p->h, "flux_buffer_write");
-            goto cleanup;
+            return -1;
         }
 
         /* add list of msgs if there is overflow? */
@@ -615,7 +605,7 @@ static int remote_output (flux_subprocess_t *p, flux_future_t *f,
             flux_log_error (p->h, "channel buffer error: rank = %d pid = %d, stream = %s, len = %d",
                             rank, pid, stream, len);
             errno = EOVERFLOW;
-            goto cleanup;
+            return -1;
         }
     }
     if (eof) {
@@ -623,6 +613,31 @@ static int remote_output (flux_subprocess_t *p, flux_future_t *f,
         if (flux_buffer_readonly (c->read_buffer) < 0)
             flux_log_error (p->h, "flux_buffer_readonly");
     }
+    return 0;
+}
+
+static int remote_output (flux_subprocess_t *p, flux_future_t *f,
+                          int rank, pid_t pid)
+{
+    const char *stream = NULL;
+    char *data = NULL;
+    int len = 0;
+    bool eof = false;
+    json_t *io = NULL;
+    int rv = -1;
+
+    if (flux_rpc_get_unpack (f, "{ s:o }", "io", &io)) {
+        flux_log_error (p->h, "flux_rpc_get_unpack EPROTO io");
+        goto cleanup;
+    }
+
+    if (iodecode (io, &stream, NULL, &data, &len, &eof) < 0) {
+        flux_log_error (p->h, "iodecode");
+        goto cleanup;
+    }
+
+    if (remote_output_buffer (p, stream, data, len, eof, rank, pid) < 0)
+        goto cleanup;
 
     rv = 0;
 cleanup:
@@ -630,6 +645,32 @@ cleanup:
     return rv;
 }
 
+/* Decode a raw output response, see RAW_OUTPUT_DATA in
+ * subprocess_private.h.
+ */
+static int remote_output_raw (flux_subprocess_t *p,
+                              const char *payload,
+                              int payload_len)
+{
+    const char *stream = payload + 1;
+    const char *end;
+
+    if ((payload[0] != RAW_OUTPUT_DATA && payload[0] != RAW_OUTPUT_EOF)
+        || !(end = memchr (stream, '\0', payload_len - 1))) {
+        flux_log (p->h, LOG_ERR, "%s: malformed raw output", __FUNCTION__);
+        errno = EPROTO;
+        return -1;
+    }
+    end++;
+    return remote_output_buffer (p,
+                                 stream,
+                                 end,
+                                 payload_len - (end - payload),
+                                 payload[0] == RAW_OUTPUT_EOF,
+                                 p->rank,
+                                 p->pid);
+}
+
 static void remote_completion (flux_subprocess_t *p)
 {
     p->remote_completed = true;
@@ -642,10 +683,24 @@ static void remote_completion (flux_subprocess_t *p)
 static void remote_exec_cb (flux_future_t *f, void *arg)
 {
     flux_subprocess_t *p = arg;
+    const void *payload;
+    int payload_len;
     const char *type;
     int rank;
     pid_t pid;
 
+    /* Raw output responses are distinguished from JSON responses,
+     * which are always objects, by their first byte.
+     */
+    if (flux_rpc_get_raw (f, &payload, &payload_len) == 0
+        && payload_len > 0
+        && ((const char *)payload)[0] != '{') {
+        if (remote_output_raw (p, payload, payload_len) < 0)
+            goto error;
+        flux_future_reset (f);
+        return;
+    }
+
     if (flux_rpc_get_unpack (f, "{ s:s s:i }",
                              "type", &type,
                              "rank", &rank) < 0) {
@@ -757,11 +812,12 @@ int remote_exec (flux_subprocess_t *p)
      * don't care if user doesn't want it.
      */
     if (!(f = flux_rpc_pack (p->h, "cmb.rexec", p->rank, 0,
-                             "{s:s s:i s:i s:i}",
+                             "{s:s s:i s:i s:i s:i}",
                              "cmd", cmd_str,
                              "on_channel_out", p->ops.on_channel_out ? 1 : 0,
                              "on_stdout", p->ops.on_stdout ? 1 : 0,
-                             "on_stderr", p->ops.on_stderr ? 1 : 0))) {
+                             "on_stderr", p->ops.on_stderr ? 1 : 0,
+                             "raw_output", 1))) {
         flux_log_error (p->h, "flux_rpc");
         goto error;
     }
@@ -16,6 +16,7 @@
 #include <wait.h>
 #include <unistd.h>
 #include <errno.h>
+#include <string.h>
 
 #include <czmq.h>
 #include <sodium.h>
@@ -37,28 +38,121 @@
 
 static const char *auxkey = "flux::rexec";
 
+/* Output read from a subprocess is accumulated per stream and sent to
+ * the client when OUTPUT_COALESCE_SIZE bytes are pending, or
+ * OUTPUT_COALESCE_DELAY seconds after unsent data first arrived,
+ * whichever comes first.  A line buffered stream is only sent on a line
+ * boundary, unless a partial line alone reaches OUTPUT_COALESCE_SIZE.
+ * Pending output is always sent before EOF and state responses, so the
+ * client sees the same order of events as without coalescing.
+ */
+#define OUTPUT_COALESCE_SIZE    65536
+#define OUTPUT_COALESCE_DELAY   0.001
+
+struct rexec_stream {
+    char *name;
+    char *buf;                      // raw header (if raw) + pending data
+    int hdrlen;                     // length of raw header
+    int len;                        // length of pending data
+    int size;                       // allocated size of buf
+    bool line_buffered;
+    bool coalesce;
+};
+
 struct rexec {
     const flux_msg_t *msg;          // rexec request message
     flux_subprocess_server_t *s;    // server context
+    bool raw_output;                // send output as raw payload
+    zhash_t *streams;               // struct rexec_stream by name
+    flux_watcher_t *output_timer;
+    bool output_timer_armed;
 };
 
+static void rexec_stream_destroy (void *arg)
+{
+    struct rexec_stream *st = arg;
+
+    if (st) {
+        ERRNO_SAFE_WRAP (free, st->name);
+        ERRNO_SAFE_WRAP (free, st->buf);
+        ERRNO_SAFE_WRAP (free, st);
+    }
+}
+
+static struct rexec_stream *rexec_stream_create (const char *name, bool raw)
+{
+    struct rexec_stream *st;
+
+    if (!(st = calloc (1, sizeof (*st))))
+        return NULL;
+    if (!(st->name = strdup (name)))
+        goto error;
+    /* The raw output header is a type byte followed by the NUL
+     * terminated stream name.  It is written once here and sent in
+     * place, ahead of the data.
+     */
+    if (raw)
+        st->hdrlen = strlen (name) + 2;
+    st->size = st->hdrlen + 4096;
+    if (!(st->buf = malloc (st->size)))
+        goto error;
+    if (raw) {
+        st->buf[0] = RAW_OUTPUT_DATA;
+        strcpy (st->buf + 1, name);
+    }
+    st->coalesce = true;
+    return st;
+error:
+    rexec_stream_destroy (st);
+    return NULL;
+}
+
+static int rexec_stream_append (struct rexec_stream *st,
+                                const char *data,
+                                int len)
+{
+    if (st->hdrlen + st->len + len > st->size) {
+        int size = st->size;
+        char *buf;
+
+        while (st->hdrlen + st->len + len > size)
+            size *= 2;
+        if (!(buf = realloc (st->buf, size)))
+            return -1;
+        st->buf = buf;
+        st->size = size;
+    }
+    memcpy (st->buf + st->hdrlen + st->len, data, len);
+    st->len += len;
+    return 0;
+}
+
 static void rexec_destroy (struct rexec *rex)
 {
     if (rex) {
         flux_msg_decref (rex->msg);
+        zhash_destroy (&rex->streams);
+        flux_watcher_destroy (rex->output_timer);
         ERRNO_SAFE_WRAP (free, rex);
     }
 }
 
 static struct rexec *rexec_create (const flux_msg_t *msg,
-                                   flux_subprocess_server_t *s)
+                                   flux_subprocess_server_t *s,
+                                   bool raw_output)
 {
     struct rexec *rex;
 
-    if ((rex = calloc (1, sizeof (*rex)))) {
-        rex->msg = flux_msg_incref (msg);
-        rex->s = s;
+    if (!(rex = calloc (1, sizeof (*rex))))
+        return NULL;
+    if (!(rex->streams = zhash_new ())) {
+        free (rex);
+        errno = ENOMEM;
+        return NULL;
     }
+    rex->msg = flux_msg_incref (msg);
+    rex->s = s;
+    rex->raw_output = raw_output;
     return rex;
 }
 
@@ -137,6 +231,96 @@ cleanup:
     return p;
 }
 
+/* Send the first 'len' bytes of pending output on stream 'st', and
+ * EOF if 'eof' is true.  Unsent data is kept for the next response.
+ */
+static int rexec_output (flux_subprocess_t *p,
+                         struct rexec *rex,
+                         struct rexec_stream *st,
+                         int len,
+                         bool eof)
+{
+    flux_subprocess_server_t *s = rex->s;
+    char *data = st->buf + st->hdrlen;
+    json_t *io = NULL;
+    char rankstr[64];
+    int rv = -1;
+
+    if (rex->raw_output) {
+        st->buf[0] = eof ? RAW_OUTPUT_EOF : RAW_OUTPUT_DATA;
+        if (flux_respond_raw (s->h, rex->msg, st->buf, st->hdrlen + len) < 0) {
+            flux_log_error (s->h, "%s: flux_respond_raw", __FUNCTION__);
+            goto error;
+        }
+    }
+    else {
+        snprintf (rankstr, sizeof (rankstr), "%d", s->rank);
+        if (!(io = ioencode (st->name,
+                             rankstr,
+                             len ? data : NULL,
+                             len,
+                             eof))) {
+            flux_log_error (s->h, "%s: ioencode", __FUNCTION__);
+            goto error;
+        }
+        if (flux_respond_pack (s->h, rex->msg, "{s:s s:i s:i s:O}",
+                               "type", "output",
+                               "rank", s->rank,
+                               "pid", flux_subprocess_pid (p),
+                               "io", io) < 0) {
+            flux_log_error (s->h, "%s: flux_respond_pack", __FUNCTION__);
+            goto error;
+        }
+    }
+
+    if (len < st->len)
+        memmove (data, data + len, st->len - len);
+    st->len -= len;
+    rv = 0;
+error:
+    json_decref (io);
+    return rv;
+}
+
+/* Send pending output on 'st'.  Unless 'force' is true, a line
+ * buffered stream is sent only through its last complete line.
+ */
+static int rexec_output_flush (flux_subprocess_t *p,
+                               struct rexec *rex,
+                               struct rexec_stream *st,
+                               bool force,
+                               bool eof)
+{
+    int len = st->len;
+
+    if (!force && st->line_buffered) {
+        const char *data = st->buf + st->hdrlen;
+
+        while (len > 0 && data[len - 1] != '\n')
+            len--;
+        if (len == 0 && st->len >= OUTPUT_COALESCE_SIZE)
+            len = st->len;
+    }
+    if (len == 0 && !eof)
+        return 0;
+    return rexec_output (p, rex, st, len, eof);
+}
+
+static int rexec_output_flush_all (flux_subprocess_t *p,
+                                   struct rexec *rex,
+                                   bool force)
+{
+    struct rexec_stream *st;
+
+    st = zhash_first (rex->streams);
+    while (st) {
+        if (rexec_output_flush (p, rex, st, force, false) < 0)
+            return -1;
+        st = zhash_next (rex->streams);
+    }
+    return 0;
+}
+
 static void subprocess_cleanup (flux_subprocess_t *p)
 {
     struct rexec *rex = flux_subprocess_aux_get (p, auxkey);
@@ -154,6 +338,7 @@ static void rexec_completion_cb (flux_subprocess_t *p)
 
     if (p->state != FLUX_SUBPROCESS_FAILED) {
         /* no fallback if this fails */
+        (void)rexec_output_flush_all (p, rex, true);
         if (flux_respond_pack (rex->s->h, rex->msg, "{s:s s:i}",
                                "type", "complete",
                                "rank", rex->s->rank) < 0)
@@ -201,6 +386,8 @@ static void rexec_state_change_cb (flux_subprocess_t *p,
             flux_log_error (rex->s->h, "%s: flux_respond_pack", __FUNCTION__);
         }
     } else if (state == FLUX_SUBPROCESS_EXITED) {
+        if (rexec_output_flush_all (p, rex, true) < 0)
+            goto error;
         if (flux_respond_pack (rex->s->h, rex->msg, "{s:s s:i s:i s:i}",
                                "type", "state",
                                "rank", rex->s->rank,
@@ -209,6 +396,8 @@ static void rexec_state_change_cb (flux_subprocess_t *p,
             flux_log_error (rex->s->h, "%s: flux_respond_pack", __FUNCTION__);
         }
     } else if (state == FLUX_SUBPROCESS_FAILED) {
+        /* no fallback if this fails */
+        (void)rexec_output_flush_all (p, rex, true);
         if (flux_respond_pack (rex->s->h, rex->msg, "{s:s s:i s:i s:i}",
                                "type", "state",
                                "rank", rex->s->rank,
@@ -229,58 +418,112 @@ error:
     internal_fatal (rex->s, p);
 }
 
-static int rexec_output (flux_subprocess_t *p,
-                         const char *stream,
-                         flux_subprocess_server_t *s,
-                         const flux_msg_t *msg,
-                         const char *data,
-                         int len,
-                         bool eof)
+static void rexec_output_timer_cb (flux_reactor_t *r,
+                                   flux_watcher_t *w,
+                                   int revents,
+                                   void *arg)
 {
-    json_t *io = NULL;
-    char rankstr[64];
-    int rv = -1;
+    flux_subprocess_t *p = arg;
+    struct rexec *rex = flux_subprocess_aux_get (p, auxkey);
 
-    snprintf (rankstr, sizeof (rankstr), "%d", s->rank);
-    if (!(io = ioencode (stream, rankstr, data, len, eof))) {
-        flux_log_error (s->h, "%s: ioencode", __FUNCTION__);
-        goto error;
-    }
+    assert (rex != NULL);
 
-    if (flux_respond_pack (s->h, msg, "{s:s s:i s:i s:O}",
-                           "type", "output",
-                           "rank", s->rank,
-                           "pid", flux_subprocess_pid (p),
-                           "io", io) < 0) {
-        flux_log_error (s->h, "%s: flux_respond_pack", __FUNCTION__);
-        goto error;
+    rex->output_timer_armed = false;
+    if (rexec_output_flush_all (p, rex, false) < 0)
+        internal_fatal (rex->s, p);
+}
+
+static int rexec_output_timer_arm (flux_subprocess_t *p, struct rexec *rex)
+{
+    if (rex->output_timer_armed)
+        return 0;
+    if (!rex->output_timer) {
+        rex->output_timer = flux_timer_watcher_create (rex->s->r,
+                                                       OUTPUT_COALESCE_DELAY,
+                                                       0.,
+                                                       rexec_output_timer_cb,
+                                                       p);
+        if (!rex->output_timer)
+            return -1;
     }
+    else
+        flux_timer_watcher_reset (rex->output_timer,
+                                  OUTPUT_COALESCE_DELAY,
+                                  0.);
+    flux_watcher_start (rex->output_timer);
+    rex->output_timer_armed = true;
+    return 0;
+}
 
-    rv = 0;
-error:
-    json_decref (io);
-    return rv;
+static struct rexec_stream *rexec_stream_lookup (flux_subprocess_t *p,
+                                                 struct rexec *rex,
+                                                 const char *stream)
+{
+    struct rexec_stream *st;
+    int line_buffer;
+    int coalesce;
+
+    if ((st = zhash_lookup (rex->streams, stream)))
+        return st;
+    if ((line_buffer = cmd_option_line_buffer (p, stream)) < 0
+        || (coalesce = cmd_option_coalesce (p, stream)) < 0)
+        return NULL;
+    if (!(st = rexec_stream_create (stream, rex->raw_output)))
+        return NULL;
+    st->line_buffered = line_buffer ? true : false;
+    st->coalesce = coalesce ? true : false;
+    if (zhash_insert (rex->streams, stream, st) < 0) {
+        rexec_stream_destroy (st);
+        errno = EEXIST;
+        return NULL;
+    }
+    zhash_freefn (rex->streams, stream, rexec_stream_destroy);
+    return st;
 }
 
 static void rexec_output_cb (flux_subprocess_t *p, const char *stream)
 {
     struct rexec *rex = flux_subprocess_aux_get (p, auxkey);
+    struct rexec_stream *st;
     const char *ptr;
     int lenp;
 
     assert (rex != NULL);
 
+    if (!(st = rexec_stream_lookup (p, rex, stream))) {
+        flux_log_error (rex->s->h, "%s: rexec_stream_lookup", __FUNCTION__);
+        goto error;
+    }
+
     if (!(ptr = flux_subprocess_read (p, stream, -1, &lenp))) {
         flux_log_error (rex->s->h, "%s: flux_subprocess_read", __FUNCTION__);
         goto error;
     }
 
     if (lenp) {
-        if (rexec_output (p, stream, rex->s, rex->msg, ptr, lenp, false) < 0)
+        if (rexec_stream_append (st, ptr, lenp) < 0) {
+            flux_log_error (rex->s->h, "%s: rexec_stream_append",
+                            __FUNCTION__);
             goto error;
+        }
+        if (!st->coalesce) {
+            if (rexec_output_flush (p, rex, st, true, false) < 0)
+                goto error;
+        }
+        else {
+            if (st->len >= OUTPUT_COALESCE_SIZE) {
+                if (rexec_output_flush (p, rex, st, false, false) < 0)
+                    goto error;
+            }
+            if (st->len > 0 && rexec_output_timer_arm (p, rex) < 0) {
+                flux_log_error (rex->s->h, "%s: rexec_output_timer_arm",
+                                __FUNCTION__);
+                goto error;
+            }
+        }
     }
     else {
-        if (rexec_output (p, stream, rex->s, rex->msg, NULL, 0, true) < 0)
+        if (rexec_output_flush (p, rex, st, true, true) < 0)
             goto error;
     }
 
@@ -306,13 +549,15 @@ static void server_exec_cb (flux_t *h, flux_msg_handler_t *mh,
         .on_stderr = rexec_output_cb,
     };
     int on_channel_out, on_stdout, on_stderr;
+    int raw_output = 0;
     char **env = NULL;
 
-    if (flux_request_unpack (msg, NULL, "{s:s s:i s:i s:i}",
+    if (flux_request_unpack (msg, NULL, "{s:s s:i s:i s:i s?i}",
                              "cmd", &cmd_str,
                              "on_channel_out", &on_channel_out,
                              "on_stdout", &on_stdout,
-                             "on_stderr", &on_stderr))
+                             "on_stderr", &on_stderr,
+                             "raw_output", &raw_output))
         goto error;
 
     if (!on_channel_out)
@@ -373,7 +618,7 @@ static void server_exec_cb (flux_t *h, flux_msg_handler_t *mh,
         goto cleanup;
     }
 
-    if (!(rex = rexec_create (msg, s)))
+    if (!(rex = rexec_create (msg, s, raw_output ? true : false)))
         goto error;
     if (flux_subprocess_aux_set (p,
                                 auxkey,
@@ -891,7 +891,8 @@ int flux_subprocess_write (flux_subprocess_t *p, const char *stream,
         }
 
         if ((ret = flux_buffer_write (fb, buf, len)) < 0) {
-            log_err ("flux_buffer_write");
+            if (errno != ENOSPC)
+                log_err ("flux_buffer_write");
             return -1;
         }
     }
@@ -902,7 +903,8 @@ int flux_subprocess_write (flux_subprocess_t *p, const char *stream,
             return -1;
         }
         if ((ret = flux_buffer_write (c->write_buffer, buf, len)) < 0) {
-            log_err ("flux_buffer_write");
+            if (errno != ENOSPC)
+                log_err ("flux_buffer_write");
             return -1;
         }
     }
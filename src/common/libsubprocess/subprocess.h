@@ -297,6 +297,20 @@ int flux_cmd_add_channel (flux_cmd_t *cmd, const char *name);
  *    - name + "_STREAM_STOP" - configure start/stop on channel name
  *    - stdout_STREAM_STOP - configure start/stop for stdout
  *    - stderr_STREAM_STOP - configure start/stop for stderr
+ *
+ *  "COALESCE" option
+ *
+ *    By default, output of a remote subprocess is accumulated by the
+ *    remote server for a short time and sent in fewer, larger
+ *    messages.  Line buffered output is only sent in whole lines.
+ *    By setting this option to "false", output is sent as soon as it
+ *    is read on the remote side.  These options can also be set to
+ *    "true" to keep default behavior.  Note that these options only
+ *    apply to remote subprocesses.
+ *
+ *    - name + "_COALESCE" - configure coalescing on channel name
+ *    - stdout_COALESCE - configure coalescing for stdout
+ *    - stderr_COALESCE - configure coalescing for stderr
  */
 int flux_cmd_setopt (flux_cmd_t *cmd, const char *var, const char *val);
 const char *flux_cmd_getopt (flux_cmd_t *cmd, const char *var);
@@ -21,6 +21,14 @@
 
 #define CHANNEL_MAGIC    0xcafebeef
 
+/* Raw rexec output response payload: one of the type bytes below,
+ * the NUL terminated stream name, then the output data (possibly
+ * empty).  Sent instead of a JSON "output" response if the client
+ * set "raw_output" in the rexec request.
+ */
+#define RAW_OUTPUT_DATA 'o'     /* output data */
+#define RAW_OUTPUT_EOF  'e'     /* output data followed by EOF */
+
 #define CHANNEL_READ  0x01
 #define CHANNEL_WRITE 0x02
 #define CHANNEL_FD    0x04
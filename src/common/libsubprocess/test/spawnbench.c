@@ -0,0 +1,139 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* spawnbench - measure local subprocess launch rate
+ *
+ * Usage: spawnbench [--fork] [count] [command]
+ *
+ * Launch 'count' (default 256) copies of 'command' (default /bin/true)
+ * with stdout and stderr channels, as the job shell does for its tasks,
+ * and report the time taken to launch them and to reap them all.
+ * With --fork, a no-op pre_exec hook is set so that fork(2) is used
+ * instead of posix_spawn(3).
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/monotime.h"
+
+static int completed;
+
+static void die (const char *s)
+{
+    fprintf (stderr, "spawnbench: %s: %s\n", s, strerror (errno));
+    exit (1);
+}
+
+static void completion_cb (flux_subprocess_t *p)
+{
+    completed++;
+}
+
+static void output_cb (flux_subprocess_t *p, const char *stream)
+{
+    int len;
+
+    (void) flux_subprocess_read (p, stream, -1, &len);
+}
+
+static void noop_hook_cb (flux_subprocess_t *p, void *arg)
+{
+}
+
+int main (int argc, char *argv[])
+{
+    flux_subprocess_ops_t ops = {
+        .on_completion = completion_cb,
+        .on_stdout = output_cb,
+        .on_stderr = output_cb,
+    };
+    flux_subprocess_hooks_t hooks = {
+        .pre_exec = noop_hook_cb,
+    };
+    bool use_fork = false;
+    int count = 256;
+    char *av[] = { "/bin/true", NULL };
+    flux_subprocess_t **procs;
+    flux_reactor_t *r;
+    flux_cmd_t *cmd;
+    struct timespec t0;
+    double t_launch, t_total;
+    int i;
+
+    if (argc > 1 && !strcmp (argv[1], "--fork")) {
+        use_fork = true;
+        argc--;
+        argv++;
+    }
+    if (argc > 3) {
+        fprintf (stderr, "Usage: spawnbench [--fork] [count] [command]\n");
+        exit (1);
+    }
+    if (argc > 1)
+        count = strtoul (argv[1], NULL, 10);
+    if (argc > 2)
+        av[0] = argv[2];
+    if (count < 1) {
+        fprintf (stderr, "spawnbench: invalid count\n");
+        exit (1);
+    }
+
+    if (!(r = flux_reactor_create (FLUX_REACTOR_SIGCHLD)))
+        die ("flux_reactor_create");
+    if (!(cmd = flux_cmd_create (1, av, environ)))
+        die ("flux_cmd_create");
+    if (!(procs = calloc (count, sizeof (*procs))))
+        die ("calloc");
+
+    monotime (&t0);
+    for (i = 0; i < count; i++) {
+        if (flux_cmd_setenvf (cmd, 1, "FLUX_TASK_RANK", "%d", i) < 0)
+            die ("flux_cmd_setenvf");
+        if (!(procs[i] = flux_local_exec (r,
+                                          0,
+                                          cmd,
+                                          &ops,
+                                          use_fork ? &hooks : NULL)))
+            die ("flux_local_exec");
+    }
+    t_launch = monotime_since (t0) / 1000.;
+    if (flux_reactor_run (r, 0) < 0)
+        die ("flux_reactor_run");
+    t_total = monotime_since (t0) / 1000.;
+
+    if (completed != count) {
+        fprintf (stderr, "spawnbench: %d of %d completed\n", completed, count);
+        exit (1);
+    }
+    printf ("%d tasks (%s): launch %.3fs (%.0f/s), complete %.3fs\n",
+            count, use_fork ? "fork" : "spawn",
+            t_launch, t_launch > 0. ? count / t_launch : 0.,
+            t_total);
+
+    for (i = 0; i < count; i++)
+        flux_subprocess_destroy (procs[i]);
+    free (procs);
+    flux_cmd_destroy (cmd);
+    flux_reactor_destroy (r);
+    exit (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -1478,6 +1478,30 @@ void test_exec_fail (flux_reactor_t *r)
     flux_cmd_destroy (cmd);
 }
 
+void noop_hook_cb (flux_subprocess_t *p, void *arg)
+{
+}
+
+/* A pre_exec hook forces fork(2) instead of posix_spawn(3) */
+void test_exec_fail_fork (flux_reactor_t *r)
+{
+    char *av_enoent[]  = { "/usr/bin/foobarbaz", NULL };
+    flux_cmd_t *cmd = NULL;
+    flux_subprocess_t *p = NULL;
+    flux_subprocess_hooks_t hooks = {
+        .pre_exec = noop_hook_cb,
+    };
+
+    ok ((cmd = flux_cmd_create (1, av_enoent, NULL)) != NULL, "flux_cmd_create");
+
+    p = flux_local_exec (r, 0, cmd, NULL, &hooks);
+    ok (p == NULL
+        && errno == ENOENT,
+        "flux_local_exec with pre_exec hook failed with ENOENT");
+
+    flux_cmd_destroy (cmd);
+}
+
 void test_context (flux_reactor_t *r)
 {
     char *av[] = { "/bin/true", NULL };
@@ -2664,6 +2688,8 @@ int main (int argc, char *argv[])
     test_state_strings ();
     diag ("exec_fail");
     test_exec_fail (r);
+    diag ("exec_fail_fork");
+    test_exec_fail_fork (r);
     diag ("context");
     test_context (r);
     diag ("refcount");
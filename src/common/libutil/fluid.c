@@ -148,6 +148,33 @@ int fluid_generate (struct fluid_generator *gen, fluid_t *fluid)
     return 0;
 }
 
+int fluid_generate_range (struct fluid_generator *gen,
+                          int count,
+                          fluid_t *fluids)
+{
+    int i;
+
+    if (count < 0 || (count > 0 && !fluids)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (update_timestamp (gen) < 0)
+        return -1;
+    for (i = 0; i < count; i++) {
+        if (gen->seq + 1 >= (1ULL<<bits_per_seq)) {
+            if (gen->timestamp + 1 >= (1ULL<<bits_per_ts))
+                return -1;
+            gen->timestamp++;
+            gen->seq = 0;
+        }
+        fluids[i] = (gen->timestamp << (bits_per_seq + bits_per_id)
+                     | (gen->id << bits_per_seq)
+                     | gen->seq);
+        gen->seq++;
+    }
+    return 0;
+}
+
 /*  F58 encoding.
  */
 /*  Compute base58 encoding of id in *reverse*
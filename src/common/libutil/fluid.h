@@ -48,6 +48,17 @@ int fluid_init (struct fluid_generator *gen, uint32_t id, uint64_t timestamp);
  */
 int fluid_generate (struct fluid_generator *gen, fluid_t *fluid);
 
+/* Generate 'count' FLUIDs into the 'fluids' array, consecutive in the
+ * sequence of this generator, i.e. no FLUID generated before or after
+ * falls between them.  Rather than waiting for the clock when the
+ * sequence number for the current ms is exhausted, the timestamp is
+ * advanced, so a later fluid_generate() may wait up to count/1024 ms.
+ * Returns 0 on success, -1 on failure.
+ */
+int fluid_generate_range (struct fluid_generator *gen,
+                          int count,
+                          fluid_t *fluids);
+
 /* Update and retrieve the internal timestamp.
  * Returns 0 on success, -1 on failure.
  */
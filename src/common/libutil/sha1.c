@@ -87,8 +87,7 @@ A million repetitions of "a"
 
 //#include "os_types.h"
 #include "sha1.h"
-
-void SHA1_Transform(uint32_t state[5], const uint8_t buffer[64]);
+#include "shaext.h"
 
 #define rol(value, bits) (((value) << (bits)) | ((value) >> (32 - (bits))))
 
@@ -184,6 +183,20 @@ void SHA1_Transform(uint32_t state[5], const uint8_t buffer[64])
 }
 
 
+/* Hash consecutive 512-bit blocks, using SHA extensions if available. */
+static void sha1_blocks(uint32_t state[5], const uint8_t *data, size_t nblocks)
+{
+    if (shaext_available()) {
+        shaext_sha1_blocks(state, data, nblocks);
+        return;
+    }
+    while (nblocks-- > 0) {
+        SHA1_Transform(state, data);
+        data += 64;
+    }
+}
+
+
 /* SHA1Init - Initialize new context */
 void SHA1_Init(SHA1_CTX* context)
 {
@@ -211,9 +224,10 @@ void SHA1_Update(SHA1_CTX* context, const uint8_t* data, const size_t len)
     context->count[1] += (len >> 29);
     if ((j + len) > 63) {
         memcpy(&context->buffer[j], data, (i = 64-j));
-        SHA1_Transform(context->state, context->buffer);
-        for ( ; i + 63 < len; i += 64) {
-            SHA1_Transform(context->state, data + i);
+        sha1_blocks(context->state, context->buffer, 1);
+        if (len - i >= 64) {
+            sha1_blocks(context->state, data + i, (len - i) / 64);
+            i += ((len - i) / 64) * 64;
         }
         j = 0;
     }
@@ -20,6 +20,7 @@ typedef struct {
 #define SHA1_DIGEST_SIZE 20
 
 void SHA1_Init(SHA1_CTX* context);
+void SHA1_Transform(uint32_t state[5], const uint8_t buffer[64]);
 void SHA1_Update(SHA1_CTX* context, const uint8_t* data, const size_t len);
 void SHA1_Final(SHA1_CTX* context, uint8_t digest[SHA1_DIGEST_SIZE]);
 
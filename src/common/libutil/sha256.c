@@ -16,6 +16,7 @@
 #include <stdlib.h>
 #include <memory.h>
 #include "sha256.h"
+#include "shaext.h"
 
 /****************************** MACROS ******************************/
 #define ROTLEFT(a,b) (((a) << (b)) | ((a) >> (32-(b))))
@@ -96,15 +97,35 @@ void sha256_init(SHA256_CTX *ctx)
 	ctx->state[7] = 0x5be0cd19;
 }
 
-void sha256_update(SHA256_CTX *ctx, const BYTE data[], size_t len)
+/* Hash consecutive 64 byte blocks, using SHA extensions if available. */
+static void sha256_blocks(SHA256_CTX *ctx, const BYTE data[], size_t nblocks)
 {
-	WORD i;
+	if (shaext_available()) {
+		shaext_sha256_blocks((uint32_t *)ctx->state, data, nblocks);
+		return;
+	}
+	while (nblocks-- > 0) {
+		sha256_transform(ctx, data);
+		data += 64;
+	}
+}
 
-	for (i = 0; i < len; ++i) {
-		ctx->data[ctx->datalen] = data[i];
-		ctx->datalen++;
+void sha256_update(SHA256_CTX *ctx, const BYTE data[], size_t len)
+{
+	size_t i = 0;
+	size_t nblocks;
+
+	while (i < len) {
+		if (ctx->datalen == 0 && len - i >= 64) {
+			nblocks = (len - i) / 64;
+			sha256_blocks(ctx, &data[i], nblocks);
+			ctx->bitlen += 512 * nblocks;
+			i += 64 * nblocks;
+			continue;
+		}
+		ctx->data[ctx->datalen++] = data[i++];
 		if (ctx->datalen == 64) {
-			sha256_transform(ctx, ctx->data);
+			sha256_blocks(ctx, ctx->data, 1);
 			ctx->bitlen += 512;
 			ctx->datalen = 0;
 		}
@@ -127,7 +148,7 @@ void sha256_final(SHA256_CTX *ctx, BYTE hash[])
 		ctx->data[i++] = 0x80;
 		while (i < 64)
 			ctx->data[i++] = 0x00;
-		sha256_transform(ctx, ctx->data);
+		sha256_blocks(ctx, ctx->data, 1);
 		memset(ctx->data, 0, 56);
 	}
 
@@ -141,7 +162,7 @@ void sha256_final(SHA256_CTX *ctx, BYTE hash[])
 	ctx->data[58] = ctx->bitlen >> 40;
 	ctx->data[57] = ctx->bitlen >> 48;
 	ctx->data[56] = ctx->bitlen >> 56;
-	sha256_transform(ctx, ctx->data);
+	sha256_blocks(ctx, ctx->data, 1);
 
 	// Since this implementation uses little endian byte ordering and SHA uses big endian,
 	// reverse all the bytes when copying the final state to the output hash.
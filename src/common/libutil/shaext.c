@@ -0,0 +1,265 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* shaext.c - SHA1/SHA256 using x86 SHA extensions
+ *
+ * Functions are compiled with per-function target attributes, so the
+ * rest of the build need not enable SHA/SSE4.1 code generation, and are
+ * selected at runtime via cpuid.  On other architectures or compilers,
+ * shaext_available() always returns false.
+ *
+ * The round structure follows Intel's "New Instructions Supporting the
+ * Secure Hash Algorithm on Intel Architecture Processors" (2013).
+ * Message words are kept in four registers MSG[0..3] used round robin,
+ * each holding four schedule words, so the rounds are expressed with
+ * one macro per group of four (SHA1) or four (SHA256) rounds.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "shaext.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define HAVE_SHAEXT 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#if HAVE_SHAEXT
+
+static bool shaext_supported;
+static pthread_once_t shaext_once = PTHREAD_ONCE_INIT;
+
+static void shaext_detect (void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid (1, &eax, &ebx, &ecx, &edx))
+        return;
+    if (!(ecx & bit_SSSE3) || !(ecx & bit_SSE4_1))
+        return;
+    if (__get_cpuid_max (0, NULL) < 7)
+        return;
+    __cpuid_count (7, 0, eax, ebx, ecx, edx);
+    if (!(ebx & (1 << 29))) // SHA
+        return;
+    shaext_supported = true;
+}
+
+bool shaext_available (void)
+{
+    pthread_once (&shaext_once, shaext_detect);
+    return shaext_supported;
+}
+
+#define SHAEXT_TARGET __attribute__ ((target ("sha,ssse3,sse4.1")))
+
+/* Rounds 4g..4g+3 of SHA1, where the first of E[0], E[1] alternates.
+ * The schedule for later groups is advanced with msg1/xor/msg2 as long
+ * as words remain to be computed (80 words, 4 per register).
+ */
+#define SHA1_GROUP(g, f) do { \
+    __m128i *e_cur = &E[(g) % 2]; \
+    __m128i *e_next = &E[((g) + 1) % 2]; \
+    if ((g) == 0) \
+        *e_cur = _mm_add_epi32 (*e_cur, MSG[0]); \
+    else \
+        *e_cur = _mm_sha1nexte_epu32 (*e_cur, MSG[(g) % 4]); \
+    *e_next = ABCD; \
+    if ((g) >= 3 && (g) <= 18) \
+        MSG[((g) + 1) % 4] = _mm_sha1msg2_epu32 (MSG[((g) + 1) % 4], \
+                                                 MSG[(g) % 4]); \
+    ABCD = _mm_sha1rnds4_epu32 (ABCD, *e_cur, f); \
+    if ((g) >= 1 && (g) <= 16) \
+        MSG[((g) + 3) % 4] = _mm_sha1msg1_epu32 (MSG[((g) + 3) % 4], \
+                                                 MSG[(g) % 4]); \
+    if ((g) >= 2 && (g) <= 17) \
+        MSG[((g) + 2) % 4] = _mm_xor_si128 (MSG[((g) + 2) % 4], \
+                                            MSG[(g) % 4]); \
+} while (0)
+
+SHAEXT_TARGET
+void shaext_sha1_blocks (uint32_t state[5],
+                         const uint8_t *data,
+                         size_t nblocks)
+{
+    const __m128i mask = _mm_set_epi64x (0x0001020304050607ULL,
+                                         0x08090a0b0c0d0e0fULL);
+    __m128i ABCD, ABCD_SAVE, E0_SAVE;
+    __m128i E[2];
+    __m128i MSG[4];
+    int i;
+
+    ABCD = _mm_loadu_si128 ((const __m128i *)state);
+    ABCD = _mm_shuffle_epi32 (ABCD, 0x1B);
+    E[0] = _mm_set_epi32 (state[4], 0, 0, 0);
+
+    while (nblocks-- > 0) {
+        ABCD_SAVE = ABCD;
+        E0_SAVE = E[0];
+        for (i = 0; i < 4; i++) {
+            MSG[i] = _mm_loadu_si128 ((const __m128i *)(data + 16 * i));
+            MSG[i] = _mm_shuffle_epi8 (MSG[i], mask);
+        }
+        SHA1_GROUP (0, 0);
+        SHA1_GROUP (1, 0);
+        SHA1_GROUP (2, 0);
+        SHA1_GROUP (3, 0);
+        SHA1_GROUP (4, 0);
+        SHA1_GROUP (5, 1);
+        SHA1_GROUP (6, 1);
+        SHA1_GROUP (7, 1);
+        SHA1_GROUP (8, 1);
+        SHA1_GROUP (9, 1);
+        SHA1_GROUP (10, 2);
+        SHA1_GROUP (11, 2);
+        SHA1_GROUP (12, 2);
+        SHA1_GROUP (13, 2);
+        SHA1_GROUP (14, 2);
+        SHA1_GROUP (15, 3);
+        SHA1_GROUP (16, 3);
+        SHA1_GROUP (17, 3);
+        SHA1_GROUP (18, 3);
+        SHA1_GROUP (19, 3);
+        E[0] = _mm_sha1nexte_epu32 (E[0], E0_SAVE);
+        ABCD = _mm_add_epi32 (ABCD, ABCD_SAVE);
+        data += 64;
+    }
+
+    ABCD = _mm_shuffle_epi32 (ABCD, 0x1B);
+    _mm_storeu_si128 ((__m128i *)state, ABCD);
+    state[4] = _mm_extract_epi32 (E[0], 3);
+}
+
+static const uint32_t K256[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+/* Rounds 4g..4g+3 of SHA256 (two sha256rnds2 per group).
+ * The schedule for later groups is advanced with msg1/alignr/msg2 as long
+ * as words remain to be computed (64 words, 4 per register).
+ */
+#define SHA256_GROUP(g) do { \
+    __m128i msg, tmp; \
+    msg = _mm_add_epi32 (MSG[(g) % 4], \
+                         _mm_loadu_si128 ((const __m128i *)&K256[4 * (g)])); \
+    STATE1 = _mm_sha256rnds2_epu32 (STATE1, STATE0, msg); \
+    if ((g) >= 3 && (g) <= 14) { \
+        tmp = _mm_alignr_epi8 (MSG[(g) % 4], MSG[((g) + 3) % 4], 4); \
+        MSG[((g) + 1) % 4] = _mm_add_epi32 (MSG[((g) + 1) % 4], tmp); \
+        MSG[((g) + 1) % 4] = _mm_sha256msg2_epu32 (MSG[((g) + 1) % 4], \
+                                                   MSG[(g) % 4]); \
+    } \
+    msg = _mm_shuffle_epi32 (msg, 0x0E); \
+    STATE0 = _mm_sha256rnds2_epu32 (STATE0, STATE1, msg); \
+    if ((g) >= 1 && (g) <= 12) \
+        MSG[((g) + 3) % 4] = _mm_sha256msg1_epu32 (MSG[((g) + 3) % 4], \
+                                                   MSG[(g) % 4]); \
+} while (0)
+
+SHAEXT_TARGET
+void shaext_sha256_blocks (uint32_t state[8],
+                           const uint8_t *data,
+                           size_t nblocks)
+{
+    const __m128i mask = _mm_set_epi64x (0x0c0d0e0f08090a0bULL,
+                                         0x0405060700010203ULL);
+    __m128i STATE0, STATE1, ABEF_SAVE, CDGH_SAVE, TMP;
+    __m128i MSG[4];
+    int i;
+
+    TMP = _mm_loadu_si128 ((const __m128i *)&state[0]);
+    STATE1 = _mm_loadu_si128 ((const __m128i *)&state[4]);
+    TMP = _mm_shuffle_epi32 (TMP, 0xB1);            // CDAB
+    STATE1 = _mm_shuffle_epi32 (STATE1, 0x1B);      // EFGH
+    STATE0 = _mm_alignr_epi8 (TMP, STATE1, 8);      // ABEF
+    STATE1 = _mm_blend_epi16 (STATE1, TMP, 0xF0);   // CDGH
+
+    while (nblocks-- > 0) {
+        ABEF_SAVE = STATE0;
+        CDGH_SAVE = STATE1;
+        for (i = 0; i < 4; i++) {
+            MSG[i] = _mm_loadu_si128 ((const __m128i *)(data + 16 * i));
+            MSG[i] = _mm_shuffle_epi8 (MSG[i], mask);
+        }
+        SHA256_GROUP (0);
+        SHA256_GROUP (1);
+        SHA256_GROUP (2);
+        SHA256_GROUP (3);
+        SHA256_GROUP (4);
+        SHA256_GROUP (5);
+        SHA256_GROUP (6);
+        SHA256_GROUP (7);
+        SHA256_GROUP (8);
+        SHA256_GROUP (9);
+        SHA256_GROUP (10);
+        SHA256_GROUP (11);
+        SHA256_GROUP (12);
+        SHA256_GROUP (13);
+        SHA256_GROUP (14);
+        SHA256_GROUP (15);
+        STATE0 = _mm_add_epi32 (STATE0, ABEF_SAVE);
+        STATE1 = _mm_add_epi32 (STATE1, CDGH_SAVE);
+        data += 64;
+    }
+
+    TMP = _mm_shuffle_epi32 (STATE0, 0x1B);         // FEBA
+    STATE1 = _mm_shuffle_epi32 (STATE1, 0xB1);      // DCHG
+    STATE0 = _mm_blend_epi16 (TMP, STATE1, 0xF0);   // DCBA
+    STATE1 = _mm_alignr_epi8 (STATE1, TMP, 8);      // ABEF
+    _mm_storeu_si128 ((__m128i *)&state[0], STATE0);
+    _mm_storeu_si128 ((__m128i *)&state[4], STATE1);
+}
+
+#else /* !HAVE_SHAEXT */
+
+bool shaext_available (void)
+{
+    return false;
+}
+
+void shaext_sha1_blocks (uint32_t state[5],
+                         const uint8_t *data,
+                         size_t nblocks)
+{
+    abort ();
+}
+
+void shaext_sha256_blocks (uint32_t state[8],
+                           const uint8_t *data,
+                           size_t nblocks)
+{
+    abort ();
+}
+
+#endif /* !HAVE_SHAEXT */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,39 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _UTIL_SHAEXT_H
+#define _UTIL_SHAEXT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* SHA1 and SHA256 block functions using the x86 SHA extensions.
+ *
+ * shaext_available() checks (once) whether the CPU supports them.
+ * The block functions update 'state' with 'nblocks' consecutive 64 byte
+ * blocks from 'data', exactly as the generic transform functions would,
+ * and must only be called if shaext_available() returns true.
+ */
+bool shaext_available (void);
+
+void shaext_sha1_blocks (uint32_t state[5],
+                         const uint8_t *data,
+                         size_t nblocks);
+
+void shaext_sha256_blocks (uint32_t state[8],
+                           const uint8_t *data,
+                           size_t nblocks);
+
+#endif /* !_UTIL_SHAEXT_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
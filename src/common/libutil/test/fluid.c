@@ -331,6 +331,42 @@ void test_basic (void)
         "fluid_decode type=MNEMONIC fails on unknown words xx-xx-xx--xx-xx-xx");
 }
 
+void test_range (void)
+{
+    struct fluid_generator gen;
+    fluid_t ids[4096];
+    fluid_t id;
+    int errors;
+    int i;
+
+    ok (fluid_init (&gen, 1, 0) == 0,
+        "fluid_init id=1 timestamp=0 works");
+    errno = 0;
+    ok (fluid_generate_range (&gen, -1, ids) < 0 && errno == EINVAL,
+        "fluid_generate_range count=-1 fails with EINVAL");
+    errno = 0;
+    ok (fluid_generate_range (&gen, 1, NULL) < 0 && errno == EINVAL,
+        "fluid_generate_range fluids=NULL fails with EINVAL");
+    ok (fluid_generate_range (&gen, 0, NULL) == 0,
+        "fluid_generate_range count=0 works");
+
+    if (fluid_generate (&gen, &id) < 0)
+        BAIL_OUT ("fluid_generate unexpectedly failed");
+    ok (fluid_generate_range (&gen, 4096, ids) == 0,
+        "fluid_generate_range count=4096 works");
+    errors = (ids[0] <= id) ? 1 : 0;
+    for (i = 1; i < 4096; i++) {
+        if (ids[i] <= ids[i - 1])
+            errors++;
+    }
+    ok (errors == 0,
+        "fluid_generate_range FLUIDs are increasing");
+    ok (fluid_get_timestamp (ids[4095]) >= fluid_get_timestamp (ids[0]) + 3,
+        "fluid_generate_range advanced timestamp past exhausted sequence");
+    ok (fluid_generate (&gen, &id) == 0 && id > ids[4095],
+        "fluid_generate after fluid_generate_range continues sequence");
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -339,6 +375,7 @@ int main (int argc, char *argv[])
     setlocale (LC_ALL, "");
 
     test_basic ();
+    test_range ();
     test_f58 ();
     test_fluid_parse ();
 
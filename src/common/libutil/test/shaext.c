@@ -0,0 +1,127 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libutil/sha1.h"
+#include "src/common/libutil/sha256.h"
+#include "src/common/libutil/shaext.h"
+
+#define NBLOCKS 64
+
+static uint8_t data[NBLOCKS * 64];
+
+void test_sha1 (void)
+{
+    SHA1_CTX ctx;
+    uint32_t state[5];
+    int n, i;
+    int errors = 0;
+
+    for (n = 1; n <= NBLOCKS; n++) {
+        SHA1_Init (&ctx);
+        memcpy (state, ctx.state, sizeof (state));
+        for (i = 0; i < n; i++)
+            SHA1_Transform (ctx.state, data + i * 64);
+        shaext_sha1_blocks (state, data, n);
+        if (memcmp (state, ctx.state, sizeof (state)) != 0)
+            errors++;
+    }
+    ok (errors == 0,
+        "shaext_sha1_blocks matches SHA1_Transform for 1-%d blocks", NBLOCKS);
+}
+
+void test_sha256 (void)
+{
+    SHA256_CTX ctx;
+    uint32_t state[8];
+    int n, i;
+    int errors = 0;
+
+    for (n = 1; n <= NBLOCKS; n++) {
+        sha256_init (&ctx);
+        memcpy (state, ctx.state, sizeof (state));
+        for (i = 0; i < n; i++)
+            sha256_transform (&ctx, data + i * 64);
+        shaext_sha256_blocks (state, data, n);
+        if (memcmp (state, ctx.state, sizeof (state)) != 0)
+            errors++;
+    }
+    ok (errors == 0,
+        "shaext_sha256_blocks matches sha256_transform for 1-%d blocks",
+        NBLOCKS);
+}
+
+/* Hashing a buffer in one update (bulk block path) and in odd sized
+ * pieces (buffered path) must agree.
+ */
+void test_update (void)
+{
+    SHA1_CTX c1, c2;
+    SHA256_CTX s1, s2;
+    uint8_t h1[SHA256_BLOCK_SIZE];
+    uint8_t h2[SHA256_BLOCK_SIZE];
+    size_t i;
+
+    SHA1_Init (&c1);
+    SHA1_Init (&c2);
+    SHA1_Update (&c1, data, sizeof (data));
+    for (i = 0; i < sizeof (data); i += 7)
+        SHA1_Update (&c2, data + i, i + 7 > sizeof (data) ? sizeof (data) - i
+                                                          : 7);
+    SHA1_Final (&c1, h1);
+    SHA1_Final (&c2, h2);
+    ok (memcmp (h1, h2, SHA1_DIGEST_SIZE) == 0,
+        "SHA1 bulk and piecewise updates agree");
+
+    sha256_init (&s1);
+    sha256_init (&s2);
+    sha256_update (&s1, data, sizeof (data));
+    for (i = 0; i < sizeof (data); i += 7)
+        sha256_update (&s2, data + i, i + 7 > sizeof (data) ? sizeof (data) - i
+                                                            : 7);
+    sha256_final (&s1, h1);
+    sha256_final (&s2, h2);
+    ok (memcmp (h1, h2, SHA256_BLOCK_SIZE) == 0,
+        "SHA256 bulk and piecewise updates agree");
+}
+
+int main (int argc, char *argv[])
+{
+    int i;
+
+    plan (NO_PLAN);
+
+    srand (42);
+    for (i = 0; i < sizeof (data); i++)
+        data[i] = rand () & 0xff;
+
+    test_update ();
+
+    if (!shaext_available ()) {
+        diag ("CPU does not support SHA extensions");
+    }
+    else {
+        test_sha1 ();
+        test_sha256 ();
+    }
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
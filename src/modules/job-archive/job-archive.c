@@ -32,6 +32,10 @@
 #define PERIOD_DEFAULT       60.0
 #define BUSY_TIMEOUT_DEFAULT 50
 #define BUFSIZE              1024
+#define LOOKUP_WINDOW        32
+#define TXN_BATCH            256
+#define TRIGGER_DELAY        1.0
+#define TRIGGER_RETRY_MAX    30
 
 const char *sql_create_table = "CREATE TABLE if not exists jobs("
                                "  id CHAR(16) PRIMARY KEY,"
@@ -47,6 +51,13 @@ const char *sql_create_table = "CREATE TABLE if not exists jobs("
                                "  R TEXT"
     ");";
 
+/* Indexes for the common archive queries, by user and by time range.
+ * The t_inactive index also makes sql_since O(log n).
+ */
+const char *sql_create_index = \
+    "CREATE INDEX if not exists idx_jobs_userid ON jobs(userid);" \
+    "CREATE INDEX if not exists idx_jobs_t_inactive ON jobs(t_inactive);";
+
 const char *sql_store =                               \
     "INSERT INTO jobs"                                \
     "("                                               \
@@ -59,16 +70,30 @@ const char *sql_store =                               \
 
 const char *sql_since = "SELECT MAX(t_inactive) FROM jobs;";
 
+const char *sql_begin = "BEGIN IMMEDIATE;";
+const char *sql_commit = "COMMIT;";
+
 struct job_archive_ctx {
     flux_t *h;
     char *dbpath;
     double period;
     unsigned int busy_timeout;
     flux_watcher_t *w;
+    flux_msg_handler_t **handlers;
     sqlite3 *db;
     sqlite3_stmt *store_stmt;
+    sqlite3_stmt *begin_stmt;
+    sqlite3_stmt *commit_stmt;
     double since;
-    int kvs_lookup_count;
+    json_t *jobs;               // inactive jobs being archived
+    size_t jobs_index;          // next job in 'jobs' to look up
+    bool archiving;             // archive pass in progress
+    bool triggered;             // timer was shortened by a job-state event
+    bool pending;               // job went inactive during archive pass
+    json_t *announced;          // ids announced inactive, not yet archived
+    int retries;                // passes that left announced jobs behind
+    bool in_txn;                // transaction open on 'db'
+    int txn_count;              // rows stored in open transaction
 };
 
 static void log_sqlite_error (struct job_archive_ctx *ctx, const char *fmt, ...)
@@ -97,11 +122,22 @@ static void job_archive_ctx_destroy (struct job_archive_ctx *ctx)
 {
     if (ctx) {
         free (ctx->dbpath);
+        flux_msg_handler_delvec (ctx->handlers);
         flux_watcher_destroy (ctx->w);
+        json_decref (ctx->jobs);
+        json_decref (ctx->announced);
         if (ctx->store_stmt) {
             if (sqlite3_finalize (ctx->store_stmt) != SQLITE_OK)
                 log_sqlite_error (ctx, "sqlite_finalize store_stmt");
         }
+        if (ctx->begin_stmt) {
+            if (sqlite3_finalize (ctx->begin_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize begin_stmt");
+        }
+        if (ctx->commit_stmt) {
+            if (sqlite3_finalize (ctx->commit_stmt) != SQLITE_OK)
+                log_sqlite_error (ctx, "sqlite_finalize commit_stmt");
+        }
         if (ctx->db) {
             if (sqlite3_close (ctx->db) != SQLITE_OK)
                 log_sqlite_error (ctx, "sqlite3_close");
@@ -122,6 +158,10 @@ static struct job_archive_ctx * job_archive_ctx_create (flux_t *h)
     ctx->h = h;
     ctx->period = PERIOD_DEFAULT;
     ctx->busy_timeout = BUSY_TIMEOUT_DEFAULT;
+    if (!(ctx->announced = json_object ())) {
+        flux_log_error (h, "job_archive_ctx_create");
+        goto error;
+    }
 
     return ctx;
  error:
@@ -177,8 +217,11 @@ int job_archive_init (struct job_archive_ctx *ctx)
         goto error;
     }
 
+    /* WAL mode lets readers of the archive proceed while a batch is
+     * being written, and with synchronous=NORMAL a commit costs no fsync.
+     */
     if (sqlite3_exec (ctx->db,
-                      "PRAGMA journal_mode=OFF",
+                      "PRAGMA journal_mode=WAL",
                       NULL,
                       NULL,
                       NULL) != SQLITE_OK) {
@@ -186,7 +229,7 @@ int job_archive_init (struct job_archive_ctx *ctx)
         goto error;
     }
     if (sqlite3_exec (ctx->db,
-                      "PRAGMA synchronous=OFF",
+                      "PRAGMA synchronous=NORMAL",
                       NULL,
                       NULL,
                       NULL) != SQLITE_OK) {
@@ -210,6 +253,14 @@ int job_archive_init (struct job_archive_ctx *ctx)
         log_sqlite_error (ctx, "creating object table");
         goto error;
     }
+    if (sqlite3_exec (ctx->db,
+                      sql_create_index,
+                      NULL,
+                      NULL,
+                      NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "creating indexes");
+        goto error;
+    }
 
     if (sqlite3_prepare_v2 (ctx->db,
                             sql_store,
@@ -219,6 +270,22 @@ int job_archive_init (struct job_archive_ctx *ctx)
         log_sqlite_error (ctx, "preparing store stmt");
         goto error;
     }
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_begin,
+                            -1,
+                            &ctx->begin_stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing begin stmt");
+        goto error;
+    }
+    if (sqlite3_prepare_v2 (ctx->db,
+                            sql_commit,
+                            -1,
+                            &ctx->commit_stmt,
+                            NULL) != SQLITE_OK) {
+        log_sqlite_error (ctx, "preparing commit stmt");
+        goto error;
+    }
 
     if (job_archive_since_init (ctx) < 0)
         goto error;
@@ -252,7 +319,65 @@ void json_decref_wrapper (void *arg)
     json_decref ((json_t *)arg);
 }
 
-void job_info_lookup_continuation (flux_future_t *f, void *arg)
+/* Execute a prepared statement that returns no rows.  As in
+ * job_info_store(), spin if the database stays busy beyond busy_timeout.
+ */
+static int step_stmt (struct job_archive_ctx *ctx,
+                      sqlite3_stmt *stmt,
+                      const char *name)
+{
+    int rc = 0;
+
+    while (sqlite3_step (stmt) != SQLITE_DONE) {
+        if (sqlite3_errcode (ctx->db) == SQLITE_BUSY) {
+            flux_log (ctx->h, LOG_DEBUG, "%s: %s BUSY", __FUNCTION__, name);
+            usleep (1000);
+            continue;
+        }
+        log_sqlite_error (ctx, "%s: executing stmt", name);
+        rc = -1;
+        break;
+    }
+    sqlite3_reset (stmt);
+    return rc;
+}
+
+/* Rows are inserted in transactions of up to TXN_BATCH rows, so the
+ * per-commit cost is paid once per batch rather than once per job.
+ */
+static int txn_begin (struct job_archive_ctx *ctx)
+{
+    if (!ctx->in_txn) {
+        if (step_stmt (ctx, ctx->begin_stmt, "begin") < 0)
+            return -1;
+        ctx->in_txn = true;
+        ctx->txn_count = 0;
+    }
+    return 0;
+}
+
+static void txn_commit (struct job_archive_ctx *ctx)
+{
+    if (ctx->in_txn) {
+        if (step_stmt (ctx, ctx->commit_stmt, "commit") < 0) {
+            /* If COMMIT failed, sqlite may have left the transaction
+             * open.  Roll back so the next batch starts clean.  The
+             * rows are not lost, since 'since' is re-read below.
+             */
+            if (!sqlite3_get_autocommit (ctx->db))
+                (void)sqlite3_exec (ctx->db, "ROLLBACK;", NULL, NULL, NULL);
+            ctx->since = 0.;
+            (void)job_archive_since_init (ctx);
+        }
+        ctx->in_txn = false;
+        ctx->txn_count = 0;
+    }
+}
+
+/* Pipeline consume callback - store one job in the database.
+ * Errors are logged and the job is skipped.
+ */
+int job_info_store (flux_future_t *pf, flux_future_t *f, void *arg)
 {
     struct job_archive_ctx *ctx = arg;
     json_t *job;
@@ -295,6 +420,9 @@ void job_info_lookup_continuation (flux_future_t *f, void *arg)
         goto out;
     }
 
+    if (txn_begin (ctx) < 0)
+        goto out;
+
     snprintf (idbuf, 64, "%llu", (unsigned long long)id);
     if (sqlite3_bind_text (ctx->store_stmt,
                            1,
@@ -396,18 +524,17 @@ void job_info_lookup_continuation (flux_future_t *f, void *arg)
 
     if (t_inactive > ctx->since)
         ctx->since = t_inactive;
+    ctx->txn_count++;
+    (void)json_object_del (ctx->announced, idbuf);
 
 out:
     sqlite3_reset (ctx->store_stmt);
-    flux_future_destroy (f);
-    if (ctx->kvs_lookup_count
-        && (--(ctx->kvs_lookup_count)) == 0) {
-        flux_timer_watcher_reset (ctx->w, ctx->period, 0.);
-        flux_watcher_start (ctx->w);
-    }
+    if (ctx->txn_count >= TXN_BATCH)
+        txn_commit (ctx);
+    return 0;
 }
 
-int job_info_lookup (struct job_archive_ctx *ctx, json_t *job)
+flux_future_t *job_info_lookup (struct job_archive_ctx *ctx, json_t *job)
 {
     const char *topic = "job-info.lookup";
     flux_future_t *f = NULL;
@@ -441,13 +568,6 @@ int job_info_lookup (struct job_archive_ctx *ctx, json_t *job)
         flux_log_error (ctx->h, "%s: flux_rpc_pack", __FUNCTION__);
         goto error;
     }
-    if (flux_future_then (f,
-                          -1.,
-                          job_info_lookup_continuation,
-                          ctx) < 0) {
-        flux_log_error (ctx->h, "%s: flux_future_then", __FUNCTION__);
-        goto error;
-    }
     if (flux_future_aux_set (f,
                              "job",
                              json_incref (job),
@@ -457,36 +577,107 @@ int job_info_lookup (struct job_archive_ctx *ctx, json_t *job)
     }
 
     json_decref (keys);
-    ctx->kvs_lookup_count++;
-    return 0;
+    return f;
 
 error:
     flux_future_destroy (f);
     json_decref (keys);
-    return -1;
+    return NULL;
+}
+
+/* Pipeline produce callback - look up the next inactive job.
+ */
+flux_future_t *job_info_lookup_next (flux_future_t *pf, void *arg)
+{
+    struct job_archive_ctx *ctx = arg;
+
+    if (ctx->jobs_index >= json_array_size (ctx->jobs)) {
+        errno = ENODATA;
+        return NULL;
+    }
+    return job_info_lookup (ctx, json_array_get (ctx->jobs,
+                                                 ctx->jobs_index++));
+}
+
+/* End an archive pass: commit any open transaction and arm the timer
+ * for the next pass.  If a job went inactive while this pass was in
+ * progress, or a job announced inactive by a job-state event was not
+ * yet listed as inactive by job-info, the next pass starts after
+ * TRIGGER_DELAY instead of 'period'.  Announced jobs are retried for at
+ * most TRIGGER_RETRY_MAX passes, after which the periodic pass takes over.
+ */
+static void archive_done (struct job_archive_ctx *ctx)
+{
+    double after = ctx->period;
+    bool retry = false;
+
+    txn_commit (ctx);
+    json_decref (ctx->jobs);
+    ctx->jobs = NULL;
+    ctx->archiving = false;
+    if (json_object_size (ctx->announced) == 0)
+        ctx->retries = 0;
+    else if (++ctx->retries > TRIGGER_RETRY_MAX) {
+        flux_log (ctx->h, LOG_DEBUG,
+                  "%zu announced jobs not yet archived, waiting for period",
+                  json_object_size (ctx->announced));
+        json_object_clear (ctx->announced);
+        ctx->retries = 0;
+    }
+    else
+        retry = true;
+    if ((ctx->pending || retry) && TRIGGER_DELAY < after) {
+        after = TRIGGER_DELAY;
+        ctx->triggered = true;
+    }
+    ctx->pending = false;
+    flux_timer_watcher_reset (ctx->w, after, 0.);
+    flux_watcher_start (ctx->w);
+}
+
+void job_info_lookup_continuation (flux_future_t *f, void *arg)
+{
+    struct job_archive_ctx *ctx = arg;
+
+    if (flux_future_get (f, NULL) < 0)
+        flux_log_error (ctx->h, "%s: job-info lookup", __FUNCTION__);
+    flux_future_destroy (f);
+    archive_done (ctx);
 }
 
 void job_list_inactive_continuation (flux_future_t *f, void *arg)
 {
     struct job_archive_ctx *ctx = arg;
+    flux_future_t *pf = NULL;
     json_t *jobs;
-    size_t index;
-    json_t *value;
 
     if (flux_rpc_get_unpack (f, "{s:o}", "jobs", &jobs) < 0) {
         flux_log_error (ctx->h, "%s: flux_rpc_get_unpack", __FUNCTION__);
+        flux_future_destroy (f);
+        archive_done (ctx);
         return;
     }
-    json_array_foreach (jobs, index, value) {
-        if (job_info_lookup (ctx, value) < 0)
-            break;
-    }
-    /* If no new inactive jobs, still need to reset timer */
-    if (!ctx->kvs_lookup_count) {
-        flux_timer_watcher_reset (ctx->w, ctx->period, 0.);
-        flux_watcher_start (ctx->w);
-    }
+    ctx->jobs = json_incref (jobs);
+    ctx->jobs_index = 0;
     flux_future_destroy (f);
+
+    /* Look up inactive jobs with at most LOOKUP_WINDOW requests
+     * outstanding.  The timer is reset when all have been stored.
+     */
+    if (!(pf = flux_rpc_pipeline (ctx->h,
+                                  LOOKUP_WINDOW,
+                                  0,
+                                  job_info_lookup_next,
+                                  job_info_store,
+                                  ctx))
+        || flux_future_then (pf,
+                             -1.,
+                             job_info_lookup_continuation,
+                             ctx) < 0) {
+        flux_log_error (ctx->h, "%s: flux_rpc_pipeline", __FUNCTION__);
+        flux_future_destroy (pf);
+        archive_done (ctx);
+    }
 }
 
 void job_archive_cb (flux_reactor_t *r,
@@ -499,16 +690,84 @@ void job_archive_cb (flux_reactor_t *r,
                    "\"t_run\", \"t_cleanup\", \"t_inactive\"]";
     flux_future_t *f;
 
+    ctx->archiving = true;
+    ctx->triggered = false;
     if (!(f = flux_job_list_inactive (ctx->h, 0, ctx->since, attrs))) {
         flux_log_error (ctx->h, "%s: flux_job_list_inactive", __FUNCTION__);
+        archive_done (ctx);
         return;
     }
     if (flux_future_then (f, -1, job_list_inactive_continuation, ctx) < 0) {
         flux_log_error (ctx->h, "%s: flux_future_then", __FUNCTION__);
+        flux_future_destroy (f);
+        archive_done (ctx);
         return;
     }
 }
 
+/* Record the ids of jobs that became inactive in 'transitions' as
+ * announced, and return the number found.
+ */
+static int inactive_transitions (struct job_archive_ctx *ctx,
+                                 json_t *transitions)
+{
+    size_t index;
+    json_t *entry;
+    int count = 0;
+
+    json_array_foreach (transitions, index, entry) {
+        json_int_t id;
+        const char *state;
+        char idbuf[64];
+
+        if (json_unpack (entry, "[Is]", &id, &state) < 0
+            || strcmp (state, "INACTIVE") != 0)
+            continue;
+        snprintf (idbuf, sizeof (idbuf), "%llu", (unsigned long long)id);
+        if (json_object_set_new (ctx->announced, idbuf, json_true ()) < 0)
+            flux_log (ctx->h, LOG_ERR, "%s: out of memory", __FUNCTION__);
+        count++;
+    }
+    return count;
+}
+
+/* Archive jobs shortly after they become inactive instead of waiting
+ * up to 'period'.  The timer is pulled in at most once per pass, so a
+ * steady stream of job-state events batches up rather than postponing
+ * the pass indefinitely.  job-info may not have processed the transition
+ * yet when the pass runs, so passes are repeated while announced jobs
+ * remain unarchived (see archive_done()).
+ */
+static void job_state_cb (flux_t *h,
+                          flux_msg_handler_t *mh,
+                          const flux_msg_t *msg,
+                          void *arg)
+{
+    struct job_archive_ctx *ctx = arg;
+    json_t *transitions;
+
+    if (flux_event_unpack (msg, NULL, "{s:o}",
+                           "transitions", &transitions) < 0) {
+        flux_log_error (h, "%s: flux_event_unpack", __FUNCTION__);
+        return;
+    }
+    if (inactive_transitions (ctx, transitions) == 0)
+        return;
+    if (ctx->archiving)
+        ctx->pending = true;
+    else if (!ctx->triggered && TRIGGER_DELAY < ctx->period) {
+        flux_watcher_stop (ctx->w);
+        flux_timer_watcher_reset (ctx->w, TRIGGER_DELAY, 0.);
+        flux_watcher_start (ctx->w);
+        ctx->triggered = true;
+    }
+}
+
+static const struct flux_msg_handler_spec htab[] = {
+    { FLUX_MSGTYPE_EVENT, "job-state", job_state_cb, 0 },
+    FLUX_MSGHANDLER_TABLE_END,
+};
+
 static void process_config (struct job_archive_ctx *ctx, int ac, char **av)
 {
     flux_conf_error_t err;
@@ -584,6 +843,15 @@ int mod_main (flux_t *h, int ac, char **av)
         }
 
         flux_watcher_start (ctx->w);
+
+        if (flux_event_subscribe (h, "job-state") < 0) {
+            flux_log_error (h, "flux_event_subscribe");
+            goto done;
+        }
+        if (flux_msg_handler_addvec (h, htab, ctx, &ctx->handlers) < 0) {
+            flux_log_error (h, "flux_msg_handler_addvec");
+            goto done;
+        }
     }
 
     if ((rc = flux_reactor_run (flux_get_reactor (h), 0)) < 0)
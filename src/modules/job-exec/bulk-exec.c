@@ -15,12 +15,14 @@
 #include <sys/wait.h>
 #define EXIT_CODE(x) __W_EXITCODE(x,0)
 
+#include <unistd.h>
 #include <flux/core.h>
 #include <flux/idset.h>
 #include <czmq.h>
 
 #include "src/common/libutil/aux.h"
 #include "bulk-exec.h"
+#include "tree-exec.h"
 
 struct exec_cmd {
     struct idset *ranks;
@@ -34,9 +36,11 @@ struct bulk_exec {
     struct aux_item *aux;
 
     int max_start_per_loop;  /* Max subprocess started per event loop cb */
+    int tree_fanout;         /* Launch via tree-exec if > 0 */
     int total;               /* Total processes expected to run */
     int started;             /* Number of processes that have reached start */
     int complete;            /* Number of processes that have completed */
+    int launched;            /* Number of processes launched via tree */
 
     int exit_status;         /* Largest wait status of all complete procs */
 
@@ -53,6 +57,7 @@ struct bulk_exec {
 
     zlist_t *commands;
     zlist_t *processes;
+    zlist_t *trees;          /* Active tree launches (one per command) */
 
     struct bulk_exec_ops *handlers;
     void *arg;
@@ -65,6 +70,8 @@ int bulk_exec_rc (struct bulk_exec *exec)
 
 int bulk_exec_current (struct bulk_exec *exec)
 {
+    if (exec->tree_fanout > 0)
+        return exec->launched - exec->complete;
     return zlist_size (exec->processes);
 }
 
@@ -76,7 +83,13 @@ int bulk_exec_total (struct bulk_exec *exec)
 int bulk_exec_write (struct bulk_exec *exec, const char *stream,
                      const char *buf, size_t len)
 {
-    flux_subprocess_t *p = zlist_first (exec->processes);
+    flux_subprocess_t *p;
+
+    if (exec->tree_fanout > 0) {
+        errno = ENOTSUP;
+        return -1;
+    }
+    p = zlist_first (exec->processes);
     while (p) {
         if (flux_subprocess_write (p, stream, buf, len) < len)
             return -1;
@@ -87,7 +100,13 @@ int bulk_exec_write (struct bulk_exec *exec, const char *stream,
 
 int bulk_exec_close (struct bulk_exec *exec, const char *stream)
 {
-    flux_subprocess_t *p = zlist_first (exec->processes);
+    flux_subprocess_t *p;
+
+    if (exec->tree_fanout > 0) {
+        errno = ENOTSUP;
+        return -1;
+    }
+    p = zlist_first (exec->processes);
     while (p) {
         if (flux_subprocess_close (p, stream) < 0)
             return -1;
@@ -115,7 +134,7 @@ static void exit_batch_cb (flux_reactor_t *r, flux_watcher_t *w,
     exec_exit_notify (exec);
 }
 
-/*  Append completed subprocess 'p' to the current batch for exit
+/*  Append completed process on 'rank' to the current batch for exit
  *   notification. If this is the first exited process in the batch,
  *   then start a timer which will fire and call the function to
  *   notify bulk_exec user of the batch of subprocess exits.
@@ -123,9 +142,8 @@ static void exit_batch_cb (flux_reactor_t *r, flux_watcher_t *w,
  *  This appraoch avoids unecessarily calling into user's callback
  *   multiple times when all tasks exit within 0.01s.
  */
-static void exit_batch_append (struct bulk_exec *exec, flux_subprocess_t *p)
+static void exit_batch_append (struct bulk_exec *exec, int rank)
 {
-    int rank = flux_subprocess_rank (p);
     if (idset_set (exec->exit_batch, rank) < 0) {
         flux_log_error (exec->h, "exit_batch_append:idset_set");
         return;
@@ -145,10 +163,10 @@ static void exit_batch_append (struct bulk_exec *exec, flux_subprocess_t *p)
     }
 }
 
-static void exec_add_completed (struct bulk_exec *exec, flux_subprocess_t *p)
+static void exec_add_completed (struct bulk_exec *exec, int rank)
 {
     /* Append this process to the current batch for notification */
-    exit_batch_append (exec, p);
+    exit_batch_append (exec, rank);
 
     if (++exec->complete == exec->total) {
         exec_exit_notify (exec);
@@ -165,37 +183,54 @@ static void exec_complete_cb (flux_subprocess_t *p)
     if (status > exec->exit_status)
         exec->exit_status = status;
 
-    exec_add_completed (exec, p);
+    exec_add_completed (exec, flux_subprocess_rank (p));
 }
 
-static void exec_state_cb (flux_subprocess_t *p, flux_subprocess_state_t state)
+static void exec_started (struct bulk_exec *exec, int count)
 {
-    struct bulk_exec *exec = flux_subprocess_aux_get (p, "job-exec::exec");
-    if (state == FLUX_SUBPROCESS_RUNNING) {
-        if (++exec->started == exec->total) {
-            if (exec->handlers->on_start)
-                (*exec->handlers->on_start) (exec, exec->arg);
-        }
+    exec->started += count;
+    if (exec->started == exec->total) {
+        if (exec->handlers->on_start)
+            (*exec->handlers->on_start) (exec, exec->arg);
     }
-    else if (state == FLUX_SUBPROCESS_FAILED
-            || state == FLUX_SUBPROCESS_EXEC_FAILED) {
-        int errnum = flux_subprocess_fail_errno (p);
-        int code = EXIT_CODE(1);
+}
 
-        if (errnum == EPERM || errnum == EACCES)
-            code = EXIT_CODE(126);
-        else if (errnum == ENOENT)
-            code = EXIT_CODE(127);
-        else if (errnum == EHOSTUNREACH)
-            code = EXIT_CODE(68);
+/*  Map errno from a failed launch to a shell-like exit code.
+ */
+static int exec_failed_code (int errnum)
+{
+    if (errnum == EPERM || errnum == EACCES)
+        return EXIT_CODE(126);
+    else if (errnum == ENOENT)
+        return EXIT_CODE(127);
+    else if (errnum == EHOSTUNREACH)
+        return EXIT_CODE(68);
+    return EXIT_CODE(1);
+}
 
-        if (code > exec->exit_status)
-            exec->exit_status = code;
+static void exec_failed (struct bulk_exec *exec, int rank, int errnum)
+{
+    int code = exec_failed_code (errnum);
 
-        if (exec->handlers->on_error)
-            (*exec->handlers->on_error) (exec, p, exec->arg);
+    if (code > exec->exit_status)
+        exec->exit_status = code;
 
-        exec_add_completed (exec, p);
+    if (exec->handlers->on_error)
+        (*exec->handlers->on_error) (exec, rank, errnum, exec->arg);
+
+    exec_add_completed (exec, rank);
+}
+
+static void exec_state_cb (flux_subprocess_t *p, flux_subprocess_state_t state)
+{
+    struct bulk_exec *exec = flux_subprocess_aux_get (p, "job-exec::exec");
+    if (state == FLUX_SUBPROCESS_RUNNING)
+        exec_started (exec, 1);
+    else if (state == FLUX_SUBPROCESS_FAILED
+            || state == FLUX_SUBPROCESS_EXEC_FAILED) {
+        exec_failed (exec,
+                     flux_subprocess_rank (p),
+                     flux_subprocess_fail_errno (p));
     }
 }
 
@@ -212,7 +247,8 @@ static void exec_output_cb (flux_subprocess_t *p, const char *stream)
     if (len) {
         int rank = flux_subprocess_rank (p);
         if (exec->handlers->on_output)
-            (*exec->handlers->on_output) (exec, p, stream, s, len, exec->arg);
+            (*exec->handlers->on_output) (exec, rank, stream, s, len,
+                                          exec->arg);
         else
             flux_log (exec->h, LOG_INFO, "rank %d: %s: %s", rank, stream, s);
     }
@@ -269,12 +305,111 @@ static int subprocess_destroy (flux_t *h, flux_subprocess_t *p)
     return 0;
 }
 
+/*  Tree launch callbacks: reduced notifications from the launch tree
+ *   are applied to the bulk_exec object as if from local subprocesses.
+ */
+static void tree_start (struct tree_exec *te,
+                        const struct idset *ranks,
+                        void *arg)
+{
+    exec_started (arg, idset_count (ranks));
+}
+
+static void tree_exit (struct tree_exec *te,
+                       const struct idset *ranks,
+                       int status,
+                       void *arg)
+{
+    struct bulk_exec *exec = arg;
+    unsigned int rank;
+
+    if (status > exec->exit_status)
+        exec->exit_status = status;
+    rank = idset_first (ranks);
+    while (rank != IDSET_INVALID_ID) {
+        exec_add_completed (exec, rank);
+        rank = idset_next (ranks, rank);
+    }
+}
+
+static void tree_error (struct tree_exec *te,
+                        uint32_t rank,
+                        int errnum,
+                        void *arg)
+{
+    exec_failed (arg, rank, errnum);
+}
+
+static void tree_output (struct tree_exec *te,
+                         uint32_t rank,
+                         const char *stream,
+                         const char *data,
+                         int len,
+                         void *arg)
+{
+    struct bulk_exec *exec = arg;
+
+    if (exec->handlers->on_output)
+        (*exec->handlers->on_output) (exec, rank, stream, data, len,
+                                      exec->arg);
+    else
+        flux_log (exec->h, LOG_INFO, "rank %d: %s: %s", rank, stream, data);
+}
+
+static struct tree_exec_ops tree_ops = {
+    .on_start =  tree_start,
+    .on_exit =   tree_exit,
+    .on_error =  tree_error,
+    .on_output = tree_output,
+};
+
+/*  Launch all ranks of 'cmd' with a single request to each child of
+ *   the tree root.  The max per loop limit does not apply, since the
+ *   cost of starting processes is distributed across the tree.
+ */
+static int exec_start_cmd_tree (struct bulk_exec *exec, struct exec_cmd *cmd)
+{
+    static unsigned int seq = 0;
+    struct tree_exec *te;
+    uint32_t rank;
+    char key[128];
+    int count = idset_count (cmd->ranks);
+
+    if (flux_get_rank (exec->h, &rank) < 0)
+        return -1;
+    (void) snprintf (key, sizeof (key), "%u.%ju.%u",
+                     (unsigned int) rank,
+                     (uintmax_t) getpid (),
+                     seq++);
+    if (!(te = tree_exec_launch (exec->h,
+                                 key,
+                                 cmd->ranks,
+                                 exec->tree_fanout,
+                                 cmd->cmd,
+                                 cmd->flags,
+                                 &tree_ops,
+                                 exec)))
+        return -1;
+    if (zlist_append (exec->trees, te) < 0) {
+        tree_exec_destroy (te);
+        errno = ENOMEM;
+        return -1;
+    }
+    zlist_freefn (exec->trees, te, (zlist_free_fn *) tree_exec_destroy, true);
+    exec->launched += count;
+    idset_range_clear (cmd->ranks, 0, INT_MAX);
+    return count;
+}
+
 static int exec_start_cmd (struct bulk_exec *exec,
                            struct exec_cmd *cmd,
                            int max)
 {
     int count = 0;
     uint32_t rank;
+
+    if (exec->tree_fanout > 0)
+        return exec_start_cmd_tree (exec, cmd);
     rank = idset_first (cmd->ranks);
     while (rank != IDSET_INVALID_ID && (max < 0 || count < max)) {
         flux_subprocess_t *p = flux_rexec (exec->h,
@@ -320,7 +455,7 @@ static int exec_start_cmds (struct bulk_exec *exec, int max)
         if (idset_count (cmd->ranks) == 0)
             zlist_remove (exec->commands, cmd);
         if (max > 0)
-            max -= rc;
+            max = rc < max ? max - rc : 0;
 
     }
     return 0;
@@ -350,7 +485,7 @@ static void check_cb (flux_reactor_t *r, flux_watcher_t *w,
     if (exec_start_cmds (exec, exec->max_start_per_loop) < 0) {
         bulk_exec_stop (exec);
         if (exec->handlers->on_error)
-            (*exec->handlers->on_error) (exec, NULL, exec->arg);
+            (*exec->handlers->on_error) (exec, -1, errno, exec->arg);
     }
 }
 
@@ -358,6 +493,7 @@ void bulk_exec_destroy (struct bulk_exec *exec)
 {
     if (exec) {
         zlist_destroy (&exec->processes);
+        zlist_destroy (&exec->trees);
         zlist_destroy (&exec->commands);
         idset_destroy (exec->exit_batch);
         flux_watcher_destroy (exec->prep);
@@ -383,6 +519,7 @@ struct bulk_exec * bulk_exec_create (struct bulk_exec_ops *ops, void *arg)
     exec->handlers = ops;
     exec->arg = arg;
     exec->processes = zlist_new ();
+    exec->trees = zlist_new ();
     exec->commands = zlist_new ();
     exec->exit_batch = idset_create (0, IDSET_FLAG_AUTOGROW);
     exec->max_start_per_loop = 1;
@@ -400,6 +537,16 @@ int bulk_exec_set_max_per_loop (struct bulk_exec *exec, int max)
     return 0;
 }
 
+int bulk_exec_set_tree_fanout (struct bulk_exec *exec, int fanout)
+{
+    if (fanout < 0 || exec->active) {
+        errno = EINVAL;
+        return -1;
+    }
+    exec->tree_fanout = fanout;
+    return 0;
+}
+
 int bulk_exec_push_cmd (struct bulk_exec *exec,
                        const struct idset *ranks,
                        flux_cmd_t *cmd,
@@ -469,12 +616,36 @@ int bulk_exec_cancel (struct bulk_exec *exec)
 flux_future_t *bulk_exec_kill (struct bulk_exec *exec, int signum)
 {
     flux_subprocess_t *p = zlist_first (exec->processes);
+    struct tree_exec *te = zlist_first (exec->trees);
     flux_future_t *cf = NULL;
 
     if (!(cf = flux_future_wait_all_create ()))
         return NULL;
     flux_future_set_flux (cf, exec->h);
 
+    while (te) {
+        if (!tree_exec_finished (te)) {
+            flux_future_t *f;
+            char s[64];
+            if (!(f = tree_exec_kill (te, signum))) {
+                int err = errno;
+                if (err == ENOENT)
+                    goto next;
+                if ((f = flux_future_create (NULL, NULL)))
+                    flux_future_fulfill_error (f, err, flux_strerror (err));
+                else
+                    flux_future_fulfill_error (cf, err, "Internal error");
+            }
+            (void) snprintf (s, sizeof (s)-1, "tree.%p", (void *) te);
+            if (flux_future_push (cf, s, f) < 0) {
+                fprintf (stderr, "flux_future_push: %s\n", strerror (errno));
+                flux_future_destroy (f);
+            }
+        }
+next:
+        te = zlist_next (exec->trees);
+    }
+
     while (p) {
         if (flux_subprocess_state (p) == FLUX_SUBPROCESS_RUNNING
             || flux_subprocess_state (p) == FLUX_SUBPROCESS_INIT) {
@@ -511,13 +682,12 @@ flux_future_t *bulk_exec_kill (struct bulk_exec *exec, int signum)
 }
 
 static void imp_kill_output (struct bulk_exec *kill,
-                             flux_subprocess_t *p,
+                             int rank,
                              const char *stream,
                              const char *data,
                              int len,
                              void *arg)
 {
-    int rank = flux_subprocess_rank (p);
     flux_log (kill->h, LOG_INFO,
               "rank%d: flux-imp kill: %s: %s",
               rank,
@@ -535,12 +705,14 @@ static void imp_kill_complete (struct bulk_exec *kill, void *arg)
 }
 
 static void imp_kill_error (struct bulk_exec *kill,
-                            flux_subprocess_t *p,
+                            int rank,
+                            int errnum,
                             void *arg)
 {
-    flux_log_error (kill->h,
-                    "imp kill: rank=%d: failed",
-                    flux_subprocess_rank (p));
+    flux_log (kill->h, LOG_ERR,
+              "imp kill: rank=%d: failed: %s",
+              rank,
+              flux_strerror (errnum));
 }
 
 
@@ -579,6 +751,11 @@ flux_future_t *bulk_exec_imp_kill (struct bulk_exec *exec,
     flux_future_t *f = NULL;
     int count = 0;
 
+    if (exec->tree_fanout > 0) {
+        errno = ENOTSUP;
+        return NULL;
+    }
+
     /* Empty future for return value
      */
     if (!(f = flux_future_create (NULL, NULL))) {
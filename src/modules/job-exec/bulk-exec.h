@@ -23,14 +23,18 @@ typedef void (*exec_exit_f) (struct bulk_exec *, void *arg,
                              const struct idset *ranks);
 
 typedef void (*exec_io_f)   (struct bulk_exec *,
-                             flux_subprocess_t *,
+                             int rank,
                              const char *stream,
 			     const char *data,
 			     int data_len,
                              void *arg);
 
+/*  Called with the failed rank and errno, or rank = -1 if processes
+ *   could not be launched at all.
+ */
 typedef void (*exec_error_f) (struct bulk_exec *,
-                              flux_subprocess_t *,
+                              int rank,
+                              int errnum,
                               void *arg);
 
 struct bulk_exec_ops {
@@ -55,6 +59,15 @@ int bulk_exec_aux_set (struct bulk_exec *exec,
  */
 int bulk_exec_set_max_per_loop (struct bulk_exec *exec, int max);
 
+/*  Launch each command hierarchically through a tree of the given fanout
+ *   (see tree-exec.h) instead of one flux_rexec(3) per rank from the
+ *   caller.  Requires the job-exec module to be loaded on all target ranks.
+ *   Process stdin is not available in this mode, so bulk_exec_write(),
+ *   bulk_exec_close() and bulk_exec_imp_kill() fail with ENOTSUP.
+ *   A fanout of 0 (the default) disables tree launch.
+ */
+int bulk_exec_set_tree_fanout (struct bulk_exec *exec, int fanout);
+
 void bulk_exec_destroy (struct bulk_exec *exec);
 
 int bulk_exec_push_cmd (struct bulk_exec *exec,
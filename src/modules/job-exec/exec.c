@@ -14,6 +14,12 @@
  *
  * Launch configured job shell, one per rank.
  *
+ * By default all job shells are started directly from this rank.
+ * If exec.tree-fanout (or the tree-fanout=N module option) is set,
+ * shells of single-user jobs are instead launched through a k-ary tree
+ * of job-exec modules over the job's ranks (see tree-exec.c), which
+ * requires job-exec to be loaded on all ranks.
+ *
  * TEST CONFIGURATION
  *
  * Test and other configuration may be presented in the jobspec
@@ -40,6 +46,7 @@ extern char **environ;
 static const char *default_cwd = "/tmp";
 static const char *default_job_shell = NULL;
 static const char *flux_imp_path = NULL;
+static int tree_fanout = 0;
 
 /* Configuration for "bulk" execution implementation. Used only for testing
  *  for now.
@@ -137,7 +144,7 @@ static void complete_cb (struct bulk_exec *exec, void *arg)
                             bulk_exec_rc (exec));
 }
 
-static void output_cb (struct bulk_exec *exec, flux_subprocess_t *p,
+static void output_cb (struct bulk_exec *exec, int rank,
                        const char *stream,
                        const char *data,
                        int data_len,
@@ -146,17 +153,21 @@ static void output_cb (struct bulk_exec *exec, flux_subprocess_t *p,
     struct jobinfo *job = arg;
     flux_log (job->h, LOG_INFO, "%ju: %d: %s: %s",
                       (uintmax_t) job->id,
-                      flux_subprocess_rank (p),
+                      rank,
                       stream, data);
 }
 
-static void error_cb (struct bulk_exec *exec, flux_subprocess_t *p, void *arg)
+static void error_cb (struct bulk_exec *exec, int rank, int errnum, void *arg)
 {
     struct jobinfo *job = arg;
-    const char *arg0 = flux_cmd_arg (flux_subprocess_get_cmd (p), 0);
-    jobinfo_fatal_error (job, flux_subprocess_fail_errno (p),
-                              "cmd=%s: rank=%d failed",
-                              arg0, flux_subprocess_rank (p));
+    const char *arg0 = job->multiuser ? flux_imp_path : job_shell_path (job);
+
+    if (rank < 0)
+        jobinfo_fatal_error (job, errnum, "cmd=%s: launch failed", arg0);
+    else
+        jobinfo_fatal_error (job, errnum,
+                                  "cmd=%s: rank=%d failed",
+                                  arg0, rank);
 }
 
 static struct bulk_exec_ops exec_ops = {
@@ -189,6 +200,15 @@ static int exec_init (struct jobinfo *job)
         flux_log_error (job->h, "exec_init: bulk_exec_create");
         goto err;
     }
+    /*  Multiuser jobs need stdin of each IMP, so are always launched
+     *   directly from this rank.
+     */
+    if (!job->multiuser
+        && tree_fanout > 0
+        && bulk_exec_set_tree_fanout (exec, tree_fanout) < 0) {
+        flux_log_error (job->h, "exec_init: bulk_exec_set_tree_fanout");
+        goto err;
+    }
     if (!(conf = exec_conf_create (job->jobspec))) {
         flux_log_error (job->h, "exec_init: exec_conf_create");
         goto err;
@@ -373,16 +393,37 @@ static int exec_config (flux_t *h, int argc, char **argv)
         return -1;
     }
 
+    /*  Check configuration for exec.tree-fanout */
+    if (flux_conf_unpack (flux_get_conf (h),
+                          &err,
+                          "{s?:{s?i}}",
+                          "exec",
+                            "tree-fanout", &tree_fanout) < 0) {
+        flux_log (h, LOG_ERR,
+                  "error reading config value exec.tree-fanout: %s",
+                  err.errbuf);
+        return -1;
+    }
+
     /* Finally, override values on cmdline */
     for (int i = 0; i < argc; i++) {
         if (strncmp (argv[i], "job-shell=", 10) == 0)
             default_job_shell = argv[i]+10;
         else if (strncmp (argv[i], "imp=", 4) == 0)
             flux_imp_path = argv[i]+4;
+        else if (strncmp (argv[i], "tree-fanout=", 12) == 0)
+            tree_fanout = strtol (argv[i]+12, NULL, 10);
+    }
+    if (tree_fanout < 0) {
+        flux_log (h, LOG_ERR, "invalid tree-fanout: %d", tree_fanout);
+        errno = EINVAL;
+        return -1;
     }
     flux_log (h, LOG_DEBUG, "using default shell path %s", default_job_shell);
     if (flux_imp_path)
         flux_log (h, LOG_DEBUG, "using imp path %s", flux_imp_path);
+    if (tree_fanout > 0)
+        flux_log (h, LOG_DEBUG, "using tree launch fanout %d", tree_fanout);
     return 0;
 }
 
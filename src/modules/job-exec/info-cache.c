@@ -0,0 +1,325 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* Per-broker cache of job information for job shells
+ *
+ * Each entry holds the encoded "job-exec.info" response for one job,
+ * so a hit costs one flux_respond(3) with no re-encoding.  Entries on
+ * rank 0 live as long as the job in job-exec.  Entries on other ranks
+ * are copies fetched from the parent broker, and expire cache_timeout
+ * seconds after they arrive, by which time all shells of the job have
+ * normally been started.
+ *
+ * Every request is checked against the job owner, whether it is
+ * answered from the cache or after an upstream lookup.
+ */
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <jansson.h>
+#include <czmq.h>
+#include <flux/core.h>
+
+#include "src/common/libjob/job_hash.h"
+
+#include "info-cache.h"
+
+struct info_entry {
+    struct info_cache *ic;
+    flux_jobid_t id;
+    uint32_t userid;
+    char *payload;              /* encoded response, NULL while pending */
+    zlist_t *requests;          /* requests waiting for upstream lookup */
+    flux_future_t *f;           /* upstream lookup */
+    flux_watcher_t *timer;      /* expiration of an upstream copy */
+};
+
+struct info_cache {
+    flux_t *h;
+    uint32_t rank;
+    zhashx_t *entries;
+    flux_msg_handler_t **handlers;
+};
+
+static const double cache_timeout = 60.;
+
+static void info_entry_destroy (struct info_entry *e)
+{
+    if (e) {
+        int saved_errno = errno;
+        const flux_msg_t *msg;
+
+        if (e->requests) {
+            while ((msg = zlist_pop (e->requests)))
+                flux_msg_decref (msg);
+            zlist_destroy (&e->requests);
+        }
+        flux_future_destroy (e->f);
+        flux_watcher_destroy (e->timer);
+        free (e->payload);
+        free (e);
+        errno = saved_errno;
+    }
+}
+
+static void info_entry_destructor (void **item)
+{
+    if (item) {
+        info_entry_destroy (*item);
+        *item = NULL;
+    }
+}
+
+static struct info_entry *info_entry_create (struct info_cache *ic,
+                                             flux_jobid_t id)
+{
+    struct info_entry *e;
+
+    if (!(e = calloc (1, sizeof (*e))))
+        return NULL;
+    e->ic = ic;
+    e->id = id;
+    if (!(e->requests = zlist_new ())) {
+        free (e);
+        errno = ENOMEM;
+        return NULL;
+    }
+    return e;
+}
+
+/*  Insert 'e' into the cache, replacing any existing entry for the job.
+ */
+static int info_entry_insert (struct info_cache *ic, struct info_entry *e)
+{
+    zhashx_delete (ic->entries, &e->id);
+    if (zhashx_insert (ic->entries, &e->id, e) < 0) {
+        errno = EEXIST;
+        return -1;
+    }
+    return 0;
+}
+
+static void info_entry_respond (struct info_entry *e, const flux_msg_t *msg)
+{
+    flux_t *h = e->ic->h;
+
+    if (flux_msg_authorize (msg, e->userid) < 0) {
+        if (flux_respond_error (h, msg, errno, NULL) < 0)
+            flux_log_error (h, "job-exec.info: flux_respond_error");
+        return;
+    }
+    if (flux_respond (h, msg, e->payload) < 0)
+        flux_log_error (h, "job-exec.info: flux_respond");
+}
+
+static void expire_cb (flux_reactor_t *r,
+                       flux_watcher_t *w,
+                       int revents,
+                       void *arg)
+{
+    struct info_entry *e = arg;
+    zhashx_delete (e->ic->entries, &e->id);
+}
+
+static void lookup_continuation (flux_future_t *f, void *arg)
+{
+    struct info_entry *e = arg;
+    struct info_cache *ic = e->ic;
+    const flux_msg_t *msg;
+    const char *s;
+    int userid;
+
+    if (flux_rpc_get_unpack (f, "{s:i}", "userid", &userid) < 0
+        || flux_rpc_get (f, &s) < 0
+        || !(e->payload = strdup (s))
+        || !(e->timer = flux_timer_watcher_create (flux_get_reactor (ic->h),
+                                                   cache_timeout,
+                                                   0.,
+                                                   expire_cb,
+                                                   e))) {
+        int errnum = errno;
+        while ((msg = zlist_pop (e->requests))) {
+            if (flux_respond_error (ic->h, msg, errnum, NULL) < 0)
+                flux_log_error (ic->h, "job-exec.info: flux_respond_error");
+            flux_msg_decref (msg);
+        }
+        zhashx_delete (ic->entries, &e->id);
+        return;
+    }
+    e->userid = userid;
+    flux_future_destroy (f);
+    e->f = NULL;
+    while ((msg = zlist_pop (e->requests))) {
+        info_entry_respond (e, msg);
+        flux_msg_decref (msg);
+    }
+    flux_watcher_start (e->timer);
+}
+
+/*  Create a pending entry for job 'id' and look it up on the parent.
+ */
+static struct info_entry *info_entry_lookup (struct info_cache *ic,
+                                             flux_jobid_t id)
+{
+    struct info_entry *e;
+
+    if (!(e = info_entry_create (ic, id)))
+        return NULL;
+    if (!(e->f = flux_rpc_pack (ic->h,
+                                "job-exec.info",
+                                FLUX_NODEID_UPSTREAM,
+                                0,
+                                "{s:I}",
+                                "id", id))
+        || flux_future_then (e->f, -1., lookup_continuation, e) < 0
+        || info_entry_insert (ic, e) < 0) {
+        info_entry_destroy (e);
+        return NULL;
+    }
+    return e;
+}
+
+static void info_cb (flux_t *h,
+                     flux_msg_handler_t *mh,
+                     const flux_msg_t *msg,
+                     void *arg)
+{
+    struct info_cache *ic = arg;
+    struct info_entry *e;
+    flux_jobid_t id;
+
+    if (flux_request_unpack (msg, NULL, "{s:I}", "id", &id) < 0)
+        goto error;
+    if (!(e = zhashx_lookup (ic->entries, &id))) {
+        if (ic->rank == 0) {
+            errno = ENOENT;
+            goto error;
+        }
+        if (!(e = info_entry_lookup (ic, id)))
+            goto error;
+    }
+    if (e->payload)
+        info_entry_respond (e, msg);
+    else if (zlist_append (e->requests, (void *) flux_msg_incref (msg)) < 0) {
+        flux_msg_decref (msg);
+        errno = ENOMEM;
+        goto error;
+    }
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "job-exec.info: flux_respond_error");
+}
+
+int info_cache_add (struct info_cache *ic,
+                    flux_jobid_t id,
+                    uint32_t userid,
+                    const char *jobspec,
+                    const char *R)
+{
+    struct info_entry *e;
+    json_t *o;
+
+    if (!ic || !jobspec || !R) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(e = info_entry_create (ic, id)))
+        return -1;
+    e->userid = userid;
+    if (!(o = json_pack ("{s:I s:i s:s s:s}",
+                         "id", id,
+                         "userid", userid,
+                         "jobspec", jobspec,
+                         "R", R))
+        || !(e->payload = json_dumps (o, JSON_COMPACT))) {
+        json_decref (o);
+        info_entry_destroy (e);
+        errno = ENOMEM;
+        return -1;
+    }
+    json_decref (o);
+    if (info_entry_insert (ic, e) < 0) {
+        info_entry_destroy (e);
+        return -1;
+    }
+    return 0;
+}
+
+void info_cache_remove (struct info_cache *ic, flux_jobid_t id)
+{
+    if (ic)
+        zhashx_delete (ic->entries, &id);
+}
+
+static const struct flux_msg_handler_spec htab[] = {
+    { FLUX_MSGTYPE_REQUEST, "job-exec.info", info_cb, FLUX_ROLE_USER },
+    FLUX_MSGHANDLER_TABLE_END,
+};
+
+/*  Answer requests still waiting on an upstream lookup with ENOSYS,
+ *   since the module is going away and the lookup will never finish.
+ */
+static void info_cache_respond_pending (struct info_cache *ic)
+{
+    struct info_entry *e;
+    const flux_msg_t *msg;
+
+    e = zhashx_first (ic->entries);
+    while (e) {
+        while ((msg = zlist_pop (e->requests))) {
+            if (flux_respond_error (ic->h, msg, ENOSYS, NULL) < 0)
+                flux_log_error (ic->h, "job-exec.info: flux_respond_error");
+            flux_msg_decref (msg);
+        }
+        e = zhashx_next (ic->entries);
+    }
+}
+
+void info_cache_destroy (struct info_cache *ic)
+{
+    if (ic) {
+        int saved_errno = errno;
+        flux_msg_handler_delvec (ic->handlers);
+        if (ic->entries) {
+            info_cache_respond_pending (ic);
+            zhashx_destroy (&ic->entries);
+        }
+        free (ic);
+        errno = saved_errno;
+    }
+}
+
+struct info_cache *info_cache_create (flux_t *h)
+{
+    struct info_cache *ic;
+
+    if (!(ic = calloc (1, sizeof (*ic))))
+        return NULL;
+    ic->h = h;
+    if (flux_get_rank (h, &ic->rank) < 0)
+        goto error;
+    if (!(ic->entries = job_hash_create ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    zhashx_set_destructor (ic->entries, info_entry_destructor);
+    if (flux_msg_handler_addvec (h, htab, ic, &ic->handlers) < 0)
+        goto error;
+    return ic;
+error:
+    info_cache_destroy (ic);
+    return NULL;
+}
+
+/* vi: ts=4 sw=4 expandtab
+ */
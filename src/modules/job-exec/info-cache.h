@@ -0,0 +1,48 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* Per-broker cache of job information for job shells
+ *
+ * The "job-exec.info" service is provided on every rank.  A request
+ * {"id":I} is answered with {"id":I, "userid":i, "jobspec":s, "R":s},
+ * a superset of the job-info.lookup response for the same keys.
+ *
+ * On rank 0, entries are added by job-exec for each job it starts.
+ * On other ranks, a miss is forwarded upstream once, concurrent requests
+ * for the same job wait for that response, and the result is cached
+ * for a short time.  Thus a job of N shells costs rank 0 one request per
+ * TBON child instead of N job-info.lookup requests.
+ */
+
+#ifndef HAVE_JOB_EXEC_INFO_CACHE_H
+#define HAVE_JOB_EXEC_INFO_CACHE_H 1
+
+#include <flux/core.h>
+
+struct info_cache;
+
+struct info_cache *info_cache_create (flux_t *h);
+void info_cache_destroy (struct info_cache *ic);
+
+/* Make 'jobspec' and 'R' of job 'id', owned by 'userid', available
+ * to job shells until info_cache_remove() is called.
+ */
+int info_cache_add (struct info_cache *ic,
+                    flux_jobid_t id,
+                    uint32_t userid,
+                    const char *jobspec,
+                    const char *R);
+
+void info_cache_remove (struct info_cache *ic, flux_jobid_t id);
+
+#endif /* !HAVE_JOB_EXEC_INFO_CACHE_H */
+
+/* vi: ts=4 sw=4 expandtab
+ */
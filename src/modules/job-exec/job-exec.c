@@ -34,7 +34,9 @@
  *
  * Jobspec and R are parsed as soon as asynchronous initialization tasks
  * complete. If any of these steps fail, an exec initialization exception
- * is thrown. Finally, the implementation "init" method is called.
+ * is thrown. Jobspec and R are then made available to job shells through
+ * the job-exec.info service (see info-cache.h). Finally, the
+ * implementation "init" method is called.
  *
  * JOB STARTING/RUNNING:
  *
@@ -101,6 +103,8 @@
 #include "src/common/libutil/fsd.h"
 #include "src/common/libutil/errno_safe.h"
 #include "job-exec.h"
+#include "tree-exec.h"
+#include "info-cache.h"
 
 static double kill_timeout=5.0;
 
@@ -117,6 +121,8 @@ struct job_exec_ctx {
     flux_t *              h;
     flux_msg_handler_t ** handlers;
     zhashx_t *            jobs;
+    struct tree_exec_service *tree;
+    struct info_cache *   info;
 };
 
 void jobinfo_incref (struct jobinfo *job)
@@ -130,6 +136,7 @@ void jobinfo_decref (struct jobinfo *job)
         int saved_errno = errno;
         flux_watcher_destroy (job->kill_timer);
         flux_watcher_destroy (job->expiration_timer);
+        info_cache_remove (job->ctx->info, job->id);
         zhashx_delete (job->ctx->jobs, &job->id);
         if (job->impl && job->impl->exit)
             (*job->impl->exit) (job);
@@ -826,6 +833,11 @@ static void jobinfo_start_continue (flux_future_t *f, void *arg)
         jobinfo_fatal_error (job, errno, "reading jobspec: %s", error.text);
         goto done;
     }
+    /*  Serve jobspec and R to job shells via job-exec.info.  On failure,
+     *   shells fall back to job-info.lookup, so this is not fatal.
+     */
+    if (info_cache_add (job->ctx->info, job->id, job->userid, jobspec, R) < 0)
+        flux_log_error (job->h, "info_cache_add");
     if (jobinfo_load_implementation (job) < 0) {
         jobinfo_fatal_error (job, errno, "failed to initialize implementation");
         goto done;
@@ -1061,6 +1073,8 @@ static void job_exec_ctx_destroy (struct job_exec_ctx *ctx)
         return;
     zhashx_destroy (&ctx->jobs);
     flux_msg_handler_delvec (ctx->handlers);
+    tree_exec_service_destroy (ctx->tree);
+    info_cache_destroy (ctx->info);
     free (ctx);
 }
 
@@ -1152,8 +1166,33 @@ int mod_main (flux_t *h, int argc, char **argv)
 {
     int saved_errno = 0;
     int rc = -1;
+    uint32_t rank = FLUX_NODEID_ANY;
     struct job_exec_ctx *ctx = job_exec_ctx_create (h);
 
+    if (!ctx) {
+        flux_log_error (h, "job-exec: failed to create context");
+        return -1;
+    }
+    /*  Every rank provides the tree launch and job info services for
+     *   job shells.  Only rank 0 is an exec service for the job-manager.
+     */
+    if (!(ctx->tree = tree_exec_service_create (h))) {
+        flux_log_error (h, "tree_exec_service_create");
+        goto out;
+    }
+    if (!(ctx->info = info_cache_create (h))) {
+        flux_log_error (h, "info_cache_create");
+        goto out;
+    }
+    if (flux_get_rank (h, &rank) < 0) {
+        flux_log_error (h, "flux_get_rank");
+        goto out;
+    }
+    if (rank > 0) {
+        rc = flux_reactor_run (flux_get_reactor (h), 0);
+        goto out;
+    }
+
     if (job_exec_initialize (h, argc, argv) < 0
         || configure_implementations (h, argc, argv) < 0) {
         flux_log_error (h, "job-exec: module initialization failed");
@@ -1174,7 +1213,7 @@ int mod_main (flux_t *h, int argc, char **argv)
     rc = flux_reactor_run (flux_get_reactor (h), 0);
 out:
     saved_errno = errno;
-    if (flux_event_unsubscribe (h, "job-exception") < 0)
+    if (rank == 0 && flux_event_unsubscribe (h, "job-exception") < 0)
         flux_log_error (h, "flux_event_unsubscribe ('job-exception')");
     job_exec_ctx_destroy (ctx);
     errno = saved_errno;
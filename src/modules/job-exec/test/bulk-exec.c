@@ -22,19 +22,21 @@
 
 #include "bulk-exec.h"
 #include "src/common/libutil/log.h"
+#include "src/common/libutil/monotime.h"
 
 extern char **environ;
 static int cancel_after = 0;
+static struct timespec t0;
 
 void started (struct bulk_exec *exec, void *arg)
 {
-    log_msg ("started");
+    log_msg ("started in %.3fs", monotime_since (t0) / 1000.);
 }
 
 void complete (struct bulk_exec *exec, void *arg)
 {
     flux_t *h = arg;
-    log_msg ("complete");
+    log_msg ("complete in %.3fs", monotime_since (t0) / 1000.);
     flux_reactor_stop (flux_get_reactor (h));
 }
 
@@ -45,24 +47,19 @@ void exited (struct bulk_exec *exec, void *arg, const struct idset *ids)
     free (s);
 }
 
-void on_error (struct bulk_exec *exec, flux_subprocess_t *p, void *arg)
+void on_error (struct bulk_exec *exec, int rank, int errnum, void *arg)
 {
-    if (p) {
-        flux_subprocess_state_t state = flux_subprocess_state (p);
-        log_msg ("%d: pid %ju: %s", flux_subprocess_rank (p),
-                (uintmax_t) flux_subprocess_pid (p),
-                flux_subprocess_state_string (state));
-    }
+    if (rank >= 0)
+        log_msg ("%d: %s", rank, strerror (errnum));
     flux_future_t *f = bulk_exec_kill (exec, 9);
     if (flux_future_get (f, NULL) < 0)
         log_err_exit ("bulk_exec_kill");
 }
 
-void on_output (struct bulk_exec *exec, flux_subprocess_t *p,
+void on_output (struct bulk_exec *exec, int rank,
                 const char *stream, const char *data,
                 int data_len, void *arg)
 {
-    int rank = flux_subprocess_rank (p);
     FILE *fp = strcmp (stream, "stdout") == 0 ? stdout : stderr;
     fprintf (fp, "%d: %s", rank, data);
 }
@@ -189,6 +186,13 @@ int main (int ac, char **av)
           .arginfo = "NCMDS",
           .usage = "Cancel after NCMDS cmds have been launched"
         },
+        { .name = "tree-fanout",
+          .key  = 't',
+          .has_arg = 1,
+          .arginfo = "K",
+          .usage = "Launch through a tree of fanout K (requires job-exec "
+                   "module on all ranks)"
+        },
         OPTPARSE_TABLE_END
     };
 
@@ -238,10 +242,15 @@ int main (int ac, char **av)
     if (bulk_exec_set_max_per_loop (exec, optparse_get_int (p, "mpl", -1)) < 0)
         log_err_exit ("bulk_exec_set_max_per_loop");
 
+    if (bulk_exec_set_tree_fanout (exec,
+                                   optparse_get_int (p, "tree-fanout", 0)) < 0)
+        log_err_exit ("bulk_exec_set_tree_fanout");
+
     ncmds = optparse_get_int (p, "ncmds", 1);
 
     push_commands (exec, idset, ncmds, ac, av);
 
+    monotime (&t0);
     if (bulk_exec_start (h, exec) < 0)
         log_err_exit ("bulk_exec_start");
 
@@ -0,0 +1,1117 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* Hierarchical launch of one command per rank
+ *
+ * OPERATION
+ *
+ * The N target ranks are laid out as positions 1..N of a k-ary tree
+ * (see libutil/kary.c) whose root, position 0, is the launcher itself.
+ * Position p > 0 is the (p-1)th rank of the target idset, in order.
+ *
+ * A "job-exec.tree-launch" request carries the launch key, the encoded
+ * target idset, the position of the receiver, the fanout, and the
+ * command template, so every rank can compute its own children without
+ * further communication.  The receiver forwards the request unmodified
+ * (apart from "index") to its children, then starts its local process
+ * with flux_rexec(3) to its own rank.
+ *
+ * Responses are streamed back to the parent, batched with a short timer
+ * as in bulk-exec's exit batching.  Each response is an object with the
+ * optional keys
+ *
+ *  "start":s                          - idset of ranks now running
+ *  "output":[[rank,stream,data],...]  - lines of output
+ *  "error":[[rank,errnum],...]        - ranks that failed to start
+ *  "exit":{"ranks":s,"status":i}      - idset of exited ranks, max status
+ *
+ * and the stream is terminated with ENODATA once the receiver and its
+ * whole subtree have exited.  Any other error terminating a child stream
+ * causes every unreported rank of that subtree to be reported as an error.
+ *
+ * If the sender of a launch request disconnects, or the launcher is
+ * destroyed before its children finish (sending "job-exec.tree-cancel"),
+ * the receiver kills its local process and subtree with SIGKILL and
+ * drops the launch once they have exited, without further responses.
+ */
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <limits.h>
+#include <signal.h>
+#include <jansson.h>
+#include <czmq.h>
+#include <flux/core.h>
+#include <flux/idset.h>
+
+#include "src/common/libsubprocess/command.h"
+#include "src/common/libutil/kary.h"
+
+#include "tree-exec.h"
+
+struct tree_child {
+    struct tree_exec *te;
+    uint32_t rank;
+    flux_future_t *f;
+    struct idset *pending;      /* ranks in subtree not yet exited */
+    bool done;
+};
+
+struct tree_exec {
+    flux_t *h;
+    char *key;
+    zlist_t *children;
+    int active;                 /* child streams not yet terminated */
+    const struct tree_exec_ops *ops;
+    void *arg;
+};
+
+struct tree_launch {
+    struct tree_exec_service *svc;
+    char *key;
+    const flux_msg_t *msg;
+    char *sender;               /* uuid of requestor, for disconnect */
+    flux_subprocess_t *p;
+    struct tree_exec *te;       /* launch of child subtrees, if any */
+    bool local_done;
+    bool finished;
+    bool cancelled;             /* requestor is gone, do not respond */
+
+    /* Batched notifications for the parent */
+    struct idset *started;
+    struct idset *exited;
+    int exit_status;
+    json_t *errors;
+    json_t *output;
+    flux_watcher_t *timer;
+    bool timer_armed;
+};
+
+struct tree_exec_service {
+    flux_t *h;
+    uint32_t rank;
+    zhash_t *launches;
+    flux_msg_handler_t **handlers;
+};
+
+static const double batch_timeout = 0.01;
+
+/*  Decode target idset 's' into an array of ranks in tree position order.
+ *   Since position 0 is the launcher, the tree size is count + 1.
+ */
+static uint32_t *ranks_decode (const char *s, uint32_t *sizep)
+{
+    struct idset *ids;
+    uint32_t *rankv;
+    unsigned int id;
+    uint32_t n = 0;
+
+    if (!(ids = idset_decode (s)))
+        return NULL;
+    if (idset_count (ids) == 0) {
+        idset_destroy (ids);
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(rankv = calloc (idset_count (ids), sizeof (rankv[0])))) {
+        idset_destroy (ids);
+        return NULL;
+    }
+    id = idset_first (ids);
+    while (id != IDSET_INVALID_ID) {
+        rankv[n++] = id;
+        id = idset_next (ids, id);
+    }
+    idset_destroy (ids);
+    *sizep = n + 1;
+    return rankv;
+}
+
+/*  Return the set of ranks in the subtree rooted at position 'index'.
+ *   The children of position i are k*i+1 .. k*i+k, so each level of
+ *   the subtree is a contiguous range of positions.
+ */
+static struct idset *subtree_ranks (int k,
+                                    uint32_t size,
+                                    uint32_t index,
+                                    const uint32_t *rankv)
+{
+    struct idset *ids;
+    uint64_t lo = index;
+    uint64_t hi = index;
+
+    if (!(ids = idset_create (0, IDSET_FLAG_AUTOGROW)))
+        return NULL;
+    while (lo < size) {
+        uint64_t i;
+        for (i = lo; i <= hi && i < size; i++) {
+            if (idset_set (ids, rankv[i - 1]) < 0) {
+                idset_destroy (ids);
+                return NULL;
+            }
+        }
+        lo = lo * k + 1;
+        hi = hi * k + k;
+    }
+    return ids;
+}
+
+static void tree_child_destroy (void *arg)
+{
+    struct tree_child *child = arg;
+    if (child) {
+        int saved_errno = errno;
+        flux_future_destroy (child->f);
+        idset_destroy (child->pending);
+        free (child);
+        errno = saved_errno;
+    }
+}
+
+/*  Tell a child that was sent a launch request to kill its subtree,
+ *   since nobody will be listening for its responses.
+ */
+static void tree_child_cancel (struct tree_child *child)
+{
+    struct tree_exec *te = child->te;
+    flux_future_t *f;
+
+    if (!(f = flux_rpc_pack (te->h,
+                             "job-exec.tree-cancel",
+                             child->rank,
+                             FLUX_RPC_NORESPONSE,
+                             "{s:s}",
+                             "key", te->key)))
+        flux_log_error (te->h,
+                        "tree-exec: %s: cancel rank %u",
+                        te->key,
+                        (unsigned int) child->rank);
+    flux_future_destroy (f);
+}
+
+void tree_exec_destroy (struct tree_exec *te)
+{
+    if (te) {
+        int saved_errno = errno;
+        if (te->children) {
+            struct tree_child *child = zlist_first (te->children);
+            while (child) {
+                if (child->f && !child->done)
+                    tree_child_cancel (child);
+                child = zlist_next (te->children);
+            }
+        }
+        zlist_destroy (&te->children);
+        free (te->key);
+        free (te);
+        errno = saved_errno;
+    }
+}
+
+bool tree_exec_finished (struct tree_exec *te)
+{
+    return te->active == 0;
+}
+
+/*  Report every unreported rank of 'child' subtree as failed with errnum.
+ */
+static void tree_child_lost (struct tree_child *child, int errnum)
+{
+    struct tree_exec *te = child->te;
+    unsigned int rank;
+
+    rank = idset_first (child->pending);
+    while (rank != IDSET_INVALID_ID) {
+        if (te->ops->on_error)
+            (*te->ops->on_error) (te, rank, errnum, te->arg);
+        rank = idset_next (child->pending, rank);
+    }
+    idset_range_clear (child->pending, 0, INT_MAX);
+}
+
+static void tree_child_output (struct tree_child *child, json_t *output)
+{
+    struct tree_exec *te = child->te;
+    size_t index;
+    json_t *entry;
+
+    json_array_foreach (output, index, entry) {
+        int rank;
+        const char *stream;
+        const char *data;
+        size_t len;
+
+        if (json_unpack (entry, "[is s%]", &rank, &stream, &data, &len) < 0) {
+            flux_log (te->h, LOG_ERR, "tree-exec: malformed output entry");
+            continue;
+        }
+        if (te->ops->on_output)
+            (*te->ops->on_output) (te, rank, stream, data, len, te->arg);
+    }
+}
+
+static void tree_child_errors (struct tree_child *child, json_t *errors)
+{
+    struct tree_exec *te = child->te;
+    size_t index;
+    json_t *entry;
+
+    json_array_foreach (errors, index, entry) {
+        int rank;
+        int errnum;
+
+        if (json_unpack (entry, "[ii]", &rank, &errnum) < 0) {
+            flux_log (te->h, LOG_ERR, "tree-exec: malformed error entry");
+            continue;
+        }
+        idset_clear (child->pending, rank);
+        if (te->ops->on_error)
+            (*te->ops->on_error) (te, rank, errnum, te->arg);
+    }
+}
+
+static int tree_child_exit (struct tree_child *child,
+                            const char *ranks,
+                            int status)
+{
+    struct tree_exec *te = child->te;
+    struct idset *ids;
+    unsigned int rank;
+
+    if (!(ids = idset_decode (ranks)))
+        return -1;
+    rank = idset_first (ids);
+    while (rank != IDSET_INVALID_ID) {
+        idset_clear (child->pending, rank);
+        rank = idset_next (ids, rank);
+    }
+    if (te->ops->on_exit)
+        (*te->ops->on_exit) (te, ids, status, te->arg);
+    idset_destroy (ids);
+    return 0;
+}
+
+static int tree_child_start (struct tree_child *child, const char *ranks)
+{
+    struct tree_exec *te = child->te;
+    struct idset *ids;
+
+    if (!(ids = idset_decode (ranks)))
+        return -1;
+    if (te->ops->on_start)
+        (*te->ops->on_start) (te, ids, te->arg);
+    idset_destroy (ids);
+    return 0;
+}
+
+static void tree_child_response (flux_future_t *f, void *arg)
+{
+    struct tree_child *child = arg;
+    struct tree_exec *te = child->te;
+    const char *start = NULL;
+    const char *exit_ranks = NULL;
+    int exit_status = 0;
+    json_t *errors = NULL;
+    json_t *output = NULL;
+
+    if (flux_rpc_get_unpack (f, "{s?s s?{s:s s:i} s?o s?o}",
+                                "start", &start,
+                                "exit",
+                                  "ranks", &exit_ranks,
+                                  "status", &exit_status,
+                                "error", &errors,
+                                "output", &output) < 0) {
+        if (errno != ENODATA) {
+            flux_log_error (te->h,
+                            "tree-exec: %s: rank %u",
+                            te->key,
+                            (unsigned int) child->rank);
+            tree_child_lost (child, errno);
+        }
+        else if (idset_count (child->pending) > 0) {
+            flux_log (te->h, LOG_ERR,
+                      "tree-exec: %s: rank %u: stream ended early",
+                      te->key,
+                      (unsigned int) child->rank);
+            tree_child_lost (child, EPROTO);
+        }
+        child->done = true;
+        if (--te->active == 0 && te->ops->on_finish)
+            (*te->ops->on_finish) (te, te->arg);
+        return;
+    }
+    /*  Process notifications in the order they could have occurred,
+     *   so a rank's output and start always precede its exit.
+     */
+    if (start && tree_child_start (child, start) < 0)
+        flux_log_error (te->h, "tree-exec: invalid start ranks");
+    if (output)
+        tree_child_output (child, output);
+    if (errors)
+        tree_child_errors (child, errors);
+    if (exit_ranks && tree_child_exit (child, exit_ranks, exit_status) < 0)
+        flux_log_error (te->h, "tree-exec: invalid exit ranks");
+    flux_future_reset (f);
+}
+
+/*  Send launch requests to the children of position 'index'.
+ */
+static struct tree_exec *tree_exec_create (flux_t *h,
+                                           const char *key,
+                                           const char *ranks,
+                                           const uint32_t *rankv,
+                                           uint32_t size,
+                                           uint32_t index,
+                                           int fanout,
+                                           const char *cmd,
+                                           int flags,
+                                           const struct tree_exec_ops *ops,
+                                           void *arg)
+{
+    struct tree_exec *te;
+    int i;
+
+    if (!(te = calloc (1, sizeof (*te))))
+        return NULL;
+    te->h = h;
+    te->ops = ops;
+    te->arg = arg;
+    if (!(te->key = strdup (key)) || !(te->children = zlist_new ()))
+        goto error;
+    for (i = 0; i < fanout; i++) {
+        uint32_t pos = kary_childof (fanout, size, index, i);
+        struct tree_child *child;
+
+        if (pos == KARY_NONE)
+            break;
+        if (!(child = calloc (1, sizeof (*child))))
+            goto error;
+        if (zlist_append (te->children, child) < 0) {
+            tree_child_destroy (child);
+            errno = ENOMEM;
+            goto error;
+        }
+        zlist_freefn (te->children, child, tree_child_destroy, true);
+        child->te = te;
+        child->rank = rankv[pos - 1];
+        if (!(child->pending = subtree_ranks (fanout, size, pos, rankv)))
+            goto error;
+        if (!(child->f = flux_rpc_pack (h,
+                                        "job-exec.tree-launch",
+                                        child->rank,
+                                        FLUX_RPC_STREAMING,
+                                        "{s:s s:s s:i s:i s:s s:i}",
+                                        "key", key,
+                                        "ranks", ranks,
+                                        "index", pos,
+                                        "fanout", fanout,
+                                        "cmd", cmd,
+                                        "flags", flags))
+            || flux_future_then (child->f,
+                                 -1.,
+                                 tree_child_response,
+                                 child) < 0)
+            goto error;
+        te->active++;
+    }
+    return te;
+error:
+    /*  Children already sent a launch request are cancelled here.
+     */
+    tree_exec_destroy (te);
+    return NULL;
+}
+
+struct tree_exec *tree_exec_launch (flux_t *h,
+                                    const char *key,
+                                    const struct idset *ranks,
+                                    int fanout,
+                                    const flux_cmd_t *cmd,
+                                    int flags,
+                                    const struct tree_exec_ops *ops,
+                                    void *arg)
+{
+    struct tree_exec *te = NULL;
+    char *ranks_str = NULL;
+    char *cmd_str = NULL;
+    uint32_t *rankv = NULL;
+    uint32_t size;
+
+    if (!h || !key || !ranks || fanout < 1 || !cmd || !ops) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(ranks_str = idset_encode (ranks, IDSET_FLAG_RANGE))
+        || !(rankv = ranks_decode (ranks_str, &size))
+        || !(cmd_str = flux_cmd_tojson (cmd)))
+        goto out;
+    te = tree_exec_create (h,
+                           key,
+                           ranks_str,
+                           rankv,
+                           size,
+                           0,
+                           fanout,
+                           cmd_str,
+                           flags,
+                           ops,
+                           arg);
+out:
+    free (ranks_str);
+    free (rankv);
+    free (cmd_str);
+    return te;
+}
+
+static void kill_continuation (flux_future_t *f, void *arg)
+{
+    flux_t *h = flux_future_get_flux (f);
+    if (flux_future_get (f, NULL) < 0 && errno != ENOENT)
+        flux_log_error (h, "tree-exec: kill");
+    flux_future_destroy (f);
+}
+
+flux_future_t *tree_exec_kill (struct tree_exec *te, int signum)
+{
+    struct tree_child *child;
+    flux_future_t *cf;
+
+    if (!(cf = flux_future_wait_all_create ()))
+        return NULL;
+    flux_future_set_flux (cf, te->h);
+
+    child = zlist_first (te->children);
+    while (child) {
+        if (!child->done) {
+            flux_future_t *f;
+            char s[64];
+
+            if (!(f = flux_rpc_pack (te->h,
+                                     "job-exec.tree-kill",
+                                     child->rank,
+                                     0,
+                                     "{s:s s:i}",
+                                     "key", te->key,
+                                     "signal", signum)))
+                goto error;
+            (void) snprintf (s, sizeof (s), "%u", (unsigned int) child->rank);
+            if (flux_future_push (cf, s, f) < 0) {
+                flux_future_destroy (f);
+                goto error;
+            }
+        }
+        child = zlist_next (te->children);
+    }
+    if (!flux_future_first_child (cf)) {
+        flux_future_destroy (cf);
+        errno = ENOENT;
+        return NULL;
+    }
+    return cf;
+error:
+    flux_future_destroy (cf);
+    return NULL;
+}
+
+/*
+ *  Launch service
+ */
+
+static void tree_launch_destroy (void *arg)
+{
+    struct tree_launch *l = arg;
+    if (l) {
+        int saved_errno = errno;
+        flux_watcher_destroy (l->timer);
+        tree_exec_destroy (l->te);
+        flux_subprocess_unref (l->p);
+        idset_destroy (l->started);
+        idset_destroy (l->exited);
+        json_decref (l->errors);
+        json_decref (l->output);
+        flux_msg_decref (l->msg);
+        free (l->sender);
+        free (l->key);
+        free (l);
+        errno = saved_errno;
+    }
+}
+
+static int tree_launch_respond (struct tree_launch *l)
+{
+    flux_t *h = l->svc->h;
+    json_t *o;
+    json_t *a = NULL;
+    char *s = NULL;
+
+    if (!(o = json_object ()))
+        goto nomem;
+    if (idset_count (l->started) > 0) {
+        if (!(s = idset_encode (l->started, IDSET_FLAG_RANGE))
+            || json_object_set_new (o, "start", json_string (s)) < 0)
+            goto nomem;
+        free (s);
+        s = NULL;
+        idset_range_clear (l->started, 0, INT_MAX);
+    }
+    /*  Hand the batched arrays over to the response and start new ones.
+     */
+    if (json_array_size (l->output) > 0) {
+        if (!(a = json_array ())
+            || json_object_set (o, "output", l->output) < 0)
+            goto nomem;
+        json_decref (l->output);
+        l->output = a;
+        a = NULL;
+    }
+    if (json_array_size (l->errors) > 0) {
+        if (!(a = json_array ())
+            || json_object_set (o, "error", l->errors) < 0)
+            goto nomem;
+        json_decref (l->errors);
+        l->errors = a;
+        a = NULL;
+    }
+    if (idset_count (l->exited) > 0) {
+        if (!(s = idset_encode (l->exited, IDSET_FLAG_RANGE))
+            || json_object_set_new (o, "exit",
+                                    json_pack ("{s:s s:i}",
+                                               "ranks", s,
+                                               "status", l->exit_status)) < 0)
+            goto nomem;
+        free (s);
+        s = NULL;
+        idset_range_clear (l->exited, 0, INT_MAX);
+        l->exit_status = 0;
+    }
+    if (json_object_size (o) > 0
+        && flux_respond_pack (h, l->msg, "O", o) < 0)
+        flux_log_error (h, "tree-exec: %s: flux_respond_pack", l->key);
+    json_decref (o);
+    return 0;
+nomem:
+    free (s);
+    json_decref (a);
+    json_decref (o);
+    errno = ENOMEM;
+    return -1;
+}
+
+static void tree_launch_timer_cb (flux_reactor_t *r,
+                                  flux_watcher_t *w,
+                                  int revents,
+                                  void *arg)
+{
+    struct tree_launch *l = arg;
+    struct tree_exec_service *svc = l->svc;
+
+    l->timer_armed = false;
+    if (!l->cancelled && tree_launch_respond (l) < 0)
+        flux_log_error (svc->h, "tree-exec: %s: respond", l->key);
+    if (l->finished) {
+        if (!l->cancelled
+            && flux_respond_error (svc->h, l->msg, ENODATA, NULL) < 0)
+            flux_log_error (svc->h, "tree-exec: %s: respond", l->key);
+        zhash_delete (svc->launches, l->key);
+    }
+}
+
+/*  Arm the batch timer if it is not already pending.
+ */
+static void tree_launch_notify (struct tree_launch *l)
+{
+    if (!l->timer_armed) {
+        flux_timer_watcher_reset (l->timer, batch_timeout, 0.);
+        flux_watcher_start (l->timer);
+        l->timer_armed = true;
+    }
+}
+
+/*  Once the local process and all children are done, flush any pending
+ *   notifications and terminate the stream from the reactor, since this
+ *   may be called from a subprocess or child future callback.
+ */
+static void tree_launch_check_finished (struct tree_launch *l)
+{
+    if (l->finished || !l->local_done || (l->te && !tree_exec_finished (l->te)))
+        return;
+    l->finished = true;
+    flux_watcher_stop (l->timer);
+    flux_timer_watcher_reset (l->timer, 0., 0.);
+    flux_watcher_start (l->timer);
+    l->timer_armed = true;
+}
+
+static void tree_launch_start (struct tree_launch *l, const struct idset *ids)
+{
+    unsigned int rank = idset_first (ids);
+    while (rank != IDSET_INVALID_ID) {
+        if (idset_set (l->started, rank) < 0)
+            flux_log_error (l->svc->h, "tree-exec: idset_set");
+        rank = idset_next (ids, rank);
+    }
+    tree_launch_notify (l);
+}
+
+static void tree_launch_exit (struct tree_launch *l,
+                              const struct idset *ids,
+                              int status)
+{
+    unsigned int rank = idset_first (ids);
+    while (rank != IDSET_INVALID_ID) {
+        if (idset_set (l->exited, rank) < 0)
+            flux_log_error (l->svc->h, "tree-exec: idset_set");
+        rank = idset_next (ids, rank);
+    }
+    if (status > l->exit_status)
+        l->exit_status = status;
+    tree_launch_notify (l);
+}
+
+static void tree_launch_error (struct tree_launch *l, uint32_t rank, int errnum)
+{
+    json_t *entry = json_pack ("[ii]", (int) rank, errnum);
+    if (!entry || json_array_append_new (l->errors, entry) < 0) {
+        json_decref (entry);
+        flux_log_error (l->svc->h, "tree-exec: error append");
+    }
+    tree_launch_notify (l);
+}
+
+static void tree_launch_output (struct tree_launch *l,
+                                uint32_t rank,
+                                const char *stream,
+                                const char *data,
+                                int len)
+{
+    json_t *entry = json_pack ("[is s#]", (int) rank, stream, data, len);
+    if (!entry || json_array_append_new (l->output, entry) < 0) {
+        json_decref (entry);
+        flux_log_error (l->svc->h, "tree-exec: output append");
+    }
+    tree_launch_notify (l);
+}
+
+/*  Notifications from child subtrees are simply merged into our batch.
+ */
+static void child_start (struct tree_exec *te,
+                         const struct idset *ranks,
+                         void *arg)
+{
+    tree_launch_start (arg, ranks);
+}
+
+static void child_exit (struct tree_exec *te,
+                        const struct idset *ranks,
+                        int status,
+                        void *arg)
+{
+    tree_launch_exit (arg, ranks, status);
+}
+
+static void child_error (struct tree_exec *te,
+                         uint32_t rank,
+                         int errnum,
+                         void *arg)
+{
+    tree_launch_error (arg, rank, errnum);
+}
+
+static void child_output (struct tree_exec *te,
+                          uint32_t rank,
+                          const char *stream,
+                          const char *data,
+                          int len,
+                          void *arg)
+{
+    tree_launch_output (arg, rank, stream, data, len);
+}
+
+static void child_finish (struct tree_exec *te, void *arg)
+{
+    tree_launch_check_finished (arg);
+}
+
+static const struct tree_exec_ops child_ops = {
+    .on_start = child_start,
+    .on_exit = child_exit,
+    .on_error = child_error,
+    .on_output = child_output,
+    .on_finish = child_finish,
+};
+
+static void tree_launch_kill (struct tree_launch *l, int signum);
+
+/*  Local subprocess callbacks
+ */
+static void local_single (struct tree_launch *l,
+                          void (*fn) (struct tree_launch *,
+                                      const struct idset *,
+                                      int),
+                          int status)
+{
+    struct idset *ids = idset_create (0, IDSET_FLAG_AUTOGROW);
+    if (!ids || idset_set (ids, l->svc->rank) < 0) {
+        flux_log_error (l->svc->h, "tree-exec: idset_create");
+        idset_destroy (ids);
+        return;
+    }
+    (*fn) (l, ids, status);
+    idset_destroy (ids);
+}
+
+static void local_start (struct tree_launch *l,
+                         const struct idset *ids,
+                         int status)
+{
+    tree_launch_start (l, ids);
+}
+
+static void local_completion_cb (flux_subprocess_t *p)
+{
+    struct tree_launch *l = flux_subprocess_aux_get (p, "tree-exec::launch");
+
+    if (l->local_done)
+        return;
+    local_single (l, tree_launch_exit, flux_subprocess_status (p));
+    l->local_done = true;
+    tree_launch_check_finished (l);
+}
+
+static void local_state_cb (flux_subprocess_t *p,
+                            flux_subprocess_state_t state)
+{
+    struct tree_launch *l = flux_subprocess_aux_get (p, "tree-exec::launch");
+
+    if (state == FLUX_SUBPROCESS_RUNNING) {
+        local_single (l, local_start, 0);
+        /*  Launch was cancelled before the process was running.
+         */
+        if (l->cancelled)
+            tree_launch_kill (l, SIGKILL);
+    }
+    else if (state == FLUX_SUBPROCESS_FAILED
+             || state == FLUX_SUBPROCESS_EXEC_FAILED) {
+        if (l->local_done)
+            return;
+        tree_launch_error (l, l->svc->rank, flux_subprocess_fail_errno (p));
+        l->local_done = true;
+        tree_launch_check_finished (l);
+    }
+}
+
+static void local_output_cb (flux_subprocess_t *p, const char *stream)
+{
+    struct tree_launch *l = flux_subprocess_aux_get (p, "tree-exec::launch");
+    const char *s;
+    int len;
+
+    if (!(s = flux_subprocess_getline (p, stream, &len))) {
+        flux_log_error (l->svc->h, "tree-exec: flux_subprocess_getline");
+        return;
+    }
+    if (len)
+        tree_launch_output (l, l->svc->rank, stream, s, len);
+}
+
+static flux_subprocess_ops_t local_ops = {
+    .on_completion =   local_completion_cb,
+    .on_state_change = local_state_cb,
+    .on_stdout =       local_output_cb,
+    .on_stderr =       local_output_cb,
+};
+
+static int tree_launch_local (struct tree_launch *l,
+                              const char *cmd_str,
+                              int flags)
+{
+    struct tree_exec_service *svc = l->svc;
+    flux_cmd_t *cmd;
+    json_error_t error;
+
+    if (!(cmd = flux_cmd_fromjson (cmd_str, &error))) {
+        flux_log (svc->h, LOG_ERR, "tree-exec: cmd: %s", error.text);
+        errno = EPROTO;
+        return -1;
+    }
+    if (!(l->p = flux_rexec (svc->h, svc->rank, flags, cmd, &local_ops))
+        || flux_subprocess_aux_set (l->p, "tree-exec::launch", l, NULL) < 0) {
+        flux_cmd_destroy (cmd);
+        return -1;
+    }
+    flux_cmd_destroy (cmd);
+    return 0;
+}
+
+static struct tree_launch *tree_launch_create (struct tree_exec_service *svc,
+                                               const char *key,
+                                               const flux_msg_t *msg)
+{
+    flux_reactor_t *r = flux_get_reactor (svc->h);
+    struct tree_launch *l;
+
+    if (!(l = calloc (1, sizeof (*l))))
+        return NULL;
+    l->svc = svc;
+    l->msg = flux_msg_incref (msg);
+    if (!(l->key = strdup (key))
+        || !(l->started = idset_create (0, IDSET_FLAG_AUTOGROW))
+        || !(l->exited = idset_create (0, IDSET_FLAG_AUTOGROW))
+        || !(l->errors = json_array ())
+        || !(l->output = json_array ())
+        || !(l->timer = flux_timer_watcher_create (r,
+                                                   batch_timeout,
+                                                   0.,
+                                                   tree_launch_timer_cb,
+                                                   l)))
+        goto error;
+    return l;
+error:
+    tree_launch_destroy (l);
+    return NULL;
+}
+
+static void launch_cb (flux_t *h,
+                       flux_msg_handler_t *mh,
+                       const flux_msg_t *msg,
+                       void *arg)
+{
+    struct tree_exec_service *svc = arg;
+    struct tree_launch *l = NULL;
+    const char *key;
+    const char *ranks;
+    const char *cmd;
+    int index;
+    int fanout;
+    int flags;
+    uint32_t *rankv = NULL;
+    uint32_t size;
+
+    if (flux_request_unpack (msg, NULL, "{s:s s:s s:i s:i s:s s:i}",
+                                        "key", &key,
+                                        "ranks", &ranks,
+                                        "index", &index,
+                                        "fanout", &fanout,
+                                        "cmd", &cmd,
+                                        "flags", &flags) < 0)
+        goto error;
+    if (!flux_msg_is_streaming (msg)) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (zhash_lookup (svc->launches, key)) {
+        errno = EEXIST;
+        goto error;
+    }
+    if (!(rankv = ranks_decode (ranks, &size)))
+        goto error;
+    if (fanout < 1
+        || index < 1
+        || index >= size
+        || rankv[index - 1] != svc->rank) {
+        errno = EINVAL;
+        goto error;
+    }
+    if (!(l = tree_launch_create (svc, key, msg))
+        || flux_msg_get_route_first (msg, &l->sender) < 0)
+        goto error;
+    if (kary_childof (fanout, size, index, 0) != KARY_NONE
+        && !(l->te = tree_exec_create (h,
+                                       key,
+                                       ranks,
+                                       rankv,
+                                       size,
+                                       index,
+                                       fanout,
+                                       cmd,
+                                       flags,
+                                       &child_ops,
+                                       l)))
+        goto error;
+    if (zhash_insert (svc->launches, l->key, l) < 0) {
+        errno = EEXIST;
+        goto error;
+    }
+    zhash_freefn (svc->launches, l->key, tree_launch_destroy);
+
+    /*  Children are already on their way, so a local failure is reported
+     *   like any other rank's failure rather than failing the request.
+     */
+    if (tree_launch_local (l, cmd, flags) < 0) {
+        tree_launch_error (l, svc->rank, errno);
+        l->local_done = true;
+        tree_launch_check_finished (l);
+    }
+    free (rankv);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "tree-exec: launch: flux_respond_error");
+    tree_launch_destroy (l);
+    free (rankv);
+}
+
+/*  Send signal to the local process and the subtree of launch 'l'.
+ */
+static void tree_launch_kill (struct tree_launch *l, int signum)
+{
+    flux_t *h = l->svc->h;
+    flux_future_t *f;
+
+    if (l->p
+        && (flux_subprocess_state (l->p) == FLUX_SUBPROCESS_RUNNING
+            || flux_subprocess_state (l->p) == FLUX_SUBPROCESS_INIT)) {
+        if (!(f = flux_subprocess_kill (l->p, signum))
+            || flux_future_then (f, -1., kill_continuation, NULL) < 0) {
+            flux_log_error (h, "tree-exec: %s: kill", l->key);
+            flux_future_destroy (f);
+        }
+    }
+    if (l->te && (f = tree_exec_kill (l->te, signum))) {
+        if (flux_future_then (f, -1., kill_continuation, NULL) < 0) {
+            flux_log_error (h, "tree-exec: %s: kill children", l->key);
+            flux_future_destroy (f);
+        }
+    }
+}
+
+/*  The requestor of launch 'l' is gone.  Kill everything it started,
+ *   and drop the launch silently once all of it has exited.
+ */
+static void tree_launch_cancel (struct tree_launch *l)
+{
+    if (l->cancelled)
+        return;
+    l->cancelled = true;
+    flux_log (l->svc->h, LOG_DEBUG, "tree-exec: %s: cancelled", l->key);
+    tree_launch_kill (l, SIGKILL);
+}
+
+static void kill_cb (flux_t *h,
+                     flux_msg_handler_t *mh,
+                     const flux_msg_t *msg,
+                     void *arg)
+{
+    struct tree_exec_service *svc = arg;
+    struct tree_launch *l;
+    const char *key;
+    int signum;
+
+    if (flux_request_unpack (msg, NULL, "{s:s s:i}",
+                                        "key", &key,
+                                        "signal", &signum) < 0)
+        goto error;
+    if (!(l = zhash_lookup (svc->launches, key))) {
+        errno = ENOENT;
+        goto error;
+    }
+    /*  Acknowledge once the signal is on its way to the subtree,
+     *   rather than waiting for the whole subtree to respond.
+     */
+    tree_launch_kill (l, signum);
+    if (flux_respond (h, msg, NULL) < 0)
+        flux_log_error (h, "tree-exec: kill: flux_respond");
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "tree-exec: kill: flux_respond_error");
+}
+
+/*  job-exec.tree-cancel request (no response)
+ *   The parent destroyed its launch before this subtree finished.
+ */
+static void cancel_cb (flux_t *h,
+                       flux_msg_handler_t *mh,
+                       const flux_msg_t *msg,
+                       void *arg)
+{
+    struct tree_exec_service *svc = arg;
+    struct tree_launch *l;
+    const char *key;
+
+    if (flux_request_unpack (msg, NULL, "{s:s}", "key", &key) < 0) {
+        flux_log_error (h, "tree-exec: cancel: flux_request_unpack");
+        return;
+    }
+    if ((l = zhash_lookup (svc->launches, key)))
+        tree_launch_cancel (l);
+}
+
+/*  job-exec.disconnect request
+ *   This is sent automatically when a job-exec module that sent us
+ *   launch requests is unloaded.  Cancel all of its launches.
+ */
+static void disconnect_cb (flux_t *h,
+                           flux_msg_handler_t *mh,
+                           const flux_msg_t *msg,
+                           void *arg)
+{
+    struct tree_exec_service *svc = arg;
+    struct tree_launch *l;
+    char *sender;
+
+    if (flux_request_decode (msg, NULL, NULL) < 0
+        || flux_msg_get_route_first (msg, &sender) < 0) {
+        flux_log_error (h, "tree-exec: disconnect");
+        return;
+    }
+    l = zhash_first (svc->launches);
+    while (l) {
+        if (l->sender && !strcmp (l->sender, sender))
+            tree_launch_cancel (l);
+        l = zhash_next (svc->launches);
+    }
+    free (sender);
+}
+
+static const struct flux_msg_handler_spec htab[] = {
+    { FLUX_MSGTYPE_REQUEST, "job-exec.tree-launch", launch_cb,     0 },
+    { FLUX_MSGTYPE_REQUEST, "job-exec.tree-kill",   kill_cb,       0 },
+    { FLUX_MSGTYPE_REQUEST, "job-exec.tree-cancel", cancel_cb,     0 },
+    { FLUX_MSGTYPE_REQUEST, "job-exec.disconnect",  disconnect_cb, 0 },
+    FLUX_MSGHANDLER_TABLE_END,
+};
+
+void tree_exec_service_destroy (struct tree_exec_service *svc)
+{
+    if (svc) {
+        int saved_errno = errno;
+        flux_msg_handler_delvec (svc->handlers);
+        zhash_destroy (&svc->launches);
+        free (svc);
+        errno = saved_errno;
+    }
+}
+
+struct tree_exec_service *tree_exec_service_create (flux_t *h)
+{
+    struct tree_exec_service *svc;
+
+    if (!(svc = calloc (1, sizeof (*svc))))
+        return NULL;
+    svc->h = h;
+    if (flux_get_rank (h, &svc->rank) < 0)
+        goto error;
+    if (!(svc->launches = zhash_new ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (flux_msg_handler_addvec (h, htab, svc, &svc->handlers) < 0)
+        goto error;
+    return svc;
+error:
+    tree_exec_service_destroy (svc);
+    return NULL;
+}
+
+/* vi: ts=4 sw=4 expandtab
+ */
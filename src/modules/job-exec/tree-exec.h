@@ -0,0 +1,97 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* Hierarchical launch of one command per rank
+ *
+ * Instead of one flux_rexec(3) stream per target rank, the launcher
+ * sends a single "job-exec.tree-launch" request to each of its children
+ * in a k-ary tree laid out over the target ranks.  Every rank starts
+ * its local copy of the command, forwards the request to its own
+ * children, and reduces start, exit, error, and output notifications
+ * from its subtree into batched responses to its parent.
+ *
+ * The "job-exec.tree-launch", "job-exec.tree-kill" and
+ * "job-exec.tree-cancel" services are provided on every rank by
+ * tree_exec_service_create().
+ */
+
+#ifndef HAVE_JOB_EXEC_TREE_EXEC_H
+#define HAVE_JOB_EXEC_TREE_EXEC_H 1
+
+#include <flux/core.h>
+#include <flux/idset.h>
+
+struct tree_exec;
+struct tree_exec_service;
+
+struct tree_exec_ops {
+    /* 'ranks' have started */
+    void (*on_start)  (struct tree_exec *te,
+                       const struct idset *ranks,
+                       void *arg);
+    /* 'ranks' have exited, with largest wait status 'status' */
+    void (*on_exit)   (struct tree_exec *te,
+                       const struct idset *ranks,
+                       int status,
+                       void *arg);
+    /* 'rank' failed to start, or was lost, with 'errnum' */
+    void (*on_error)  (struct tree_exec *te,
+                       uint32_t rank,
+                       int errnum,
+                       void *arg);
+    /* one line of output from 'rank' */
+    void (*on_output) (struct tree_exec *te,
+                       uint32_t rank,
+                       const char *stream,
+                       const char *data,
+                       int len,
+                       void *arg);
+    /* all ranks have reported exit or error */
+    void (*on_finish) (struct tree_exec *te, void *arg);
+};
+
+/* Launch 'cmd' on 'ranks' through a tree of the given fanout.
+ * 'key' must uniquely identify this launch among all active launches
+ * in the instance, and is used to address a later tree_exec_kill().
+ */
+struct tree_exec *tree_exec_launch (flux_t *h,
+                                    const char *key,
+                                    const struct idset *ranks,
+                                    int fanout,
+                                    const flux_cmd_t *cmd,
+                                    int flags,
+                                    const struct tree_exec_ops *ops,
+                                    void *arg);
+
+/* Destroy 'te'.  Any part of the launch that has not finished is
+ * killed with SIGKILL, since its notifications can no longer be delivered.
+ */
+void tree_exec_destroy (struct tree_exec *te);
+
+/* Return true once all ranks have reported exit or error.
+ */
+bool tree_exec_finished (struct tree_exec *te);
+
+/* Send 'signum' to all running processes of this launch.  The returned
+ * future is fulfilled once every child subtree of the launcher has
+ * acknowledged the request.  Returns NULL with errno == ENOENT if no
+ * part of the launch is still active.
+ */
+flux_future_t *tree_exec_kill (struct tree_exec *te, int signum);
+
+/* Register the tree-launch services on this rank.
+ */
+struct tree_exec_service *tree_exec_service_create (flux_t *h);
+void tree_exec_service_destroy (struct tree_exec_service *svc);
+
+#endif /* !HAVE_JOB_EXEC_TREE_EXEC_H */
+
+/* vi: ts=4 sw=4 expandtab
+ */
@@ -12,6 +12,7 @@
 #include "config.h"
 #endif
 #include <unistd.h>
+#include <limits.h>
 #include <czmq.h>
 #include <jansson.h>
 #include <flux/core.h>
@@ -42,6 +43,13 @@
  * The jobid is returned to the user in response to the job-ingest.submit RPC.
  * Responses are sent after the job has been successfully ingested.
  *
+ * A job-ingest.submit-bulk request carries an array of signed jobspecs,
+ * and a count of instances to create from each.  Each signed jobspec is
+ * checked once.  If all are valid, the instances are assigned a
+ * consecutive range of jobids, committed in one KVS transaction,
+ * announced in one job-manager.submit request, and the jobids are
+ * returned together in one response.  Otherwise no jobs are created.
+ *
  * Currently all KVS data is committed under job.<fluid-dothex>,
  * where <fluid-dothex> is the jobid converted to 16-bit, 0-padded hex
  * strings delimited by periods, e.g.
@@ -68,6 +76,14 @@
  */
 const double batch_timeout = 0.01;
 
+/* The default maximum number of jobs (jobspecs x count) that may be
+ * created by one submit-bulk request.  All of them are allocated, assigned
+ * FLUIDs and committed at once, so an unbounded request would tie up the
+ * module and push the FLUID timestamp far ahead of the clock.
+ * Override with bulk-max=N on the module load command line.
+ */
+const int bulk_max_default = 65536;
+
 /* Timeout (seconds) to wait for validators to terminate when
  * stopped by closing their stdin.  If the timer pops, stop the reactor
  * and allow validate_destroy() to signal them.
@@ -87,6 +103,8 @@ struct job_ingest_ctx {
     struct batch *batch;
     flux_watcher_t *timer;
 
+    int bulk_max;               // max jobs created by one submit-bulk
+
     bool shutdown;              // no new jobs are accepted in shutdown mode
     int shutdown_process_count; // number of validators executing at shutdown
     flux_watcher_t *shutdown_timer;
@@ -103,6 +121,7 @@ struct job {
 
     char *jobspec;      // jobspec, not \0 terminated (unwrapped from signed)
     int jobspecsz;      // jobspec string length
+    bool jobspec_shared; // jobspec is owned by another job (bulk instance)
 
     struct job_ingest_ctx *ctx;
 };
@@ -112,6 +131,20 @@ struct batch {
     flux_kvs_txn_t *txn;
     zlist_t *jobs;
     json_t *joblist;
+    const flux_msg_t *msg;  // submit-bulk request, if not one per job
+};
+
+/* State of a job-ingest.submit-bulk request, while its signed jobspecs
+ * are validated.
+ */
+struct bulk {
+    struct job_ingest_ctx *ctx;
+    const flux_msg_t *msg;
+    zlist_t *jobs;      // one job per signed jobspec
+    int count;          // instances of each job
+    int pending;        // validations in progress
+    int errnum;         // first validation error
+    char errbuf[256];
 };
 
 static int make_key (char *buf, int bufsz, struct job *job, const char *name);
@@ -122,7 +155,8 @@ static int make_key (char *buf, int bufsz, struct job *job, const char *name);
 static void job_clean (struct job *job)
 {
     if (job) {
-        free (job->jobspec);
+        if (!job->jobspec_shared)
+            free (job->jobspec);
         job->jobspec = NULL;
     }
 }
@@ -131,33 +165,64 @@ static void job_destroy (struct job *job)
 {
     if (job) {
         int saved_errno = errno;
-        free (job->jobspec);
+        job_clean (job);
         flux_msg_decref (job->msg);
         free (job);
         errno = saved_errno;
     }
 }
 
-static struct job *job_create (const flux_msg_t *msg,
-                               struct job_ingest_ctx *ctx)
+static struct job *job_alloc (const flux_msg_t *msg,
+                              struct job_ingest_ctx *ctx)
 {
     struct job *job;
 
     if (!(job = calloc (1, sizeof (*job))))
         return NULL;
     job->msg = flux_msg_incref (msg);
+    if (flux_msg_get_cred (job->msg, &job->cred) < 0) {
+        job_destroy (job);
+        return NULL;
+    }
+    job->ctx = ctx;
+    return job;
+}
+
+static struct job *job_create (const flux_msg_t *msg,
+                               struct job_ingest_ctx *ctx)
+{
+    struct job *job;
+
+    if (!(job = job_alloc (msg, ctx)))
+        return NULL;
     if (flux_request_unpack (job->msg, NULL, "{s:s s:i s:i}",
                              "J", &job->J,
                              "priority", &job->priority,
-                             "flags", &job->flags) < 0)
-        goto error;
-    if (flux_msg_get_cred (job->msg, &job->cred) < 0)
-        goto error;
-    job->ctx = ctx;
+                             "flags", &job->flags) < 0) {
+        job_destroy (job);
+        return NULL;
+    }
     return job;
-error:
-    job_destroy (job);
-    return NULL;
+}
+
+/* Create an instance of bulk submitted 'job', sharing its jobspec.
+ */
+static struct job *job_instance_create (struct job *job)
+{
+    struct job *instance;
+
+    if (!(instance = calloc (1, sizeof (*instance))))
+        return NULL;
+    instance->msg = flux_msg_incref (job->msg);
+    instance->J = job->J;
+    instance->cred = job->cred;
+    instance->priority = job->priority;
+    instance->flags = job->flags;
+    instance->jobspec = job->jobspec;
+    instance->jobspecsz = job->jobspecsz;
+    instance->jobspec_shared = true;
+    instance->ctx = job->ctx;
+    return instance;
 }
 
 static void batch_destroy (struct batch *batch)
@@ -172,6 +237,7 @@ static void batch_destroy (struct batch *batch)
             json_decref (batch->joblist);
             flux_kvs_txn_destroy (batch->txn);
         }
+        flux_msg_decref (batch->msg);
         free (batch);
         errno = saved_errno;
     }
@@ -209,6 +275,12 @@ static void batch_respond_error (struct batch *batch,
 {
     flux_t *h = batch->ctx->h;
     struct job *job = zlist_first (batch->jobs);
+
+    if (batch->msg) {
+        if (flux_respond_error (h, batch->msg, errnum, errstr) < 0)
+            flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+        return;
+    }
     while (job) {
         if (flux_respond_error (h, job->msg, errnum, errstr) < 0)
             flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
@@ -222,6 +294,32 @@ static void batch_respond_success (struct batch *batch)
 {
     flux_t *h = batch->ctx->h;
     struct job *job = zlist_first (batch->jobs);
+
+    if (batch->msg) {
+        json_t *ids;
+
+        if (!(ids = json_array ()))
+            goto nomem;
+        while (job) {
+            json_t *id = json_integer (job->id);
+            if (!id || json_array_append_new (ids, id) < 0) {
+                json_decref (id);
+                json_decref (ids);
+                goto nomem;
+            }
+            job = zlist_next (batch->jobs);
+        }
+        if (flux_respond_pack (h, batch->msg, "{s:o}", "ids", ids) < 0)
+            flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
+        return;
+nomem:
+        /* N.B. jobs were ingested, but the requestor can't be told their
+         * ids.  Respond with an error so it at least doesn't hang.
+         */
+        if (flux_respond_error (h, batch->msg, ENOMEM, NULL) < 0)
+            flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+        return;
+    }
     while (job) {
         if (flux_respond_pack (h, job->msg, "{s:I}", "id", job->id) < 0)
             flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
@@ -330,21 +428,14 @@ static void batch_flush_continuation (flux_future_t *f, void *arg)
     flux_future_destroy (f);
 }
 
-/* batch timer - expires 'batch_timeout' seconds after batch was created.
- * Replace ctx->batch with a NULL, and pass 'batch' off to a chain of
- * continuations that commit its data to the KVS, respond to requestors,
- * and announce the new jobids.
+/* Pass 'batch' off to a chain of continuations that commit its data to
+ * the KVS, respond to requestors, and announce the new jobids.
  */
-static void batch_flush (flux_reactor_t *r, flux_watcher_t *w,
-                         int revents, void *arg)
+static void batch_commit (struct batch *batch)
 {
-    struct job_ingest_ctx *ctx = arg;
-    struct batch *batch;
+    struct job_ingest_ctx *ctx = batch->ctx;
     flux_future_t *f;
 
-    batch = ctx->batch;
-    ctx->batch = NULL;
-
     if (!(f = flux_kvs_commit (ctx->h, NULL, 0, batch->txn))) {
         batch_respond_error (batch, errno, "flux_kvs_commit failed");
         goto error;
@@ -361,6 +452,20 @@ error:
     batch_destroy (batch);
 }
 
+/* batch timer - expires 'batch_timeout' seconds after batch was created.
+ * Replace ctx->batch with a NULL, and commit 'batch'.
+ */
+static void batch_flush (flux_reactor_t *r, flux_watcher_t *w,
+                         int revents, void *arg)
+{
+    struct job_ingest_ctx *ctx = arg;
+    struct batch *batch;
+
+    batch = ctx->batch;
+    ctx->batch = NULL;
+    batch_commit (batch);
+}
+
 /* Format key within the KVS directory of 'job'.
  */
 static int make_key (char *buf, int bufsz, struct job *job, const char *name)
@@ -486,77 +591,76 @@ static int valid_flags (int flags)
     return 0;
 }
 
-/* Handle "job-ingest.submit" request to add a new job.
+/* Check that the submit request for 'job' is permitted.
+ * On failure, an error message may be placed in 'errbuf' and assigned
+ * to 'errmsg'.
  */
-static void submit_cb (flux_t *h, flux_msg_handler_t *mh,
-                       const flux_msg_t *msg, void *arg)
+static int job_check_request (struct job *job,
+                              const char **errmsg,
+                              char *errbuf,
+                              int errbufsz)
 {
-    struct job_ingest_ctx *ctx = arg;
-    struct job *job = NULL;
-    const char *errmsg = NULL;
-    char errbuf[256];
-    int64_t userid_signer;
-    const char *mech_type;
-    flux_future_t *f = NULL;
-
-    if (ctx->shutdown) {
-        errno = ENOSYS;
-        goto error;
-    }
-
-    /* Parse request.
-     */
-    if (!(job = job_create (msg, ctx)))
-        goto error;
     /* Validate submit flags.
      */
     if (valid_flags (job->flags) < 0)
-        goto error;
+        return -1;
     /* Validate requested job priority.
      */
     if (job->priority < FLUX_JOB_PRIORITY_MIN
             || job->priority > FLUX_JOB_PRIORITY_MAX) {
-        snprintf (errbuf, sizeof (errbuf), "priority range is [%d:%d]",
+        snprintf (errbuf, errbufsz, "priority range is [%d:%d]",
                   FLUX_JOB_PRIORITY_MIN, FLUX_JOB_PRIORITY_MAX);
-        errmsg = errbuf;
+        *errmsg = errbuf;
         errno = EINVAL;
-        goto error;
+        return -1;
     }
     if (!(job->cred.rolemask & FLUX_ROLE_OWNER)
            && job->priority > FLUX_JOB_PRIORITY_DEFAULT) {
-        snprintf (errbuf, sizeof (errbuf),
+        snprintf (errbuf, errbufsz,
                   "only the instance owner can submit with priority >%d",
                   FLUX_JOB_PRIORITY_DEFAULT);
-        errmsg = errbuf;
+        *errmsg = errbuf;
         errno = EINVAL;
-        goto error;
+        return -1;
     }
     /* Only owner can set FLUX_JOB_WAITABLE.
      */
     if (!(job->cred.rolemask & FLUX_ROLE_OWNER)
             && (job->flags & FLUX_JOB_WAITABLE)) {
         snprintf (errbuf,
-                  sizeof (errbuf),
+                  errbufsz,
                   "only the instance onwer can submit with FLUX_JOB_WAITABLE");
-        errmsg = errbuf;
+        *errmsg = errbuf;
         errno = EINVAL;
-        goto error;
+        return -1;
     }
-    /* Validate jobspec signature, and unwrap(J) -> jobspec,  jobspecsz.
-     * Userid claimed by signature must match authenticated job->cred.userid.
-     * If not the instance owner, a strong signature is required
-     * to give the IMP permission to launch processes on behalf of the user.
-     */
+    return 0;
+}
+
+/* Validate jobspec signature, and unwrap(J) -> jobspec,  jobspecsz.
+ * Userid claimed by signature must match authenticated job->cred.userid.
+ * If not the instance owner, a strong signature is required
+ * to give the IMP permission to launch processes on behalf of the user.
+ */
+static int job_unwrap (struct job_ingest_ctx *ctx,
+                       struct job *job,
+                       const char **errmsg,
+                       char *errbuf,
+                       int errbufsz)
+{
+    int64_t userid_signer;
+    const char *mech_type;
+
 #if HAVE_FLUX_SECURITY
     const void *jobspec;
     if (flux_sign_unwrap_anymech (ctx->sec, job->J, &jobspec, &job->jobspecsz,
                                   &mech_type, &userid_signer,
                                   FLUX_SIGN_NOVERIFY) < 0) {
-        errmsg = flux_security_last_error (ctx->sec);
-        goto error;
+        *errmsg = flux_security_last_error (ctx->sec);
+        return -1;
     }
     if (!(job->jobspec = malloc (job->jobspecsz)))
-        goto error;
+        return -1;
     memcpy (job->jobspec, jobspec, job->jobspecsz);
 #else
     uint32_t userid_signer_u32;
@@ -566,29 +670,56 @@ static void submit_cb (flux_t *h, flux_msg_handler_t *mh,
      */
     if (sign_none_unwrap (job->J, (void **)&job->jobspec, &job->jobspecsz,
                           &userid_signer_u32) < 0) {
-        errmsg = "could not unwrap jobspec";
-        goto error;
+        *errmsg = "could not unwrap jobspec";
+        return -1;
     }
     mech_type = "none";
     userid_signer = userid_signer_u32;
 #endif
     if (userid_signer != job->cred.userid) {
-        snprintf (errbuf, sizeof (errbuf),
+        snprintf (errbuf, errbufsz,
                   "signer=%lu != requestor=%lu",
                   (unsigned long)userid_signer,
                   (unsigned long)job->cred.userid);
-        errmsg = errbuf;
+        *errmsg = errbuf;
         errno = EPERM;
-        goto error;
+        return -1;
     }
     if (!(job->cred.rolemask & FLUX_ROLE_OWNER)
                                 && !strcmp (mech_type, "none")) {
-        snprintf (errbuf, sizeof (errbuf),
+        snprintf (errbuf, errbufsz,
                   "only instance owner can use sign-type=none");
-        errmsg = errbuf;
+        *errmsg = errbuf;
         errno = EPERM;
+        return -1;
+    }
+    return 0;
+}
+
+/* Handle "job-ingest.submit" request to add a new job.
+ */
+static void submit_cb (flux_t *h, flux_msg_handler_t *mh,
+                       const flux_msg_t *msg, void *arg)
+{
+    struct job_ingest_ctx *ctx = arg;
+    struct job *job = NULL;
+    const char *errmsg = NULL;
+    char errbuf[256];
+    flux_future_t *f = NULL;
+
+    if (ctx->shutdown) {
+        errno = ENOSYS;
         goto error;
     }
+
+    /* Parse request.
+     */
+    if (!(job = job_create (msg, ctx)))
+        goto error;
+    if (job_check_request (job, &errmsg, errbuf, sizeof (errbuf)) < 0)
+        goto error;
+    if (job_unwrap (ctx, job, &errmsg, errbuf, sizeof (errbuf)) < 0)
+        goto error;
     /* Validate jobspec asynchronously.
      * Continue submission process in validate_continuation().
      */
@@ -604,6 +735,230 @@ error:
     flux_future_destroy (f);
 }
 
+static void bulk_destroy (struct bulk *bulk)
+{
+    if (bulk) {
+        int saved_errno = errno;
+        if (bulk->jobs) {
+            struct job *job;
+            while ((job = zlist_pop (bulk->jobs)))
+                job_destroy (job);
+            zlist_destroy (&bulk->jobs);
+        }
+        flux_msg_decref (bulk->msg);
+        free (bulk);
+        errno = saved_errno;
+    }
+}
+
+static struct bulk *bulk_create (struct job_ingest_ctx *ctx,
+                                 const flux_msg_t *msg,
+                                 int count)
+{
+    struct bulk *bulk;
+
+    if (!(bulk = calloc (1, sizeof (*bulk))))
+        return NULL;
+    if (!(bulk->jobs = zlist_new ())) {
+        bulk_destroy (bulk);
+        errno = ENOMEM;
+        return NULL;
+    }
+    bulk->ctx = ctx;
+    bulk->msg = flux_msg_incref (msg);
+    bulk->count = count;
+    return bulk;
+}
+
+/* Record the first error encountered among the jobs of 'bulk'.
+ */
+static void bulk_set_error (struct bulk *bulk,
+                            struct job *job,
+                            int errnum,
+                            const char *errmsg)
+{
+    if (bulk->errnum == 0) {
+        int index = 0;
+        struct job *entry = zlist_first (bulk->jobs);
+        while (entry && entry != job) {
+            entry = zlist_next (bulk->jobs);
+            index++;
+        }
+        bulk->errnum = errnum;
+        snprintf (bulk->errbuf, sizeof (bulk->errbuf), "jobs[%d]: %s",
+                  index, errmsg ? errmsg : strerror (errnum));
+    }
+}
+
+/* All jobspecs of 'bulk' have been validated.  If they are all valid,
+ * create 'count' instances of each, with consecutive jobids, in a batch
+ * of their own that is committed right away, then respond to the request
+ * once the jobs are announced.  Otherwise, respond with the first error.
+ */
+static void bulk_ingest (struct bulk *bulk)
+{
+    struct job_ingest_ctx *ctx = bulk->ctx;
+    struct batch *batch = NULL;
+    fluid_t *ids = NULL;
+    struct job *job;
+    int total = zlist_size (bulk->jobs) * bulk->count;
+    int n = 0;
+    int i;
+
+    if (bulk->errnum != 0) {
+        errno = bulk->errnum;
+        goto error;
+    }
+    if (!(batch = batch_create (ctx)))
+        goto error;
+    batch->msg = flux_msg_incref (bulk->msg);
+    if (!(ids = calloc (total, sizeof (ids[0])))
+        || fluid_generate_range (&ctx->gen, total, ids) < 0)
+        goto error;
+    job = zlist_first (bulk->jobs);
+    while (job) {
+        for (i = 0; i < bulk->count; i++) {
+            struct job *instance;
+
+            if (!(instance = job_instance_create (job)))
+                goto error;
+            instance->id = ids[n++];
+            if (batch_add_job (batch, instance) < 0) {
+                job_destroy (instance);
+                goto error;
+            }
+        }
+        job = zlist_next (bulk->jobs);
+    }
+    free (ids);
+    bulk_destroy (bulk);
+    batch_commit (batch);
+    return;
+error:
+    if (flux_respond_error (ctx->h,
+                            bulk->msg,
+                            errno,
+                            bulk->errnum ? bulk->errbuf : NULL) < 0)
+        flux_log_error (ctx->h, "%s: flux_respond_error", __FUNCTION__);
+    free (ids);
+    if (batch) {
+        flux_msg_decref (batch->msg);
+        batch->msg = NULL;  // already responded
+        batch_destroy (batch);
+    }
+    bulk_destroy (bulk);
+}
+
+static void bulk_validate_continuation (flux_future_t *f, void *arg)
+{
+    struct bulk *bulk = arg;
+    struct job *job = flux_future_aux_get (f, "job-ingest::job");
+
+    if (flux_future_get (f, NULL) < 0)
+        bulk_set_error (bulk, job, errno, future_strerror (f, errno));
+    flux_future_destroy (f);
+    if (--bulk->pending == 0)
+        bulk_ingest (bulk);
+}
+
+/* Handle "job-ingest.submit-bulk" request to add many jobs at once.
+ */
+static void submit_bulk_cb (flux_t *h, flux_msg_handler_t *mh,
+                            const flux_msg_t *msg, void *arg)
+{
+    struct job_ingest_ctx *ctx = arg;
+    struct bulk *bulk = NULL;
+    struct job *job;
+    json_t *jobs;
+    int count = 1;
+    int priority;
+    int flags;
+    const char *errmsg = NULL;
+    char errbuf[256];
+    size_t index;
+    json_t *entry;
+
+    if (ctx->shutdown) {
+        errno = ENOSYS;
+        goto error;
+    }
+    if (flux_request_unpack (msg, NULL, "{s:o s?:i s:i s:i}",
+                             "jobs", &jobs,
+                             "count", &count,
+                             "priority", &priority,
+                             "flags", &flags) < 0)
+        goto error;
+    if (!json_is_array (jobs)
+        || json_array_size (jobs) == 0
+        || count < 1
+        || json_array_size (jobs) > INT_MAX / count) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (json_array_size (jobs) * count > (size_t) ctx->bulk_max) {
+        snprintf (errbuf, sizeof (errbuf),
+                  "submit-bulk of %zu jobs exceeds maximum of %d",
+                  json_array_size (jobs) * count,
+                  ctx->bulk_max);
+        errmsg = errbuf;
+        errno = E2BIG;
+        goto error;
+    }
+    if (!(bulk = bulk_create (ctx, msg, count)))
+        goto error;
+    /* Check and unwrap all jobs before any validation is started, so
+     * that the request can be failed here without leaving futures behind.
+     */
+    json_array_foreach (jobs, index, entry) {
+        if (!(job = job_alloc (msg, ctx)))
+            goto error;
+        if (zlist_append (bulk->jobs, job) < 0) {
+            job_destroy (job);
+            errno = ENOMEM;
+            goto error;
+        }
+        job->priority = priority;
+        job->flags = flags;
+        if (!(job->J = json_string_value (entry))) {
+            errno = EPROTO;
+            goto error;
+        }
+        if (job_check_request (job, &errmsg, errbuf, sizeof (errbuf)) < 0
+            || job_unwrap (ctx, job, &errmsg, errbuf, sizeof (errbuf)) < 0) {
+            bulk_set_error (bulk, job, errno, errmsg);
+            errno = bulk->errnum;
+            errmsg = bulk->errbuf;
+            goto error;
+        }
+    }
+    /* Validate jobspecs asynchronously.
+     * Continue in bulk_validate_continuation(), then bulk_ingest().
+     */
+    job = zlist_first (bulk->jobs);
+    while (job) {
+        flux_future_t *f;
+
+        if (!(f = validate_jobspec (ctx->validate,
+                                    job->jobspec,
+                                    job->jobspecsz))
+            || flux_future_aux_set (f, "job-ingest::job", job, NULL) < 0
+            || flux_future_then (f, -1., bulk_validate_continuation, bulk) < 0) {
+            flux_future_destroy (f);
+            bulk_set_error (bulk, job, errno, NULL);
+            break;
+        }
+        bulk->pending++; // N.B. continuation runs no sooner than next loop
+        job = zlist_next (bulk->jobs);
+    }
+    if (bulk->pending == 0)
+        bulk_ingest (bulk);
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, errmsg) < 0)
+        flux_log_error (h, "%s: flux_respond_error", __FUNCTION__);
+    bulk_destroy (bulk);
+}
+
 static void exit_cb (void *arg)
 {
     struct job_ingest_ctx *ctx = arg;
@@ -677,14 +1032,19 @@ error:
 static const struct flux_msg_handler_spec htab[] = {
     { FLUX_MSGTYPE_REQUEST,  "job-ingest.getinfo", getinfo_cb, 0},
     { FLUX_MSGTYPE_REQUEST,  "job-ingest.submit", submit_cb, FLUX_ROLE_USER },
+    { FLUX_MSGTYPE_REQUEST,
+      "job-ingest.submit-bulk",
+      submit_bulk_cb,
+      FLUX_ROLE_USER
+    },
     { FLUX_MSGTYPE_REQUEST,  "job-ingest.shutdown", shutdown_cb, 0 },
     FLUX_MSGHANDLER_TABLE_END,
 };
 
 /* Configure the validator.
- * Use compiled in path and string for validator program and args,
- * unless overridden with validator=path or schema=path on module load
- * command line.
+ * Use the native validator with compiled in args, unless overridden with
+ * validator=path and/or validator-args=args on module load command line.
+ * An external validator program is only run if validator=path is given.
  */
 int validate_initialize (flux_t *h,
                          int argc,
@@ -692,13 +1052,13 @@ int validate_initialize (flux_t *h,
                          struct validate **validate)
 {
     const char *usage_message = "Usage: flux module load [OPTIONS] job-ingest "
-                                " [validator-args=ARGS] [validator=PATH]";
-    const char *valpath;
+                                " [validator-args=ARGS] [validator=PATH]"
+                                " [bulk-max=N]";
+    const char *valpath = NULL;
     const char *valargs;
     struct validate *v;
     int i;
 
-    valpath = flux_conf_builtin_get ("jobspec_validate_path", FLUX_CONF_AUTO);
     valargs = flux_conf_builtin_get ("jobspec_validator_args", FLUX_CONF_AUTO);
     for (i = 0; i < argc; i++) {
         if (!strncmp (argv[i], "validator-args=", 15)) {
@@ -711,6 +1071,9 @@ int validate_initialize (flux_t *h,
                 return -1;
             }
         }
+        else if (!strncmp (argv[i], "bulk-max=", 9)) {
+            continue; // handled by bulk_max_initialize()
+        }
         else {
             flux_log (h, LOG_ERR, "invalid option %s", argv[i]);
             flux_log (h, LOG_ERR, "%s", usage_message);
@@ -726,6 +1089,34 @@ int validate_initialize (flux_t *h,
     return 0;
 }
 
+/* Set the maximum jobs per submit-bulk request from bulk-max=N on the
+ * module load command line, if given.
+ */
+static int bulk_max_initialize (struct job_ingest_ctx *ctx,
+                                int argc,
+                                char **argv)
+{
+    int i;
+
+    ctx->bulk_max = bulk_max_default;
+    for (i = 0; i < argc; i++) {
+        if (!strncmp (argv[i], "bulk-max=", 9)) {
+            char *endptr;
+            long l;
+
+            errno = 0;
+            l = strtol (argv[i] + 9, &endptr, 10);
+            if (errno != 0 || *endptr != '\0' || l < 1 || l > INT_MAX) {
+                flux_log (ctx->h, LOG_ERR, "invalid option %s", argv[i]);
+                errno = EINVAL;
+                return -1;
+            }
+            ctx->bulk_max = l;
+        }
+    }
+    return 0;
+}
+
 int mod_main (flux_t *h, int argc, char **argv)
 {
     flux_reactor_t *r = flux_get_reactor (h);
@@ -735,6 +1126,8 @@ int mod_main (flux_t *h, int argc, char **argv)
 
     memset (&ctx, 0, sizeof (ctx));
     ctx.h = h;
+    if (bulk_max_initialize (&ctx, argc, argv) < 0)
+        goto done;
 #if HAVE_FLUX_SECURITY
     if (!(ctx.sec = flux_security_create (0))) {
         flux_log_error (h, "flux_security_create");
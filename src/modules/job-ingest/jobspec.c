@@ -0,0 +1,297 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* jobspec.c - native jobspec validation
+ *
+ * Checks mirror Jobspec and JobspecV1 in the Python bindings
+ * (flux/job/Jobspec.py), including error messages, so that the result
+ * does not depend on whether jobspec was validated in-process or by
+ * validate-jobspec.py.  JSON types are checked strictly, e.g. a boolean
+ * is not accepted as an integer.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <jansson.h>
+
+#include "jobspec.h"
+
+struct errbuf {
+    char *buf;
+    int size;
+};
+
+static int errprintf (struct errbuf *e, const char *fmt, ...)
+{
+    va_list ap;
+
+    if (e->buf && e->size > 0) {
+        va_start (ap, fmt);
+        (void)vsnprintf (e->buf, e->size, fmt, ap);
+        va_end (ap);
+    }
+    errno = EINVAL;
+    return -1;
+}
+
+static bool key_in (const char *key, const char **keys)
+{
+    int i;
+    for (i = 0; keys[i] != NULL; i++) {
+        if (!strcmp (key, keys[i]))
+            return true;
+    }
+    return false;
+}
+
+/* Check the keys of 'o' against NULL terminated 'expected' list.
+ */
+static int validate_keys (struct errbuf *e,
+                          json_t *o,
+                          const char **expected,
+                          bool keys_optional,
+                          bool allow_additional)
+{
+    const char *key;
+    json_t *value;
+    int i;
+
+    if (!keys_optional) {
+        for (i = 0; expected[i] != NULL; i++) {
+            if (!json_object_get (o, expected[i]))
+                return errprintf (e, "Missing key (%s)", expected[i]);
+        }
+    }
+    if (!allow_additional) {
+        json_object_foreach (o, key, value) {
+            if (!key_in (key, expected))
+                return errprintf (e, "Extraneous key (%s)", key);
+        }
+    }
+    return 0;
+}
+
+static int validate_complex_range (struct errbuf *e, json_t *range)
+{
+    const char *range_keys[] = { "min", "max", "operator", "operand", NULL };
+    const char *int_keys[] = { "min", "max", "operand", NULL };
+    json_t *op;
+    int i;
+
+    if (!json_object_get (range, "min"))
+        return errprintf (e, "min must be in range");
+    if (json_object_size (range) > 1
+        && validate_keys (e, range, range_keys, false, false) < 0)
+        return -1;
+    for (i = 0; int_keys[i] != NULL; i++) {
+        json_t *val = json_object_get (range, int_keys[i]);
+        if (!val)
+            continue;
+        if (!json_is_integer (val))
+            return errprintf (e, "%s must be an int", int_keys[i]);
+        if (json_integer_value (val) < 1)
+            return errprintf (e, "%s must be > 0", int_keys[i]);
+    }
+    if ((op = json_object_get (range, "operator"))) {
+        const char *s = json_string_value (op);
+        if (!s || (strcmp (s, "+") && strcmp (s, "*") && strcmp (s, "^")))
+            return errprintf (e, "operator must be one of ['+', '*', '^']");
+    }
+    return 0;
+}
+
+static int validate_resource (struct errbuf *e, json_t *res)
+{
+    const char *string_keys[] = { "id", "unit", "label", NULL };
+    json_t *type;
+    json_t *count;
+    json_t *exclusive;
+    int i;
+
+    if (!json_is_object (res))
+        return errprintf (e, "resource must be a mapping");
+
+    if (!(type = json_object_get (res, "type")))
+        return errprintf (e, "type is a required key for resources");
+    if (!json_is_string (type))
+        return errprintf (e, "type must be a string");
+
+    if (!(count = json_object_get (res, "count")))
+        return errprintf (e, "count is a required key for resources");
+    if (json_is_object (count)) {
+        if (validate_complex_range (e, count) < 0)
+            return -1;
+    }
+    else if (!json_is_integer (count))
+        return errprintf (e, "count must be an int or mapping");
+    else if (json_integer_value (count) < 1)
+        return errprintf (e, "count must be > 0");
+
+    for (i = 0; string_keys[i] != NULL; i++) {
+        json_t *val = json_object_get (res, string_keys[i]);
+        if (val && !json_is_string (val))
+            return errprintf (e, "%s must be a string", string_keys[i]);
+    }
+
+    if ((exclusive = json_object_get (res, "exclusive"))
+        && !json_is_boolean (exclusive))
+        return errprintf (e, "exclusive must be a boolean");
+
+    if (!strcmp (json_string_value (type), "slot")
+        && !json_object_get (res, "label"))
+        return errprintf (e, "slots must have labels");
+    return 0;
+}
+
+/* Validate each resource, then its children, in the same depth first
+ * order as Jobspec.__iter__().
+ */
+static int validate_resource_list (struct errbuf *e, json_t *resources)
+{
+    size_t index;
+    json_t *res;
+
+    json_array_foreach (resources, index, res) {
+        json_t *with;
+
+        if (validate_resource (e, res) < 0)
+            return -1;
+        if ((with = json_object_get (res, "with"))) {
+            if (!json_is_array (with))
+                return errprintf (e, "resource must be a mapping");
+            if (validate_resource_list (e, with) < 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+static int validate_task (struct errbuf *e, json_t *task)
+{
+    const char *task_keys[] = { "command", "slot", "count", NULL };
+    json_t *command;
+    json_t *attributes;
+    json_t *arg;
+    size_t index;
+
+    if (!json_is_object (task))
+        return errprintf (e, "task must be a mapping");
+    if (validate_keys (e, task, task_keys, false, true) < 0)
+        return -1;
+    if (!json_is_object (json_object_get (task, "count")))
+        return errprintf (e, "count must be a mapping");
+    if (!json_is_string (json_object_get (task, "slot")))
+        return errprintf (e, "slot must be a string");
+    if ((attributes = json_object_get (task, "attributes"))
+        && !json_is_object (attributes))
+        return errprintf (e, "count must be a mapping");
+
+    command = json_object_get (task, "command");
+    if ((json_is_array (command) && json_array_size (command) == 0)
+        || (json_is_string (command) && json_string_length (command) == 0))
+        return errprintf (e, "command array cannot have length of zero");
+    if (!json_is_array (command))
+        return errprintf (e, "command must be a list of strings");
+    json_array_foreach (command, index, arg) {
+        if (!json_is_string (arg))
+            return errprintf (e, "command must be a list of strings");
+    }
+    return 0;
+}
+
+static int validate_attributes (struct errbuf *e, json_t *attributes)
+{
+    const char *attr_keys[] = { "system", "user", NULL };
+    return validate_keys (e, attributes, attr_keys, true, false);
+}
+
+/* Extra requirements of JobspecV1.
+ */
+static int validate_v1 (struct errbuf *e, json_t *attributes)
+{
+    json_t *system;
+    json_t *duration;
+
+    if (!(system = json_object_get (attributes, "system")))
+        return errprintf (e, "attributes.system is a required key");
+    if (!json_is_object (system))
+        return errprintf (e, "attributes.system must be a mapping");
+    if (!(duration = json_object_get (system, "duration")))
+        return errprintf (e, "attributes.system.duration is a required key");
+    if (!json_is_number (duration))
+        return errprintf (e, "attributes.system.duration must be a number");
+    return 0;
+}
+
+int jobspec_validate (json_t *jobspec,
+                      int require_version,
+                      char *errbuf,
+                      int errbufsz)
+{
+    const char *top_level_keys[] = {
+        "resources", "tasks", "version", "attributes", NULL
+    };
+    struct errbuf e = { .buf = errbuf, .size = errbufsz };
+    json_t *resources;
+    json_t *tasks;
+    json_t *version;
+    json_t *attributes;
+    json_t *task;
+    size_t index;
+    bool v1;
+
+    if (!json_is_object (jobspec))
+        return errprintf (&e, "jobspec must be a mapping");
+    if (validate_keys (&e, jobspec, top_level_keys, false, false) < 0)
+        return -1;
+
+    resources = json_object_get (jobspec, "resources");
+    tasks = json_object_get (jobspec, "tasks");
+    version = json_object_get (jobspec, "version");
+    attributes = json_object_get (jobspec, "attributes");
+
+    v1 = (require_version == 1
+          || (json_is_integer (version) && json_integer_value (version) == 1));
+    if (v1 && (!json_is_integer (version) || json_integer_value (version) != 1))
+        return errprintf (&e, "version must be 1");
+
+    if (!json_is_array (resources))
+        return errprintf (&e, "resources must be a sequence");
+    if (!json_is_array (tasks))
+        return errprintf (&e, "tasks must be a sequence");
+    if (!json_is_integer (version))
+        return errprintf (&e, "version must be an integer");
+    if (!json_is_object (attributes))
+        return errprintf (&e, "attributes must be a mapping");
+    if (json_integer_value (version) < 1)
+        return errprintf (&e, "version must be >= 1");
+
+    if (validate_resource_list (&e, resources) < 0)
+        return -1;
+    json_array_foreach (tasks, index, task) {
+        if (validate_task (&e, task) < 0)
+            return -1;
+    }
+    if (validate_attributes (&e, attributes) < 0)
+        return -1;
+    if (v1 && validate_v1 (&e, attributes) < 0)
+        return -1;
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
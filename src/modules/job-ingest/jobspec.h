@@ -0,0 +1,33 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _JOB_INGEST_JOBSPEC_H
+#define _JOB_INGEST_JOBSPEC_H
+
+#include <jansson.h>
+
+/* Validate decoded jobspec per RFC 14, applying the same checks as the
+ * Python Jobspec classes used by validate-jobspec.py.  Version 1 checks
+ * are applied if the jobspec declares version 1, or if 'require_version'
+ * is 1.  Set 'require_version' to 0 to use the version in the jobspec.
+ *
+ * Returns 0 if valid.  On failure, returns -1 with errno set to EINVAL
+ * and a description of the problem in 'errbuf'.
+ */
+int jobspec_validate (json_t *jobspec,
+                      int require_version,
+                      char *errbuf,
+                      int errbufsz);
+
+#endif /* !_JOB_INGEST_JOBSPEC_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,193 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#include <errno.h>
+#include <string.h>
+#include <jansson.h>
+
+#include "src/common/libtap/tap.h"
+#include "jobspec.h"
+
+struct jobspec_test {
+    const char *descr;
+    int require_version;
+    const char *input;
+    const char *error_string;   // NULL if jobspec is valid
+};
+
+#define JOBSPEC_TEST_END { NULL, 0, NULL, NULL }
+
+#define RESOURCES \
+    "\"resources\": [{\"type\": \"slot\", \"count\": 1, \"label\": \"foo\"," \
+    "  \"with\": [{\"type\": \"core\", \"count\": 1}]}]"
+
+#define TASKS \
+    "\"tasks\": [{\"command\": [\"app\"], \"slot\": \"foo\"," \
+    "  \"count\": {\"per_slot\": 1}}]"
+
+#define V1_ATTRIBUTES \
+    "\"attributes\": {\"system\": {\"duration\": 0}}"
+
+struct jobspec_test tests[] = {
+    { "basic jobspec is valid", 0,
+      "{\"version\": 999, " RESOURCES ", " TASKS ", \"attributes\": {}}",
+      NULL,
+    },
+    { "basic V1 jobspec is valid", 0,
+      "{\"version\": 1, " RESOURCES ", " TASKS ", " V1_ATTRIBUTES "}",
+      NULL,
+    },
+    { "basic V1 jobspec is valid with require_version=1", 1,
+      "{\"version\": 1, " RESOURCES ", " TASKS ", " V1_ATTRIBUTES "}",
+      NULL,
+    },
+    { "complex count range is valid", 0,
+      "{\"version\": 999, \"resources\": [{\"type\": \"slot\","
+      "  \"count\": {\"min\": 1, \"max\": 4, \"operator\": \"+\","
+      "  \"operand\": 1}, \"label\": \"foo\"}], " TASKS ","
+      "  \"attributes\": {\"user\": {\"x\": 1}}}",
+      NULL,
+    },
+    { "jobspec that is not an object is invalid", 0,
+      "[]",
+      "jobspec must be a mapping",
+    },
+    { "missing tasks is invalid", 0,
+      "{\"version\": 999, " RESOURCES ", \"attributes\": {}}",
+      "Missing key (tasks)",
+    },
+    { "extra top level key is invalid", 0,
+      "{\"version\": 999, " RESOURCES ", " TASKS ", \"attributes\": {},"
+      "  \"foo\": 1}",
+      "Extraneous key (foo)",
+    },
+    { "version 0 is invalid", 0,
+      "{\"version\": 0, " RESOURCES ", " TASKS ", \"attributes\": {}}",
+      "version must be >= 1",
+    },
+    { "version 999 is invalid with require_version=1", 1,
+      "{\"version\": 999, " RESOURCES ", " TASKS ", " V1_ATTRIBUTES "}",
+      "version must be 1",
+    },
+    { "V1 jobspec without duration is invalid", 0,
+      "{\"version\": 1, " RESOURCES ", " TASKS ","
+      "  \"attributes\": {\"system\": {}}}",
+      "attributes.system.duration is a required key",
+    },
+    { "V1 jobspec with string duration is invalid", 0,
+      "{\"version\": 1, " RESOURCES ", " TASKS ","
+      "  \"attributes\": {\"system\": {\"duration\": \"1m\"}}}",
+      "attributes.system.duration must be a number",
+    },
+    { "resource count of zero is invalid", 0,
+      "{\"version\": 999, \"resources\": [{\"type\": \"node\","
+      "  \"count\": 0}], " TASKS ", \"attributes\": {}}",
+      "count must be > 0",
+    },
+    { "boolean resource count is invalid", 0,
+      "{\"version\": 999, \"resources\": [{\"type\": \"node\","
+      "  \"count\": true}], " TASKS ", \"attributes\": {}}",
+      "count must be an int or mapping",
+    },
+    { "partial count range is invalid", 0,
+      "{\"version\": 999, \"resources\": [{\"type\": \"node\","
+      "  \"count\": {\"min\": 1, \"max\": 2}}], " TASKS ","
+      "  \"attributes\": {}}",
+      "Missing key (operator)",
+    },
+    { "bad range operator is invalid", 0,
+      "{\"version\": 999, \"resources\": [{\"type\": \"node\","
+      "  \"count\": {\"min\": 1, \"max\": 2, \"operator\": \"-\","
+      "  \"operand\": 1}}], " TASKS ", \"attributes\": {}}",
+      "operator must be one of ['+', '*', '^']",
+    },
+    { "slot without label is invalid", 0,
+      "{\"version\": 999, \"resources\": [{\"type\": \"slot\","
+      "  \"count\": 1}], " TASKS ", \"attributes\": {}}",
+      "slots must have labels",
+    },
+    { "invalid nested resource is invalid", 0,
+      "{\"version\": 999, \"resources\": [{\"type\": \"node\", \"count\": 1,"
+      "  \"with\": [{\"count\": 1}]}], " TASKS ", \"attributes\": {}}",
+      "type is a required key for resources",
+    },
+    { "empty command is invalid", 0,
+      "{\"version\": 999, " RESOURCES ", \"tasks\": [{\"command\": [],"
+      "  \"slot\": \"foo\", \"count\": {\"per_slot\": 1}}],"
+      "  \"attributes\": {}}",
+      "command array cannot have length of zero",
+    },
+    { "non-string command argument is invalid", 0,
+      "{\"version\": 999, " RESOURCES ", \"tasks\": [{\"command\": [1],"
+      "  \"slot\": \"foo\", \"count\": {\"per_slot\": 1}}],"
+      "  \"attributes\": {}}",
+      "command must be a list of strings",
+    },
+    { "task without slot is invalid", 0,
+      "{\"version\": 999, " RESOURCES ", \"tasks\": [{\"command\": [\"a\"],"
+      "  \"count\": {\"per_slot\": 1}}], \"attributes\": {}}",
+      "Missing key (slot)",
+    },
+    { "unknown attributes section is invalid", 0,
+      "{\"version\": 999, " RESOURCES ", " TASKS ","
+      "  \"attributes\": {\"foo\": {}}}",
+      "Extraneous key (foo)",
+    },
+    JOBSPEC_TEST_END
+};
+
+static void test_errbuf (void)
+{
+    json_t *o;
+
+    if (!(o = json_loads ("{}", 0, NULL)))
+        BAIL_OUT ("json_loads failed");
+    errno = 0;
+    ok (jobspec_validate (o, 0, NULL, 0) < 0 && errno == EINVAL,
+        "jobspec_validate works with NULL errbuf");
+    json_decref (o);
+}
+
+int main (int ac, char *av[])
+{
+    struct jobspec_test *e = NULL;
+
+    plan (NO_PLAN);
+
+    e = &tests[0];
+    while (e && e->descr) {
+        json_t *o;
+        json_error_t error;
+        char errbuf[256];
+        int rc;
+
+        if (!(o = json_loads (e->input, 0, &error)))
+            BAIL_OUT ("%s: json_loads: %s", e->descr, error.text);
+        memset (errbuf, 0, sizeof (errbuf));
+        errno = 0;
+        rc = jobspec_validate (o, e->require_version, errbuf, sizeof (errbuf));
+        if (e->error_string == NULL)
+            ok (rc == 0, "%s", e->descr);
+        else {
+            ok (rc < 0 && errno == EINVAL, "%s", e->descr);
+            is (errbuf, e->error_string,
+                "got expected error: %s", errbuf);
+        }
+        json_decref (o);
+        e++;
+    }
+    test_errbuf ();
+
+    done_testing ();
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -10,12 +10,16 @@
 
 /* validate - asynchronous jobspec validation interface
  *
- * Spawn worker(s) to validate jobspec.  Up to 'DEFAULT_WORKER_COUNT'
- * workers may be active at one time.  They are started lazily, on demand,
- * and stop after a period of inactivity (see "tunables" below).
+ * By default, jobspec is validated in-process (see jobspec.c), and the
+ * returned future is already fulfilled.
  *
- * The validator executable and its command line, including the
- * location of jobspec.jsonschema, are currently hardwired.
+ * If a validator executable is configured, spawn worker(s) to validate
+ * jobspec instead.  Up to 'MAX_WORKER_COUNT' workers may be active
+ * at one time.  They are started lazily, when the estimated time to
+ * drain the backlog of running workers exceeds a threshold, and stop
+ * after a period of inactivity (see "tunables" below).  Work is packed
+ * onto the lowest numbered worker that can take it, so that extra
+ * workers go idle and exit once a burst of submissions has passed.
  *
  * Jobspec is expected to be in encoded JSON form, with or without
  * whitespace or NULL termination.  The encoding is normalized before
@@ -38,6 +42,7 @@
 
 #include "validate.h"
 #include "worker.h"
+#include "jobspec.h"
 
 /* Tunables:
  */
@@ -46,9 +51,14 @@
  */
 #define MAX_WORKER_COUNT 4
 
-/* Start a new worker if backlog reaches this level for all active workers.
+/* Start a new worker if the estimated backlog of all active workers
+ * reaches this many seconds...
  */
-const int worker_queue_threshold = 32;
+const double worker_backlog_threshold = 0.1;
+
+/* ...or, before a worker has produced a time estimate, this many requests.
+ */
+const int worker_queue_threshold = 256;
 
 /* Workers exit once they have been inactive for this many seconds.
  */
@@ -58,6 +68,8 @@ const double worker_inactivity_timeout = 5.0;
 
 struct validate {
     flux_t *h;
+    bool native;            // validate in-process, no workers
+    int require_version;    // native only: --require-version=N
     struct worker *worker[MAX_WORKER_COUNT];
 };
 
@@ -92,6 +104,8 @@ int validate_stop_notify (struct validate *v, process_exit_f cb, void *arg)
     int count;
 
     count = 0;
+    if (v->native)
+        return 0;
     for (i = 0; i < MAX_WORKER_COUNT; i++)
         count += worker_stop_notify (v->worker[i], cb, arg);
     return count;
@@ -102,7 +116,8 @@ void validate_destroy (struct validate *v)
     if (v) {
         int saved_errno = errno;
         int i;
-        validate_killall (v);
+        if (!v->native)
+            validate_killall (v);
         for (i = 0; i < MAX_WORKER_COUNT; i++)
             worker_destroy (v->worker[i]);
         free (v);
@@ -119,6 +134,47 @@ static bool str_ends_with (const char *str, const char *suffix)
         (!strncmp ((str + str_len) - suffix_len, suffix, suffix_len));
 }
 
+/* The native validator accepts the same arguments as validate-jobspec.py,
+ * i.e. "--require-version,N" or "--require-version=N".
+ */
+static int parse_native_args (struct validate *v, const char *validator_args)
+{
+    char *argz = NULL;
+    size_t argz_len = 0;
+    char *arg = NULL;
+    char *endptr;
+    const char *val;
+
+    if (!validator_args)
+        return 0;
+    if (argz_create_sep (validator_args, ',', &argz, &argz_len) != 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    while ((arg = argz_next (argz, argz_len, arg))) {
+        if (!strcmp (arg, "--require-version")) {
+            if (!(arg = argz_next (argz, argz_len, arg)))
+                goto inval;
+            val = arg;
+        }
+        else if (!strncmp (arg, "--require-version=", 18))
+            val = arg + 18;
+        else
+            goto inval;
+        errno = 0;
+        v->require_version = strtol (val, &endptr, 10);
+        if (errno != 0 || *endptr != '\0' || v->require_version != 1)
+            goto inval;
+    }
+    free (argz);
+    return 0;
+inval:
+    flux_log (v->h, LOG_ERR, "invalid validator-args: %s", validator_args);
+    free (argz);
+    errno = EINVAL;
+    return -1;
+}
+
 struct validate *validate_create (flux_t *h,
                                   const char *validate_path,
                                   const char *validator_args)
@@ -135,7 +191,12 @@ struct validate *validate_create (flux_t *h,
         return NULL;
     v->h = h;
 
-    assert (validate_path != NULL);
+    if (!validate_path) {
+        v->native = true;
+        if (parse_native_args (v, validator_args) < 0)
+            goto error;
+        return v;
+    }
 
     if (str_ends_with (validate_path, ".py"))
         argv[argc++] = PYTHON_INTERPRETER;
@@ -176,8 +237,18 @@ error:
     return NULL;
 }
 
-/* Select worker with least backlog.  If none is running, or the best
- * has a backlog at or beyond threshold, activate a new one, if possible.
+static bool worker_is_overloaded (struct worker *w)
+{
+    double backlog = worker_backlog (w);
+
+    if (backlog > 0.)
+        return backlog >= worker_backlog_threshold;
+    return worker_queue_depth (w) >= worker_queue_threshold;
+}
+
+/* Select the first running worker that is not overloaded.  If there is
+ * none, activate a new one if possible, otherwise select the running
+ * worker with least backlog.
  */
 struct worker *select_best_worker (struct validate *v)
 {
@@ -187,25 +258,44 @@ struct worker *select_best_worker (struct validate *v)
 
     for (i = 0; i < MAX_WORKER_COUNT; i++) {
         if (worker_is_running (v->worker[i])) {
-            if (!best || (worker_queue_depth (v->worker[i])
-                        < worker_queue_depth (best)))
+            if (!worker_is_overloaded (v->worker[i]))
+                return v->worker[i];
+            if (!best || (worker_backlog (v->worker[i])
+                        < worker_backlog (best)))
                 best = v->worker[i];
         }
         else if (!idle)
             idle = v->worker[i];
     }
-    if (idle && (!best || worker_queue_depth (best) >= worker_queue_threshold))
+    if (idle)
         best = idle;
 
     return best;
 }
 
+/* Validate jobspec in-process, and return the result in a fulfilled future.
+ */
+static flux_future_t *validate_native (struct validate *v, json_t *o)
+{
+    flux_future_t *f;
+    char errbuf[256];
+
+    if (!(f = flux_future_create (NULL, NULL)))
+        return NULL;
+    flux_future_set_flux (f, v->h);
+    if (jobspec_validate (o, v->require_version, errbuf, sizeof (errbuf)) < 0)
+        flux_future_fulfill_error (f, errno, errbuf);
+    else
+        flux_future_fulfill (f, NULL, NULL);
+    return f;
+}
+
 flux_future_t *validate_jobspec (struct validate *v, const char *buf, int len)
 {
     flux_future_t *f;
     json_t *o;
     json_error_t error;
-    char *s;
+    char *s = NULL;
     int saved_errno;
     struct worker *w;
 
@@ -223,6 +313,12 @@ flux_future_t *validate_jobspec (struct validate *v, const char *buf, int len)
         flux_future_fulfill_error (f, EINVAL, errbuf);
         return f;
     }
+    if (v->native) {
+        if (!(f = validate_native (v, o)))
+            goto error;
+        json_decref (o);
+        return f;
+    }
     if (!(s = json_dumps (o, JSON_COMPACT)))
         goto error;
     w = select_best_worker (v);
@@ -28,6 +28,11 @@ flux_future_t *validate_jobspec (struct validate *v, const char *buf, int len);
  */
 int validate_stop_notify (struct validate *v, process_exit_f cb, void *arg);
 
+/* Create validation context.  If 'validate_path' is NULL, jobspec is
+ * validated in-process, and 'validator_args' may only contain
+ * "--require-version,1".  Otherwise 'validate_path' is an external
+ * validator program run with the comma separated 'validator_args'.
+ */
 struct validate *validate_create (flux_t *h,
                                   const char *validate_path,
                                   const char *validator_args);
@@ -11,16 +11,10 @@
 from __future__ import print_function
 
 import sys
-import json
 import argparse
 
 from flux.job import validate_jobspec
-
-
-def emit(object_dict):
-    s = json.dumps(object_dict, separators=(",", ":"))
-    print(s)
-    sys.stdout.flush()
+from flux.job.validator import ValidatorWorker
 
 
 print("ready", file=sys.stderr)
@@ -43,18 +37,6 @@ if args.require_version is not None:
         )
         exit(1)
 
-while True:
-    line = sys.stdin.readline()
-    if line == "":
-        break
-    errnum, errstr = (0, None)
-    try:
-        validate_jobspec(line, args.require_version)
-    except (ValueError, TypeError, EnvironmentError) as e:
-        errnum, errstr = (1, str(e))
-    if errstr != None:
-        emit({"errnum": errnum, "errstr": errstr})
-    else:
-        emit({"errnum": errnum})
+ValidatorWorker(lambda js: validate_jobspec(js, args.require_version)).run()
 
 print("exiting", file=sys.stderr)
@@ -15,22 +15,14 @@ import argparse
 import json
 import jsonschema
 
+from flux.job.validator import ValidatorWorker
 
-def emit(object_dict):
-    s = json.dumps(object_dict, separators=(",", ":"))
-    print(s)
-    sys.stdout.flush()
 
-
-def validate(schema, line):
+def validate(jobspec):
     try:
-        jobspec = json.loads(line)
         jsonschema.validate(jobspec, schema)
-    except ValueError as e:
-        return (1, str(e))
     except jsonschema.exceptions.ValidationError as e:
-        return (1, e.message.replace("u'", "'"))
-    return (0, None)
+        raise ValueError(e.message.replace("u'", "'"))
 
 
 parser = argparse.ArgumentParser()
@@ -47,14 +39,6 @@ except ValueError as e:
 
 print("ready", file=sys.stderr)
 
-while True:
-    line = sys.stdin.readline()
-    if line == "":
-        break
-    errnum, errstr = validate(schema, line)
-    if errstr != None:
-        emit({"errnum": errnum, "errstr": errstr})
-    else:
-        emit({"errnum": errnum})
+ValidatorWorker(validate).run()
 
 print("exiting", file=sys.stderr)
@@ -13,21 +13,37 @@
  * Start a coprocess that reads work from stdin (one line at a time),
  * then emits a one-line JSON result on stdout.  Stderr is logged.
  *
- * Each line of INPUT is a free form string with no embedded newlines.
- *
  * Each line of OUTPUT is an encoded JSON object with no embedded newlines.
  * Failure is indicated by errnum != 0 and optional error string:
  *  {"errnum":i ?"errstr":s}
  * Success is indicated by errnum = 0 and optional data object:
  *  {"errnum:0, ?"data":o}.
  *
+ * Two protocol versions are supported.  The first line sent to a new
+ * coprocess is
+ *  {"protocol":2}
+ * A coprocess that supports version 2 responds with the same line.
+ * Any other response is discarded and version 1 is used.  Work requested
+ * before the response arrives is held until the version is known.
+ *
+ * Version 1: each line of INPUT is a free form string with no embedded
+ * newlines.  The coprocess emits results in the order received.
+ *
+ * Version 2: each line of INPUT wraps the (JSON encoded) work in an
+ * object with a request id:
+ *  {"id":i "data":o}
+ * and each line of OUTPUT carries the id of the request it answers:
+ *  {"id":i "errnum":i ?"errstr":s ?"data":o}
+ * Results may be emitted in any order.
+ *
  * Work is requested by calling worker_request() with an input string.
  * A future is returned that is fulfilled when a result is received.
  *
- * Work may be submitted even when the worker is busy.  The worker emits
- * work results in the order received.  Internally, the worker maintains
- * a queue of futures, and each time a result is received, the future at
- * the head of queue is fulfilled.
+ * Work may be submitted even when the worker is busy.  Requests are
+ * buffered and written to the coprocess in batches, once 'batch_max'
+ * requests are waiting or 'batch_timeout' seconds have elapsed, so a
+ * burst of requests costs the coprocess one read rather than one per
+ * request.
  *
  * The broker exec service is used to spawn workers on the local rank,
  * using the libsubprocess API.
@@ -49,12 +65,43 @@
 
 const char *worker_auxkey = "flux::worker";
 
+/* Tunables:
+ */
+
+/* Write pending requests once this many are waiting...
+ */
+static const int batch_max = 128;
+
+/* ...or once the oldest has waited this many seconds.
+ */
+static const double batch_timeout = 0.001;
+
+/* Weight of each new sample in the service time moving average.
+ */
+static const double service_time_weight = 0.1;
+
+static const char *hello = "{\"protocol\":2}\n";
+
+struct worker_req {
+    uint32_t id;
+    flux_future_t *f;
+    char *s;                // work, until it is written to the coprocess
+    double t_sent;
+};
+
 struct worker {
     flux_t *h;
     char *name;
     flux_subprocess_t *p;
     flux_cmd_t *cmd;
-    zlist_t *queue; // queue of futures (head is currently running)
+    int protocol;           // 0 until version handshake completes
+    uint32_t seq;           // id of next request
+    uint32_t v1_next;       // id of next expected version 1 response
+    zhashx_t *pending;      // id => struct worker_req
+    zlist_t *unsent;        // requests waiting to be written
+    flux_watcher_t *batch_timer;
+    double service_time;    // moving average of time per request
+    double last_response;
     flux_watcher_t *timer;
     double inactivity_timeout;
     zlist_t *trash;
@@ -64,6 +111,8 @@ struct worker {
 
 static int worker_start (struct worker *w);
 static void worker_stop (struct worker *w);
+static void worker_flush (struct worker *w);
+static void worker_unexpected_exit (struct worker *w);
 
 /* Subprocess completed.
  * Destroy the subprocess, but don't use w->p since that may be a diferent
@@ -90,10 +139,13 @@ static void worker_completion_cb (flux_subprocess_t *p)
     zlist_remove (w->trash, p);
 
     /*  Be sure to nullify w->p if this worker unexpectedly exited
-     *  (i.e., worker_stop() wasn't called on it)
+     *  (i.e., worker_stop() wasn't called on it), and fail any requests
+     *  that were sent after its stdout was closed.
      */
-    if (w->p == p)
+    if (w->p == p) {
         w->p = NULL;
+        worker_unexpected_exit (w);
+    }
 
     /*  Call worker_stop_notify() callback, if any
      */
@@ -124,6 +176,65 @@ static void worker_state_cb (flux_subprocess_t *p,
     }
 }
 
+static void worker_req_destroy (struct worker_req *req)
+{
+    if (req) {
+        int saved_errno = errno;
+        flux_future_decref (req->f);
+        free (req->s);
+        free (req);
+        errno = saved_errno;
+    }
+}
+
+static struct worker_req *worker_req_create (flux_future_t *f,
+                                             uint32_t id,
+                                             const char *s)
+{
+    struct worker_req *req;
+
+    if (!(req = calloc (1, sizeof (*req))))
+        return NULL;
+    if (!(req->s = strdup (s))) {
+        free (req);
+        return NULL;
+    }
+    req->id = id;
+    req->f = f;
+    flux_future_incref (f);
+    return req;
+}
+
+/* N.B. zhashx_destructor_fn signature
+ */
+static void req_destructor (void **item)
+{
+    if (item) {
+        worker_req_destroy (*item);
+        *item = NULL;
+    }
+}
+
+/* N.B. zhashx_hash_fn signature
+ */
+static size_t req_hasher (const void *key)
+{
+    const uint32_t *id = key;
+    return *id;
+}
+
+#define NUMCMP(a,b) ((a)==(b)?0:((a)<(b)?-1:1))
+
+/* N.B. zhashx_comparator_fn signature
+ */
+static int req_hash_key_cmp (const void *key1, const void *key2)
+{
+    const uint32_t *id1 = key1;
+    const uint32_t *id2 = key2;
+
+    return NUMCMP (*id1, *id2);
+}
+
 static void worker_timeout (flux_reactor_t *r, flux_watcher_t *timer,
                             int revents, void *arg)
 {
@@ -149,18 +260,20 @@ static void worker_active (struct worker *w)
         flux_log_error (w->h, "%s: worker_start", w->name);
 }
 
-/* Fulfill future 'f' with result 's'.
- * Ensure that any errors in parsing 's' are passed on to 'f' as well.
+/* Fulfill future 'f' with decoded result 'o'.
+ * Ensure that any errors in parsing 'o' are passed on to 'f' as well.
  */
-static void worker_fulfill_future (struct worker *w, flux_future_t *f, const char *s)
+static void worker_fulfill_future (struct worker *w,
+                                   flux_future_t *f,
+                                   json_t *o,
+                                   const char *s)
 {
-    json_t *o;
     int errnum;
     const char *errstr = NULL; // optional
     json_t *data = NULL; // optional
     char *s_data = NULL;
 
-    if (!(o = json_loads (s, 0, NULL))) {
+    if (!o) {
         flux_log (w->h, LOG_ERR, "%s: json_loads '%s' failed", w->name, s);
         errnum = EINVAL;
         goto error;
@@ -182,27 +295,100 @@ static void worker_fulfill_future (struct worker *w, flux_future_t *f, const cha
         }
     }
     flux_future_fulfill (f, s_data, (flux_free_f)free);
-    json_decref (o);
     return;
 error:
     flux_future_fulfill_error (f, errnum, errstr);
-    json_decref (o);
 }
 
-static void worker_unexpected_exit (struct worker *w)
+/* Fail all pending requests with 'errnum' and 'errstr'.
+ */
+static void worker_fail_pending (struct worker *w,
+                                 int errnum,
+                                 const char *errstr)
 {
-    flux_future_t *f;
-    const char *json_err =
-        "{\"errnum\":71,"
-        "\"errstr\":\"Unrecoverable error: validator unexpectedly exited\"}";
+    struct worker_req *req;
 
-    /*  Respond to any pending requests immediately with error above.
+    zlist_purge (w->unsent);
+    while ((req = zhashx_first (w->pending))) {
+        flux_future_fulfill_error (req->f, errnum, errstr);
+        zhashx_delete (w->pending, &req->id);
+    }
+    flux_watcher_stop (w->batch_timer);
+}
+
+static void worker_unexpected_exit (struct worker *w)
+{
+    /*  Respond to any pending requests immediately with error.
      *  The remainder of worker cleanup will happen in the exit callback.
      */
-    while ((f = zlist_pop (w->queue))) {
-        worker_fulfill_future (w, f, json_err);
-        flux_future_decref (f);
+    worker_fail_pending (w,
+                         EPROTO,
+                         "Unrecoverable error: validator unexpectedly exited");
+}
+
+/* Handle the coprocess response to the protocol version handshake.
+ * Requests held during the handshake may now be written.
+ */
+static void worker_handshake (struct worker *w, json_t *o)
+{
+    int protocol = 1;
+
+    if (o)
+        (void)json_unpack (o, "{s:i}", "protocol", &protocol);
+    if (protocol != 2)
+        protocol = 1;
+    w->protocol = protocol;
+    w->v1_next = w->seq - zlist_size (w->unsent);
+    flux_log (w->h, LOG_DEBUG, "%s: using protocol version %d",
+              w->name, w->protocol);
+    if (zlist_size (w->unsent) > 0)
+        worker_flush (w);
+}
+
+/* Update the per-request service time estimate on receipt of a response
+ * to a request sent at 't_sent'.  While the worker is continuously busy,
+ * the interval between responses is the time it spent on one request.
+ */
+static void worker_update_service_time (struct worker *w, double t_sent)
+{
+    double now = flux_reactor_now (flux_get_reactor (w->h));
+    double start = t_sent > w->last_response ? t_sent : w->last_response;
+    double sample = now - start;
+
+    if (w->service_time == 0.)
+        w->service_time = sample;
+    else
+        w->service_time = service_time_weight * sample
+                          + (1. - service_time_weight) * w->service_time;
+    w->last_response = now;
+}
+
+/* Match response 'o' to a pending request, and fulfill its future.
+ */
+static void worker_response (struct worker *w, json_t *o, const char *s)
+{
+    struct worker_req *req;
+    uint32_t id;
+    int i;
+
+    if (w->protocol == 1)
+        id = w->v1_next++;
+    else if (!o || json_unpack (o, "{s:i}", "id", &i) < 0) {
+        flux_log (w->h, LOG_ERR, "%s: response has no id: '%s'", w->name, s);
+        return;
+    }
+    else
+        id = i;
+    if (!(req = zhashx_lookup (w->pending, &id)) || req->s != NULL) {
+        flux_log (w->h, LOG_ERR, "%s: dropping orphan response: '%s'",
+                  w->name, s);
+        return;
     }
+    worker_update_service_time (w, req->t_sent);
+    worker_fulfill_future (w, req->f, o, s);
+    zhashx_delete (w->pending, &id);
+    if (zhashx_size (w->pending) == 0)
+        worker_inactive (w);
 }
 
 /* Subprocess output available
@@ -239,17 +425,17 @@ static void worker_output_cb (flux_subprocess_t *p, const char *stream)
         return;
     }
     if (!strcmp (stream, "stdout")) {
-        flux_future_t *f;
+        json_t *o = json_loads (s, 0, NULL);
 
-        if (!(f = zlist_pop (w->queue))) {
+        if (w->p != p) {
             flux_log (w->h, LOG_ERR, "%s: dropping orphan response: '%s'",
                       w->name, s);
-            return;
         }
-        worker_fulfill_future (w, f, s);
-        flux_future_decref (f);
-        if (zlist_size (w->queue) == 0)
-            worker_inactive (w);
+        else if (w->protocol == 0)
+            worker_handshake (w, o);
+        else
+            worker_response (w, o, s);
+        json_decref (o);
     }
     else if (!strcmp (stream, "stderr")) {
         flux_log (w->h, LOG_DEBUG, "%s: %s", w->name, s ? s : "");
@@ -264,12 +450,63 @@ flux_subprocess_ops_t worker_ops = {
     .on_stderr          = worker_output_cb,
 };
 
-flux_future_t *worker_request (struct worker *w, const char *s)
+/* Write all unsent requests to the coprocess with a single write.
+ * If that fails, fail the requests rather than leave them waiting forever.
+ */
+static void worker_flush (struct worker *w)
 {
-    int bufsz = strlen (s) + 1;
+    double now = flux_reactor_now (flux_get_reactor (w->h));
+    struct worker_req *req;
+    size_t bufsz = 0;
     char *buf;
+    int len = 0;
+    int errnum;
+
+    flux_watcher_stop (w->batch_timer);
+    if (w->protocol == 0 || zlist_size (w->unsent) == 0)
+        return;
+    req = zlist_first (w->unsent);
+    while (req) {
+        bufsz += strlen (req->s) + 32; // room for {"id":N,"data":...}\n
+        req = zlist_next (w->unsent);
+    }
+    if (!(buf = malloc (bufsz + 1)))
+        goto error;
+    while ((req = zlist_pop (w->unsent))) {
+        if (w->protocol == 2)
+            len += sprintf (buf + len, "{\"id\":%u,\"data\":%s}\n",
+                            (unsigned int)req->id, req->s);
+        else
+            len += sprintf (buf + len, "%s\n", req->s);
+        free (req->s);
+        req->s = NULL;
+        req->t_sent = now;
+    }
+    if (flux_subprocess_write (w->p, "stdin", buf, len) != len) {
+        free (buf);
+        goto error;
+    }
+    free (buf);
+    return;
+error:
+    errnum = errno;
+    flux_log_error (w->h, "%s: error writing requests", w->name);
+    worker_fail_pending (w, errnum, NULL);
+    worker_inactive (w);
+}
+
+static void worker_batch_timeout (flux_reactor_t *r,
+                                  flux_watcher_t *timer,
+                                  int revents,
+                                  void *arg)
+{
+    worker_flush (arg);
+}
+
+flux_future_t *worker_request (struct worker *w, const char *s)
+{
     flux_future_t *f;
-    int saved_errno;
+    struct worker_req *req = NULL;
 
     if (strchr (s, '\n')) {
         errno = EINVAL;
@@ -278,23 +515,33 @@ flux_future_t *worker_request (struct worker *w, const char *s)
     if (!(f = flux_future_create (NULL, NULL)))
         return NULL;
     flux_future_set_flux (f, w->h);
-    if (!(buf = malloc (bufsz)))
-        goto error;
-    memcpy (buf, s, bufsz - 1);
-    buf[bufsz - 1] = '\n';
     worker_active (w);
-    if (flux_subprocess_write (w->p, "stdin", buf, bufsz) != bufsz)
+    if (!w->p) {
+        errno = EAGAIN; // worker could not be started, try again later
         goto error;
-    if (zlist_append (w->queue, f) < 0)
+    }
+    if (!(req = worker_req_create (f, w->seq, s)))
         goto error;
-    flux_future_incref (f); // queue takes a reference on the future
-    free (buf);
+    if (zhashx_insert (w->pending, &req->id, req) < 0) {
+        worker_req_destroy (req);
+        errno = EEXIST;
+        goto error;
+    }
+    if (zlist_append (w->unsent, req) < 0) {
+        zhashx_delete (w->pending, &req->id);
+        errno = ENOMEM;
+        goto error;
+    }
+    w->seq++;
+    if (zlist_size (w->unsent) >= batch_max)
+        worker_flush (w);
+    else if (zlist_size (w->unsent) == 1) {
+        flux_timer_watcher_reset (w->batch_timer, batch_timeout, 0.);
+        flux_watcher_start (w->batch_timer);
+    }
     return f;
 error:
-    saved_errno = errno;
-    free (buf);
     flux_future_destroy (f);
-    errno = saved_errno;
     return NULL;
 }
 
@@ -355,13 +602,25 @@ static int worker_start (struct worker *w)
             worker_stop (w);
             return -1;
         }
+        w->protocol = 0;
+        w->service_time = 0.;
+        w->last_response = 0.;
+        if (flux_subprocess_write (w->p, "stdin", hello, strlen (hello)) < 0) {
+            worker_stop (w);
+            return -1;
+        }
     }
     return 0;
 }
 
 int worker_queue_depth (struct worker *w)
 {
-    return zlist_size (w->queue);
+    return zhashx_size (w->pending);
+}
+
+double worker_backlog (struct worker *w)
+{
+    return zhashx_size (w->pending) * w->service_time;
 }
 
 bool worker_is_running (struct worker *w)
@@ -374,16 +633,15 @@ void worker_destroy (struct worker *w)
     if (w) {
         int saved_errno = errno;
         flux_subprocess_t *p;
-        flux_future_t *f;
 
         worker_stop (w); // puts w->p in w->trash
         flux_cmd_destroy (w->cmd);
-        while ((f = zlist_pop (w->queue)))
-            flux_future_decref (f);
-        zlist_destroy (&w->queue);
+        zlist_destroy (&w->unsent);
+        zhashx_destroy (&w->pending);
         while ((p = zlist_pop (w->trash)))
             flux_subprocess_destroy (p);
         zlist_destroy (&w->trash);
+        flux_watcher_destroy (w->batch_timer);
         flux_watcher_destroy (w->timer);
         free (w->name);
         free (w);
@@ -410,8 +668,19 @@ struct worker *worker_create (flux_t *h, double inactivity_timeout,
         goto error;
     if (!(w->name = strdup (basename (name))))
         goto error;
-    if (!(w->queue = zlist_new ()))
+    if (!(w->batch_timer = flux_timer_watcher_create (r, batch_timeout, 0.,
+                                                      worker_batch_timeout,
+                                                      w)))
+        goto error;
+    if (!(w->unsent = zlist_new ()))
+        goto error;
+    if (!(w->pending = zhashx_new ()))
         goto error;
+    zhashx_set_key_hasher (w->pending, req_hasher);
+    zhashx_set_key_comparator (w->pending, req_hash_key_cmp);
+    zhashx_set_key_duplicator (w->pending, NULL);
+    zhashx_set_key_destructor (w->pending, NULL);
+    zhashx_set_destructor (w->pending, (zhashx_destructor_fn *)req_destructor);
     if (!(w->cmd = flux_cmd_create (argc, argv, environ))) {
         flux_log_error (h, "flux_cmd_create");
         goto error;
@@ -21,6 +21,12 @@ struct worker;
 flux_future_t *worker_request (struct worker *w, const char *s);
 
 int worker_queue_depth (struct worker *w);
+
+/* Estimated time in seconds for the worker to complete its queued work,
+ * based on the recent time per request.  Zero if no estimate is
+ * available yet.
+ */
+double worker_backlog (struct worker *w);
 bool worker_is_running (struct worker *w);
 
 flux_future_t *worker_kill (struct worker *w, int signo);
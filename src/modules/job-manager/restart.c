@@ -17,8 +17,10 @@
 #include <argz.h>
 #include <envz.h>
 #include <flux/core.h>
+#include <czmq.h>
 
 #include "src/common/libutil/fluid.h"
+#include "src/common/libutil/errno_safe.h"
 
 #include "job.h"
 #include "restart.h"
@@ -42,87 +44,177 @@ int restart_count_char (const char *s, char c)
     return count;
 }
 
-static int depthfirst_map_one (flux_t *h, const char *key, int dirskip,
-                               restart_map_f cb, void *arg)
+/* Active jobs are found by walking the job.A.B.C.D directories.
+ * Directory and eventlog lookups are pipelined, with up to
+ * RESTART_LOOKUP_WINDOW outstanding at once.  'keys' holds directories
+ * and job keys that have been found but not yet looked up.  New keys
+ * are pushed on the front so the walk stays roughly depth first, and
+ * 'keys' does not grow to hold every job key at once.
+ */
+#define RESTART_LOOKUP_WINDOW 128
+
+struct restart_walk {
+    flux_t *h;
+    int dirskip;
+    restart_map_f cb;
+    void *arg;
+    zlist_t *keys;
+    int count;
+};
+
+/* Job keys are four levels below the top level directory.
+ */
+static int restart_key_level (struct restart_walk *rw, const char *key)
 {
-    flux_jobid_t id;
-    flux_future_t *f;
-    const char *eventlog;
-    struct job *job = NULL;
-    char path[64];
-    int rc = -1;
+    return restart_count_char (key + rw->dirskip, '.');
+}
 
-    if (strlen (key) <= dirskip) {
-        errno = EINVAL;
-        return -1;
+static flux_future_t *restart_walk_produce (flux_future_t *pf, void *arg)
+{
+    struct restart_walk *rw = arg;
+    flux_future_t *f = NULL;
+    char *key;
+
+    if (!(key = zlist_pop (rw->keys))) {
+        errno = ENODATA;
+        return NULL;
     }
-    if (fluid_decode (key + dirskip + 1, &id, FLUID_STRING_DOTHEX) < 0)
-        return -1;
-    if (flux_job_kvs_key (path, sizeof (path), id, "eventlog") < 0) {
-        errno = EINVAL;
-        return -1;
+    if (restart_key_level (rw, key) == 4) {
+        flux_jobid_t id;
+        char path[64];
+
+        if (strlen (key) <= rw->dirskip) {
+            errno = EINVAL;
+            goto error;
+        }
+        if (fluid_decode (key + rw->dirskip + 1, &id, FLUID_STRING_DOTHEX) < 0)
+            goto error;
+        if (flux_job_kvs_key (path, sizeof (path), id, "eventlog") < 0) {
+            errno = EINVAL;
+            goto error;
+        }
+        if (!(f = flux_kvs_lookup (rw->h, NULL, 0, path)))
+            goto error;
     }
-    if (!(f = flux_kvs_lookup (h, NULL, 0, path)))
-        goto done;
-    if (flux_kvs_lookup_get (f, &eventlog) < 0)
-        goto done;
-    if (!(job = job_create_from_eventlog (id, eventlog)))
-        goto done;
-    if (cb (job, arg) < 0)
-        goto done;
-    rc = 1;
-done:
+    else {
+        if (!(f = flux_kvs_lookup (rw->h, NULL, FLUX_KVS_READDIR, key)))
+            goto error;
+    }
+    if (flux_future_aux_set (f, "key", key, free) < 0)
+        goto error;
+    return f;
+error:
     flux_future_destroy (f);
-    job_decref (job);
-    return rc;
+    ERRNO_SAFE_WRAP (free, key);
+    return NULL;
 }
 
-static int depthfirst_map (flux_t *h, const char *key,
-                           int dirskip, restart_map_f cb, void *arg)
+static int restart_walk_dir (struct restart_walk *rw,
+                             flux_future_t *f,
+                             const char *key)
 {
-    flux_future_t *f;
     const flux_kvsdir_t *dir;
     flux_kvsitr_t *itr;
     const char *name;
-    int path_level;
-    int count = 0;
     int rc = -1;
 
-    path_level = restart_count_char (key + dirskip, '.');
-    if (!(f = flux_kvs_lookup (h, NULL, FLUX_KVS_READDIR, key)))
-        return -1;
     if (flux_kvs_lookup_get_dir (f, &dir) < 0) {
-        if (errno == ENOENT && path_level == 0)
-            rc = 0;
-        goto done;
+        if (errno == ENOENT && restart_key_level (rw, key) == 0)
+            return 0;
+        return -1;
     }
     if (!(itr = flux_kvsitr_create (dir)))
-        goto done;
+        return -1;
     while ((name = flux_kvsitr_next (itr))) {
         char *nkey;
-        int n;
         if (!flux_kvsdir_isdir (dir, name))
             continue;
         if (!(nkey = flux_kvsdir_key_at (dir, name)))
-            goto done_destroyitr;
-        if (path_level == 3) // orig 'key' = .A.B.C, thus 'nkey' is complete
-            n = depthfirst_map_one (h, nkey, dirskip, cb, arg);
-        else
-            n = depthfirst_map (h, nkey, dirskip, cb, arg);
-        if (n < 0) {
-            int saved_errno = errno;
+            goto done;
+        if (zlist_push (rw->keys, nkey) < 0) {
             free (nkey);
-            errno = saved_errno;
-            goto done_destroyitr;
+            errno = ENOMEM;
+            goto done;
         }
-        count += n;
-        free (nkey);
     }
-    rc = count;
-done_destroyitr:
+    rc = 0;
+done:
     flux_kvsitr_destroy (itr);
+    return rc;
+}
+
+static int restart_walk_consume (flux_future_t *pf,
+                                 flux_future_t *f,
+                                 void *arg)
+{
+    struct restart_walk *rw = arg;
+    const char *key = flux_future_aux_get (f, "key");
+    const char *eventlog;
+    struct job *job;
+    flux_jobid_t id;
+    int rc;
+
+    if (restart_key_level (rw, key) < 4)
+        return restart_walk_dir (rw, f, key);
+
+    if (fluid_decode (key + rw->dirskip + 1, &id, FLUID_STRING_DOTHEX) < 0)
+        return -1;
+    if (flux_kvs_lookup_get (f, &eventlog) < 0)
+        return -1;
+    if (!(job = job_create_from_eventlog (id, eventlog)))
+        return -1;
+    rc = rw->cb (job, rw->arg);
+    job_decref (job);
+    if (rc < 0)
+        return -1;
+    rw->count++;
+    return 0;
+}
+
+/* Call 'cb' for each job found under 'key', returning the number of
+ * jobs found, or -1 on error.
+ */
+static int restart_map (flux_t *h, const char *key,
+                        int dirskip, restart_map_f cb, void *arg)
+{
+    struct restart_walk rw = {
+        .h = h,
+        .dirskip = dirskip,
+        .cb = cb,
+        .arg = arg,
+        .count = 0,
+    };
+    flux_future_t *f = NULL;
+    char *s;
+    int saved_errno;
+    int rc = -1;
+
+    if (!(rw.keys = zlist_new ())) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (!(s = strdup (key)) || zlist_append (rw.keys, s) < 0) {
+        free (s);
+        errno = ENOMEM;
+        goto done;
+    }
+    if (!(f = flux_rpc_pipeline (h,
+                                 RESTART_LOOKUP_WINDOW,
+                                 0,
+                                 restart_walk_produce,
+                                 restart_walk_consume,
+                                 &rw)))
+        goto done;
+    if (flux_future_get (f, NULL) < 0)
+        goto done;
+    rc = rw.count;
 done:
+    saved_errno = errno;
     flux_future_destroy (f);
+    while ((s = zlist_pop (rw.keys)))
+        free (s);
+    zlist_destroy (&rw.keys);
+    errno = saved_errno;
     return rc;
 }
 
@@ -197,7 +289,7 @@ int restart_from_kvs (struct job_manager *ctx)
 
     /* Load any active jobs present in the KVS at startup.
      */
-    count = depthfirst_map (ctx->h, dirname, dirskip, restart_map_cb, ctx);
+    count = restart_map (ctx->h, dirname, dirskip, restart_map_cb, ctx);
     if (count < 0)
         return -1;
     flux_log (ctx->h, LOG_INFO, "restart: %d jobs", count);
@@ -21,6 +21,15 @@
 #include "src/common/libkvs/kvs_util_private.h"
 #include "src/common/libutil/blobref.h"
 
+/* A kvs.lookup-plus RPC, possibly shared by several watchers of the same
+ * key at the same root with identical credentials and flags.
+ */
+struct lookup {
+    flux_future_t *f;
+    int refcount;
+    zlist_t *watchers;          // watchers waiting on this lookup
+};
+
 /* State for one watcher */
 struct watcher {
     const flux_msg_t *request;  // request message
@@ -35,7 +44,8 @@ struct watcher {
     int initial_rootseq;        // initial rootseq returned by initial rpc
     char *key;                  // lookup key
     int flags;                  // kvs_lookup flags
-    zlist_t *lookups;           // list of futures, in commit order
+    zlist_t *lookups;           // list of struct lookup, in commit order
+    int wakeseq;                // rootseq at which watcher was last woken
 
     struct ns_monitor *nsm;     // back pointer for removal
     json_t *prev;               // previous watch value for KVS_WATCH_FULL/UNIQ
@@ -63,6 +73,10 @@ struct ns_monitor {
     int errnum;                 // if non-zero, error pending for all watchers
     struct watch_ctx *ctx;      // back-pointer to watch_ctx
     zlist_t *watchers;          // list of watchers of this namespace
+    zhash_t *keyidx;            // key => zlist of watchers of that key
+    zlist_t *full_watchers;     // FLUX_KVS_WATCH_FULL watchers (not indexed)
+    zhashx_t *shared;           // lookup hashkey => struct lookup, valid
+                                //  only during one watcher_respond pass
     char *topic;                // topic string for subscription
     bool subscribed;            // subscription active
     flux_future_t *getrootf;    // initial getroot future
@@ -74,8 +88,62 @@ struct watch_ctx {
     flux_t *h;
     flux_msg_handler_t **handlers;
     zhash_t *namespaces;        // hash of monitored namespaces
+    int lookups_shared;         // count of lookup RPCs avoided by sharing
 };
 
+static void lookup_decref (struct lookup *l)
+{
+    if (l && --l->refcount == 0) {
+        int saved_errno = errno;
+        flux_future_destroy (l->f);
+        zlist_destroy (&l->watchers);
+        free (l);
+        errno = saved_errno;
+    }
+}
+
+static struct lookup *lookup_create (flux_future_t *f)
+{
+    struct lookup *l;
+
+    if (!(l = calloc (1, sizeof (*l))))
+        return NULL;
+    if (!(l->watchers = zlist_new ())) {
+        free (l);
+        errno = ENOMEM;
+        return NULL;
+    }
+    l->f = f;
+    l->refcount = 1;
+    return l;
+}
+
+/* Attach watcher 'w' to lookup 'l', taking a reference on 'l'.
+ */
+static int lookup_attach (struct lookup *l, struct watcher *w)
+{
+    if (zlist_append (l->watchers, w) < 0)
+        goto nomem;
+    if (zlist_append (w->lookups, l) < 0) {
+        zlist_remove (l->watchers, w);
+        goto nomem;
+    }
+    l->refcount++;
+    return 0;
+nomem:
+    errno = ENOMEM;
+    return -1;
+}
+
+/* Detach watcher 'w' from lookup 'l', dropping its reference on 'l'.
+ * N.B. caller must remove 'l' from w->lookups.
+ */
+static void lookup_detach (struct lookup *l, struct watcher *w)
+{
+    zlist_remove (l->watchers, w);
+    lookup_decref (l);
+}
+
 static void watcher_destroy (struct watcher *w)
 {
     if (w) {
@@ -83,9 +151,9 @@ static void watcher_destroy (struct watcher *w)
         flux_msg_decref (w->request);
         free (w->key);
         if (w->lookups) {
-            flux_future_t *f;
-            while ((f = zlist_pop (w->lookups)))
-                flux_future_destroy (f);
+            struct lookup *l;
+            while ((l = zlist_pop (w->lookups)))
+                lookup_detach (l, w);
             zlist_destroy (&w->lookups);
         }
         json_decref (w->prev);
@@ -110,6 +178,7 @@ static struct watcher *watcher_create (const flux_msg_t *msg, const char *key,
         goto error_nomem;
     w->flags = flags;
     w->rootseq = -1;
+    w->wakeseq = -1;
     return w;
 error_nomem:
     errno = ENOMEM;
@@ -151,6 +220,9 @@ static void namespace_destroy (struct ns_monitor *nsm)
     if (nsm) {
         int saved_errno = errno;
         commit_destroy (nsm->commit);
+        zhashx_destroy (&nsm->shared);
+        zhash_destroy (&nsm->keyidx);
+        zlist_destroy (&nsm->full_watchers);
         if (nsm->watchers) {
             struct watcher *w;
             while ((w = zlist_pop (nsm->watchers)))
@@ -173,7 +245,10 @@ static struct ns_monitor *namespace_create (struct watch_ctx *ctx,
     struct ns_monitor *nsm = calloc (1, sizeof (*nsm));
     if (!nsm)
         return NULL;
-    if (!(nsm->watchers = zlist_new ()))
+    if (!(nsm->watchers = zlist_new ())
+        || !(nsm->keyidx = zhash_new ())
+        || !(nsm->full_watchers = zlist_new ())
+        || !(nsm->shared = zhashx_new ()))
         goto error;
     if (!(nsm->ns_name = strdup (ns)))
         goto error;
@@ -208,26 +283,61 @@ error:
     return NULL;
 }
 
-/* Helper for watcher_respond - is key a member of array?
- * N.B. array 'a' can be NULL
+static void keyidx_list_destroy (void *item)
+{
+    zlist_t *l = item;
+    zlist_destroy (&l);
+}
+
+/* Add watcher to the namespace key index, so that setroot events
+ * need only wake watchers of the keys that changed.
+ * FLUX_KVS_WATCH_FULL watchers must be woken on every change, since
+ * a change to a parent directory may alter their value.
  */
-static bool array_match (json_t *a, const char *key)
+static int keyidx_add (struct ns_monitor *nsm, struct watcher *w)
 {
-    size_t index;
-    json_t *value;
+    zlist_t *l;
 
-    json_array_foreach (a, index, value) {
-        const char *s = json_string_value (value);
-        if (s && !strcmp (s, key))
-            return true;
+    if ((w->flags & FLUX_KVS_WATCH_FULL)) {
+        if (zlist_append (nsm->full_watchers, w) < 0)
+            goto nomem;
+        return 0;
+    }
+    if (!(l = zhash_lookup (nsm->keyidx, w->key))) {
+        if (!(l = zlist_new ()))
+            goto nomem;
+        if (zhash_insert (nsm->keyidx, w->key, l) < 0) {
+            zlist_destroy (&l);
+            goto nomem;
+        }
+        zhash_freefn (nsm->keyidx, w->key, keyidx_list_destroy);
+    }
+    if (zlist_append (l, w) < 0)
+        goto nomem;
+    return 0;
+nomem:
+    errno = ENOMEM;
+    return -1;
+}
+
+static void keyidx_remove (struct ns_monitor *nsm, struct watcher *w)
+{
+    zlist_t *l;
+
+    if ((w->flags & FLUX_KVS_WATCH_FULL))
+        zlist_remove (nsm->full_watchers, w);
+    else if ((l = zhash_lookup (nsm->keyidx, w->key))) {
+        zlist_remove (l, w);
+        if (zlist_size (l) == 0)
+            zhash_delete (nsm->keyidx, w->key);
     }
-    return false;
 }
 
 static void watcher_cleanup (struct ns_monitor *nsm, struct watcher *w)
 {
     /* wait for all in flight lookups to complete before destroying watcher */
     if (zlist_size (w->lookups) == 0) {
+        keyidx_remove (nsm, w);
         zlist_remove (nsm->watchers, w);
         watcher_destroy (w);
     }
@@ -485,20 +595,19 @@ error:
     w->finished = true;
 }
 
-/* One lookup has completed.
- * Pop ready futures off w->lookups and send responses, until
- * the list is empty, or a non-ready future is encountered.
+/* Pop ready lookups off w->lookups and send responses, until
+ * the list is empty, or a non-ready lookup is encountered.
  */
-static void lookup_continuation (flux_future_t *f, void *arg)
+static void watcher_process_lookups (struct watcher *w)
 {
-    struct watcher *w = arg;
     struct ns_monitor *nsm = w->nsm;
+    struct lookup *l;
 
-    while ((f = zlist_first (w->lookups)) && flux_future_is_ready (f)) {
-        f = zlist_pop (w->lookups);
+    while ((l = zlist_first (w->lookups)) && flux_future_is_ready (l->f)) {
+        l = zlist_pop (w->lookups);
         if (!w->finished)
-            handle_lookup_response (f, w);
-        flux_future_destroy (f);
+            handle_lookup_response (l->f, w);
+        lookup_detach (l, w);
         /* if WAITCREATE and !WATCH, then we only care about sending
          * one response and being done.  We can use the responded flag
          * to indicate that condition.
@@ -512,6 +621,32 @@ static void lookup_continuation (flux_future_t *f, void *arg)
         watcher_cleanup (nsm, w);
 }
 
+/* One lookup has completed.
+ * Let each watcher sharing it process its ready lookups.
+ * N.B. watchers may detach from 'l' and be destroyed during iteration,
+ * so iterate over a duplicate list and hold a reference on 'l'.
+ */
+static void lookup_continuation (flux_future_t *f, void *arg)
+{
+    struct lookup *l = arg;
+    zlist_t *watchers;
+    struct watcher *w;
+
+    if (!(watchers = zlist_dup (l->watchers))) {
+        flux_log_error (flux_future_get_flux (f), "%s: zlist_dup",
+                        __FUNCTION__);
+        return;
+    }
+    l->refcount++;
+    w = zlist_first (watchers);
+    while (w) {
+        watcher_process_lookups (w);
+        w = zlist_next (watchers);
+    }
+    zlist_destroy (&watchers);
+    lookup_decref (l);
+}
+
 /* Like flux_kvs_lookupat() except:
  * - targets kvs.lookup-plus, so root_ref & root_seq are available in
  *   response
@@ -579,28 +714,74 @@ error:
     return NULL;
 }
 
+/* Lookups other than the initial one may be shared by watchers of the
+ * same key at the same root, if credentials and flags are identical,
+ * since the KVS would return the same result to each.
+ */
+static char *lookup_hashkey (struct ns_monitor *nsm, struct watcher *w)
+{
+    char *hashkey;
+
+    if (asprintf (&hashkey, "%d:%u:%u:%d:%s",
+                  nsm->commit->rootseq,
+                  (unsigned int)w->cred.userid,
+                  (unsigned int)w->cred.rolemask,
+                  w->flags,
+                  w->key) < 0)
+        return NULL;
+    return hashkey;
+}
+
 static int process_lookup_response (struct ns_monitor *nsm, struct watcher *w)
 {
     flux_future_t *f;
+    struct lookup *l = NULL;
+    char *hashkey = NULL;
+    bool initial = !w->initial_rpc_sent;
+
+    if (!initial) {
+        if (!(hashkey = lookup_hashkey (nsm, w)))
+            return -1;
+        if ((l = zhashx_lookup (nsm->shared, hashkey))) {
+            free (hashkey);
+            if (lookup_attach (l, w) < 0)
+                return -1;
+            nsm->ctx->lookups_shared++;
+            w->rootseq = nsm->commit->rootseq;
+            return 0;
+        }
+    }
     if (!(f = lookupat (nsm->ctx->h,
                         w,
                         nsm->commit->rootref,
                         nsm->commit->rootseq,
                         nsm->ns_name))) {
         flux_log_error (nsm->ctx->h, "%s: lookupat", __FUNCTION__);
-        return -1;
+        goto error;
     }
-    if (zlist_append (w->lookups, f) < 0) {
+    if (!(l = lookup_create (f))) {
         flux_future_destroy (f);
-        errno = ENOMEM;
-        return -1;
+        goto error;
     }
-    if (flux_future_then (f, -1., lookup_continuation, w) < 0) {
-        flux_future_destroy (f);
-        return -1;
+    if (flux_future_then (f, -1., lookup_continuation, l) < 0
+        || lookup_attach (l, w) < 0)
+        goto error;
+    lookup_decref (l); // w->lookups now holds the only reference
+    if (hashkey) {
+        /* nsm->shared does not own 'l'.  It is purged at the end of the
+         * watcher_respond pass, while 'l' is still referenced by 'w'.
+         */
+        if (zhashx_insert (nsm->shared, hashkey, l) < 0)
+            flux_log (nsm->ctx->h, LOG_DEBUG, "%s: zhash_insert failed",
+                      __FUNCTION__);
+        free (hashkey);
     }
     w->rootseq = nsm->commit->rootseq;
     return 0;
+error:
+    lookup_decref (l);
+    free (hashkey);
+    return -1;
 }
 
 /* Respond to watcher request, if appropriate.
@@ -648,10 +829,10 @@ static void watcher_respond (struct ns_monitor *nsm, struct watcher *w)
     }
     /* flux_kvs_lookup (FLUX_KVS_WATCH)
      *
-     * Ordering note: KVS lookups can be returned out of order.  KVS lookup
-     * futures are added to the w->lookups zlist in commit order here, and
-     * in lookup_continuation(), fulfilled futures are popped off the head
-     * of w->lookups until an unfulfilled future is encountered, so that
+     * Ordering note: KVS lookups can be returned out of order.  KVS lookups
+     * are added to the w->lookups zlist in commit order here, and
+     * in watcher_process_lookups(), fulfilled lookups are popped off the
+     * head of w->lookups until an unfulfilled lookup is encountered, so that
      * responses are always returned to the watcher in commit order.
      *
      * Security note: although the requestor has already been authenticated
@@ -662,10 +843,15 @@ static void watcher_respond (struct ns_monitor *nsm, struct watcher *w)
      *
      * Note on FLUX_KVS_WATCH_FULL: A lookup / comparison is done on every
      * change.
+     *
+     * Other watchers are only woken by setroot_cb() when their key is
+     * in the commit key list (see watcher_respond_keys()), but the full
+     * pass in watcher_respond_ns() may reach any watcher, so check that
+     * the key is in the commit key list (w->wakeseq) here also.
      */
     if (w->rootseq == -1
         || (w->flags & FLUX_KVS_WATCH_FULL)
-        || array_match (nsm->commit->keys, w->key)) {
+        || w->wakeseq == nsm->commit->rootseq) {
         if (process_lookup_response (nsm, w) < 0)
             goto error_respond;
     }
@@ -680,6 +866,46 @@ finished:
     watcher_cleanup (nsm, w);
 }
 
+/* Set w->wakeseq to the current rootseq for each watcher in 'src' not
+ * already woken for this commit, and append it to 'woken' if non-NULL.
+ */
+static int wake_watchers (struct ns_monitor *nsm, zlist_t *src, zlist_t *woken)
+{
+    int rootseq = nsm->commit->rootseq;
+    struct watcher *w;
+
+    w = zlist_first (src);
+    while (w) {
+        if (w->wakeseq != rootseq) {
+            w->wakeseq = rootseq;
+            if (woken && zlist_append (woken, w) < 0) {
+                errno = ENOMEM;
+                return -1;
+            }
+        }
+        w = zlist_next (src);
+    }
+    return 0;
+}
+
+/* Wake watchers of keys in the current commit key list.
+ */
+static int wake_watchers_keys (struct ns_monitor *nsm, zlist_t *woken)
+{
+    size_t index;
+    json_t *value;
+
+    json_array_foreach (nsm->commit->keys, index, value) {
+        const char *key = json_string_value (value);
+        zlist_t *l;
+        if (key && (l = zhash_lookup (nsm->keyidx, key))) {
+            if (wake_watchers (nsm, l, woken) < 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
 /* Respond to all ready watchers.
  * N.B. watcher_respond() may call zlist_remove() on nsm->watchers.
  * Since zlist_t is not deletion-safe for traversal, a temporary duplicate
@@ -690,6 +916,8 @@ static void watcher_respond_ns (struct ns_monitor *nsm)
     zlist_t *l;
     struct watcher *w;
 
+    if (nsm->commit)
+        (void)wake_watchers_keys (nsm, NULL);
     if ((l = zlist_dup (nsm->watchers))) {
         w = zlist_first (l);
         while (w) {
@@ -700,6 +928,36 @@ static void watcher_respond_ns (struct ns_monitor *nsm)
     }
     else
         flux_log_error (nsm->ctx->h, "%s: zlist_dup", __FUNCTION__);
+    zhashx_purge (nsm->shared);
+}
+
+/* Respond to watchers affected by the current commit: watchers of keys
+ * in the commit key list, and FLUX_KVS_WATCH_FULL watchers.  Watchers are
+ * gathered into a temporary list first, since watcher_respond() may
+ * modify the index.  Fall back to a full pass on error.
+ */
+static void watcher_respond_keys (struct ns_monitor *nsm)
+{
+    zlist_t *woken;
+    struct watcher *w;
+
+    if (!(woken = zlist_new ())
+        || wake_watchers_keys (nsm, woken) < 0
+        || wake_watchers (nsm, nsm->full_watchers, woken) < 0)
+        goto fallback;
+    w = zlist_first (woken);
+    while (w) {
+        watcher_respond (nsm, w);
+        w = zlist_next (woken);
+    }
+    zlist_destroy (&woken);
+    zhashx_purge (nsm->shared);
+    return;
+fallback:
+    flux_log_error (nsm->ctx->h, "%s: falling back to full pass",
+                    __FUNCTION__);
+    zlist_destroy (&woken);
+    watcher_respond_ns (nsm);
 }
 
 /* Cancel watcher 'w' if it matches (sender, matchtag).
@@ -845,6 +1103,7 @@ static void setroot_cb (flux_t *h, flux_msg_handler_t *mh,
     int owner;
     json_t *keys;
     struct commit *commit;
+    bool keyed;
 
     if (flux_event_unpack (msg, NULL, "{s:s s:i s:s s:i s:o}",
                            "namespace", &ns,
@@ -863,10 +1122,19 @@ static void setroot_cb (flux_t *h, flux_msg_handler_t *mh,
         nsm->errnum = errno;
         goto done;
     }
+    /* If a previous commit was known, all watchers have sent their
+     * initial lookup, so only watchers affected by this commit need
+     * to be visited.
+     */
+    keyed = nsm->commit && nsm->errnum == 0 && nsm->fatal_errnum == 0;
     commit_destroy (nsm->commit);
     nsm->commit = commit;
     if (nsm->owner == FLUX_USERID_UNKNOWN)
         nsm->owner = owner;
+    if (keyed) {
+        watcher_respond_keys (nsm);
+        return;
+    }
 done:
     watcher_respond_ns (nsm);
 }
@@ -982,7 +1250,12 @@ static void lookup_cb (flux_t *h, flux_msg_handler_t *mh,
     if (!(w = watcher_create (msg, key, flags)))
         goto error;
     w->nsm = nsm;
+    if (keyidx_add (nsm, w) < 0) {
+        watcher_destroy (w);
+        goto error;
+    }
     if (zlist_append (nsm->watchers, w) < 0) {
+        keyidx_remove (nsm, w);
         watcher_destroy (w);
         errno = ENOMEM;
         goto error;
@@ -1056,13 +1329,14 @@ static void stats_cb (flux_t *h, flux_msg_handler_t *mh,
         goto nomem;
     nsm = zhash_first (ctx->namespaces);
     while (nsm) {
-        json_t *o = json_pack ("{s:i s:i s:s s:i}",
+        json_t *o = json_pack ("{s:i s:i s:s s:i s:i}",
                                "owner", (int)nsm->owner,
                                "rootseq", nsm->commit ? nsm->commit->rootseq
                                                       : -1,
                                "rootref", nsm->commit ? nsm->commit->rootref
                                                       : "(null)",
-                               "watchers", (int)zlist_size (nsm->watchers));
+                               "watchers", (int)zlist_size (nsm->watchers),
+                               "keys", (int)zhash_size (nsm->keyidx));
         if (!o)
             goto nomem;
         if (json_object_set_new (stats, nsm->ns_name, o) < 0) {
@@ -1072,8 +1346,9 @@ static void stats_cb (flux_t *h, flux_msg_handler_t *mh,
         watchers += zlist_size (nsm->watchers);
         nsm = zhash_next (ctx->namespaces);
     }
-    if (flux_respond_pack (h, msg, "{s:i s:i s:O}",
+    if (flux_respond_pack (h, msg, "{s:i s:i s:i s:O}",
                            "watchers", watchers,
+                           "lookups-shared", ctx->lookups_shared,
                            "namespace-count", (int)zhash_size (ctx->namespaces),
                            "namespaces", stats) < 0)
         flux_log_error (h, "%s: flux_respond_pack", __FUNCTION__);
@@ -0,0 +1,170 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* hashpool.c - worker threads for encoding and hashing KVS objects
+ *
+ * Each hashpool_run() is a "generation".  Workers sleep until the
+ * generation changes, then claim indices from a shared atomic counter
+ * until it reaches 'count', so uneven work items balance themselves.
+ * The last worker to finish wakes the caller.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "hashpool.h"
+
+struct hashpool {
+    int nthreads;
+    pthread_t *threads;
+    int started;                // number of threads successfully started
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_cond;   // signaled when generation changes
+    pthread_cond_t done_cond;   // signaled when active drops to zero
+    unsigned int generation;
+    int active;                 // workers still running this generation
+    bool shutdown;
+
+    hashpool_f fn;
+    void *arg;
+    int count;
+    int next;                   // next index to claim (atomic)
+};
+
+static void run_items (struct hashpool *hp)
+{
+    int i;
+
+    while ((i = __atomic_fetch_add (&hp->next, 1, __ATOMIC_RELAXED))
+                                                            < hp->count)
+        hp->fn (hp->arg, i);
+}
+
+static void *worker (void *arg)
+{
+    struct hashpool *hp = arg;
+    unsigned int generation = 0;
+
+    pthread_mutex_lock (&hp->lock);
+    for (;;) {
+        while (!hp->shutdown && hp->generation == generation)
+            pthread_cond_wait (&hp->work_cond, &hp->lock);
+        if (hp->shutdown)
+            break;
+        generation = hp->generation;
+        pthread_mutex_unlock (&hp->lock);
+
+        run_items (hp);
+
+        pthread_mutex_lock (&hp->lock);
+        if (--hp->active == 0)
+            pthread_cond_signal (&hp->done_cond);
+    }
+    pthread_mutex_unlock (&hp->lock);
+    return NULL;
+}
+
+void hashpool_run (struct hashpool *hp, hashpool_f fn, void *arg, int count)
+{
+    int i;
+
+    if (count <= 0)
+        return;
+    if (!hp || hp->started == 0 || count == 1) {
+        for (i = 0; i < count; i++)
+            fn (arg, i);
+        return;
+    }
+    pthread_mutex_lock (&hp->lock);
+    hp->fn = fn;
+    hp->arg = arg;
+    hp->count = count;
+    hp->next = 0;
+    hp->active = hp->started;
+    hp->generation++;
+    pthread_cond_broadcast (&hp->work_cond);
+    pthread_mutex_unlock (&hp->lock);
+
+    run_items (hp);
+
+    pthread_mutex_lock (&hp->lock);
+    while (hp->active > 0)
+        pthread_cond_wait (&hp->done_cond, &hp->lock);
+    pthread_mutex_unlock (&hp->lock);
+}
+
+int hashpool_get_nthreads (struct hashpool *hp)
+{
+    return hp ? hp->started : 0;
+}
+
+void hashpool_destroy (struct hashpool *hp)
+{
+    if (hp) {
+        int saved_errno = errno;
+        int i;
+
+        pthread_mutex_lock (&hp->lock);
+        hp->shutdown = true;
+        pthread_cond_broadcast (&hp->work_cond);
+        pthread_mutex_unlock (&hp->lock);
+        for (i = 0; i < hp->started; i++)
+            pthread_join (hp->threads[i], NULL);
+        pthread_cond_destroy (&hp->done_cond);
+        pthread_cond_destroy (&hp->work_cond);
+        pthread_mutex_destroy (&hp->lock);
+        free (hp->threads);
+        free (hp);
+        errno = saved_errno;
+    }
+}
+
+struct hashpool *hashpool_create (int nthreads)
+{
+    struct hashpool *hp;
+    int e;
+
+    if (nthreads < 1) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(hp = calloc (1, sizeof (*hp))))
+        return NULL;
+    if (!(hp->threads = calloc (nthreads, sizeof (hp->threads[0])))) {
+        free (hp);
+        return NULL;
+    }
+    hp->nthreads = nthreads;
+    pthread_mutex_init (&hp->lock, NULL);
+    pthread_cond_init (&hp->work_cond, NULL);
+    pthread_cond_init (&hp->done_cond, NULL);
+    while (hp->started < nthreads) {
+        if ((e = pthread_create (&hp->threads[hp->started],
+                                 NULL,
+                                 worker,
+                                 hp)) != 0) {
+            hashpool_destroy (hp);
+            errno = e;
+            return NULL;
+        }
+        hp->started++;
+    }
+    return hp;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
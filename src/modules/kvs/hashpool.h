@@ -0,0 +1,35 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_KVS_HASHPOOL_H
+#define _FLUX_KVS_HASHPOOL_H
+
+/* hashpool - worker threads for encoding and hashing KVS objects
+ *
+ * hashpool_run() calls fn (arg, i) for each i in [0, count), spreading the
+ * calls over the pool threads and the calling thread, and returns when all
+ * calls have completed.  'fn' must not call into the flux_t handle, cache,
+ * or anything else owned by the KVS module thread.
+ */
+
+typedef void (*hashpool_f)(void *arg, int i);
+
+struct hashpool *hashpool_create (int nthreads);
+void hashpool_destroy (struct hashpool *hp);
+
+int hashpool_get_nthreads (struct hashpool *hp);
+
+void hashpool_run (struct hashpool *hp, hashpool_f fn, void *arg, int count);
+
+#endif /* !_FLUX_KVS_HASHPOOL_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -39,6 +39,8 @@
 #include "kvstxn.h"
 #include "kvsroot.h"
 #include "kvssync.h"
+#include "hashpool.h"
+#include "lookupcache.h"
 
 /* Expire cache_entry after 'max_lastuse_age' heartbeats.
  */
@@ -55,6 +57,11 @@ const int max_namespace_age = 1000;
  */
 const bool event_includes_rootdir = true;
 
+/* Default number of path walk results kept in the lookup cache,
+ * override with lookup-cache-size=N (0 disables the cache).
+ */
+const int default_lookupcache_size = 4096;
+
 typedef struct {
     struct cache *cache;    /* blobref => cache_entry */
     kvsroot_mgr_t *krm;
@@ -66,6 +73,10 @@ typedef struct {
     flux_watcher_t *idle_w;
     flux_watcher_t *check_w;
     int transaction_merge;
+    int hash_workers;
+    struct hashpool *hashpool;
+    int lookupcache_size;
+    struct lookupcache *lookupcache;
     bool events_init;            /* flag */
     const char *hash_name;
     unsigned int seq;           /* for commit transactions */
@@ -95,6 +106,8 @@ static void freectx (void *arg)
     if (ctx) {
         cache_destroy (ctx->cache);
         kvsroot_mgr_destroy (ctx->krm);
+        hashpool_destroy (ctx->hashpool);
+        lookupcache_destroy (ctx->lookupcache);
         flux_watcher_destroy (ctx->prep_w);
         flux_watcher_destroy (ctx->check_w);
         flux_watcher_destroy (ctx->idle_w);
@@ -156,6 +169,7 @@ static kvs_ctx_t *getctx (flux_t *h)
             flux_watcher_start (ctx->check_w);
         }
         ctx->transaction_merge = 1;
+        ctx->lookupcache_size = default_lookupcache_size;
         if (flux_aux_set (h, "kvssrv", ctx, freectx) < 0) {
             saved_errno = errno;
             goto error;
@@ -1342,6 +1356,7 @@ static lookup_t *lookup_common (flux_t *h, flux_msg_handler_t *mh,
                                   flags,
                                   h)))
             goto done;
+        lookup_set_lookupcache (lh, ctx->lookupcache);
     }
     else {
         int err;
@@ -2233,6 +2248,7 @@ static void stats_get_cb (flux_t *h, flux_msg_handler_t *mh,
     tstat_t ts = { .min = 0.0, .max = 0.0, .M = 0.0, .S = 0.0, .newM = 0.0,
                    .newS = 0.0, .n = 0 };
     int size = 0, incomplete = 0, dirty = 0;
+    int lc_size, lc_hits, lc_misses;
     double scale = 1E-3;
 
     if (flux_request_decode (msg, NULL, NULL) < 0)
@@ -2252,12 +2268,17 @@ static void stats_get_cb (flux_t *h, flux_msg_handler_t *mh,
                               "max", tstat_max (&ts)*scale)))
         goto nomem;
 
-    if (!(cstats = json_pack ("{ s:f s:O s:i s:i s:i }",
+    lookupcache_get_stats (ctx->lookupcache, &lc_size, &lc_hits, &lc_misses);
+
+    if (!(cstats = json_pack ("{ s:f s:O s:i s:i s:i s:i s:i s:i }",
                               "obj size total (MiB)", (double)size/1048576,
                               "obj size (KiB)", tstats,
                               "#obj dirty", dirty,
                               "#obj incomplete", incomplete,
-                              "#faults", ctx->faults)))
+                              "#faults", ctx->faults,
+                              "#lookup cache entries", lc_size,
+                              "#lookup cache hits", lc_hits,
+                              "#lookup cache misses", lc_misses)))
         goto nomem;
 
     if (!(nsstats = json_object ()))
@@ -2314,6 +2335,7 @@ static int stats_clear_root_cb (struct kvsroot *root, void *arg)
 static void stats_clear (kvs_ctx_t *ctx)
 {
     ctx->faults = 0;
+    lookupcache_clear_stats (ctx->lookupcache);
 
     if (kvsroot_mgr_iter_roots (ctx->krm, stats_clear_root_cb, NULL) < 0)
         flux_log_error (ctx->h, "%s: kvsroot_mgr_iter_roots", __FUNCTION__);
@@ -2826,6 +2848,10 @@ static void process_args (kvs_ctx_t *ctx, int ac, char **av)
     for (i = 0; i < ac; i++) {
         if (strncmp (av[i], "transaction-merge=", 13) == 0)
             ctx->transaction_merge = strtoul (av[i]+13, NULL, 10);
+        else if (strncmp (av[i], "hash-workers=", 13) == 0)
+            ctx->hash_workers = strtoul (av[i]+13, NULL, 10);
+        else if (strncmp (av[i], "lookup-cache-size=", 18) == 0)
+            ctx->lookupcache_size = strtoul (av[i]+18, NULL, 10);
         else
             flux_log (ctx->h, LOG_ERR, "Unknown option `%s'", av[i]);
     }
@@ -2970,11 +2996,28 @@ int mod_main (flux_t *h, int argc, char **argv)
         goto done;
     }
     process_args (ctx, argc, argv);
+    if (ctx->lookupcache_size > 0) {
+        if (!(ctx->lookupcache = lookupcache_create (ctx->lookupcache_size))) {
+            flux_log_error (h, "lookupcache_create");
+            goto done;
+        }
+    }
     if (ctx->rank == 0) {
         struct kvsroot *root;
         char rootref[BLOBREF_MAX_STRING_SIZE];
         uint32_t owner = getuid ();
 
+        /* Commits are only processed on rank 0, so only create
+         * hash workers here.
+         */
+        if (ctx->hash_workers > 0) {
+            if (!(ctx->hashpool = hashpool_create (ctx->hash_workers))) {
+                flux_log_error (h, "hashpool_create");
+                goto done;
+            }
+            kvsroot_mgr_set_hashpool (ctx->krm, ctx->hashpool);
+        }
+
         /* Look for a checkpoint and use it if found.
          * Otherwise start the primary root namespace with an empty directory.
          */
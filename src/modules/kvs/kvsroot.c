@@ -30,6 +30,7 @@ struct kvsroot_mgr {
     bool iterating_roots;
     flux_t *h;
     void *arg;
+    struct hashpool *hashpool;
 };
 
 kvsroot_mgr_t *kvsroot_mgr_create (flux_t *h, void *arg)
@@ -94,6 +95,11 @@ static void kvsroot_destroy (void *data)
     }
 }
 
+void kvsroot_mgr_set_hashpool (kvsroot_mgr_t *krm, struct hashpool *hp)
+{
+    krm->hashpool = hp;
+}
+
 struct kvsroot *kvsroot_mgr_create_root (kvsroot_mgr_t *krm,
                                          struct cache *cache,
                                          const char *hash_name,
@@ -128,6 +134,7 @@ struct kvsroot *kvsroot_mgr_create_root (kvsroot_mgr_t *krm,
         flux_log_error (krm->h, "kvstxn_mgr_create");
         goto error;
     }
+    kvstxn_mgr_set_hashpool (root->ktm, krm->hashpool);
 
     if (!(root->trm = treq_mgr_create ())) {
         flux_log_error (krm->h, "treq_mgr_create");
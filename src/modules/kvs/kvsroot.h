@@ -48,6 +48,11 @@ void kvsroot_mgr_destroy (kvsroot_mgr_t *krm);
 
 int kvsroot_mgr_root_count (kvsroot_mgr_t *krm);
 
+/* hashpool is passed to kvstxn_mgr_set_hashpool() for roots created
+ * after this call.  The caller retains ownership.
+ */
+void kvsroot_mgr_set_hashpool (kvsroot_mgr_t *krm, struct hashpool *hp);
+
 struct kvsroot *kvsroot_mgr_create_root (kvsroot_mgr_t *krm,
                                          struct cache *cache,
                                          const char *hash_name,
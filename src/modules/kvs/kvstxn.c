@@ -35,6 +35,12 @@
 #define KVSTXN_MERGED          0x02 /* kvstxn is a merger of transactions */
 #define KVSTXN_MERGE_COMPONENT 0x04 /* kvstxn is member of a merger */
 
+/* Minimum number of objects to store before the hashpool is used to
+ * unroll a transaction's root copy.  Below this, thread handoff costs
+ * more than it saves.
+ */
+#define KVSTXN_HASHPOOL_MIN    64
+
 struct kvstxn_mgr {
     struct cache *cache;
     const char *ns_name;
@@ -43,6 +49,7 @@ struct kvstxn_mgr {
     zlist_t *ready;
     flux_t *h;
     void *aux;
+    struct hashpool *hashpool;  /* optional, not owned */
 };
 
 struct kvstxn {
@@ -238,20 +245,19 @@ static void cleanup_dirty_cache_list (kvstxn_t *kt)
         kvstxn_cleanup_dirty_cache_entry (kt, entry);
 }
 
-/* Store object 'o' under key 'ref' in local cache.
- * Object reference is still owned by the caller.
+/* Encode object 'o' for storage and compute its blobref.
  * 'is_raw' indicates this data is a json string w/ base64 value and
  * should be flushed to the content store as raw data after it is
  * decoded.  Otherwise, the json object should be a treeobj.
- * Returns -1 on error, 0 on success entry already there, 1 on success
- * entry needs to be flushed to content store
+ * On success, the caller must free '*datap'.
+ * This function does not log and touches no kvstxn state, so it may be
+ * called from hashpool threads.  Returns -1 on error with errno set.
  */
-static int store_cache (kvstxn_t *kt, int current_epoch, json_t *o,
-                        bool is_raw, char *ref, int ref_len,
-                        struct cache_entry **entryp)
+static int store_encode (const char *hash_name, json_t *o, bool is_raw,
+                         char *ref, int ref_len,
+                         char **datap, size_t *lenp)
 {
-    struct cache_entry *entry;
-    int saved_errno, rc;
+    int saved_errno;
     const char *xdata;
     char *data = NULL;
     size_t xlen, len;
@@ -261,10 +267,8 @@ static int store_cache (kvstxn_t *kt, int current_epoch, json_t *o,
         xlen = strlen (xdata);
         len = BASE64_DECODE_SIZE (xlen);
         if (len > 0) {
-            if (!(data = malloc (len))) {
-                flux_log_error (kt->ktm->h, "malloc");
+            if (!(data = malloc (len)))
                 goto error;
-            }
             if (sodium_base642bin ((unsigned char *)data, len, xdata, xlen,
                                    NULL, &len, NULL,
                                    sodium_base64_VARIANT_ORIGINAL) < 0) {
@@ -274,25 +278,43 @@ static int store_cache (kvstxn_t *kt, int current_epoch, json_t *o,
         }
     }
     else {
-        if (treeobj_validate (o) < 0 || !(data = treeobj_encode (o))) {
-            flux_log_error (kt->ktm->h, "%s: treeobj_encode", __FUNCTION__);
+        if (treeobj_validate (o) < 0 || !(data = treeobj_encode (o)))
             goto error;
-        }
         len = strlen (data);
     }
-    if (blobref_hash (kt->ktm->hash_name, data, len, ref, ref_len) < 0) {
-        flux_log_error (kt->ktm->h, "%s: blobref_hash", __FUNCTION__);
+    if (blobref_hash (hash_name, data, len, ref, ref_len) < 0)
         goto error;
-    }
+    *datap = data;
+    *lenp = len;
+    return 0;
+ error:
+    saved_errno = errno;
+    free (data);
+    errno = saved_errno;
+    return -1;
+}
+
+/* Store encoded 'data' under key 'ref' in local cache.
+ * Data is still owned by the caller.
+ * Returns -1 on error, 0 on success entry already there, 1 on success
+ * entry needs to be flushed to content store
+ */
+static int store_insert (kvstxn_t *kt, int current_epoch, const char *ref,
+                         const char *data, size_t len,
+                         struct cache_entry **entryp)
+{
+    struct cache_entry *entry;
+    int rc;
+
     if (!(entry = cache_lookup (kt->ktm->cache, ref, current_epoch))) {
         if (!(entry = cache_entry_create (ref))) {
             flux_log_error (kt->ktm->h, "%s: cache_entry_create", __FUNCTION__);
-            goto error;
+            return -1;
         }
         if (cache_insert (kt->ktm->cache, entry) < 0) {
             cache_entry_destroy (entry);
             flux_log_error (kt->ktm->h, "%s: cache_insert", __FUNCTION__);
-            goto error;
+            return -1;
         }
     }
     if (cache_entry_get_valid (entry)) {
@@ -304,26 +326,45 @@ static int store_cache (kvstxn_t *kt, int current_epoch, json_t *o,
             int ret;
             ret = cache_remove_entry (kt->ktm->cache, ref);
             assert (ret == 1);
-            goto error;
+            return -1;
         }
         if (cache_entry_set_dirty (entry, true) < 0) {
             flux_log_error (kt->ktm->h, "%s: cache_entry_set_dirty",__FUNCTION__);
             int ret;
             ret = cache_remove_entry (kt->ktm->cache, ref);
             assert (ret == 1);
-            goto error;
+            return -1;
         }
         rc = 1;
     }
     *entryp = entry;
-    free (data);
     return rc;
+}
 
- error:
+/* Store object 'o' under key 'ref' in local cache.
+ * Object reference is still owned by the caller.
+ * See store_encode() for 'is_raw'.
+ * Returns -1 on error, 0 on success entry already there, 1 on success
+ * entry needs to be flushed to content store
+ */
+static int store_cache (kvstxn_t *kt, int current_epoch, json_t *o,
+                        bool is_raw, char *ref, int ref_len,
+                        struct cache_entry **entryp)
+{
+    int saved_errno, rc;
+    char *data;
+    size_t len;
+
+    if (store_encode (kt->ktm->hash_name, o, is_raw,
+                      ref, ref_len, &data, &len) < 0) {
+        flux_log_error (kt->ktm->h, "%s: store_encode", __FUNCTION__);
+        return -1;
+    }
+    rc = store_insert (kt, current_epoch, ref, data, len, entryp);
     saved_errno = errno;
     free (data);
     errno = saved_errno;
-    return -1;
+    return rc;
 }
 
 /* Store DIRVAL objects, converting them to DIRREFs.
@@ -408,6 +449,313 @@ static int kvstxn_unroll (kvstxn_t *kt, int current_epoch, json_t *dir)
     return 0;
 }
 
+/* Parallel unroll, used when the kvstxn manager has a hashpool.
+ *
+ * Objects to store are collected in one walk of the root copy, each
+ * tagged with its height: 0 for a large val or a dir with nothing to
+ * unroll, otherwise one more than the greatest height of anything it
+ * contains.  Objects of equal height are independent, so each height is
+ * encoded and hashed as one hashpool batch.  The results are then inserted
+ * into the cache and swapped into the parent dir on this thread, which
+ * readies the next height for encoding.
+ */
+struct unroll_item {
+    json_t *dir_data;           /* data of dir containing this entry */
+    const char *name;           /* entry name in dir_data */
+    json_t *o;                  /* dir treeobj, or val data if is_raw */
+    bool is_raw;
+    bool shared;                /* encode on calling thread */
+    int height;
+    char *data;                 /* encoded object */
+    size_t len;
+    char ref[BLOBREF_MAX_STRING_SIZE];
+    int errnum;
+};
+
+struct unroll {
+    kvstxn_t *kt;
+    struct unroll_item *items;
+    int count;
+    int size;
+    int maxheight;
+    int *batch;                 /* indices into items[] for one batch */
+    struct unroll_ptr *ptrs;    /* containers in batch, for sharing check */
+    int nptrs;
+    int ptrs_size;
+};
+
+static void unroll_cleanup (struct unroll *u)
+{
+    int i;
+
+    for (i = 0; i < u->count; i++)
+        free (u->items[i].data);
+    free (u->items);
+    free (u->batch);
+    free (u->ptrs);
+}
+
+static int unroll_append (struct unroll *u, json_t *dir_data,
+                          const char *name, json_t *o, bool is_raw,
+                          int height)
+{
+    struct unroll_item *item;
+
+    if (u->count == u->size) {
+        int newsize = u->size ? u->size * 2 : 64;
+        struct unroll_item *p;
+        if (!(p = realloc (u->items, newsize * sizeof (*p)))) {
+            errno = ENOMEM;
+            return -1;
+        }
+        u->items = p;
+        u->size = newsize;
+    }
+    item = &u->items[u->count++];
+    memset (item, 0, sizeof (*item));
+    item->dir_data = dir_data;
+    item->name = name;
+    item->o = o;
+    item->is_raw = is_raw;
+    item->height = height;
+    if (height > u->maxheight)
+        u->maxheight = height;
+    return 0;
+}
+
+/* Collect objects to store in 'dir', depth first, setting '*heightp' to
+ * the height 'dir' will have as an item.
+ */
+static int unroll_collect (struct unroll *u, json_t *dir, int *heightp)
+{
+    json_t *dir_data;
+    json_t *dir_entry;
+    const char *name;
+    int height = 0;
+
+    if (!(dir_data = treeobj_get_data (dir)))
+        return -1;
+    json_object_foreach (dir_data, name, dir_entry) {
+        if (treeobj_is_dir (dir_entry)) {
+            int h;
+            if (unroll_collect (u, dir_entry, &h) < 0
+                || unroll_append (u, dir_data, name, dir_entry, false, h) < 0)
+                return -1;
+            if (h + 1 > height)
+                height = h + 1;
+        }
+        else if (treeobj_is_val (dir_entry)) {
+            json_t *val_data;
+            const char *str;
+
+            if (!(val_data = treeobj_get_data (dir_entry)))
+                return -1;
+            str = json_string_value (val_data);
+            assert (str);
+            if (strlen (str) > BLOBREF_MAX_STRING_SIZE) {
+                if (unroll_append (u, dir_data, name, val_data, true, 0) < 0)
+                    return -1;
+                if (height < 1)
+                    height = 1;
+            }
+        }
+    }
+    *heightp = height;
+    return 0;
+}
+
+struct unroll_ptr {
+    const json_t *o;
+    int index;                  /* index into items[] */
+};
+
+static int unroll_ptr_cmp (const void *a, const void *b)
+{
+    const struct unroll_ptr *p1 = a;
+    const struct unroll_ptr *p2 = b;
+
+    if (p1->o < p2->o)
+        return -1;
+    return p1->o > p2->o ? 1 : 0;
+}
+
+static int unroll_ptr_add (struct unroll *u, const json_t *o, int index)
+{
+    if (u->nptrs == u->ptrs_size) {
+        int newsize = u->ptrs_size ? u->ptrs_size * 2 : 256;
+        struct unroll_ptr *p;
+        if (!(p = realloc (u->ptrs, newsize * sizeof (*p)))) {
+            errno = ENOMEM;
+            return -1;
+        }
+        u->ptrs = p;
+        u->ptrs_size = newsize;
+    }
+    u->ptrs[u->nptrs].o = o;
+    u->ptrs[u->nptrs].index = index;
+    u->nptrs++;
+    return 0;
+}
+
+/* Mark dirs in the batch that share a json container with another dir
+ * in the batch.  Some versions of jansson mark containers while dumping
+ * them, so such dirs must be encoded on this thread.  Sharing with
+ * objects outside the batch, e.g. val dirents still referenced by the
+ * transaction's ops, is harmless since nothing else is being encoded.
+ */
+static int unroll_mark_shared (struct unroll *u, int n)
+{
+    int i;
+
+    u->nptrs = 0;
+    for (i = 0; i < n; i++) {
+        struct unroll_item *item = &u->items[u->batch[i]];
+        json_t *dir_data;
+        json_t *dir_entry;
+        const char *name;
+
+        if (item->is_raw)
+            continue;
+        if (!(dir_data = treeobj_get_data (item->o))
+            || unroll_ptr_add (u, item->o, u->batch[i]) < 0
+            || unroll_ptr_add (u, dir_data, u->batch[i]) < 0)
+            return -1;
+        json_object_foreach (dir_data, name, dir_entry) {
+            json_t *data = treeobj_get_data (dir_entry);
+
+            if (unroll_ptr_add (u, dir_entry, u->batch[i]) < 0
+                || (data && !json_is_string (data)
+                         && unroll_ptr_add (u, data, u->batch[i]) < 0))
+                return -1;
+        }
+    }
+    qsort (u->ptrs, u->nptrs, sizeof (u->ptrs[0]), unroll_ptr_cmp);
+    for (i = 1; i < u->nptrs; i++) {
+        if (u->ptrs[i].o == u->ptrs[i - 1].o
+            && u->ptrs[i].index != u->ptrs[i - 1].index) {
+            u->items[u->ptrs[i].index].shared = true;
+            u->items[u->ptrs[i - 1].index].shared = true;
+        }
+    }
+    return 0;
+}
+
+static void unroll_encode (struct unroll *u, struct unroll_item *item)
+{
+    if (store_encode (u->kt->ktm->hash_name,
+                      item->o,
+                      item->is_raw,
+                      item->ref,
+                      sizeof (item->ref),
+                      &item->data,
+                      &item->len) < 0)
+        item->errnum = errno;
+}
+
+/* hashpool_f - encode and hash one item of the current batch
+ */
+static void unroll_encode_cb (void *arg, int i)
+{
+    struct unroll *u = arg;
+
+    unroll_encode (u, &u->items[u->batch[i]]);
+}
+
+/* Insert an encoded item into the cache and replace its entry in the
+ * parent dir with a dirref or valref.
+ */
+static int unroll_store (struct unroll *u, int current_epoch,
+                         struct unroll_item *item)
+{
+    kvstxn_t *kt = u->kt;
+    struct cache_entry *entry;
+    json_t *ktmp;
+    int ret;
+
+    if (item->errnum) {
+        errno = item->errnum;
+        flux_log_error (kt->ktm->h, "%s: store_encode", __FUNCTION__);
+        return -1;
+    }
+    if ((ret = store_insert (kt, current_epoch, item->ref,
+                             item->data, item->len, &entry)) < 0)
+        return -1;
+    if (ret) {
+        if (zlist_push (kt->dirty_cache_entries_list, entry) < 0) {
+            kvstxn_cleanup_dirty_cache_entry (kt, entry);
+            errno = ENOMEM;
+            return -1;
+        }
+    }
+    if (item->is_raw)
+        ktmp = treeobj_create_valref (item->ref);
+    else
+        ktmp = treeobj_create_dirref (item->ref);
+    if (!ktmp)
+        return -1;
+    if (json_object_set_new (item->dir_data, item->name, ktmp) < 0) {
+        json_decref (ktmp);
+        errno = ENOMEM;
+        return -1;
+    }
+    free (item->data);
+    item->data = NULL;
+    return 0;
+}
+
+static int kvstxn_unroll_parallel (kvstxn_t *kt, int current_epoch,
+                                   json_t *dir)
+{
+    struct unroll u = { .kt = kt };
+    struct hashpool *hp;
+    int height, h, i;
+    int saved_errno;
+
+    assert (treeobj_is_dir (dir));
+
+    if (unroll_collect (&u, dir, &height) < 0)
+        goto error;
+    if (u.count == 0)
+        return 0;
+    if (!(u.batch = calloc (u.count, sizeof (u.batch[0])))) {
+        errno = ENOMEM;
+        goto error;
+    }
+    hp = u.count >= KVSTXN_HASHPOOL_MIN ? kt->ktm->hashpool : NULL;
+    for (h = 0; h <= u.maxheight; h++) {
+        int n = 0;
+        int nparallel = 0;
+
+        for (i = 0; i < u.count; i++) {
+            if (u.items[i].height == h)
+                u.batch[n++] = i;
+        }
+        if (hp && unroll_mark_shared (&u, n) < 0)
+            goto error;
+        for (i = 0; i < n; i++) {
+            struct unroll_item *item = &u.items[u.batch[i]];
+            if (item->shared)
+                unroll_encode (&u, item);
+            else
+                u.batch[nparallel++] = u.batch[i];
+        }
+        hashpool_run (hp, unroll_encode_cb, &u, nparallel);
+        for (i = 0; i < u.count; i++) {
+            if (u.items[i].height == h) {
+                if (unroll_store (&u, current_epoch, &u.items[i]) < 0)
+                    goto error;
+            }
+        }
+    }
+    unroll_cleanup (&u);
+    return 0;
+error:
+    saved_errno = errno;
+    unroll_cleanup (&u);
+    errno = saved_errno;
+    return -1;
+}
+
 static int kvstxn_val_data_to_cache (kvstxn_t *kt, int current_epoch,
                                      json_t *val, char *ref, int ref_len)
 {
@@ -973,7 +1321,11 @@ kvstxn_process_t kvstxn_process (kvstxn_t *kt,
         struct cache_entry *entry;
         int sret;
 
-        if (kvstxn_unroll (kt, current_epoch, kt->rootcpy) < 0)
+        if (kt->ktm->hashpool)
+            sret = kvstxn_unroll_parallel (kt, current_epoch, kt->rootcpy);
+        else
+            sret = kvstxn_unroll (kt, current_epoch, kt->rootcpy);
+        if (sret < 0)
             kt->errnum = errno;
         else if ((sret = store_cache (kt,
                                       current_epoch,
@@ -1139,6 +1491,11 @@ void kvstxn_mgr_destroy (kvstxn_mgr_t *ktm)
     }
 }
 
+void kvstxn_mgr_set_hashpool (kvstxn_mgr_t *ktm, struct hashpool *hp)
+{
+    ktm->hashpool = hp;
+}
+
 int kvstxn_mgr_add_transaction (kvstxn_mgr_t *ktm,
                                 const char *name,
                                 json_t *ops,
@@ -15,6 +15,7 @@
 #include <czmq.h>
 
 #include "cache.h"
+#include "hashpool.h"
 
 typedef struct kvstxn_mgr kvstxn_mgr_t;
 typedef struct kvstxn kvstxn_t;
@@ -135,6 +136,12 @@ kvstxn_mgr_t *kvstxn_mgr_create (struct cache *ktache,
 
 void kvstxn_mgr_destroy (kvstxn_mgr_t *ktm);
 
+/* Encode and hash objects to store in parallel using 'hp', or serially
+ * if 'hp' is NULL (the default).  The caller retains ownership of 'hp',
+ * which may be shared by many kvstxn_mgr_t.
+ */
+void kvstxn_mgr_set_hashpool (kvstxn_mgr_t *ktm, struct hashpool *hp);
+
 /* kvstxn_mgr_add_transaction() will internally create a kvstxn_t and
  * store it in the queue of ready to process transactions.
  *
@@ -28,6 +28,7 @@
 
 #include "cache.h"
 #include "kvsroot.h"
+#include "lookupcache.h"
 
 #include "lookup.h"
 
@@ -87,9 +88,15 @@ struct lookup {
     int errnum;                 /* errnum if error */
     int aux_errnum;
 
+    /* optional cache of walk results */
+    struct lookupcache *lc;
+
     /* API internal */
     zlist_t *levels;
     const json_t *wdirent;       /* result after walk() */
+    json_t *cached_wdirent;      /* wdirent, if from lookupcache */
+    bool walk_cached;            /* walk() skipped, result from lookupcache */
+    bool walk_crossed_namespace; /* result depends on other namespaces */
     enum {
         LOOKUP_STATE_INIT,
         LOOKUP_STATE_CHECK_NAMESPACE,
@@ -295,6 +302,7 @@ static lookup_process_t walk_symlink (lookup_t *lh,
 
         if (ns) {
             lookup_process_t nsret;
+            lh->walk_crossed_namespace = true;
             nsret = symlink_check_namespace (lh,
                                              ns,
                                              &root);
@@ -601,6 +609,7 @@ void lookup_destroy (lookup_t *lh)
         json_decref (lh->val);
         free (lh->missing_namespace);
         zlist_destroy (&lh->levels);
+        json_decref (lh->cached_wdirent);
         free (lh);
     }
 }
@@ -727,6 +736,12 @@ int lookup_get_root_seq (lookup_t *lh)
     return -1;
 }
 
+void lookup_set_lookupcache (lookup_t *lh, struct lookupcache *lc)
+{
+    if (lh)
+        lh->lc = lc;
+}
+
 int lookup_set_current_epoch (lookup_t *lh, int epoch)
 {
     if (lh) {
@@ -1011,9 +1026,18 @@ lookup_process_t lookup (lookup_t *lh)
             lh->state = LOOKUP_STATE_WALK_INIT;
             /* fallthrough */
         case LOOKUP_STATE_WALK_INIT:
-            /* initialize walk - first depth is level 0 */
-
-            if (!walk_levels_push (lh, lh->root_ref, lh->path, 0)) {
+            /* initialize walk - first depth is level 0, unless an
+             * identical walk from this root has been cached.
+             */
+            if (lh->lc && lookupcache_get (lh->lc,
+                                           lh->root_ref,
+                                           lh->path,
+                                           lh->flags,
+                                           &lh->cached_wdirent) == 0) {
+                lh->wdirent = lh->cached_wdirent;
+                lh->walk_cached = true;
+            }
+            else if (!walk_levels_push (lh, lh->root_ref, lh->path, 0)) {
                 lh->errnum = errno;
                 goto error;
             }
@@ -1029,15 +1053,29 @@ lookup_process_t lookup (lookup_t *lh)
                     goto error;
             }
 
-            lret = walk (lh);
+            if (!lh->walk_cached) {
+                lret = walk (lh);
 
-            if (lret == LOOKUP_PROCESS_ERROR)
-                goto error;
-            else if (lret == LOOKUP_PROCESS_LOAD_MISSING_NAMESPACE)
-                return LOOKUP_PROCESS_LOAD_MISSING_NAMESPACE;
-            else if (lret == LOOKUP_PROCESS_LOAD_MISSING_REFS)
-                return LOOKUP_PROCESS_LOAD_MISSING_REFS;
-            else if (!lh->wdirent) {
+                if (lret == LOOKUP_PROCESS_ERROR)
+                    goto error;
+                else if (lret == LOOKUP_PROCESS_LOAD_MISSING_NAMESPACE)
+                    return LOOKUP_PROCESS_LOAD_MISSING_NAMESPACE;
+                else if (lret == LOOKUP_PROCESS_LOAD_MISSING_REFS)
+                    return LOOKUP_PROCESS_LOAD_MISSING_REFS;
+
+                /* A walk through a symlink to another namespace depends
+                 * on that namespace's root and the user's access to it,
+                 * so it cannot be cached by this root ref alone.
+                 * Failure to cache is not an error.
+                 */
+                if (lh->lc && !lh->walk_crossed_namespace)
+                    (void)lookupcache_put (lh->lc,
+                                           lh->root_ref,
+                                           lh->path,
+                                           lh->flags,
+                                           lh->wdirent);
+            }
+            if (!lh->wdirent) {
                 //lh->errnum = ENOENT;
                 goto done; /* a NULL response is not necessarily an error */
             }
@@ -14,6 +14,7 @@
 #include <flux/core.h>
 #include "cache.h"
 #include "kvsroot.h"
+#include "lookupcache.h"
 
 typedef struct lookup lookup_t;
 
@@ -102,6 +103,12 @@ const char *lookup_get_namespace (lookup_t *lh);
 const char *lookup_get_root_ref (lookup_t *lh);
 int lookup_get_root_seq (lookup_t *lh);
 
+/* Use 'lc' to skip walking the key path when an identical walk has been
+ * done before, and to record the result otherwise.  Must be called before
+ * the first call to lookup().  The caller retains ownership of 'lc'.
+ */
+void lookup_set_lookupcache (lookup_t *lh, struct lookupcache *lc);
+
 /* Set a new current epoch.  Convenience on RPC replays and epoch may
  * be new */
 int lookup_set_current_epoch (lookup_t *lh, int epoch);
@@ -0,0 +1,184 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <flux/core.h>
+#include <jansson.h>
+
+#include "src/common/libutil/lru_cache.h"
+
+#include "lookupcache.h"
+
+#define LOOKUPCACHE_FLAGS (FLUX_KVS_READLINK | FLUX_KVS_TREEOBJ)
+
+struct lookupcache {
+    lru_cache_t *lru;
+    int hits;
+    int misses;
+};
+
+/* Wrapper so that a "not found" result (NULL dirent) can be stored.
+ */
+struct lookupcache_entry {
+    json_t *dirent;
+};
+
+static void lookupcache_entry_destroy (void *data)
+{
+    struct lookupcache_entry *e = data;
+    if (e) {
+        json_decref (e->dirent);
+        free (e);
+    }
+}
+
+static char *lookupcache_key (const char *root_ref,
+                              const char *path,
+                              int flags)
+{
+    char *key;
+
+    if (asprintf (&key,
+                  "%d:%s:%s",
+                  flags & LOOKUPCACHE_FLAGS,
+                  root_ref,
+                  path) < 0) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return key;
+}
+
+int lookupcache_get (struct lookupcache *lc,
+                     const char *root_ref,
+                     const char *path,
+                     int flags,
+                     json_t **direntp)
+{
+    struct lookupcache_entry *e;
+    char *key;
+
+    if (!lc || !root_ref || !path || !direntp) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(key = lookupcache_key (root_ref, path, flags)))
+        return -1;
+    e = lru_cache_get (lc->lru, key);
+    free (key);
+    if (!e) {
+        lc->misses++;
+        errno = ENOENT;
+        return -1;
+    }
+    lc->hits++;
+    *direntp = json_incref (e->dirent);
+    return 0;
+}
+
+int lookupcache_put (struct lookupcache *lc,
+                     const char *root_ref,
+                     const char *path,
+                     int flags,
+                     const json_t *dirent)
+{
+    struct lookupcache_entry *e;
+    char *key = NULL;
+    int saved_errno;
+
+    if (!lc || !root_ref || !path) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(e = calloc (1, sizeof (*e))))
+        return -1;
+    /* N.B. json_deep_copy() takes a non-const argument in older jansson */
+    if (dirent && !(e->dirent = json_deep_copy ((json_t *)dirent))) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (!(key = lookupcache_key (root_ref, path, flags)))
+        goto error;
+    if (lru_cache_put (lc->lru, key, e) < 0) {
+        if (errno == EEXIST) {
+            lookupcache_entry_destroy (e);
+            free (key);
+            return 0;
+        }
+        goto error;
+    }
+    free (key);
+    return 0;
+error:
+    saved_errno = errno;
+    lookupcache_entry_destroy (e);
+    free (key);
+    errno = saved_errno;
+    return -1;
+}
+
+void lookupcache_get_stats (struct lookupcache *lc,
+                            int *size,
+                            int *hits,
+                            int *misses)
+{
+    if (size)
+        *size = lc ? lru_cache_size (lc->lru) : 0;
+    if (hits)
+        *hits = lc ? lc->hits : 0;
+    if (misses)
+        *misses = lc ? lc->misses : 0;
+}
+
+void lookupcache_clear_stats (struct lookupcache *lc)
+{
+    if (lc) {
+        lc->hits = 0;
+        lc->misses = 0;
+    }
+}
+
+void lookupcache_destroy (struct lookupcache *lc)
+{
+    if (lc) {
+        int saved_errno = errno;
+        lru_cache_destroy (lc->lru);
+        free (lc);
+        errno = saved_errno;
+    }
+}
+
+struct lookupcache *lookupcache_create (int maxsize)
+{
+    struct lookupcache *lc;
+
+    if (maxsize < 1) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if (!(lc = calloc (1, sizeof (*lc))))
+        return NULL;
+    if (!(lc->lru = lru_cache_create (maxsize))) {
+        lookupcache_destroy (lc);
+        errno = ENOMEM;
+        return NULL;
+    }
+    lru_cache_set_free_f (lc->lru, lookupcache_entry_destroy);
+    return lc;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -0,0 +1,63 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#ifndef _FLUX_KVS_LOOKUPCACHE_H
+#define _FLUX_KVS_LOOKUPCACHE_H
+
+#include <jansson.h>
+
+/* lookupcache - bounded LRU cache of lookup path walk results
+ *
+ * Maps (root ref, normalized path, flags) to the dirent found by walking
+ * the path from the root, or to "not found".  Since root refs are content
+ * addressed, an entry never becomes stale, it just stops being used once
+ * the namespace moves on to a new root, and eventually ages out.
+ *
+ * Only FLUX_KVS_READLINK and FLUX_KVS_TREEOBJ affect the walk, so other
+ * flags are ignored when forming the key.
+ */
+
+struct lookupcache;
+
+struct lookupcache *lookupcache_create (int maxsize);
+void lookupcache_destroy (struct lookupcache *lc);
+
+/* Get the cached walk result for (root_ref, path, flags).
+ * On hit, return 0 and set '*direntp' to a new reference to the cached
+ * dirent, or to NULL if the path was cached as not found.
+ * On miss, return -1 with errno = ENOENT.
+ */
+int lookupcache_get (struct lookupcache *lc,
+                     const char *root_ref,
+                     const char *path,
+                     int flags,
+                     json_t **direntp);
+
+/* Cache a copy of 'dirent' as the walk result for (root_ref, path, flags).
+ * If 'dirent' is NULL, the path is cached as not found.
+ * Returns 0 on success, -1 on failure with errno set.
+ */
+int lookupcache_put (struct lookupcache *lc,
+                     const char *root_ref,
+                     const char *path,
+                     int flags,
+                     const json_t *dirent);
+
+void lookupcache_get_stats (struct lookupcache *lc,
+                            int *size,
+                            int *hits,
+                            int *misses);
+void lookupcache_clear_stats (struct lookupcache *lc);
+
+#endif /* !_FLUX_KVS_LOOKUPCACHE_H */
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
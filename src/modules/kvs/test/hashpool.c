@@ -0,0 +1,107 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <stdlib.h>
+#include <errno.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/modules/kvs/hashpool.h"
+
+#define NITEMS 10000
+
+static void incr_cb (void *arg, int i)
+{
+    int *items = arg;
+    items[i]++;
+}
+
+/* Return the number of items not called exactly 'expected' times.
+ */
+static int count_errors (int *items, int count, int expected)
+{
+    int errors = 0;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (items[i] != expected)
+            errors++;
+    }
+    return errors;
+}
+
+void basic (void)
+{
+    struct hashpool *hp;
+    int *items;
+    int i;
+
+    if (!(items = calloc (NITEMS, sizeof (items[0]))))
+        BAIL_OUT ("calloc failed");
+
+    ok ((hp = hashpool_create (4)) != NULL,
+        "hashpool_create nthreads=4 works");
+    ok (hashpool_get_nthreads (hp) == 4,
+        "hashpool_get_nthreads returns 4");
+
+    hashpool_run (hp, incr_cb, items, NITEMS);
+    ok (count_errors (items, NITEMS, 1) == 0,
+        "hashpool_run called fn once for each of %d items", NITEMS);
+
+    for (i = 0; i < 100; i++)
+        hashpool_run (hp, incr_cb, items, 1 + i * (NITEMS / 100));
+    ok (items[0] == 101 && items[NITEMS - 1] == 1,
+        "hashpool_run works for 100 consecutive batches");
+
+    hashpool_run (hp, incr_cb, items, 0);
+    ok (items[0] == 101,
+        "hashpool_run count=0 does nothing");
+
+    hashpool_destroy (hp);
+    free (items);
+}
+
+void serial (void)
+{
+    int items[16] = { 0 };
+
+    hashpool_run (NULL, incr_cb, items, 16);
+    ok (count_errors (items, 16, 1) == 0,
+        "hashpool_run hp=NULL runs items on calling thread");
+    ok (hashpool_get_nthreads (NULL) == 0,
+        "hashpool_get_nthreads hp=NULL returns 0");
+}
+
+void invalid (void)
+{
+    errno = 0;
+    ok (hashpool_create (0) == NULL && errno == EINVAL,
+        "hashpool_create nthreads=0 fails with EINVAL");
+    lives_ok ({hashpool_destroy (NULL);},
+        "hashpool_destroy hp=NULL doesn't crash");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    basic ();
+    serial ();
+    invalid ();
+
+    done_testing ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -3364,6 +3364,83 @@ void kvstxn_process_fallback_merge (void)
     cache_destroy (cache);
 }
 
+/* Commit a transaction large enough to use the hashpool, containing
+ * nested dirs and large values.  Copy the resulting root ref to 'ref'
+ * and set 'count' to the number of dirty cache entries.
+ */
+void hashpool_commit (struct hashpool *hp, char *ref, int ref_len, int *count)
+{
+    struct cache *cache;
+    kvstxn_mgr_t *ktm;
+    kvstxn_t *kt;
+    char rootref[BLOBREF_MAX_STRING_SIZE];
+    char bigval[256];
+    json_t *ops;
+    const char *newroot;
+    int i;
+
+    cache = create_cache_with_empty_rootdir (rootref, sizeof (rootref));
+
+    if (!(ktm = kvstxn_mgr_create (cache,
+                                   KVS_PRIMARY_NAMESPACE,
+                                   "sha1",
+                                   NULL,
+                                   &test_global)))
+        BAIL_OUT ("kvstxn_mgr_create failed");
+    kvstxn_mgr_set_hashpool (ktm, hp);
+
+    memset (bigval, 'x', sizeof (bigval) - 1);
+    bigval[sizeof (bigval) - 1] = '\0';
+    ops = json_array ();
+    for (i = 0; i < 500; i++) {
+        char key[64];
+        char val[16];
+        snprintf (key, sizeof (key), "a.b%d.c%d.key%d", i % 7, i % 31, i);
+        snprintf (val, sizeof (val), "%d", i);
+        ops_append (ops, key, i % 5 == 0 ? bigval : val, 0);
+    }
+    ok (kvstxn_mgr_add_transaction (ktm, "transaction1", ops, 0) == 0,
+        "kvstxn_mgr_add_transaction works");
+    json_decref (ops);
+
+    ok ((kt = kvstxn_mgr_get_ready_transaction (ktm)) != NULL,
+        "kvstxn_mgr_get_ready_transaction returns ready kvstxn");
+    ok (kvstxn_process (kt, 1, rootref) == KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES,
+        "kvstxn_process returns KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES");
+    *count = 0;
+    ok (kvstxn_iter_dirty_cache_entries (kt, cache_count_dirty_cb, count) == 0,
+        "kvstxn_iter_dirty_cache_entries works for dirty cache entries");
+    ok (kvstxn_process (kt, 1, rootref) == KVSTXN_PROCESS_FINISHED,
+        "kvstxn_process returns KVSTXN_PROCESS_FINISHED");
+    ok ((newroot = kvstxn_get_newroot_ref (kt)) != NULL,
+        "kvstxn_get_newroot_ref returns != NULL when processing complete");
+    snprintf (ref, ref_len, "%s", newroot ? newroot : "");
+
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+    kvstxn_mgr_destroy (ktm);
+    cache_destroy (cache);
+}
+
+void kvstxn_process_hashpool (void)
+{
+    struct hashpool *hp;
+    char serialref[BLOBREF_MAX_STRING_SIZE];
+    char poolref[BLOBREF_MAX_STRING_SIZE];
+    int serialcount, poolcount;
+
+    ok ((hp = hashpool_create (4)) != NULL,
+        "hashpool_create works");
+
+    hashpool_commit (NULL, serialref, sizeof (serialref), &serialcount);
+    hashpool_commit (hp, poolref, sizeof (poolref), &poolcount);
+    ok (strcmp (serialref, poolref) == 0,
+        "root ref is the same with and without hashpool");
+    ok (serialcount == poolcount,
+        "same number of dirty cache entries with and without hashpool");
+
+    hashpool_destroy (hp);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -3403,6 +3480,7 @@ int main (int argc, char *argv[])
     kvstxn_process_append_errors ();
     kvstxn_process_append_no_duplicate ();
     kvstxn_process_fallback_merge ();
+    kvstxn_process_hashpool ();
 
     done_testing ();
     return (0);
@@ -0,0 +1,206 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* kvstxn_bench - time kvstxn_process() for one large transaction
+ *
+ * Commits COUNT keys spread over directories of up to FANOUT entries
+ * into an empty root, first serially, then with a hashpool of NTHREADS
+ * workers, and reports the time spent in kvstxn_process() for each.
+ * Values are VALSIZE bytes, so values larger than a blobref are stored
+ * as separate objects.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <getopt.h>
+#include <stdio.h>
+#include <string.h>
+#include <jansson.h>
+
+#include "src/common/libutil/log.h"
+#include "src/common/libutil/blobref.h"
+#include "src/common/libutil/monotime.h"
+#include "src/common/libkvs/kvs.h"
+#include "src/common/libkvs/treeobj.h"
+#include "src/common/libkvs/kvs_txn_private.h"
+#include "src/modules/kvs/cache.h"
+#include "src/modules/kvs/kvstxn.h"
+#include "src/modules/kvs/hashpool.h"
+
+#define OPTIONS "hn:t:f:s:"
+static const struct option longopts[] = {
+    {"help",       no_argument,        0, 'h'},
+    {"count",      required_argument,  0, 'n'},
+    {"nthreads",   required_argument,  0, 't'},
+    {"fanout",     required_argument,  0, 'f'},
+    {"valsize",    required_argument,  0, 's'},
+    { 0, 0, 0, 0 },
+};
+
+static int count = 100000;
+static int fanout = 100;
+static int valsize = 8;
+
+void usage (void)
+{
+    fprintf (stderr,
+"Usage: kvstxn_bench [-n COUNT] [-t NTHREADS] [-f FANOUT] [-s VALSIZE]\n"
+);
+    exit (1);
+}
+
+static json_t *create_ops (void)
+{
+    json_t *ops;
+    char *val;
+    int i;
+
+    if (!(val = malloc (valsize)))
+        log_err_exit ("malloc");
+    memset (val, 'x', valsize);
+    if (!(ops = json_array ()))
+        log_msg_exit ("json_array");
+    for (i = 0; i < count; i++) {
+        char key[128];
+        json_t *dirent;
+        json_t *op;
+
+        /* key is the base-fanout representation of i, one dir per digit
+         */
+        snprintf (key, sizeof (key), "bench.%d.%d.key%d",
+                  i / (fanout * fanout), (i / fanout) % fanout, i);
+        if (!(dirent = treeobj_create_val (val, valsize))
+            || txn_encode_op (key, 0, dirent, &op) < 0
+            || json_array_append_new (ops, op) < 0)
+            log_msg_exit ("error creating op");
+        json_decref (dirent);
+    }
+    free (val);
+    return ops;
+}
+
+static struct cache *create_cache (char *ref, int ref_len)
+{
+    struct cache *cache;
+    struct cache_entry *entry;
+    json_t *rootdir;
+    char *s;
+
+    if (!(cache = cache_create ())
+        || !(rootdir = treeobj_create_dir ())
+        || !(s = treeobj_encode (rootdir))
+        || blobref_hash ("sha1", s, strlen (s), ref, ref_len) < 0
+        || !(entry = cache_entry_create (ref))
+        || cache_entry_set_raw (entry, s, strlen (s)) < 0
+        || cache_insert (cache, entry) < 0)
+        log_err_exit ("error creating cache");
+    free (s);
+    json_decref (rootdir);
+    return cache;
+}
+
+static int clear_dirty_cb (kvstxn_t *kt, struct cache_entry *entry, void *arg)
+{
+    int *n = arg;
+    (*n)++;
+    return cache_entry_set_dirty (entry, false);
+}
+
+static void bench (json_t *ops, struct hashpool *hp)
+{
+    struct cache *cache;
+    kvstxn_mgr_t *ktm;
+    kvstxn_t *kt;
+    char rootref[BLOBREF_MAX_STRING_SIZE];
+    struct timespec t0;
+    double elapsed;
+    int n = 0;
+
+    cache = create_cache (rootref, sizeof (rootref));
+    if (!(ktm = kvstxn_mgr_create (cache, "primary", "sha1", NULL, NULL)))
+        log_err_exit ("kvstxn_mgr_create");
+    kvstxn_mgr_set_hashpool (ktm, hp);
+    if (kvstxn_mgr_add_transaction (ktm, "bench", ops, 0) < 0
+        || !(kt = kvstxn_mgr_get_ready_transaction (ktm)))
+        log_err_exit ("error adding transaction");
+
+    monotime (&t0);
+    if (kvstxn_process (kt, 1, rootref) != KVSTXN_PROCESS_DIRTY_CACHE_ENTRIES)
+        log_msg_exit ("kvstxn_process: %s", strerror (kvstxn_get_errnum (kt)));
+    elapsed = monotime_since (t0);
+
+    if (kvstxn_iter_dirty_cache_entries (kt, clear_dirty_cb, &n) < 0
+        || kvstxn_process (kt, 1, rootref) != KVSTXN_PROCESS_FINISHED)
+        log_msg_exit ("kvstxn_process did not finish");
+
+    printf ("nthreads=%d keys=%d objects=%d time=%.1fms root=%s\n",
+            hashpool_get_nthreads (hp),
+            count,
+            n,
+            elapsed,
+            kvstxn_get_newroot_ref (kt));
+
+    kvstxn_mgr_remove_transaction (ktm, kt, false);
+    kvstxn_mgr_destroy (ktm);
+    cache_destroy (cache);
+}
+
+int main (int argc, char *argv[])
+{
+    struct hashpool *hp;
+    json_t *ops;
+    int nthreads = 4;
+    int ch;
+
+    log_init ("kvstxn_bench");
+
+    while ((ch = getopt_long (argc, argv, OPTIONS, longopts, NULL)) != -1) {
+        switch (ch) {
+            case 'h': /* --help */
+                usage ();
+                break;
+            case 'n': /* --count N */
+                count = strtoul (optarg, NULL, 10);
+                break;
+            case 't': /* --nthreads N */
+                nthreads = strtoul (optarg, NULL, 10);
+                break;
+            case 'f': /* --fanout N */
+                fanout = strtoul (optarg, NULL, 10);
+                break;
+            case 's': /* --valsize N */
+                valsize = strtoul (optarg, NULL, 10);
+                break;
+            default:
+                usage ();
+                break;
+        }
+    }
+    if (optind < argc || count < 1 || nthreads < 1 || fanout < 1
+                      || valsize < 1)
+        usage ();
+
+    ops = create_ops ();
+    if (!(hp = hashpool_create (nthreads)))
+        log_err_exit ("hashpool_create");
+
+    bench (ops, NULL);
+    bench (ops, hp);
+
+    hashpool_destroy (hp);
+    json_decref (ops);
+    log_fini ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
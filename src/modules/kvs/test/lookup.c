@@ -23,6 +23,7 @@
 #include "src/common/libkvs/kvs_util_private.h"
 #include "src/modules/kvs/cache.h"
 #include "src/modules/kvs/lookup.h"
+#include "src/modules/kvs/lookupcache.h"
 #include "src/common/libutil/blobref.h"
 
 struct flux_msg_cred owner_cred = { .userid = 0, .rolemask = FLUX_ROLE_OWNER };
@@ -3499,6 +3500,122 @@ void lookup_stall_ref_expire_cache_entries (void) {
     json_decref (root);
 }
 
+/* Look up 'key' in namespace 'ns' using 'lc', and check the value.
+ */
+void check_lookupcache (struct cache *cache,
+                        kvsroot_mgr_t *krm,
+                        struct lookupcache *lc,
+                        const char *ns,
+                        const char *key,
+                        json_t *value)
+{
+    lookup_t *lh;
+
+    ok ((lh = lookup_create (cache,
+                             krm,
+                             1,
+                             ns,
+                             NULL,
+                             0,
+                             key,
+                             owner_cred,
+                             0,
+                             NULL)) != NULL,
+        "lookup_create %s on namespace %s", key, ns);
+    lookup_set_lookupcache (lh, lc);
+    check_value (lh, value, key);
+}
+
+void lookup_lookupcache (void) {
+    json_t *rootA;
+    json_t *rootB;
+    json_t *dirref;
+    json_t *test;
+    struct cache *cache;
+    kvsroot_mgr_t *krm;
+    struct lookupcache *lc;
+    char dirref_ref[BLOBREF_MAX_STRING_SIZE];
+    char root_refA[BLOBREF_MAX_STRING_SIZE];
+    char root_refB[BLOBREF_MAX_STRING_SIZE];
+    int size, hits, misses;
+
+    ok ((cache = cache_create ()) != NULL,
+        "cache_create works");
+    ok ((krm = kvsroot_mgr_create (NULL, NULL)) != NULL,
+        "kvsroot_mgr_create works");
+    ok ((lc = lookupcache_create (16)) != NULL,
+        "lookupcache_create works");
+
+    /* This cache is
+     *
+     * dirref_ref
+     * "val" : val to "foo"
+     *
+     * root_refA
+     * "dirref" : dirref to dirref_ref
+     * "symlinkNS2B" : symlinkNS to "val" in namespace=B
+     *
+     * root_refB
+     * "val" : val to "bar"
+     */
+
+    dirref = treeobj_create_dir ();
+    _treeobj_insert_entry_val (dirref, "val", "foo", 3);
+    treeobj_hash ("sha1", dirref, dirref_ref, sizeof (dirref_ref));
+    (void)cache_insert (cache, create_cache_entry_treeobj (dirref_ref, dirref));
+
+    rootA = treeobj_create_dir ();
+    _treeobj_insert_entry_dirref (rootA, "dirref", dirref_ref);
+    _treeobj_insert_entry_symlink (rootA, "symlinkNS2B", "B", "val");
+    treeobj_hash ("sha1", rootA, root_refA, sizeof (root_refA));
+    (void)cache_insert (cache, create_cache_entry_treeobj (root_refA, rootA));
+
+    rootB = treeobj_create_dir ();
+    _treeobj_insert_entry_val (rootB, "val", "bar", 3);
+    treeobj_hash ("sha1", rootB, root_refB, sizeof (root_refB));
+    (void)cache_insert (cache, create_cache_entry_treeobj (root_refB, rootB));
+
+    setup_kvsroot (krm, "A", cache, root_refA, 0);
+    setup_kvsroot (krm, "B", cache, root_refB, 0);
+
+    test = treeobj_create_val ("foo", 3);
+    check_lookupcache (cache, krm, lc, "A", "dirref.val", test);
+    lookupcache_get_stats (lc, &size, &hits, &misses);
+    ok (size == 1 && hits == 0 && misses == 1,
+        "first lookup of dirref.val missed lookupcache and was added");
+    check_lookupcache (cache, krm, lc, "A", "dirref.val", test);
+    lookupcache_get_stats (lc, &size, &hits, &misses);
+    ok (size == 1 && hits == 1 && misses == 1,
+        "second lookup of dirref.val hit lookupcache");
+    json_decref (test);
+
+    check_lookupcache (cache, krm, lc, "A", "dirref.missing", NULL);
+    check_lookupcache (cache, krm, lc, "A", "dirref.missing", NULL);
+    lookupcache_get_stats (lc, &size, &hits, &misses);
+    ok (size == 2 && hits == 2 && misses == 2,
+        "lookup of missing key was cached as not found");
+
+    test = treeobj_create_val ("bar", 3);
+    check_lookupcache (cache, krm, lc, "A", "symlinkNS2B", test);
+    check_lookupcache (cache, krm, lc, "A", "symlinkNS2B", test);
+    lookupcache_get_stats (lc, &size, &hits, &misses);
+    ok (size == 2 && hits == 2 && misses == 4,
+        "lookup through symlink to another namespace was not cached");
+    json_decref (test);
+
+    lookupcache_clear_stats (lc);
+    lookupcache_get_stats (lc, &size, &hits, &misses);
+    ok (size == 2 && hits == 0 && misses == 0,
+        "lookupcache_clear_stats works");
+
+    lookupcache_destroy (lc);
+    cache_destroy (cache);
+    kvsroot_mgr_destroy (krm);
+    json_decref (dirref);
+    json_decref (rootA);
+    json_decref (rootB);
+}
+
 int main (int argc, char *argv[])
 {
     plan (NO_PLAN);
@@ -3521,6 +3638,7 @@ int main (int argc, char *argv[])
     lookup_stall_ref ();
     lookup_stall_namespace_removed ();
     lookup_stall_ref_expire_cache_entries ();
+    lookup_lookupcache ();
 
     done_testing ();
     return (0);
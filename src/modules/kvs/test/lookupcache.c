@@ -0,0 +1,144 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "src/common/libtap/tap.h"
+#include "src/common/libkvs/treeobj.h"
+#include "src/modules/kvs/lookupcache.h"
+
+static const char *ref1 = "sha1-508259c0f7fd50e47716b50ad1f0fc6ed46017f9";
+static const char *ref2 = "sha1-1111111111111111111111111111111111111111";
+
+void basic (void)
+{
+    struct lookupcache *lc;
+    json_t *val;
+    json_t *o;
+    int size, hits, misses;
+
+    ok ((lc = lookupcache_create (8)) != NULL,
+        "lookupcache_create works");
+
+    errno = 0;
+    o = NULL;
+    ok (lookupcache_get (lc, ref1, "a.b", 0, &o) < 0 && errno == ENOENT,
+        "lookupcache_get on empty cache fails with ENOENT");
+
+    val = treeobj_create_val ("foo", 3);
+    ok (lookupcache_put (lc, ref1, "a.b", 0, val) == 0,
+        "lookupcache_put works");
+    ok (lookupcache_get (lc, ref1, "a.b", 0, &o) == 0
+        && o != NULL && json_equal (o, val),
+        "lookupcache_get returns cached dirent");
+    ok (o != val,
+        "lookupcache_put stored a copy");
+    json_decref (o);
+
+    ok (lookupcache_get (lc, ref1, "a.b", FLUX_KVS_WAITCREATE, &o) == 0
+        && o != NULL && json_equal (o, val),
+        "lookupcache_get ignores flags that do not affect the walk");
+    json_decref (o);
+
+    errno = 0;
+    ok (lookupcache_get (lc, ref1, "a.b", FLUX_KVS_READLINK, &o) < 0
+        && errno == ENOENT,
+        "lookupcache_get with FLUX_KVS_READLINK is a different entry");
+    errno = 0;
+    ok (lookupcache_get (lc, ref2, "a.b", 0, &o) < 0 && errno == ENOENT,
+        "lookupcache_get with different root ref is a different entry");
+
+    ok (lookupcache_put (lc, ref2, "a.b", 0, NULL) == 0,
+        "lookupcache_put dirent=NULL works");
+    o = val;
+    ok (lookupcache_get (lc, ref2, "a.b", 0, &o) == 0 && o == NULL,
+        "lookupcache_get returns NULL dirent for cached not found");
+
+    ok (lookupcache_put (lc, ref1, "a.b", 0, val) == 0,
+        "lookupcache_put of existing entry works");
+
+    lookupcache_get_stats (lc, &size, &hits, &misses);
+    ok (size == 2 && hits == 3 && misses == 3,
+        "lookupcache_get_stats returns expected values");
+    lookupcache_clear_stats (lc);
+    lookupcache_get_stats (lc, &size, &hits, &misses);
+    ok (size == 2 && hits == 0 && misses == 0,
+        "lookupcache_clear_stats works");
+
+    json_decref (val);
+    lookupcache_destroy (lc);
+}
+
+void lru (void)
+{
+    struct lookupcache *lc;
+    char path[16];
+    json_t *o;
+    int size;
+    int i;
+
+    ok ((lc = lookupcache_create (4)) != NULL,
+        "lookupcache_create maxsize=4 works");
+    for (i = 0; i < 10; i++) {
+        snprintf (path, sizeof (path), "key%d", i);
+        if (lookupcache_put (lc, ref1, path, 0, NULL) < 0)
+            BAIL_OUT ("lookupcache_put failed");
+    }
+    lookupcache_get_stats (lc, &size, NULL, NULL);
+    ok (size == 4,
+        "lookupcache holds at most maxsize entries");
+    ok (lookupcache_get (lc, ref1, "key9", 0, &o) == 0,
+        "most recent entry is cached");
+    ok (lookupcache_get (lc, ref1, "key0", 0, &o) < 0,
+        "oldest entry was evicted");
+    lookupcache_destroy (lc);
+}
+
+void errors (void)
+{
+    json_t *o;
+    int size = -1, hits = -1, misses = -1;
+
+    errno = 0;
+    ok (lookupcache_create (0) == NULL && errno == EINVAL,
+        "lookupcache_create maxsize=0 fails with EINVAL");
+    errno = 0;
+    ok (lookupcache_get (NULL, ref1, "a", 0, &o) < 0 && errno == EINVAL,
+        "lookupcache_get lc=NULL fails with EINVAL");
+    errno = 0;
+    ok (lookupcache_put (NULL, ref1, "a", 0, NULL) < 0 && errno == EINVAL,
+        "lookupcache_put lc=NULL fails with EINVAL");
+    lookupcache_get_stats (NULL, &size, &hits, &misses);
+    ok (size == 0 && hits == 0 && misses == 0,
+        "lookupcache_get_stats lc=NULL returns zeroes");
+    lives_ok ({lookupcache_destroy (NULL);},
+        "lookupcache_destroy lc=NULL doesn't crash");
+}
+
+int main (int argc, char *argv[])
+{
+    plan (NO_PLAN);
+
+    basic ();
+    lru ();
+    errors ();
+
+    done_testing ();
+    return (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
@@ -29,6 +29,7 @@
 #include "drain.h"
 #include "exclude.h"
 #include "acquire.h"
+#include "topo.h"
 #include "rutil.h"
 
 /* Parse [resource] table.
@@ -125,6 +126,7 @@ static void resource_ctx_destroy (struct resource_ctx *ctx)
         drain_destroy (ctx->drain);
         discover_destroy (ctx->discover);
         monitor_destroy (ctx->monitor);
+        topo_destroy (ctx->topo);
         exclude_destroy (ctx->exclude);
         reslog_destroy (ctx->reslog);
         flux_msg_handler_delvec (ctx->handlers);
@@ -296,6 +298,8 @@ int mod_main (flux_t *h, int argc, char **argv)
         goto error;
     if (!(ctx->monitor = monitor_create (ctx, monitor_force_up)))
         goto error;
+    if (!(ctx->topo = topo_create (ctx)))
+        goto error;
     if (ctx->rank == 0) {
         if (reload_eventlog (h, &eventlog) < 0)
             goto error;
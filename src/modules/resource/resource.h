@@ -20,6 +20,7 @@ struct resource_ctx {
     struct exclude *exclude;
     struct acquire *acquire;
     struct reslog *reslog;
+    struct topo *topo;
 
     uint32_t rank;
     uint32_t size;
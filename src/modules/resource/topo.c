@@ -0,0 +1,127 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* topo.c - serve the local hwloc topology
+ *
+ * On all ranks:
+ * - load the hwloc topology of this node on the first resource.topo-get
+ *   request, and export it to XML.
+ * - respond to resource.topo-get with {"xml":s} from then on.
+ *
+ * Job shells load their topology from this XML with
+ * hwloc_topology_set_xmlbuffer() instead of discovering it again for
+ * every job, which is slow on nodes with many cores, NUMA domains or
+ * devices.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <hwloc.h>
+#include <flux/core.h>
+#include <jansson.h>
+
+#include "resource.h"
+#include "topo.h"
+
+struct topo {
+    struct resource_ctx *ctx;
+    flux_msg_handler_t **handlers;
+    char *xml;
+};
+
+static char *topo_load_xml (void)
+{
+    hwloc_topology_t topology;
+    char *buf;
+    int buflen;
+    char *xml = NULL;
+
+    if (hwloc_topology_init (&topology) < 0)
+        return NULL;
+    if (hwloc_topology_load (topology) < 0)
+        goto done;
+#if HWLOC_API_VERSION >= 0x20000
+    if (hwloc_topology_export_xmlbuffer (topology, &buf, &buflen, 0) < 0)
+#else
+    if (hwloc_topology_export_xmlbuffer (topology, &buf, &buflen) < 0)
+#endif
+        goto done;
+    xml = strdup (buf);
+    hwloc_free_xmlbuffer (topology, buf);
+done:
+    hwloc_topology_destroy (topology);
+    if (!xml)
+        errno = EINVAL;
+    return xml;
+}
+
+static void topo_get_cb (flux_t *h,
+                         flux_msg_handler_t *mh,
+                         const flux_msg_t *msg,
+                         void *arg)
+{
+    struct topo *topo = arg;
+
+    if (flux_request_decode (msg, NULL, NULL) < 0)
+        goto error;
+    if (!topo->xml) {
+        if (!(topo->xml = topo_load_xml ())) {
+            flux_log_error (h, "error loading hwloc topology");
+            goto error;
+        }
+    }
+    if (flux_respond_pack (h, msg, "{s:s}", "xml", topo->xml) < 0)
+        flux_log_error (h, "error responding to topo-get request");
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        flux_log_error (h, "error responding to topo-get request");
+}
+
+static const struct flux_msg_handler_spec htab[] = {
+    {
+        .typemask = FLUX_MSGTYPE_REQUEST,
+        .topic_glob = "resource.topo-get",
+        .cb = topo_get_cb,
+        .rolemask = FLUX_ROLE_USER
+    },
+    FLUX_MSGHANDLER_TABLE_END,
+};
+
+void topo_destroy (struct topo *topo)
+{
+    if (topo) {
+        int saved_errno = errno;
+        flux_msg_handler_delvec (topo->handlers);
+        free (topo->xml);
+        free (topo);
+        errno = saved_errno;
+    }
+}
+
+struct topo *topo_create (struct resource_ctx *ctx)
+{
+    struct topo *topo;
+
+    if (!(topo = calloc (1, sizeof (*topo))))
+        return NULL;
+    topo->ctx = ctx;
+    if (flux_msg_handler_addvec (ctx->h, htab, topo, &topo->handlers) < 0)
+        goto error;
+    return topo;
+error:
+    topo_destroy (topo);
+    return NULL;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
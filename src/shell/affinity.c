@@ -154,14 +154,59 @@ static void shell_affinity_destroy (void *arg)
     free (sa);
 }
 
+/*  Load topology from the XML cached by the local broker's resource
+ *   module, which avoids a full hwloc discovery in every job shell.
+ */
+static int topology_load_cached (flux_shell_t *shell, hwloc_topology_t topo)
+{
+    flux_t *h = flux_shell_get_flux (shell);
+    flux_future_t *f = NULL;
+    const char *xml;
+    int standalone = 0;
+    int rc = -1;
+
+    /*  A standalone shell has no broker to ask.
+     */
+    if (!h
+        || flux_shell_info_unpack (shell,
+                                   "{s:{s:b}}",
+                                   "options",
+                                     "standalone", &standalone) < 0
+        || standalone)
+        return -1;
+    if (!(f = flux_rpc (h, "resource.topo-get", NULL, FLUX_NODEID_ANY, 0))
+        || flux_rpc_get_unpack (f, "{s:s}", "xml", &xml) < 0)
+        goto out;
+    /*  Topology is this system's, so allow binding with it.
+     */
+    if (hwloc_topology_set_xmlbuffer (topo, xml, strlen (xml) + 1) < 0
+        || hwloc_topology_set_flags (topo,
+                                     HWLOC_TOPOLOGY_FLAG_IS_THISSYSTEM) < 0
+        || hwloc_topology_load (topo) < 0)
+        goto out;
+    rc = 0;
+out:
+    flux_future_destroy (f);
+    return rc;
+}
+
 /*  Initialize topology object for affinity processing.
  */
-static int shell_affinity_topology_init (struct shell_affinity *sa)
+static int shell_affinity_topology_init (struct shell_affinity *sa,
+                                         flux_shell_t *shell)
 {
     if (hwloc_topology_init (&sa->topo) < 0)
         return shell_log_errno ("hwloc_topology_init");
-    if (hwloc_topology_load (sa->topo) < 0)
-        return shell_log_errno ("hwloc_topology_load");
+    if (topology_load_cached (shell, sa->topo) < 0) {
+        shell_debug ("affinity: no cached topology, loading from system");
+        hwloc_topology_destroy (sa->topo);
+        if (hwloc_topology_init (&sa->topo) < 0) {
+            sa->topo = NULL;
+            return shell_log_errno ("hwloc_topology_init");
+        }
+        if (hwloc_topology_load (sa->topo) < 0)
+            return shell_log_errno ("hwloc_topology_load");
+    }
     if (topology_restrict_current (sa->topo) < 0)
         return shell_log_errno ("topology_restrict_current");
     return 0;
@@ -176,7 +221,7 @@ static struct shell_affinity * shell_affinity_create (flux_shell_t *shell)
     struct shell_affinity *sa = calloc (1, sizeof (*sa));
     if (!sa)
         return NULL;
-    if (shell_affinity_topology_init (sa) < 0)
+    if (shell_affinity_topology_init (sa, shell) < 0)
         goto err;
     if (flux_shell_rank_info_unpack (shell,
                                      -1,
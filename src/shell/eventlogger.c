@@ -8,6 +8,24 @@
  * SPDX-License-Identifier: LGPL-3.0
 \************************************************************/
 
+/*  eventlogger - batched eventlog appends
+ *
+ *  Appends are collected into a KVS transaction which is committed
+ *   when the batch timer expires, or immediately on a synchronous
+ *   append or flush.
+ *
+ *  Eventloggers created with eventlogger_create_shared() share the
+ *   current batch of their parent, so appends to different eventlogs
+ *   from different shell components within one batch interval are
+ *   committed in a single KVS transaction.  Each eventlogger keeps its
+ *   own callbacks, batch timeout, and commit timeout.  A shared batch
+ *   is committed at the earliest deadline of its members.
+ *
+ *  When commits take longer than the batch timeout, the batch timeout
+ *   is stretched toward the average commit latency (up to a limit), so
+ *   that a slow KVS receives fewer, larger transactions.
+ */
+
 #if HAVE_CONFIG_H
 #include "config.h"
 #endif
@@ -18,20 +36,48 @@
 #include "src/common/libeventlog/eventlog.h"
 #include "eventlogger.h"
 
+/*  Limit on stretching the batch timeout of an eventlogger when commit
+ *   latency is high, as a multiple of its batch timeout.
+ */
+static const double batch_timeout_max_scale = 10.;
+
+struct batch_entry {
+    struct eventlogger *ev;
+    json_t *entry;
+};
+
 struct eventlog_batch {
-    zlist_t *entries;
+    zlist_t *entries;           /* struct batch_entry for async appends */
+    zlist_t *members;           /* eventloggers that appended to batch  */
     flux_kvs_txn_t *txn;
     flux_watcher_t *timer;
-    struct eventlogger *ev;
+    double deadline;            /* reactor time at which timer expires  */
+    double t_commit;            /* reactor time at which commit started */
+    struct eventlog_txn *shared;
+};
+
+/*  State shared by an eventlogger and all eventloggers created from it.
+ */
+struct eventlog_txn {
+    int usecount;
+    flux_t *h;
+    zlist_t *pending;
+    struct eventlog_batch *current;
+    double latency;             /* moving average of commit latency */
+
+    /* statistics */
+    int appends;
+    int commits;
+    int sync_commits;
+    int errors;
+    double max_latency;
 };
 
 struct eventlogger {
     int refcount;
-    flux_t *h;
     double batch_timeout;
     double commit_timeout;
-    zlist_t *pending;
-    struct eventlog_batch *current;
+    struct eventlog_txn *shared;
     struct eventlogger_ops ops;
     void *arg;
 };
@@ -46,35 +92,56 @@ int eventlogger_set_commit_timeout (struct eventlogger *ev, double timeout)
     return 0;
 }
 
+static void batch_entry_destroy (struct batch_entry *be)
+{
+    if (be) {
+        json_decref (be->entry);
+        free (be);
+    }
+}
+
 static void eventlog_batch_destroy (struct eventlog_batch *batch)
 {
     if (batch) {
         if (batch->entries)
             zlist_destroy (&batch->entries);
+        if (batch->members)
+            zlist_destroy (&batch->members);
         flux_kvs_txn_destroy (batch->txn);
         flux_watcher_destroy (batch->timer);
         free (batch);
     }
 }
 
-static void eventlogger_batch_complete (struct eventlogger *ev,
+/*  Remove a completed batch, and notify members for which this was
+ *   the last pending batch that they are idle.
+ */
+static void eventlogger_batch_complete (struct eventlog_txn *shared,
                                         struct eventlog_batch *batch)
 {
-    zlist_remove (ev->pending, batch);
-    if (--ev->refcount == 0 && ev->ops.idle)
-        (*ev->ops.idle) (ev, ev->arg);
+    struct eventlogger *ev;
+    zlist_t *members = batch->members;
+
+    batch->members = NULL;
+    if (shared->current == batch)
+        shared->current = NULL;
+    zlist_remove (shared->pending, batch);
+    while ((ev = zlist_pop (members))) {
+        if (--ev->refcount == 0 && ev->ops.idle)
+            (*ev->ops.idle) (ev, ev->arg);
+    }
+    zlist_destroy (&members);
 }
 
-static int eventlogger_batch_start (struct eventlogger *ev,
-                                    struct eventlog_batch *batch)
+static int eventlogger_batch_join (struct eventlogger *ev,
+                                   struct eventlog_batch *batch)
 {
-    if (zlist_append (ev->pending, batch) < 0)
+    if (zlist_exists (batch->members, ev))
+        return 0;
+    if (zlist_append (batch->members, ev) < 0) {
+        errno = ENOMEM;
         return -1;
-    zlist_freefn (ev->pending,
-                  batch,
-                  (zlist_free_fn *) eventlog_batch_destroy,
-                  true);
-
+    }
     /*  If refcount just increased to 1, notify that eventlogger is busy */
     if (++ev->refcount == 1 && ev->ops.busy)
         (*ev->ops.busy) (ev, ev->arg);
@@ -83,23 +150,54 @@ static int eventlogger_batch_start (struct eventlogger *ev,
 
 static void eventlog_batch_error (struct eventlog_batch *batch, int errnum)
 {
-    struct eventlogger *ev = batch->ev;
-    json_t *entry;
-    if (!ev->ops.err)
-        return;
-    entry = zlist_first (batch->entries);
-    while (entry) {
-        (*ev->ops.err) (ev, errnum, entry);
-        entry = zlist_next (batch->entries);
+    struct batch_entry *be;
+
+    batch->shared->errors++;
+    be = zlist_first (batch->entries);
+    while (be) {
+        if (be->ev && be->ev->ops.err)
+            (*be->ev->ops.err) (be->ev, errnum, be->entry);
+        be = zlist_next (batch->entries);
+    }
+}
+
+/*  Commit timeout for a batch is the shortest of its members.
+ */
+static double eventlog_batch_commit_timeout (struct eventlog_batch *batch)
+{
+    double timeout = -1.;
+    struct eventlogger *ev = zlist_first (batch->members);
+
+    while (ev) {
+        if (ev->commit_timeout >= 0.
+            && (timeout < 0. || ev->commit_timeout < timeout))
+            timeout = ev->commit_timeout;
+        ev = zlist_next (batch->members);
     }
+    return timeout;
+}
+
+static void eventlog_txn_update_latency (struct eventlog_txn *shared,
+                                         double t)
+{
+    if (shared->latency == 0.)
+        shared->latency = t;
+    else
+        shared->latency = 0.75 * shared->latency + 0.25 * t;
+    if (t > shared->max_latency)
+        shared->max_latency = t;
 }
 
 static void commit_cb (flux_future_t *f, void *arg)
 {
     struct eventlog_batch *batch = arg;
+    struct eventlog_txn *shared = batch->shared;
+    flux_reactor_t *r = flux_get_reactor (shared->h);
+
     if (flux_future_get (f, NULL) < 0)
         eventlog_batch_error (batch, errno);
-    eventlogger_batch_complete (batch->ev, batch);
+    eventlog_txn_update_latency (shared, flux_reactor_now (r) - batch->t_commit);
+    eventlogger_batch_complete (shared, batch);
     flux_future_destroy (f);
 }
 
@@ -107,81 +205,200 @@ static void
 timer_cb (flux_reactor_t *r, flux_watcher_t *w, int revents, void *arg)
 {
     struct eventlog_batch *batch = arg;
-    struct eventlogger *ev = batch->ev;
-    flux_t *h = ev->h;
-    double timeout = ev->commit_timeout;
+    struct eventlog_txn *shared = batch->shared;
+    double timeout = eventlog_batch_commit_timeout (batch);
     flux_future_t *f = NULL;
     int flags = FLUX_KVS_TXN_COMPACT;
 
-    if (!(f = flux_kvs_commit (h, NULL, flags, batch->txn))
+    batch->t_commit = flux_reactor_now (r);
+    if (!(f = flux_kvs_commit (shared->h, NULL, flags, batch->txn))
         || flux_future_then (f, timeout, commit_cb, batch) < 0) {
         eventlog_batch_error (batch, errno);
+        flux_future_destroy (f);
+        eventlogger_batch_complete (shared, batch);
         return;
     }
-    batch->ev->current = NULL;
+    shared->commits++;
+    shared->current = NULL;
 }
 
-static struct eventlog_batch * eventlog_batch_create (struct eventlogger *ev)
+static struct eventlog_batch *eventlog_batch_create (struct eventlog_txn *shared)
 {
     struct eventlog_batch *batch = calloc (1, sizeof (*batch));
     if (!batch)
         return NULL;
-    flux_reactor_t *r = flux_get_reactor (ev->h);
-    batch->ev = ev;
+    flux_reactor_t *r = flux_get_reactor (shared->h);
+    batch->shared = shared;
     batch->entries = zlist_new ();
+    batch->members = zlist_new ();
     batch->txn = flux_kvs_txn_create ();
-    batch->timer = flux_timer_watcher_create (r,
-                                              ev->batch_timeout, 0.,
-                                              timer_cb,
-                                              batch);
-    if (!batch->entries || !batch->txn || !batch->timer) {
+    batch->timer = flux_timer_watcher_create (r, 0., 0., timer_cb, batch);
+    if (!batch->entries || !batch->members || !batch->txn || !batch->timer) {
         eventlog_batch_destroy (batch);
         return NULL;
     }
-    flux_watcher_start (batch->timer);
+    batch->deadline = -1.;
     return batch;
 }
 
+/*  Batch timeout of 'ev', stretched toward the average commit latency.
+ */
+static double eventlogger_batch_timeout (struct eventlogger *ev)
+{
+    double timeout = ev->batch_timeout;
+    double latency = ev->shared->latency;
+
+    if (latency > timeout) {
+        double max = timeout * batch_timeout_max_scale;
+        timeout = latency < max ? latency : max;
+    }
+    return timeout;
+}
+
+/*  Arm the batch timer to expire no later than the batch timeout of 'ev'.
+ */
+static void eventlog_batch_arm (struct eventlog_batch *batch,
+                                struct eventlogger *ev)
+{
+    flux_reactor_t *r = flux_get_reactor (batch->shared->h);
+    double timeout = eventlogger_batch_timeout (ev);
+    double now = flux_reactor_now (r);
+
+    if (batch->deadline >= 0. && batch->deadline <= now + timeout)
+        return;
+    batch->deadline = now + timeout;
+    flux_watcher_stop (batch->timer);
+    flux_timer_watcher_reset (batch->timer, timeout, 0.);
+    flux_watcher_start (batch->timer);
+}
+
+static void eventlog_txn_decref (struct eventlog_txn *shared)
+{
+    if (shared && --shared->usecount == 0) {
+        if (shared->pending)
+            zlist_destroy (&shared->pending);
+        free (shared);
+    }
+}
+
+static struct eventlog_txn *eventlog_txn_create (flux_t *h)
+{
+    struct eventlog_txn *shared = calloc (1, sizeof (*shared));
+    if (!shared)
+        return NULL;
+    if (!(shared->pending = zlist_new ())) {
+        free (shared);
+        errno = ENOMEM;
+        return NULL;
+    }
+    shared->h = h;
+    shared->usecount = 1;
+    return shared;
+}
+
+/*  Forget 'ev' in any batches that outlive it.
+ */
+static void eventlogger_detach (struct eventlogger *ev)
+{
+    struct eventlog_batch *batch = zlist_first (ev->shared->pending);
+    while (batch) {
+        struct batch_entry *be = zlist_first (batch->entries);
+        while (be) {
+            if (be->ev == ev)
+                be->ev = NULL;
+            be = zlist_next (batch->entries);
+        }
+        if (batch->members)
+            zlist_remove (batch->members, ev);
+        batch = zlist_next (ev->shared->pending);
+    }
+}
+
 void eventlogger_destroy (struct eventlogger *ev)
 {
     if (ev) {
-        if (ev->pending)
-            zlist_destroy (&ev->pending);
+        if (ev->shared) {
+            if (ev->shared->usecount == 1) {
+                struct eventlog_batch *batch;
+                while ((batch = zlist_pop (ev->shared->pending)))
+                    eventlog_batch_destroy (batch);
+            }
+            else
+                eventlogger_detach (ev);
+            eventlog_txn_decref (ev->shared);
+        }
         free (ev);
     }
 }
 
-struct eventlogger *eventlogger_create (flux_t *h,
-                                        double timeout,
-                                        struct eventlogger_ops *ops,
-                                        void *arg)
+static struct eventlogger *eventlogger_new (struct eventlog_txn *shared,
+                                            double timeout,
+                                            struct eventlogger_ops *ops,
+                                            void *arg)
 {
     struct eventlogger *ev = calloc (1, sizeof (*ev));
     if (ev) {
-        ev->pending = zlist_new ();
-        if (!ev->pending) {
-            eventlogger_destroy (ev);
-            return NULL;
-        }
-        ev->h = h;
+        ev->shared = shared;
         ev->batch_timeout = timeout;
         ev->commit_timeout = -1.;
-        ev->current = NULL;
         ev->ops = *ops;
         ev->arg = arg;
     }
     return ev;
 }
 
+struct eventlogger *eventlogger_create (flux_t *h,
+                                        double timeout,
+                                        struct eventlogger_ops *ops,
+                                        void *arg)
+{
+    struct eventlog_txn *shared;
+    struct eventlogger *ev;
+
+    if (!(shared = eventlog_txn_create (h)))
+        return NULL;
+    if (!(ev = eventlogger_new (shared, timeout, ops, arg)))
+        eventlog_txn_decref (shared);
+    return ev;
+}
+
+struct eventlogger *eventlogger_create_shared (struct eventlogger *parent,
+                                               double timeout,
+                                               struct eventlogger_ops *ops,
+                                               void *arg)
+{
+    struct eventlogger *ev;
+
+    if (!parent || !ops) {
+        errno = EINVAL;
+        return NULL;
+    }
+    if ((ev = eventlogger_new (parent->shared, timeout, ops, arg)))
+        parent->shared->usecount++;
+    return ev;
+}
+
 static struct eventlog_batch * eventlog_batch_get (struct eventlogger *ev)
 {
-    struct eventlog_batch *batch = ev->current;
+    struct eventlog_txn *shared = ev->shared;
+    struct eventlog_batch *batch = shared->current;
+
     if (!batch) {
-        if (!(ev->current = eventlog_batch_create (ev)))
+        if (!(batch = eventlog_batch_create (shared)))
+            return NULL;
+        if (zlist_append (shared->pending, batch) < 0) {
+            eventlog_batch_destroy (batch);
+            errno = ENOMEM;
             return NULL;
-        batch = ev->current;
-        eventlogger_batch_start (ev, batch);
+        }
+        zlist_freefn (shared->pending,
+                      batch,
+                      (zlist_free_fn *) eventlog_batch_destroy,
+                      true);
+        shared->current = batch;
     }
+    if (eventlogger_batch_join (ev, batch) < 0)
+        return NULL;
     return batch;
 }
 
@@ -194,10 +411,11 @@ static int append_wait (struct eventlogger *ev,
     if (!batch)
         return -1;
 
-    if (flux_kvs_txn_put (ev->current->txn,
+    if (flux_kvs_txn_put (batch->txn,
                           FLUX_KVS_APPEND,
                           path, entrystr) < 0)
         return -1;
+    ev->shared->appends++;
 
     return eventlogger_flush (ev);
 }
@@ -208,22 +426,31 @@ static int append_async (struct eventlogger *ev,
                          const char *entrystr)
 {
     struct eventlog_batch *batch = eventlog_batch_get (ev);
+    struct batch_entry *be;
 
     if (!batch)
         return -1;
-    if (flux_kvs_txn_put (ev->current->txn,
+    if (flux_kvs_txn_put (batch->txn,
                           FLUX_KVS_APPEND,
                           path,
                           entrystr) < 0)
             return -1;
+    ev->shared->appends++;
 
-    if (zlist_append (batch->entries, entry) < 0)
+    if (!(be = calloc (1, sizeof (*be))))
+        return -1;
+    be->ev = ev;
+    be->entry = json_incref (entry);
+    if (zlist_append (batch->entries, be) < 0) {
+        batch_entry_destroy (be);
+        errno = ENOMEM;
         return -1;
-    json_incref (entry);
+    }
     zlist_freefn (batch->entries,
-                  entry,
-                  (zlist_free_fn *) json_decref,
+                  be,
+                  (zlist_free_fn *) batch_entry_destroy,
                   true);
+    eventlog_batch_arm (batch, ev);
     return 0;
 }
 
@@ -267,25 +494,64 @@ int eventlogger_flush (struct eventlogger *ev)
 {
     int rc = -1;
     flux_future_t *f = NULL;
+    struct eventlog_txn *shared = ev->shared;
     struct eventlog_batch *batch;
+    flux_reactor_t *r = flux_get_reactor (shared->h);
     int flags = FLUX_KVS_TXN_COMPACT;
 
-    if (!(batch = eventlog_batch_get (ev)))
-        return -1;
-
-    if (!(f = flux_kvs_commit (ev->h, NULL, flags, ev->current->txn))
-        || flux_future_wait_for (f, ev->commit_timeout) < 0)
+    if (!(batch = shared->current))
+        return 0;
+
+    flux_watcher_stop (batch->timer);
+    batch->t_commit = flux_reactor_now (r);
+    if (!(f = flux_kvs_commit (shared->h, NULL, flags, batch->txn))
+        || flux_future_wait_for (f,
+                                 eventlog_batch_commit_timeout (batch)) < 0) {
+        /*  The batch timer is stopped, so the batch would never be
+         *   committed if left current.  Fail it now.
+         */
+        int saved_errno = errno;
+        eventlog_batch_error (batch, errno);
+        eventlogger_batch_complete (shared, batch);
+        errno = saved_errno;
         goto out;
+    }
     if ((rc = flux_future_get (f, NULL)) < 0)
         eventlog_batch_error (batch, errno);
-
-    eventlogger_batch_complete (ev, ev->current);
-    ev->current = NULL;
+    shared->commits++;
+    shared->sync_commits++;
+    flux_reactor_now_update (r);
+    eventlog_txn_update_latency (shared, flux_reactor_now (r) - batch->t_commit);
+    eventlogger_batch_complete (shared, batch);
 out:
     flux_future_destroy (f);
     return rc;
 }
 
+json_t *eventlogger_stats (struct eventlogger *ev)
+{
+    struct eventlog_txn *shared;
+    json_t *o;
+
+    if (!ev) {
+        errno = EINVAL;
+        return NULL;
+    }
+    shared = ev->shared;
+    if (!(o = json_pack ("{s:i s:i s:i s:i s:i s:f s:f}",
+                         "appends", shared->appends,
+                         "commits", shared->commits,
+                         "sync-commits", shared->sync_commits,
+                         "errors", shared->errors,
+                         "pending", (int) zlist_size (shared->pending),
+                         "latency", shared->latency,
+                         "max-latency", shared->max_latency))) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return o;
+}
+
 /*
  * vi:tabstop=4 shiftwidth=4 expandtab
  */
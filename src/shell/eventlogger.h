@@ -45,6 +45,15 @@ struct eventlogger *eventlogger_create (flux_t *h,
                                         struct eventlogger_ops *ops,
                                         void *arg);
 
+/*  Create an eventlogger that shares batches, and thus KVS transactions,
+ *   with 'parent' and any other eventloggers created from it.  The new
+ *   eventlogger has its own callbacks and batch timeout.
+ */
+struct eventlogger *eventlogger_create_shared (struct eventlogger *parent,
+                                               double timeout,
+                                               struct eventlogger_ops *ops,
+                                               void *arg);
+
 void eventlogger_destroy (struct eventlogger *ev);
 
 int eventlogger_append (struct eventlogger *ev,
@@ -62,6 +71,12 @@ int eventlogger_set_commit_timeout (struct eventlogger *ev, double timeout);
 
 int eventlogger_flush (struct eventlogger *ev);
 
+/*  Return counters for the batches shared by 'ev' as a JSON object:
+ *   {"appends":i, "commits":i, "sync-commits":i, "errors":i, "pending":i,
+ *    "latency":f, "max-latency":f}
+ */
+json_t *eventlogger_stats (struct eventlogger *ev);
+
 #ifdef __cplusplus
 }
 #endif
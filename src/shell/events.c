@@ -10,6 +10,11 @@
 
 /*  Shell exec.eventlog event emitter
  *  Allows context for shell events to be added from multiple sources.
+ *
+ *  The eventlogger of the emitter is also shared with other shell
+ *   components (output, input, log messages), so that their appends
+ *   to the guest namespace are coalesced into as few KVS transactions
+ *   as possible.
  */
 
 #if HAVE_CONFIG_H
@@ -78,6 +83,36 @@ struct shell_eventlogger *shell_eventlogger_create (flux_shell_t *shell)
     return shev;
 }
 
+struct eventlogger *shell_eventlogger_share (struct shell_eventlogger *shev,
+                                             double timeout,
+                                             struct eventlogger_ops *ops,
+                                             void *arg)
+{
+    if (!shev) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return eventlogger_create_shared (shev->ev, timeout, ops, arg);
+}
+
+int shell_eventlogger_flush (struct shell_eventlogger *shev)
+{
+    if (!shev) {
+        errno = EINVAL;
+        return -1;
+    }
+    return eventlogger_flush (shev->ev);
+}
+
+json_t *shell_eventlogger_stats (struct shell_eventlogger *shev)
+{
+    if (!shev) {
+        errno = EINVAL;
+        return NULL;
+    }
+    return eventlogger_stats (shev->ev);
+}
+
 int shell_eventlogger_emit_event (struct shell_eventlogger *shev,
                                   int flags,
                                   const char *event)
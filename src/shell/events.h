@@ -11,6 +11,8 @@
 #ifndef _SHELL_EVENTS_H
 #define _SHELL_EVENTS_H
 
+#include "eventlogger.h"
+
 struct shell_eventlogger;
 
 void shell_eventlogger_destroy (struct shell_eventlogger *shev);
@@ -20,6 +22,20 @@ int shell_eventlogger_emit_event (struct shell_eventlogger *shev,
                                   int flags,
                                   const char *event);
 
+/*  Create an eventlogger for another shell component that commits its
+ *   appends in the same KVS transactions as shell events.
+ */
+struct eventlogger *shell_eventlogger_share (struct shell_eventlogger *shev,
+                                             double timeout,
+                                             struct eventlogger_ops *ops,
+                                             void *arg);
+
+/*  Synchronously commit appends pending in shared eventloggers.
+ */
+int shell_eventlogger_flush (struct shell_eventlogger *shev);
+
+json_t *shell_eventlogger_stats (struct shell_eventlogger *shev);
+
 int shell_eventlogger_context_vpack (struct shell_eventlogger *shev,
                                      const char *event,
                                      int flags,
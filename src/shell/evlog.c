@@ -109,7 +109,6 @@ static void evlog_error (struct eventlogger *ev, int errnum, json_t *entry)
 
 static struct evlog *evlog_create (flux_shell_t *shell)
 {
-    flux_t *h = flux_shell_get_flux (shell);
     struct eventlogger_ops ops = {
         .busy = evlog_ref,
         .idle = evlog_unref,
@@ -117,11 +116,16 @@ static struct evlog *evlog_create (flux_shell_t *shell)
     };
     struct evlog *evlog = calloc (1, sizeof (*evlog));
 
-    if (h == NULL) {
-        fprintf (stderr, "evlog_create failure due to no handle\n");
+    if (shell->ev == NULL) {
+        fprintf (stderr, "evlog_create failure due to no eventlogger\n");
+        free (evlog);
         return NULL;
     }
-    if (!evlog || !(evlog->ev = eventlogger_create (h, 0.01, &ops, evlog)))
+    if (!evlog
+        || !(evlog->ev = shell_eventlogger_share (shell->ev,
+                                                  0.01,
+                                                  &ops,
+                                                  evlog)))
         goto err;
     eventlogger_set_commit_timeout (evlog->ev, 5.);
     evlog->level = FLUX_SHELL_NOTICE + shell->verbose;
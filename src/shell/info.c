@@ -85,6 +85,42 @@ static flux_future_t *lookup_job_info (flux_t *h,
     return f;
 }
 
+/* Fetch jobspec and R from the job-exec.info service, which is answered
+ * by the local broker from a per-broker cache, so that a job does not
+ * send one job-info.lookup per shell to rank 0.  Assign whichever of
+ * *jobspec and *R is NULL.  Return future on success, or NULL on failure
+ * so that the caller may fall back to lookup_job_info().
+ * N.B. assigned values remain valid until future is destroyed.
+ */
+static flux_future_t *exec_job_info (flux_t *h,
+                                     flux_jobid_t jobid,
+                                     const char **jobspec,
+                                     const char **R)
+{
+    flux_future_t *f;
+    const char *s_jobspec;
+    const char *s_R;
+
+    if (!(f = flux_rpc_pack (h,
+                             "job-exec.info",
+                             FLUX_NODEID_ANY,
+                             0,
+                             "{s:I}",
+                             "id", jobid))
+        || flux_rpc_get_unpack (f, "{s:s s:s}",
+                                "jobspec", &s_jobspec,
+                                "R", &s_R) < 0) {
+        shell_debug ("job-exec.info: %s", future_strerror (f, errno));
+        flux_future_destroy (f);
+        return NULL;
+    }
+    if (!*jobspec)
+        *jobspec = s_jobspec;
+    if (!*R)
+        *R = s_R;
+    return f;
+}
+
 /* Read content of file 'optarg' and return it or NULL on failure (log error).
  * Caller must free returned result.
  */
@@ -137,13 +173,14 @@ static int shell_init_jobinfo (flux_shell_t *shell,
     json_error_t error;
 
     if (!R || !jobspec) {
-        /* Fetch missing jobinfo from broker job-info service */
+        /* Fetch missing jobinfo from job-exec, or job-info service */
         if (shell->standalone) {
             shell_log_error ("Invalid arguments: standalone and R/jobspec are unset");
             return -1;
         }
-        if (!(f = lookup_job_info (shell->h, shell->jobid, jobspec, R))
-                || lookup_job_info_get (f, &jobspec, &R) < 0)
+        if (!(f = exec_job_info (shell->h, shell->jobid, &jobspec, &R))
+            && (!(f = lookup_job_info (shell->h, shell->jobid, jobspec, R))
+                || lookup_job_info_get (f, &jobspec, &R) < 0))
             goto out;
     }
     if (!(info->jobspec = jobspec_parse (jobspec, &error))) {
@@ -10,9 +10,33 @@
 
 /* std input handling
  *
- * Depending on inputs from user, a service is started to receive
- * stdin from front-end command or file is read for redirected
- * standard input.
+ * Depending on inputs from user, a service is started on the leader
+ * shell to receive stdin from front-end command or file is read for
+ * redirected standard input.
+ *
+ * The leader records input in the guest.input eventlog per RFC24
+ * (unless input.kvs=false) and broadcasts each chunk of input to the
+ * other shells through a k-ary tree over shell ranks (input.fanout,
+ * default 16).  Each shell forwards a chunk to the "input" service of
+ * its children and writes it to the stdin of its local tasks named by
+ * the chunk's rank idset.
+ *
+ * Notes:
+ * - A shell answers a chunk request only once its local tasks have
+ *   accepted the data (or exited) and its children have answered, so
+ *   back pressure from slow tasks propagates up the tree.  The leader
+ *   keeps at most shell_input_window chunks of file input in flight.
+ * - Data a task's subprocess buffer cannot take yet stays queued on
+ *   that task only, and is retried on a timer.
+ * - Chunks received by the leader before the init barrier are held
+ *   until "shell.start", when all shells have registered their services.
+ * - A shell with children holds an "input.forward" completion reference
+ *   while any child may still need input relayed.  A child is done once
+ *   it has acknowledged EOF, failed a request, or reported that it is
+ *   exiting.  After this shell's tasks exit, remaining children are
+ *   probed periodically, so a child that died without reporting its exit
+ *   does not hold this shell up.
+ * - stdin is not supported in standalone mode.
  */
 
 #if HAVE_CONFIG_H
@@ -20,16 +44,19 @@
 #endif
 #include <stdio.h>
 #include <string.h>
+#include <czmq.h>
 #include <flux/core.h>
 
 #include "src/common/libidset/idset.h"
 #include "src/common/libeventlog/eventlog.h"
 #include "src/common/libioencode/ioencode.h"
+#include "src/common/libutil/kary.h"
 
 #include "task.h"
 #include "svc.h"
 #include "internal.h"
 #include "builtins.h"
+#include "eventlogger.h"
 
 struct shell_input;
 
@@ -39,21 +66,26 @@ enum {
     FLUX_INPUT_TYPE_FILE = 2,
 };
 
-/* how input will reach each task */
-enum {
-    FLUX_TASK_INPUT_KVS = 1,
-};
-
-struct shell_task_input_kvs {
-    flux_future_t *input_f;
-    bool input_header_parsed;
+/* One chunk of input, shared by the tasks and children it is sent to.
+ */
+struct input_chunk {
+    struct shell_input *in;
+    json_t *context;            /* RFC24 data event context */
+    const flux_msg_t *msg;      /* request to answer when done, or NULL */
+    int pending;                /* tasks + children + self */
+    struct idset *ranks;        /* NULL == "all" */
+    char *data;
+    int len;
+    bool eof;
 };
 
 struct shell_task_input {
     struct shell_input *in;
     struct shell_task *task;
-    int type;
-    struct shell_task_input_kvs input_kvs;
+    zlist_t *queue;             /* chunks not yet written to task */
+    int offset;                 /* bytes of first chunk already written */
+    bool started;
+    bool closed;
 };
 
 struct shell_input_type_file {
@@ -61,6 +93,7 @@ struct shell_input_type_file {
     int fd;
     flux_watcher_t *w;
     char *rankstr;
+    bool eof;
 };
 
 struct shell_input {
@@ -69,92 +102,358 @@ struct shell_input {
     struct shell_task_input *task_inputs;
     int ntasks;
     struct shell_input_type_file stdin_file;
+    struct eventlogger *ev;
+    bool kvs;
+    int fanout;
+    int nchildren;
+    bool *child_done;
+    int children_active;
+    int tasks_active;
+    flux_watcher_t *probe;
+    int probes_inflight;
+    bool started;
+    zlist_t *deferred;          /* leader: chunks received before start */
+    int inflight;               /* leader: file chunks in flight */
+    flux_watcher_t *retry;
+    bool retry_armed;
+};
+
+static const int shell_input_window = 4;
+static const int shell_input_fanout = 16;
+static const double shell_input_retry = 0.01;
+static const double shell_input_probe = 1.;
+
+/* A request sent to one child shell.
+ */
+struct input_child_rpc {
+    struct shell_input *in;
+    struct input_chunk *c;      /* chunk forwarded, or NULL for a probe */
+    int child;                  /* index of child */
 };
 
-static void shell_task_input_kvs_cleanup (struct shell_task_input_kvs *kp)
+static void input_chunk_destroy (struct input_chunk *c)
 {
-    flux_future_destroy (kp->input_f);
-    kp->input_f = NULL;
+    if (c) {
+        int saved_errno = errno;
+        json_decref (c->context);
+        flux_msg_decref (c->msg);
+        idset_destroy (c->ranks);
+        free (c->data);
+        free (c);
+        errno = saved_errno;
+    }
 }
 
-static void shell_task_input_cleanup (struct shell_task_input *tp)
+static struct input_chunk *input_chunk_create (struct shell_input *in,
+                                               json_t *context,
+                                               const flux_msg_t *msg)
 {
-    shell_task_input_kvs_cleanup (&(tp->input_kvs));
+    struct input_chunk *c;
+    const char *rank;
+
+    if (!(c = calloc (1, sizeof (*c))))
+        return NULL;
+    c->in = in;
+    c->context = json_incref (context);
+    c->pending = 1;
+    if (iodecode (context, NULL, &rank, &c->data, &c->len, &c->eof) < 0)
+        goto error;
+    if (strcmp (rank, "all") != 0 && !(c->ranks = idset_decode (rank)))
+        goto error;
+    if (msg)
+        c->msg = flux_msg_incref (msg);
+    return c;
+error:
+    input_chunk_destroy (c);
+    return NULL;
 }
 
-static void shell_input_type_file_cleanup (struct shell_input_type_file *fp)
+static void input_chunk_release (struct input_chunk *c)
 {
-    close (fp->fd);
-    flux_watcher_destroy (fp->w);
-    free (fp->rankstr);
+    struct shell_input *in = c->in;
+
+    if (--c->pending > 0)
+        return;
+    if (c->msg) {
+        if (flux_respond (in->shell->h, c->msg, NULL) < 0)
+            shell_log_errno ("flux_respond");
+    }
+    else {
+        struct shell_input_type_file *fp = &in->stdin_file;
+        if (--in->inflight < shell_input_window && !fp->eof && fp->w)
+            flux_watcher_start (fp->w);
+    }
+    input_chunk_destroy (c);
 }
 
-void shell_input_destroy (struct shell_input *in)
+static void shell_task_input_close (struct shell_task_input *ti)
 {
-    if (in) {
-        int saved_errno = errno;
-        int i;
-        shell_input_type_file_cleanup (&(in->stdin_file));
-        for (i = 0; i < in->ntasks; i++)
-            shell_task_input_cleanup (&(in->task_inputs[i]));
-        free (in->task_inputs);
-        free (in);
-        errno = saved_errno;
+    struct input_chunk *c;
+
+    ti->closed = true;
+    ti->offset = 0;
+    while ((c = zlist_pop (ti->queue)))
+        input_chunk_release (c);
+}
+
+static void shell_input_retry_start (struct shell_input *in)
+{
+    if (!in->retry_armed) {
+        flux_timer_watcher_reset (in->retry, shell_input_retry, 0.);
+        flux_watcher_start (in->retry);
+        in->retry_armed = true;
+    }
+}
+
+/* Write as much queued input to task as its stdin buffer will take.
+ */
+static void shell_task_input_drain (struct shell_task_input *ti)
+{
+    struct input_chunk *c;
+    int n;
+
+    if (!ti->started)
+        return;
+    while ((c = zlist_first (ti->queue))) {
+        if (ti->offset < c->len) {
+            n = flux_subprocess_write (ti->task->proc,
+                                       "stdin",
+                                       c->data + ti->offset,
+                                       c->len - ti->offset);
+            if (n < 0) {
+                if (errno == ENOSPC) {
+                    shell_input_retry_start (ti->in);
+                    return;
+                }
+                if (errno != EPIPE)
+                    shell_log_errno ("flux_subprocess_write %d", ti->task->rank);
+                shell_task_input_close (ti);
+                return;
+            }
+            ti->offset += n;
+            if (ti->offset < c->len) {
+                shell_input_retry_start (ti->in);
+                return;
+            }
+        }
+        zlist_remove (ti->queue, c);
+        ti->offset = 0;
+        if (c->eof) {
+            if (flux_subprocess_close (ti->task->proc, "stdin") < 0)
+                shell_log_errno ("flux_subprocess_close %d", ti->task->rank);
+            input_chunk_release (c);
+            shell_task_input_close (ti);
+            return;
+        }
+        input_chunk_release (c);
     }
 }
 
-static void shell_input_put_kvs_completion (flux_future_t *f, void *arg)
+static void shell_input_retry_cb (flux_reactor_t *r,
+                                  flux_watcher_t *w,
+                                  int revents,
+                                  void *arg)
 {
     struct shell_input *in = arg;
+    int i;
 
-    if (flux_future_get (f, NULL) < 0)
-        /* failng to write stdin to input is a fatal error */
-        shell_die (1, "shell_input_put_kvs: %s", strerror (errno));
+    in->retry_armed = false;
+    for (i = 0; i < in->ntasks; i++)
+        shell_task_input_drain (&in->task_inputs[i]);
+}
+
+static void shell_task_input_push (struct shell_task_input *ti,
+                                   struct input_chunk *c)
+{
+    if (ti->closed)
+        return;
+    if (zlist_append (ti->queue, c) < 0)
+        shell_die (1, "zlist_append: out of memory");
+    c->pending++;
+    shell_task_input_drain (ti);
+}
+
+/* Child shell at index 'child' no longer needs input from this shell.
+ */
+static void shell_input_child_done (struct shell_input *in, int child)
+{
+    if (in->child_done[child])
+        return;
+    in->child_done[child] = true;
+    if (--in->children_active == 0) {
+        flux_watcher_stop (in->probe);
+        flux_shell_remove_completion_ref (in->shell, "input.forward");
+    }
+}
+
+static void input_child_continuation (flux_future_t *f, void *arg)
+{
+    struct input_child_rpc *rpc = arg;
+    struct shell_input *in = rpc->in;
+    struct input_chunk *c = rpc->c;
+
+    /* A child that has exited no longer needs input, so errors are
+     * not passed up the tree.  A child that acknowledged EOF will not
+     * be sent anything more.
+     */
+    if (flux_future_get (f, NULL) < 0) {
+        shell_debug ("input %s to child %d: %s",
+                     c ? "forward" : "probe",
+                     rpc->child,
+                     future_strerror (f, errno));
+        shell_input_child_done (in, rpc->child);
+    }
+    else if (c && c->eof)
+        shell_input_child_done (in, rpc->child);
+    flux_future_destroy (f);
+    free (rpc);
+    if (c)
+        input_chunk_release (c);
+    else
+        in->probes_inflight--;
+}
+
+/* Send chunk 'c' to the input service of a child, or if c is NULL,
+ * probe that the child is still running.
+ */
+static int shell_input_child_rpc (struct shell_input *in,
+                                  int child,
+                                  const char *method,
+                                  struct input_chunk *c)
+{
+    struct shell_info *info = in->shell->info;
+    struct input_child_rpc *rpc;
+    flux_future_t *f = NULL;
+    uint32_t rank;
+
+    rank = kary_childof (in->fanout, info->shell_size, info->shell_rank, child);
+    if (!(rpc = calloc (1, sizeof (*rpc))))
+        goto error;
+    rpc->in = in;
+    rpc->c = c;
+    rpc->child = child;
+    if (c)
+        f = flux_shell_rpc_pack (in->shell, method, rank, 0, "O", c->context);
+    else
+        f = flux_shell_rpc_pack (in->shell, method, rank, 0, "{}");
+    if (!f || flux_future_then (f, -1., input_child_continuation, rpc) < 0)
+        goto error;
+    if (c)
+        c->pending++;
+    else
+        in->probes_inflight++;
+    return 0;
+error:
+    shell_log_errno ("input %s to shell rank %u", method, rank);
     flux_future_destroy (f);
+    free (rpc);
+    return -1;
+}
+
+/* Send chunk to the children of this shell and queue it on local tasks.
+ */
+static void input_chunk_dispatch (struct input_chunk *c)
+{
+    struct shell_input *in = c->in;
+    struct shell_info *info = in->shell->info;
+    int i;
 
-    if (flux_shell_remove_completion_ref (in->shell, "input.kvs") < 0)
-        shell_log_errno ("flux_shell_remove_completion_ref");
+    for (i = 0; i < in->nchildren; i++) {
+        if (in->child_done[i])
+            continue;
+        if (shell_input_child_rpc (in, i, "input", c) < 0)
+            shell_input_child_done (in, i);
+    }
+    for (i = 0; i < in->ntasks; i++) {
+        int rank = info->rankinfo.global_basis + i;
+        if (!c->ranks || idset_test (c->ranks, rank))
+            shell_task_input_push (&in->task_inputs[i], c);
+    }
+    input_chunk_release (c);
+}
+
+static void shell_input_submit (struct shell_input *in,
+                                struct input_chunk *c)
+{
+    if (!in->started) {
+        if (zlist_append (in->deferred, c) < 0)
+            shell_die (1, "zlist_append: out of memory");
+        return;
+    }
+    input_chunk_dispatch (c);
 }
 
 static int shell_input_put_kvs (struct shell_input *in, json_t *context)
 {
-    flux_kvs_txn_t *txn = NULL;
-    flux_future_t *f = NULL;
     json_t *entry = NULL;
-    char *entrystr = NULL;
     int saved_errno;
     int rc = -1;
 
     if (!(entry = eventlog_entry_pack (0.0, "data", "O", context)))
         goto error;
-    if (!(entrystr = eventlog_entry_encode (entry)))
-        goto error;
-    if (!(txn = flux_kvs_txn_create ()))
-        goto error;
-    if (flux_kvs_txn_put (txn, FLUX_KVS_APPEND, "input", entrystr) < 0)
-        goto error;
-    if (!(f = flux_kvs_commit (in->shell->h, NULL, 0, txn)))
+    if (eventlogger_append_entry (in->ev, 0, "input", entry) < 0)
         goto error;
-    if (flux_future_then (f, -1, shell_input_put_kvs_completion, in) < 0)
-        goto error;
-    if (flux_shell_add_completion_ref (in->shell, "input.kvs") < 0) {
-        shell_log_errno ("flux_shell_remove_completion_ref");
-        goto error;
-    }
-    /* f memory responsibility of shell_input_put_kvs_completion()
-     * callback */
-    f = NULL;
     rc = 0;
  error:
     saved_errno = errno;
-    flux_kvs_txn_destroy (txn);
-    free (entrystr);
     json_decref (entry);
-    flux_future_destroy (f);
     errno = saved_errno;
     return rc;
 }
 
+/* Drop a reference on chunk without answering it, at shell exit.
+ */
+static void input_chunk_drop (struct input_chunk *c)
+{
+    if (--c->pending == 0)
+        input_chunk_destroy (c);
+}
+
+static void shell_task_input_cleanup (struct shell_task_input *tp)
+{
+    struct input_chunk *c;
+
+    if (tp->queue) {
+        while ((c = zlist_pop (tp->queue)))
+            input_chunk_drop (c);
+        zlist_destroy (&tp->queue);
+    }
+}
+
+static void shell_input_type_file_cleanup (struct shell_input_type_file *fp)
+{
+    close (fp->fd);
+    flux_watcher_destroy (fp->w);
+    fp->w = NULL;
+    free (fp->rankstr);
+}
+
+void shell_input_destroy (struct shell_input *in)
+{
+    if (in) {
+        int saved_errno = errno;
+        int i;
+        shell_input_type_file_cleanup (&(in->stdin_file));
+        if (in->task_inputs) {
+            for (i = 0; i < in->ntasks; i++)
+                shell_task_input_cleanup (&(in->task_inputs[i]));
+        }
+        free (in->task_inputs);
+        if (in->deferred) {
+            struct input_chunk *c;
+            while ((c = zlist_pop (in->deferred)))
+                input_chunk_drop (c);
+            zlist_destroy (&in->deferred);
+        }
+        flux_watcher_destroy (in->retry);
+        flux_watcher_destroy (in->probe);
+        free (in->child_done);
+        eventlogger_destroy (in->ev);
+        free (in);
+        errno = saved_errno;
+    }
+}
+
 /* Convert 'iodecode' object to an valid RFC 24 data event.
  * N.B. the iodecode object is a valid "context" for the event.
  */
@@ -164,25 +463,107 @@ static void shell_input_stdin_cb (flux_t *h,
                                   void *arg)
 {
     struct shell_input *in = arg;
-    bool eof = false;
+    struct input_chunk *c;
     json_t *o;
 
     if (flux_request_unpack (msg, NULL, "o", &o) < 0)
         goto error;
-    if (iodecode (o, NULL, NULL, NULL, NULL, &eof) < 0)
+    if (!(c = input_chunk_create (in, o, msg)))
         goto error;
-    if (shell_input_put_kvs (in, o) < 0)
+    if (in->kvs && shell_input_put_kvs (in, o) < 0) {
+        input_chunk_destroy (c);
         goto error;
-    if (eof)
+    }
+    if (c->eof)
         flux_msg_handler_stop (mh);
-    if (flux_respond (in->shell->h, msg, NULL) < 0)
+    shell_input_submit (in, c);
+    return;
+error:
+    if (flux_respond_error (in->shell->h, msg, errno, NULL) < 0)
         shell_log_errno ("flux_respond");
+}
+
+/* Chunk of input from parent shell.
+ */
+static void shell_input_forward_cb (flux_t *h,
+                                    flux_msg_handler_t *mh,
+                                    const flux_msg_t *msg,
+                                    void *arg)
+{
+    struct shell_input *in = arg;
+    struct input_chunk *c;
+    json_t *o;
+
+    if (flux_request_unpack (msg, NULL, "o", &o) < 0)
+        goto error;
+    if (!(c = input_chunk_create (in, o, msg)))
+        goto error;
+    input_chunk_dispatch (c);
     return;
 error:
     if (flux_respond_error (in->shell->h, msg, errno, NULL) < 0)
         shell_log_errno ("flux_respond");
 }
 
+/* Probe from parent shell.
+ */
+static void shell_input_probe_cb (flux_t *h,
+                                  flux_msg_handler_t *mh,
+                                  const flux_msg_t *msg,
+                                  void *arg)
+{
+    if (flux_respond (h, msg, NULL) < 0)
+        shell_log_errno ("flux_respond");
+}
+
+/* A child shell is exiting.
+ */
+static void shell_input_exit_cb (flux_t *h,
+                                 flux_msg_handler_t *mh,
+                                 const flux_msg_t *msg,
+                                 void *arg)
+{
+    struct shell_input *in = arg;
+    struct shell_info *info = in->shell->info;
+    int rank;
+    int i;
+
+    if (flux_request_unpack (msg, NULL, "{s:i}", "rank", &rank) < 0) {
+        shell_log_errno ("input-exit");
+        return;
+    }
+    for (i = 0; i < in->nchildren; i++) {
+        if (kary_childof (in->fanout,
+                          info->shell_size,
+                          info->shell_rank,
+                          i) == (uint32_t) rank) {
+            shell_input_child_done (in, i);
+            return;
+        }
+    }
+    shell_log_error ("input-exit from unexpected shell rank %d", rank);
+}
+
+/* Probe children that have not yet reported that they are done.  Each
+ * round is sent only after the previous one has been answered.
+ */
+static void shell_input_probe_timer_cb (flux_reactor_t *r,
+                                        flux_watcher_t *w,
+                                        int revents,
+                                        void *arg)
+{
+    struct shell_input *in = arg;
+    int i;
+
+    if (in->probes_inflight > 0)
+        return;
+    for (i = 0; i < in->nchildren; i++) {
+        if (!in->child_done[i]
+            && shell_input_child_rpc (in, i, "input-probe", NULL) < 0)
+            shell_input_child_done (in, i);
+    }
+}
+
 static void shell_input_type_file_init (struct shell_input *in)
 {
     struct shell_input_type_file *fp = &(in->stdin_file);
@@ -192,8 +573,19 @@ static void shell_input_type_file_init (struct shell_input *in)
 static int shell_input_parse_type (struct shell_input *in)
 {
     const char *typestr = NULL;
+    int kvs = 1;
     int ret;
 
+    in->fanout = shell_input_fanout;
+    if (flux_shell_getopt_unpack (in->shell, "input",
+                                  "{s?i s?b}",
+                                  "fanout", &in->fanout,
+                                  "kvs", &kvs) < 0)
+        return shell_log_errno ("invalid input.fanout or input.kvs option");
+    if (in->fanout < 1)
+        return shell_log_errn (EINVAL, "invalid input.fanout %d", in->fanout);
+    in->kvs = kvs ? true : false;
+
     if ((ret = flux_shell_getopt_unpack (in->shell, "input",
                                          "{s?:{s?:s}}",
                                          "stdin", "type", &typestr)) < 0)
@@ -224,37 +616,44 @@ static int shell_input_parse_type (struct shell_input *in)
     return 0;
 }
 
+/* The header is committed with other shell eventlog appends made during
+ * shell initialization, which are flushed before the init barrier, so
+ * guest.input exists before any data is appended to it.
+ */
 static int shell_input_kvs_init (struct shell_input *in, json_t *header)
 {
-    flux_kvs_txn_t *txn = NULL;
-    flux_future_t *f = NULL;
-    char *headerstr = NULL;
-    int saved_errno;
-    int rc = -1;
+    return eventlogger_append_entry (in->ev, 0, "input", header);
+}
 
-    if (!(headerstr = eventlog_entry_encode (header)))
-        goto error;
-    if (!(txn = flux_kvs_txn_create ()))
-        goto error;
-    if (flux_kvs_txn_put (txn, FLUX_KVS_APPEND, "input", headerstr) < 0)
-        goto error;
-    if (!(f = flux_kvs_commit (in->shell->h, NULL, 0, txn)))
-        goto error;
-    /* Synchronously wait for kvs commit to complete to ensure
-     * guest.input exists before passing shell initialization barrier.
-     * This is required because tasks will immediately try to watch
-     * input eventlog on starting.
-     */
-    if (flux_future_get (f, NULL) < 0)
-        shell_die_errno (1, "failed to create input eventlog");
-    rc = 0;
- error:
-    saved_errno = errno;
-    flux_kvs_txn_destroy (txn);
-    free (headerstr);
-    flux_future_destroy (f);
-    errno = saved_errno;
-    return rc;
+static void input_ref (struct eventlogger *ev, void *arg)
+{
+    struct shell_input *in = arg;
+    flux_shell_add_completion_ref (in->shell, "input.kvs");
+}
+
+static void input_unref (struct eventlogger *ev, void *arg)
+{
+    struct shell_input *in = arg;
+    flux_shell_remove_completion_ref (in->shell, "input.kvs");
+}
+
+static void input_error (struct eventlogger *ev, int errnum, json_t *entry)
+{
+    /* failing to write stdin to input is a fatal error */
+    shell_die (1, "shell_input_put_kvs: %s", strerror (errnum));
+}
+
+static int shell_input_eventlogger_start (struct shell_input *in)
+{
+    struct eventlogger_ops ops = {
+        .busy = input_ref,
+        .idle = input_unref,
+        .err = input_error
+    };
+
+    if (!(in->ev = shell_eventlogger_share (in->shell->ev, 0.01, &ops, in)))
+        return shell_log_errno ("shell_eventlogger_share");
+    return 0;
 }
 
 static int shell_input_header (struct shell_input *in)
@@ -284,27 +683,6 @@ static int shell_input_header (struct shell_input *in)
     return rc;
 }
 
-static int shell_input_put_kvs_raw (struct shell_input *in,
-                                    void *buf,
-                                    int len,
-                                    bool eof)
-{
-    json_t *context = NULL;
-    int saved_errno;
-    int rc = -1;
-
-    if (!(context = ioencode ("stdin", in->stdin_file.rankstr, buf, len, eof)))
-        goto error;
-    if (shell_input_put_kvs (in, context) < 0)
-        goto error;
-    rc = 0;
- error:
-    saved_errno = errno;
-    json_decref (context);
-    errno = saved_errno;
-    return rc;
-}
-
 static void shell_input_type_file_cb (flux_reactor_t *r, flux_watcher_t *w,
                                       int revents, void *arg)
 {
@@ -312,6 +690,8 @@ static void shell_input_type_file_cb (flux_reactor_t *r, flux_watcher_t *w,
     struct shell_input_type_file *fp = &(in->stdin_file);
     long ps = sysconf (_SC_PAGESIZE);
     char buf[ps];
+    struct input_chunk *c;
+    json_t *context;
     ssize_t n;
 
     assert (ps > 0);
@@ -319,18 +699,26 @@ static void shell_input_type_file_cb (flux_reactor_t *r, flux_watcher_t *w,
     /* Failure to read stdin in a fatal error.  Should be cleaner in
      * future.  Issue #2378 */
 
-    while ((n = read (fp->fd, buf, ps)) > 0) {
-        if (shell_input_put_kvs_raw (in, buf, n, false) < 0)
-            shell_die_errno (1, "shell_input_put_kvs_raw");
-    }
-
-    if (n < 0)
-        shell_die_errno (1, "shell_input_put_kvs_raw");
-
-    if (shell_input_put_kvs_raw (in, NULL, 0, true) < 0)
-        shell_die_errno (1, "shell_input_put_kvs_raw");
+    if ((n = read (fp->fd, buf, ps)) < 0)
+        shell_die_errno (1, "error reading input file '%s'", fp->path);
+    if (!(context = ioencode ("stdin",
+                              fp->rankstr,
+                              n > 0 ? buf : NULL,
+                              n,
+                              n == 0)))
+        shell_die_errno (1, "ioencode");
+    if (in->kvs && shell_input_put_kvs (in, context) < 0)
+        shell_die_errno (1, "shell_input_put_kvs");
+    if (!(c = input_chunk_create (in, context, NULL)))
+        shell_die_errno (1, "input_chunk_create");
+    json_decref (context);
 
-    flux_watcher_stop (w);
+    in->inflight++;
+    if (n == 0)
+        fp->eof = true;
+    if (fp->eof || in->inflight >= shell_input_window)
+        flux_watcher_stop (w);
+    input_chunk_dispatch (c);
 }
 
 static int shell_input_type_file_setup (struct shell_input *in)
@@ -348,7 +736,7 @@ static int shell_input_type_file_setup (struct shell_input *in)
 
     if (in->shell->info->total_ntasks > 1) {
         if (asprintf (&fp->rankstr, "[0-%d]",
-                      in->shell->info->total_ntasks) < 0)
+                      in->shell->info->total_ntasks - 1) < 0)
             return shell_log_errno ("asprintf");
     }
     else {
@@ -359,6 +747,53 @@ static int shell_input_type_file_setup (struct shell_input *in)
     return 0;
 }
 
+/* Set up this shell's place in the input tree and register its services.
+ */
+static int shell_input_tree_init (struct shell_input *in)
+{
+    struct shell_info *info = in->shell->info;
+    int i;
+
+    for (i = 0; i < in->fanout; i++) {
+        if (kary_childof (in->fanout,
+                          info->shell_size,
+                          info->shell_rank,
+                          i) == KARY_NONE)
+            break;
+        in->nchildren++;
+    }
+    if (in->nchildren > 0) {
+        if (!(in->child_done = calloc (in->nchildren, sizeof (bool))))
+            return -1;
+        if (!(in->probe = flux_timer_watcher_create (in->shell->r,
+                                                     0.,
+                                                     shell_input_probe,
+                                                     shell_input_probe_timer_cb,
+                                                     in)))
+            return shell_log_errno ("flux_timer_watcher_create");
+        if (flux_shell_service_register (in->shell,
+                                         "input-exit",
+                                         shell_input_exit_cb,
+                                         in) < 0)
+            return shell_log_errno ("flux_shell_service_register");
+        if (flux_shell_add_completion_ref (in->shell, "input.forward") < 0)
+            return -1;
+        in->children_active = in->nchildren;
+    }
+    if (info->shell_rank > 0) {
+        if (flux_shell_service_register (in->shell,
+                                         "input",
+                                         shell_input_forward_cb,
+                                         in) < 0
+            || flux_shell_service_register (in->shell,
+                                            "input-probe",
+                                            shell_input_probe_cb,
+                                            in) < 0)
+            return shell_log_errno ("flux_shell_service_register");
+    }
+    return 0;
+}
+
 struct shell_input *shell_input_create (flux_shell_t *shell)
 {
     struct shell_input *in;
@@ -370,13 +805,24 @@ struct shell_input *shell_input_create (flux_shell_t *shell)
     in->shell = shell;
     in->stdin_type = FLUX_INPUT_TYPE_SERVICE;
     in->ntasks = shell->info->rankinfo.ntasks;
+    in->tasks_active = in->ntasks;
 
     task_inputs_size = sizeof (struct shell_task_input) * in->ntasks;
     if (!(in->task_inputs = calloc (1, task_inputs_size)))
         goto error;
-
-    for (i = 0; i < in->ntasks; i++)
-        in->task_inputs[i].type = FLUX_TASK_INPUT_KVS;
+    for (i = 0; i < in->ntasks; i++) {
+        in->task_inputs[i].in = in;
+        if (!(in->task_inputs[i].queue = zlist_new ()))
+            goto error;
+    }
+    if (!(in->deferred = zlist_new ()))
+        goto error;
+    if (!(in->retry = flux_timer_watcher_create (shell->r,
+                                                 shell_input_retry,
+                                                 0.,
+                                                 shell_input_retry_cb,
+                                                 in)))
+        goto error;
 
     shell_input_type_file_init (in);
 
@@ -384,31 +830,38 @@ struct shell_input *shell_input_create (flux_shell_t *shell)
     if (shell_input_parse_type (in) < 0)
         goto error;
 
+    /* can't use stdin in standalone, no parent instance to get it from */
+    if (in->shell->standalone)
+        return in;
+
+    if (shell_input_tree_init (in) < 0)
+        goto error;
+
     if (shell->info->shell_rank == 0) {
-        /* can't use stdin in standalone, no kvs to write to */
-        if (!in->shell->standalone) {
-            if (in->stdin_type == FLUX_INPUT_TYPE_SERVICE) {
-                if (flux_shell_service_register (in->shell,
-                                                 "stdin",
-                                                 shell_input_stdin_cb,
-                                                 in) < 0)
-                    shell_die_errno (1, "flux_shell_service_register");
-
-                /* Do not add a completion reference for the stdin service, we
-                 * don't care if the user ever sends stdin */
-            }
+        if (in->stdin_type == FLUX_INPUT_TYPE_SERVICE) {
+            if (flux_shell_service_register (in->shell,
+                                             "stdin",
+                                             shell_input_stdin_cb,
+                                             in) < 0)
+                shell_die_errno (1, "flux_shell_service_register");
+
+            /* Do not add a completion reference for the stdin service, we
+             * don't care if the user ever sends stdin */
+        }
 
+        if (in->kvs) {
+            if (shell_input_eventlogger_start (in) < 0)
+                goto error;
             if (shell_input_header (in) < 0)
                 goto error;
+        }
 
-            if (in->stdin_type == FLUX_INPUT_TYPE_FILE) {
-                if (shell_input_type_file_setup (in) < 0)
-                    goto error;
-                /* Ok to start fd watcher now since shell_input_header()
-                 *  synchronously write guest.input header.
-                 */
-                flux_watcher_start (in->stdin_file.w);
-            }
+        /* File input is read once all shells can receive it, in
+         * shell.start.
+         */
+        if (in->stdin_type == FLUX_INPUT_TYPE_FILE) {
+            if (shell_input_type_file_setup (in) < 0)
+                goto error;
         }
     }
 
@@ -418,6 +871,22 @@ error:
     return NULL;
 }
 
+static int shell_input_start (flux_plugin_t *p,
+                              const char *topic,
+                              flux_plugin_arg_t *args,
+                              void *data)
+{
+    struct shell_input *in = data;
+    struct input_chunk *c;
+
+    in->started = true;
+    while ((c = zlist_pop (in->deferred)))
+        input_chunk_dispatch (c);
+    if (in->stdin_file.w)
+        flux_watcher_start (in->stdin_file.w);
+    return 0;
+}
+
 static int shell_input_init (flux_plugin_t *p,
                              const char *topic,
                              flux_plugin_arg_t *args,
@@ -432,119 +901,39 @@ static int shell_input_init (flux_plugin_t *p,
         shell_input_destroy (in);
         return -1;
     }
+    if (shell->info->shell_rank == 0
+        && flux_plugin_add_handler (p, "shell.start",
+                                    shell_input_start,
+                                    in) < 0)
+        return -1;
     return 0;
 }
 
-/*  Return 1 if idset string 'set' contains the integer id.
- *  O/w, return 0, or -1 on failure to decode 'set'.
- */
-static int idset_string_contains (const char *set, uint32_t id)
-{
-    int rc;
-    struct idset *idset;
-    if (strcmp (set, "all") == 0)
-        return 1;
-    if (!(idset = idset_decode (set)))
-        return shell_log_errno ("idset_decode (%s)", set);
-    rc = idset_test (idset, id);
-    idset_destroy (idset);
-    return rc;
+static struct shell_task_input *get_task_input (struct shell_input *in,
+                                                flux_shell_task_t *task)
+{
+    return &in->task_inputs[task->index];
 }
 
-static void shell_task_input_kvs_input_cb (flux_future_t *f, void *arg)
+static int shell_input_task_init (flux_plugin_t *p,
+                                  const char *topic,
+                                  flux_plugin_arg_t *args,
+                                  void *data)
 {
-    struct shell_task_input *task_input = arg;
-    struct shell_task_input_kvs *kp = &(task_input->input_kvs);
-    const char *entry;
-    json_t *o;
-    const char *name;
-    json_t *context;
+    flux_shell_t *shell = flux_plugin_get_shell (p);
+    struct shell_input *in = flux_plugin_aux_get (p, "builtin.input");
+    flux_shell_task_t *task;
 
-    if (flux_job_event_watch_get (f, &entry) < 0) {
-        if (errno == ENODATA)
-            goto done;
-        shell_die (1, "flux_job_event_watch_get: %s",
-                   future_strerror (f, errno));
-    }
-    if (!(o = eventlog_entry_decode (entry)))
-        shell_die_errno (1, "eventlog_entry_decode");
-    if (eventlog_entry_parse (o, NULL, &name, &context) < 0)
-        shell_die_errno (1, "eventlog_entry_parse");
-
-    if (!strcmp (name, "header")) {
-        /* Future: per-stream encoding */
-        kp->input_header_parsed = true;
-    }
-    else if (!strcmp (name, "data")) {
-        flux_shell_task_t *task = task_input->task;
-        const char *rank = NULL;
-        if (!kp->input_header_parsed)
-            shell_die (1, "stream data read before header");
-        if (iodecode (context, NULL, &rank, NULL, NULL, NULL) < 0)
-            shell_die (1, "malformed event context");
-        if (idset_string_contains (rank, task->rank) == 1) {
-            const char *stream;
-            char *data = NULL;
-            int len;
-            bool eof;
-            if (iodecode (context, &stream, NULL, &data, &len, &eof) < 0)
-                shell_die (1, "malformed event context");
-            if (len > 0) {
-                if (flux_subprocess_write (task->proc,
-                                           stream,
-                                           data,
-                                           len) < 0) {
-                    if (errno != EPIPE)
-                        shell_die_errno (1, "flux_subprocess_write");
-                    else
-                        eof = true; /* Pretend that we got eof */
-                }
-            }
-            if (eof) {
-                if (flux_subprocess_close (task->proc, stream) < 0)
-                    shell_die_errno (1, "flux_subprocess_close");
-                if (flux_job_event_watch_cancel (f) < 0)
-                    shell_die_errno (1, "flux_job_event_watch_cancel");
-            }
-            free (data);
-        }
-    }
-    json_decref (o);
-    flux_future_reset (f);
-    return;
-done:
-    shell_task_input_kvs_cleanup (kp);
-}
+    if (!shell || !in || !(task = flux_shell_current_task (shell)))
+        return -1;
 
-static int shell_task_input_kvs_start (struct shell_task_input *ti)
-{
-    struct shell_task_input_kvs *kp = &(ti->input_kvs);
-    flux_future_t *f = NULL;
-    /*  Start watching kvs guest.input eventlog.
-     *  Since this function is called after shell initialization
-     *   barrier, we are guaranteed that input eventlog exists.
-     */
-    if (!(f = flux_job_event_watch (ti->in->shell->h,
-                                    ti->in->shell->info->jobid,
-                                    "guest.input",
-                                    0)))
-            shell_die_errno (1, "flux_job_event_watch");
-
-    if (flux_future_then (f, -1., shell_task_input_kvs_input_cb, ti) < 0) {
-        flux_future_destroy (f);
-        shell_die_errno (1, "flux_future_then");
-    }
-    kp->input_f = f;
+    get_task_input (in, task)->task = task;
     return 0;
 }
 
-static struct shell_task_input *get_task_input (struct shell_input *in,
-                                                flux_shell_task_t *task)
-{
-    return &in->task_inputs[task->index];
-}
-
-static int shell_input_task_init (flux_plugin_t *p,
+/* Input that arrived before the task was started can now be written.
+ */
+static int shell_input_task_fork (flux_plugin_t *p,
                                   const char *topic,
                                   flux_plugin_arg_t *args,
                                   void *data)
@@ -558,15 +947,8 @@ static int shell_input_task_init (flux_plugin_t *p,
         return -1;
 
     task_input = get_task_input (in, task);
-    task_input->in = in;
-    task_input->task = task;
-
-    if (task_input->type == FLUX_TASK_INPUT_KVS) {
-        /* can't read stdin in standalone mode, no KVS to read from */
-        if (!task_input->in->shell->standalone
-            && shell_task_input_kvs_start (task_input) < 0)
-            shell_die_errno (1, "shell_input_start_task_watch");
-    }
+    task_input->started = true;
+    shell_task_input_drain (task_input);
     return 0;
 }
 
@@ -578,17 +960,43 @@ static int shell_input_task_exit (flux_plugin_t *p,
     flux_shell_t *shell = flux_plugin_get_shell (p);
     flux_shell_task_t *task = flux_shell_current_task (shell);
     struct shell_input *in = flux_plugin_aux_get (p, "builtin.input");
-    struct shell_task_input *task_input;
 
     if (!shell || !in || !task)
         return -1;
 
-    task_input = get_task_input (in, task);
-    if (task_input->type == FLUX_TASK_INPUT_KVS
-        && task_input->input_kvs.input_f) {
-        if (flux_job_event_watch_cancel (task_input->input_kvs.input_f) < 0)
-            shell_log_errno ("flux_job_event_watch_cancel");
-    }
+    shell_task_input_close (get_task_input (in, task));
+
+    /* This shell now stays up only for its children, so start checking
+     * that they are still running.
+     */
+    if (--in->tasks_active == 0 && in->children_active > 0)
+        flux_watcher_start (in->probe);
+    return 0;
+}
+
+/* Tell the parent shell that this subtree no longer needs input.
+ */
+static int shell_input_exit (flux_plugin_t *p,
+                             const char *topic,
+                             flux_plugin_arg_t *args,
+                             void *data)
+{
+    flux_shell_t *shell = flux_plugin_get_shell (p);
+    struct shell_input *in = flux_plugin_aux_get (p, "builtin.input");
+    flux_future_t *f;
+    int rank;
+
+    if (!shell || !in || shell->standalone || shell->info->shell_rank == 0)
+        return 0;
+    rank = kary_parentof (in->fanout, shell->info->shell_rank);
+    if (!(f = flux_shell_rpc_pack (shell,
+                                   "input-exit",
+                                   rank,
+                                   FLUX_RPC_NORESPONSE,
+                                   "{s:i}",
+                                   "rank", shell->info->shell_rank)))
+        shell_log_errno ("input-exit to shell rank %d", rank);
+    flux_future_destroy (f);
     return 0;
 }
 
@@ -596,7 +1004,9 @@ struct shell_builtin builtin_input = {
     .name = "input",
     .init = shell_input_init,
     .task_init = shell_input_task_init,
-    .task_exit = shell_input_task_exit
+    .task_fork = shell_input_task_fork,
+    .task_exit = shell_input_task_exit,
+    .exit = shell_input_exit,
 };
 
 /*
@@ -23,21 +23,43 @@
  * configured file.
  *
  * Notes:
+ * If a file output path template contains the {{node.id}} tag, each
+ * shell instead opens its own file and writes the output of its own
+ * tasks to it directly.  Output on that stream is then never sent to the
+ * leader, which only logs a "redirect" event per shell in the output
+ * eventlog.
+ *
+ * Output reaches the leader through a k-ary tree over shell ranks
+ * (output.fanout, default 16).  Each shell sends batches of output
+ * objects to the "write" service of its parent shell, the leader sends to
+ * itself.  A shell with children appends the batches it receives to its
+ * own outgoing batch and answers each child request only once the batch
+ * carrying it has been acknowledged by its parent, so the leader sees at
+ * most 'fanout' streams of batches and back pressure propagates down
+ * the tree.
+ *
+ * Notes:
  * - leader takes a completion reference which it gives up once each
  *   task sends an EOF for both stdout and stderr.
+ * - a shell with children takes a completion reference which it gives up
+ *   once each task of its descendant shells has sent both EOFs, so that
+ *   it does not exit while it still has output to forward.
  * - completion reference also taken for each KVS commit, to ensure
  *   commits complete before shell exits
  * - all shells (even the leader) send I/O to the service with RPC
  * - Any errors getting I/O to the leader are logged by RPC completion
- *   callbacks.
- * - Any outstanding RPCs at shell_output_destroy() are synchronously waited for
- *   there (checked for error, then destroyed).
+ *   callbacks, and returned to child shells whose output was included.
+ * - Any outstanding RPCs at shell_output_destroy() are synchronously waited
+ *   for there (checked for error, then destroyed), and any output not yet
+ *   sent is sent.
  * - Any outstanding file writes at shell_output_destroy() are
  *   synchronously waited for to complete.
  * - In standalone mode, the loop:// connector enables RPCs to work
  * - In standalone mode, output is written to the shell's stdout/stderr not KVS
  * - The number of in-flight write requests on each shell is limited to
- *   shell_output_hwm, to avoid matchtag exhaustion, etc. for chatty tasks.
+ *   shell_output_window.  Output produced while the window is full is
+ *   batched, and tasks are stopped if the batch reaches shell_output_hwm
+ *   entries.
  */
 
 #if HAVE_CONFIG_H
@@ -51,6 +73,7 @@
 #include "src/common/libidset/idset.h"
 #include "src/common/libeventlog/eventlog.h"
 #include "src/common/libioencode/ioencode.h"
+#include "src/common/libutil/kary.h"
 
 #include "task.h"
 #include "svc.h"
@@ -72,8 +95,10 @@ struct shell_output_fd {
 
 struct shell_output_type_file {
     struct shell_output_fd *fdp;
+    char *template;
     char *path;
     int label;
+    bool per_node;      // each shell writes its own tasks' output to 'path'
 };
 
 struct shell_output {
@@ -82,7 +107,12 @@ struct shell_output {
     double batch_timeout;
     int refcount;
     int eof_pending;
+    int forward_eof_pending;    // EOFs expected from descendant shells
+    int fanout;
+    int parent;                 // shell rank output batches are sent to
     zlist_t *pending_writes;
+    json_t *batch;              // output objects not yet sent to parent
+    zlist_t *batch_requests;    // child requests included in 'batch'
     json_t *output;
     bool stopped;
     int stdout_type;
@@ -94,6 +124,8 @@ struct shell_output {
 
 static const int shell_output_lwm = 100;
 static const int shell_output_hwm = 1000;
+static const int shell_output_window = 4;
+static const int shell_output_fanout = 16;
 
 /* Pause/resume output on 'stream' of 'task'.
  */
@@ -175,25 +207,25 @@ static int shell_output_term (struct shell_output *out)
     return 0;
 }
 
-static int shell_output_redirect_stream (struct shell_output *out,
-                                         flux_kvs_txn_t *txn,
-                                         const char *stream,
-                                         const char *path)
+static char *shell_output_mustache_render (struct shell_output *out,
+                                           const char *path,
+                                           int nodeid,
+                                           bool *per_node);
+
+/* Encode task ranks first .. first + ntasks - 1 for a redirect event.
+ */
+static char *task_ranks_encode (int first, int ntasks)
 {
-    struct idset *idset;
-    json_t *entry = NULL;
-    char *entrystr = NULL;
-    int saved_errno, rc = -1;
+    struct idset *idset = NULL;
     char *rankptr = NULL;
-    int ntasks = out->shell->info->rankinfo.ntasks;
 
     if (ntasks > 1) {
         int flags = IDSET_FLAG_BRACKETS | IDSET_FLAG_RANGE;
-        if (!(idset = idset_create (ntasks, 0))) {
+        if (!(idset = idset_create (first + ntasks, 0))) {
             shell_log_errno ("idset_create");
             goto error;
         }
-        if (idset_range_set (idset, 0, ntasks - 1) < 0) {
+        if (idset_range_set (idset, first, first + ntasks - 1) < 0) {
             shell_log_errno ("idset_range_set");
             goto error;
         }
@@ -203,11 +235,23 @@ static int shell_output_redirect_stream (struct shell_output *out,
         }
     }
     else {
-        if (asprintf (&rankptr, "%d", 0) < 0) {
+        if (asprintf (&rankptr, "%d", first) < 0) {
             shell_log_errno ("asprintf");
             goto error;
         }
     }
+error:
+    idset_destroy (idset);
+    return rankptr;
+}
+
+static int shell_output_redirect_entry (struct shell_output *out,
+                                        const char *stream,
+                                        const char *rankptr,
+                                        const char *path)
+{
+    json_t *entry = NULL;
+    int saved_errno, rc = -1;
 
     if (!(entry = eventlog_entry_pack (0., "redirect",
                                        "{ s:s s:s s:s }",
@@ -217,77 +261,101 @@ static int shell_output_redirect_stream (struct shell_output *out,
         shell_log_errno ("eventlog_entry_create");
         goto error;
     }
-    if (!(entrystr = eventlog_entry_encode (entry))) {
-        shell_log_errno ("eventlog_entry_encode");
-        goto error;
-    }
-    if (flux_kvs_txn_put (txn, FLUX_KVS_APPEND, "output", entrystr) < 0) {
-        shell_log_errno ("flux_kvs_txn_put");
+    if (eventlogger_append_entry (out->ev, 0, "output", entry) < 0) {
+        shell_log_errno ("eventlogger_append_entry");
         goto error;
     }
     rc = 0;
 error:
-    /* on error, future destroyed via shell_output destroy */
     saved_errno = errno;
     json_decref (entry);
-    free (entrystr);
-    free (rankptr);
     errno = saved_errno;
     return rc;
 }
 
-static int shell_output_redirect (struct shell_output *out, flux_kvs_txn_t *txn)
+/* Log a redirect event for the tasks of each shell, with the path
+ * rendered for that shell.
+ */
+static int shell_output_redirect_per_node (struct shell_output *out,
+                                           const char *stream,
+                                           const char *template)
+{
+    struct shell_info *info = out->shell->info;
+    int i;
+
+    for (i = 0; i < info->shell_size; i++) {
+        struct rcalc_rankinfo ri;
+        char *rankptr = NULL;
+        char *path = NULL;
+        int rc;
+
+        if (rcalc_get_nth (info->rcalc, i, &ri) < 0) {
+            shell_log_errno ("rcalc_get_nth %d", i);
+            return -1;
+        }
+        if (!(rankptr = task_ranks_encode (ri.global_basis, ri.ntasks))
+            || !(path = shell_output_mustache_render (out,
+                                                      template,
+                                                      i,
+                                                      NULL))) {
+            free (rankptr);
+            return -1;
+        }
+        rc = shell_output_redirect_entry (out, stream, rankptr, path);
+        free (rankptr);
+        free (path);
+        if (rc < 0)
+            return -1;
+    }
+    return 0;
+}
+
+static int shell_output_redirect_stream (struct shell_output *out,
+                                         const char *stream,
+                                         struct shell_output_type_file *ofp)
+{
+    int rc;
+    char *rankptr;
+
+    if (ofp->per_node)
+        return shell_output_redirect_per_node (out, stream, ofp->template);
+    if (!(rankptr = task_ranks_encode (0, out->shell->info->rankinfo.ntasks)))
+        return -1;
+    rc = shell_output_redirect_entry (out, stream, rankptr, ofp->path);
+    free (rankptr);
+    return rc;
+}
+
+static int shell_output_redirect (struct shell_output *out)
 {
     /* if file redirected, output redirect event */
     if (out->stdout_type == FLUX_OUTPUT_TYPE_FILE) {
         if (shell_output_redirect_stream (out,
-                                          txn,
                                           "stdout",
-                                          out->stdout_file.path) < 0)
+                                          &out->stdout_file) < 0)
             return -1;
     }
     if (out->stderr_type == FLUX_OUTPUT_TYPE_FILE) {
         if (shell_output_redirect_stream (out,
-                                          txn,
                                           "stderr",
-                                          out->stderr_file.path) < 0)
+                                          &out->stderr_file) < 0)
             return -1;
     }
     return 0;
 }
 
+/* The header and redirect events are committed with other shell
+ * eventlog appends made during shell initialization, which are flushed
+ * before the init barrier, so the output eventlog exists before the
+ * shell.init event is emitted to the exec.eventlog.
+ */
 static int shell_output_kvs_init (struct shell_output *out, json_t *header)
 {
-    flux_kvs_txn_t *txn = NULL;
-    flux_future_t *f = NULL;
-    char *headerstr = NULL;
-    int saved_errno;
-    int rc = -1;
-
-    if (!(headerstr = eventlog_entry_encode (header)))
-        goto error;
-    if (!(txn = flux_kvs_txn_create ()))
-        goto error;
-    if (flux_kvs_txn_put (txn, FLUX_KVS_APPEND, "output", headerstr) < 0)
-        goto error;
-    if (shell_output_redirect (out, txn) < 0)
-        goto error;
-    if (!(f = flux_kvs_commit (out->shell->h, NULL, 0, txn)))
-        goto error;
-    /* Wait synchronously for guest.output to be committed to kvs so
-     * that the output eventlog is guaranteed to exist before shell.init
-     * event is emitted to the exec.eventlog.
-     */
-    if (flux_future_get (f, NULL) < 0)
-        shell_die_errno (1, "failed to create header in output eventlog");
-    rc = 0;
-error:
-    saved_errno = errno;
-    flux_kvs_txn_destroy (txn);
-    free (headerstr);
-    flux_future_destroy (f);
-    errno = saved_errno;
-    return rc;
+    if (eventlogger_append_entry (out->ev, 0, "output", header) < 0)
+        return -1;
+    if (shell_output_redirect (out) < 0)
+        return -1;
+    return 0;
 }
 
 static int entry_output_is_kvs (struct shell_output *out, json_t *entry)
@@ -340,6 +408,27 @@ static int shell_output_write_fd (int fd, const void *buf, size_t len)
     return n;
 }
 
+static int shell_output_file_write (struct shell_output_type_file *ofp,
+                                    const char *rank,
+                                    const char *data,
+                                    int len)
+{
+    if (ofp->label) {
+        char *buf = NULL;
+        int buflen;
+        if ((buflen = asprintf (&buf, "%s: ", rank)) < 0)
+            return -1;
+        if (shell_output_write_fd (ofp->fdp->fd, buf, buflen) < 0) {
+            free (buf);
+            return -1;
+        }
+        free (buf);
+    }
+    if (shell_output_write_fd (ofp->fdp->fd, data, len) < 0)
+        return -1;
+    return 0;
+}
+
 static int shell_output_file (struct shell_output *out)
 {
     json_t *entry;
@@ -372,18 +461,7 @@ static int shell_output_file (struct shell_output *out)
                 ofp = &out->stderr_file;
             }
             if ((output_type == FLUX_OUTPUT_TYPE_FILE) && len > 0) {
-                if (ofp->label) {
-                    char *buf = NULL;
-                    int buflen;
-                    if ((buflen = asprintf (&buf, "%s: ", rank)) < 0)
-                        return -1;
-                    if (shell_output_write_fd (ofp->fdp->fd, buf, buflen) < 0) {
-                        free (buf);
-                        return -1;
-                    }
-                    free (buf);
-                }
-                if (shell_output_write_fd (ofp->fdp->fd, data, len) < 0)
+                if (shell_output_file_write (ofp, rank, data, len) < 0)
                     return -1;
             }
             free (data);
@@ -392,29 +470,33 @@ static int shell_output_file (struct shell_output *out)
     return 0;
 }
 
-/* Convert 'iodecode' object to an valid RFC 24 data event.
+/* Convert each 'iodecode' object of 'batch' to a valid RFC 24 data
+ * event and dispose of the events according to output type.
  * N.B. the iodecode object is a valid "context" for the event.
  */
-static void shell_output_write_cb (flux_t *h,
-                                   flux_msg_handler_t *mh,
-                                   const flux_msg_t *msg,
-                                   void *arg)
+static int shell_output_process (struct shell_output *out,
+                                 flux_msg_handler_t *mh,
+                                 json_t *batch)
 {
-    struct shell_output *out = arg;
-    bool eof = false;
+    size_t index;
     json_t *o;
-    json_t *entry;
+    int eofs = 0;
 
-    if (flux_request_unpack (msg, NULL, "o", &o) < 0)
-        goto error;
-    if (iodecode (o, NULL, NULL, NULL, NULL, &eof) < 0)
-        goto error;
-    if (!(entry = eventlog_entry_pack (0., "data", "O", o))) // increfs 'o'
-        goto error;
-    if (json_array_append_new (out->output, entry) < 0) {
-        json_decref (entry);
-        errno = ENOMEM;
-        goto error;
+    json_array_foreach (batch, index, o) {
+        bool eof = false;
+        json_t *entry;
+
+        if (iodecode (o, NULL, NULL, NULL, NULL, &eof) < 0)
+            return -1;
+        if (!(entry = eventlog_entry_pack (0., "data", "O", o))) // increfs 'o'
+            return -1;
+        if (json_array_append_new (out->output, entry) < 0) {
+            json_decref (entry);
+            errno = ENOMEM;
+            return -1;
+        }
+        if (eof)
+            eofs++;
     }
     /* Error failing to commit is a fatal error.  Should be cleaner in
      * future. Issue #2378 */
@@ -435,10 +517,11 @@ static void shell_output_write_cb (flux_t *h,
     }
     if (json_array_clear (out->output) < 0) {
         shell_log_error ("json_array_clear failed");
-        goto error;
+        return -1;
     }
-    if (eof) {
-        if (--out->eof_pending == 0) {
+    if (eofs > 0 && out->eof_pending > 0) {
+        out->eof_pending -= eofs;
+        if (out->eof_pending <= 0) {
             flux_msg_handler_stop (mh);
             if (flux_shell_remove_completion_ref (out->shell, "output.write") < 0)
                 shell_log_errno ("flux_shell_remove_completion_ref");
@@ -451,25 +534,185 @@ static void shell_output_write_cb (flux_t *h,
             }
         }
     }
-    if (flux_respond (out->shell->h, msg, NULL) < 0)
-        shell_log_errno ("flux_respond");
-    return;
+    return 0;
+}
+
+/* Respond to child shell write requests 'requests' with 'errnum',
+ * or success if errnum is zero.
+ */
+static void shell_output_respond (struct shell_output *out,
+                                  zlist_t *requests,
+                                  int errnum)
+{
+    const flux_msg_t *msg;
+
+    if (!requests)
+        return;
+    while ((msg = zlist_pop (requests))) {
+        if (errnum) {
+            if (flux_respond_error (out->shell->h, msg, errnum, NULL) < 0)
+                shell_log_errno ("flux_respond_error");
+        }
+        else if (flux_respond (out->shell->h, msg, NULL) < 0)
+            shell_log_errno ("flux_respond");
+        flux_msg_decref (msg);
+    }
+}
+
+static void requests_destroy (void *arg)
+{
+    zlist_t *requests = arg;
+    const flux_msg_t *msg;
+
+    if (requests) {
+        while ((msg = zlist_pop (requests)))
+            flux_msg_decref (msg);
+        zlist_destroy (&requests);
+    }
+}
+
+static void shell_output_write_completion (flux_future_t *f, void *arg);
+
+/* Send the current batch of output to the parent shell, unless it is
+ * empty or shell_output_window writes are already in flight, in which
+ * case output keeps accumulating until a write completes.
+ */
+static int shell_output_flush (struct shell_output *out)
+{
+    flux_future_t *f = NULL;
+
+    if (json_array_size (out->batch) == 0
+        || zlist_size (out->pending_writes) >= shell_output_window)
+        return 0;
+    if (!(f = flux_shell_rpc_pack (out->shell,
+                                   "write",
+                                   out->parent,
+                                   0,
+                                   "{s:O}",
+                                   "batch", out->batch)))
+        return -1;
+    if (flux_future_then (f, -1, shell_output_write_completion, out) < 0)
+        goto error;
+    if (out->batch_requests) {
+        if (flux_future_aux_set (f,
+                                 "requests",
+                                 out->batch_requests,
+                                 requests_destroy) < 0)
+            goto error;
+        out->batch_requests = NULL;
+    }
+    if (zlist_append (out->pending_writes, f) < 0)
+        shell_log_error ("zlist_append failed");
+    if (json_array_clear (out->batch) < 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    shell_output_control (out, false);
+    return 0;
 error:
-    if (flux_respond_error (out->shell->h, msg, errno, NULL) < 0)
-        shell_log_errno ("flux_respond");
+    flux_future_destroy (f);
+    return -1;
 }
 
 static void shell_output_write_completion (flux_future_t *f, void *arg)
 {
     struct shell_output *out = arg;
+    int errnum = 0;
 
-    if (flux_future_get (f, NULL) < 0)
+    if (flux_future_get (f, NULL) < 0) {
+        errnum = errno;
         shell_log_errno ("shell_output_write");
+    }
+    shell_output_respond (out, flux_future_aux_get (f, "requests"), errnum);
     zlist_remove (out->pending_writes, f);
     flux_future_destroy (f);
 
-    if (zlist_size (out->pending_writes) <= shell_output_lwm)
-        shell_output_control (out, false);
+    if (shell_output_flush (out) < 0)
+        shell_log_errno ("shell_output_flush");
+}
+
+/* Append output object 'o' to the current batch.
+ */
+static int shell_output_append (struct shell_output *out, json_t *o)
+{
+    if (json_array_append (out->batch, o) < 0) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (json_array_size (out->batch) >= shell_output_hwm)
+        shell_output_control (out, true);
+    return 0;
+}
+
+/* Add a batch received from a child shell to the current batch.  The
+ * request is answered once the parent has acknowledged it.
+ */
+static int shell_output_forward (struct shell_output *out,
+                                 const flux_msg_t *msg,
+                                 json_t *batch)
+{
+    size_t index;
+    json_t *o;
+    int eofs = 0;
+
+    json_array_foreach (batch, index, o) {
+        bool eof = false;
+        if (iodecode (o, NULL, NULL, NULL, NULL, &eof) < 0)
+            return -1;
+        if (shell_output_append (out, o) < 0)
+            return -1;
+        if (eof)
+            eofs++;
+    }
+    if (!out->batch_requests && !(out->batch_requests = zlist_new ())) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (zlist_append (out->batch_requests, (void *)flux_msg_incref (msg)) < 0) {
+        flux_msg_decref (msg);
+        errno = ENOMEM;
+        return -1;
+    }
+    if (eofs > 0 && out->forward_eof_pending > 0) {
+        out->forward_eof_pending -= eofs;
+        if (out->forward_eof_pending <= 0) {
+            if (flux_shell_remove_completion_ref (out->shell,
+                                                  "output.forward") < 0)
+                shell_log_errno ("flux_shell_remove_completion_ref");
+        }
+    }
+    if (shell_output_flush (out) < 0)
+        shell_log_errno ("shell_output_flush");
+    return 0;
+}
+
+static void shell_output_write_cb (flux_t *h,
+                                   flux_msg_handler_t *mh,
+                                   const flux_msg_t *msg,
+                                   void *arg)
+{
+    struct shell_output *out = arg;
+    json_t *batch;
+
+    if (flux_request_unpack (msg, NULL, "{s:o}", "batch", &batch) < 0)
+        goto error;
+    if (!json_is_array (batch)) {
+        errno = EPROTO;
+        goto error;
+    }
+    if (out->shell->info->shell_rank != 0) {
+        if (shell_output_forward (out, msg, batch) < 0)
+            goto error;
+        return;
+    }
+    if (shell_output_process (out, mh, batch) < 0)
+        goto error;
+    if (flux_respond (out->shell->h, msg, NULL) < 0)
+        shell_log_errno ("flux_respond");
+    return;
+error:
+    if (flux_respond_error (out->shell->h, msg, errno, NULL) < 0)
+        shell_log_errno ("flux_respond");
 }
 
 static int shell_output_write (struct shell_output *out,
@@ -479,38 +722,25 @@ static int shell_output_write (struct shell_output *out,
                                int len,
                                bool eof)
 {
-    flux_future_t *f = NULL;
     json_t *o = NULL;
     char rankstr[64];
+    int rc;
 
     snprintf (rankstr, sizeof (rankstr), "%d", rank);
     if (!(o = ioencode (stream, rankstr, data, len, eof))) {
         shell_log_errno ("ioencode");
         return -1;
     }
-
-    if (!(f = flux_shell_rpc_pack (out->shell, "write", 0, 0, "O", o)))
-        goto error;
-    if (flux_future_then (f, -1, shell_output_write_completion, out) < 0)
-        goto error;
-    if (zlist_append (out->pending_writes, f) < 0)
-        shell_log_error ("zlist_append failed");
-    json_decref (o);
-
-    if (zlist_size (out->pending_writes) >= shell_output_hwm)
-        shell_output_control (out, true);
-    return 0;
-
-error:
-    flux_future_destroy (f);
+    if ((rc = shell_output_append (out, o)) == 0)
+        rc = shell_output_flush (out);
     json_decref (o);
-    return -1;
+    return rc;
 }
 
 static void shell_output_type_file_cleanup (struct shell_output_type_file *ofp)
 {
-    if (ofp->path)
-        free (ofp->path);
+    free (ofp->path);
+    free (ofp->template);
 }
 
 void shell_output_destroy (struct shell_output *out)
@@ -520,13 +750,27 @@ void shell_output_destroy (struct shell_output *out)
         if (out->pending_writes) {
             flux_future_t *f;
 
+            if (shell_output_flush (out) < 0)
+                shell_log_errno ("shell_output_flush");
             while ((f = zlist_pop (out->pending_writes))) { // leader+follower
-                if (flux_future_get (f, NULL) < 0)
+                int errnum = 0;
+                if (flux_future_get (f, NULL) < 0) {
+                    errnum = errno;
                     shell_log_errno ("shell_output_write");
+                }
+                shell_output_respond (out,
+                                      flux_future_aux_get (f, "requests"),
+                                      errnum);
                 flux_future_destroy (f);
+                /* window has room again for any remaining output */
+                if (shell_output_flush (out) < 0)
+                    shell_log_errno ("shell_output_flush");
             }
             zlist_destroy (&out->pending_writes);
         }
+        shell_output_respond (out, out->batch_requests, EIO);
+        requests_destroy (out->batch_requests);
+        json_decref (out->batch);
         if (out->output && json_array_size (out->output) > 0) { // leader only
             if ((out->stdout_type == FLUX_OUTPUT_TYPE_TERM)
                 || (out->stderr_type == FLUX_OUTPUT_TYPE_TERM)) {
@@ -547,7 +791,7 @@ void shell_output_destroy (struct shell_output *out)
         json_decref (out->output);
         shell_output_type_file_cleanup (&out->stdout_file);
         shell_output_type_file_cleanup (&out->stderr_file);
-        if (out->fds) { // leader only
+        if (out->fds) { // leader, or any shell with per-node files
             struct shell_output_fd *fdp = zhash_first (out->fds);
             while (fdp) {
                 close (fdp->fd);
@@ -571,6 +815,33 @@ static bool output_type_requires_service (int type)
     return false;
 }
 
+/* Return the per-node file description of 'stream', or NULL if output
+ * on 'stream' is sent to the leader shell.
+ */
+static struct shell_output_type_file *
+shell_output_per_node (struct shell_output *out, const char *stream)
+{
+    if (!strcmp (stream, "stdout")) {
+        if (out->stdout_type == FLUX_OUTPUT_TYPE_FILE
+            && out->stdout_file.per_node)
+            return &out->stdout_file;
+    }
+    else if (out->stderr_type == FLUX_OUTPUT_TYPE_FILE
+             && out->stderr_file.per_node)
+        return &out->stderr_file;
+    return NULL;
+}
+
+/* check if output on this stream is written through the leader shell */
+static bool shell_output_forwarded (struct shell_output *out,
+                                    const char *stream)
+{
+    int type = !strcmp (stream, "stdout") ? out->stdout_type
+                                           : out->stderr_type;
+    return output_type_requires_service (type)
+           && !shell_output_per_node (out, stream);
+}
+
 static int shell_output_parse_type (struct shell_output *out,
                                     const char *typestr,
                                     int *typep)
@@ -588,9 +859,16 @@ static int shell_output_parse_type (struct shell_output *out,
     return 0;
 }
 
+struct mustache_ctx {
+    flux_shell_t *shell;
+    int nodeid;
+    bool per_node;      // set if template contained {{node.id}}
+};
+
 static int mustache_cb (FILE *fp, const char *name, void *arg)
 {
-    flux_shell_t *shell = arg;
+    struct mustache_ctx *ctx = arg;
+    flux_shell_t *shell = ctx->shell;
     char value[128];
 
     /*  "jobid" is a synonym for "id" */
@@ -616,6 +894,10 @@ static int mustache_cb (FILE *fp, const char *name, void *arg)
             return -1;
         }
     }
+    else if (strcmp (name, "node.id") == 0) {
+        snprintf (value, sizeof (value), "%d", ctx->nodeid);
+        ctx->per_node = true;
+    }
     else {
         shell_log_error ("Unknown mustache tag '%s'", name);
         return -1;
@@ -623,13 +905,19 @@ static int mustache_cb (FILE *fp, const char *name, void *arg)
     return fputs (value, fp);
 }
 
-static char * shell_output_mustache_render (struct shell_output *out,
-                                            const char *path)
+/* Render 'path' for the shell with rank 'nodeid'.  If 'per_node' is
+ * non-NULL, it is set to true if the result depends on 'nodeid'.
+ */
+static char *shell_output_mustache_render (struct shell_output *out,
+                                           const char *path,
+                                           int nodeid,
+                                           bool *per_node)
 {
     struct mustache_renderer *mr;
+    struct mustache_ctx ctx = { .shell = out->shell, .nodeid = nodeid };
     char *result = NULL;
 
-    mr = mustache_renderer_create (mustache_cb, out->shell);
+    mr = mustache_renderer_create (mustache_cb, &ctx);
     if (!mr) {
         shell_log_errno ("mustache_renderer_create");
         return NULL;
@@ -637,6 +925,8 @@ static char * shell_output_mustache_render (struct shell_output *out,
     mustache_renderer_set_log (mr, shell_llog, NULL);
     result = mustache_render (mr, path);
     mustache_renderer_destroy (mr);
+    if (result && per_node)
+        *per_node = ctx.per_node;
     return result;
 }
 
@@ -658,7 +948,11 @@ shell_output_setup_type_file (struct shell_output *out,
         return -1;
     }
 
-    if (!(ofp->path = shell_output_mustache_render (out, path)))
+    if (!(ofp->path = shell_output_mustache_render (out,
+                                                    path,
+                                                    out->shell->info->shell_rank,
+                                                    &ofp->per_node))
+        || !(ofp->template = strdup (path)))
         return -1;
 
     if (flux_shell_getopt_unpack (out->shell, "output",
@@ -667,9 +961,11 @@ shell_output_setup_type_file (struct shell_output *out,
         return -1;
 
     if (ofp_copy) {
-        if (!(ofp_copy->path = strdup (ofp->path)))
+        if (!(ofp_copy->path = strdup (ofp->path))
+            || !(ofp_copy->template = strdup (ofp->template)))
             return -1;
         ofp_copy->label = ofp->label;
+        ofp_copy->per_node = ofp->per_node;
     }
 
     return 0;
@@ -873,7 +1169,6 @@ static void output_unref (struct eventlogger *ev, void *arg)
 
 static int output_eventlogger_start (struct shell_output *out)
 {
-    flux_t *h = flux_shell_get_flux (out->shell);
     struct eventlogger_ops ops = {
         .busy = output_ref,
         .idle = output_unref
@@ -889,9 +1184,106 @@ static int output_eventlogger_start (struct shell_output *out)
 
     shell_debug ("batch timeout = %.3fs", out->batch_timeout);
 
-    out->ev = eventlogger_create (h, out->batch_timeout, &ops, out);
+    out->ev = shell_eventlogger_share (out->shell->ev,
+                                       out->batch_timeout,
+                                       &ops,
+                                       out);
     if (!out->ev)
-        return shell_log_errno ("eventlogger_create");
+        return shell_log_errno ("shell_eventlogger_share");
+    return 0;
+}
+
+static int shell_output_files_open (struct shell_output *out)
+{
+    bool leader = out->shell->info->shell_rank == 0;
+    bool open_stdout = out->stdout_type == FLUX_OUTPUT_TYPE_FILE
+                       && (leader || out->stdout_file.per_node);
+    bool open_stderr = out->stderr_type == FLUX_OUTPUT_TYPE_FILE
+                       && (leader || out->stderr_file.per_node);
+
+    if (!open_stdout && !open_stderr)
+        return 0;
+    if (!(out->fds = zhash_new ())) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (open_stdout
+        && shell_output_type_file_setup (out, &(out->stdout_file)) < 0)
+        return -1;
+    if (open_stderr
+        && shell_output_type_file_setup (out, &(out->stderr_file)) < 0)
+        return -1;
+    return 0;
+}
+
+/* Count tasks of the descendants of this shell in the output tree.
+ * The children of shell rank i are k*i+1 .. k*i+k, so each level of
+ * the subtree is a contiguous range of shell ranks.
+ */
+static int shell_output_descendant_tasks (struct shell_output *out)
+{
+    struct shell_info *info = out->shell->info;
+    uint64_t lo = info->shell_rank;
+    uint64_t hi = info->shell_rank;
+    int ntasks = 0;
+
+    for (;;) {
+        uint64_t i;
+
+        lo = lo * out->fanout + 1;
+        hi = hi * out->fanout + out->fanout;
+        if (lo >= info->shell_size)
+            break;
+        for (i = lo; i <= hi && i < info->shell_size; i++) {
+            struct rcalc_rankinfo ri;
+            if (rcalc_get_nth (info->rcalc, i, &ri) < 0)
+                return -1;
+            ntasks += ri.ntasks;
+        }
+    }
+    return ntasks;
+}
+
+/* Set up this shell's place in the output tree.  Shells other than the
+ * leader that have children forward output with the "write" service.
+ */
+static int shell_output_tree_init (struct shell_output *out)
+{
+    flux_shell_t *shell = out->shell;
+    int rank = shell->info->shell_rank;
+    int ntasks;
+
+    out->fanout = shell_output_fanout;
+    if (flux_shell_getopt_unpack (shell,
+                                  "output",
+                                  "{s?i}",
+                                  "fanout", &out->fanout) < 0)
+        return shell_log_errno ("invalid output.fanout option");
+    if (out->fanout < 1)
+        return shell_log_errn (EINVAL,
+                               "invalid output.fanout %d", out->fanout);
+    out->parent = rank > 0 ? kary_parentof (out->fanout, rank) : 0;
+
+    if (rank == 0
+        || kary_childof (out->fanout,
+                         shell->info->shell_size,
+                         rank,
+                         0) == KARY_NONE)
+        return 0;
+    if ((ntasks = shell_output_descendant_tasks (out)) < 0)
+        return shell_log_errno ("error counting descendant tasks");
+    if (shell_output_forwarded (out, "stdout"))
+        out->forward_eof_pending += ntasks;
+    if (shell_output_forwarded (out, "stderr"))
+        out->forward_eof_pending += ntasks;
+    if (out->forward_eof_pending > 0
+        && flux_shell_add_completion_ref (shell, "output.forward") < 0)
+        return -1;
+    if (flux_shell_service_register (shell,
+                                     "write",
+                                     shell_output_write_cb,
+                                     out) < 0)
+        return -1;
     return 0;
 }
 
@@ -916,17 +1308,27 @@ struct shell_output *shell_output_create (flux_shell_t *shell)
 
     if (!(out->pending_writes = zlist_new ()))
         goto error;
+    if (!(out->batch = json_array ())) {
+        errno = ENOMEM;
+        goto error;
+    }
+    if (shell_output_tree_init (out) < 0)
+        goto error;
+    /* Per-node files are opened by every shell, others by the leader.
+     */
+    if (shell_output_files_open (out) < 0)
+        goto error;
     if (shell->info->shell_rank == 0) {
-        if (output_type_requires_service (out->stdout_type)
-            || output_type_requires_service (out->stderr_type)) {
+        if (shell_output_forwarded (out, "stdout")
+            || shell_output_forwarded (out, "stderr")) {
             if (flux_shell_service_register (shell,
                                              "write",
                                              shell_output_write_cb,
                                              out) < 0)
                 goto error;
-            if (output_type_requires_service (out->stdout_type))
+            if (shell_output_forwarded (out, "stdout"))
                 out->eof_pending += shell->info->total_ntasks;
-            if (output_type_requires_service (out->stderr_type))
+            if (shell_output_forwarded (out, "stderr"))
                 out->eof_pending += shell->info->total_ntasks;
             if (flux_shell_add_completion_ref (shell, "output.write") < 0)
                 goto error;
@@ -935,21 +1337,6 @@ struct shell_output *shell_output_create (flux_shell_t *shell)
                 goto error;
             }
         }
-        if (out->stdout_type == FLUX_OUTPUT_TYPE_FILE
-            || out->stderr_type == FLUX_OUTPUT_TYPE_FILE) {
-            if (!(out->fds = zhash_new ())) {
-                errno = ENOMEM;
-                goto error;
-            }
-            if (out->stdout_type == FLUX_OUTPUT_TYPE_FILE) {
-                if (shell_output_type_file_setup (out, &(out->stdout_file)) < 0)
-                    goto error;
-            }
-            if (out->stderr_type == FLUX_OUTPUT_TYPE_FILE) {
-                if (shell_output_type_file_setup (out, &(out->stderr_file)) < 0)
-                    goto error;
-            }
-        }
         if (output_eventlogger_start (out) < 0)
             goto error;
         if (shell_output_header (out) < 0)
@@ -966,6 +1353,7 @@ static void task_output_cb (struct shell_task *task,
                             void *arg)
 {
     struct shell_output *out = arg;
+    struct shell_output_type_file *ofp;
     const char *data;
     int len;
 
@@ -973,6 +1361,13 @@ static void task_output_cb (struct shell_task *task,
     if (len < 0) {
         shell_log_errno ("read %s task %d", stream, task->rank);
     }
+    else if ((ofp = shell_output_per_node (out, stream))) {
+        char rankstr[13];
+
+        snprintf (rankstr, sizeof (rankstr), "%d", task->rank);
+        if (len > 0 && shell_output_file_write (ofp, rankstr, data, len) < 0)
+            shell_log_errno ("write %s task %d", stream, task->rank);
+    }
     else if (len > 0) {
         if (shell_output_write (out, task->rank, stream, data, len, false) < 0)
             shell_log_errno ("write %s task %d", stream, task->rank);
@@ -13,6 +13,7 @@
 #endif
 
 #include <errno.h>
+#include <stdbool.h>
 #include <string.h>
 #include <glob.h>
 #include <dlfcn.h>
@@ -32,20 +33,168 @@
 #define shell_log_errno(...) fprintf (stderr, __VA_ARGS__)
 #endif
 
+/*  A loaded plugin. Entries are reference counted so that a plugin
+ *   unloaded from within a callback is not destroyed until every
+ *   plugstack_call() that may still reach it has returned.
+ */
+struct plugin_entry {
+    flux_plugin_t *p;
+    unsigned int generation;   /* plugin handler generation when indexed */
+    bool unloaded;
+    int refcount;
+};
+
+/*  Ordered vector of plugins with a handler matching a single topic,
+ *   built on first call of that topic and cached until the set of
+ *   loaded plugins or any plugin's handlers change.
+ */
+struct topic_vector {
+    int refcount;
+    int count;
+    struct plugin_entry *entries[];
+};
+
+/*  Active plugstack_call() frame, linked through the C stack.
+ */
+struct call_frame {
+    struct plugin_entry *entry;
+    struct call_frame *prev;
+};
+
 struct plugstack {
     char *searchpath;   /* If set, search path for plugstack_load()        */
     zhashx_t *aux;      /* aux items to propagate to loaded plugins        */
-    zlistx_t *plugins;  /* Ordered list of loaded plugins                  */
+    zlistx_t *plugins;  /* Ordered list of loaded plugin entries           */
     zhashx_t *names;    /* Hash for lookup of plugins by name              */
-    zlistx_t *current;  /* stack holding current plugin in plugstack_call  */
+    zhashx_t *topics;   /* Cache of topic_vector by topic string           */
+    struct call_frame *current; /* innermost frame in plugstack_call       */
 };
 
+static struct plugin_entry *plugin_entry_create (flux_plugin_t *p)
+{
+    struct plugin_entry *e = calloc (1, sizeof (*e));
+    if (!e)
+        return NULL;
+    e->p = p;
+    e->generation = flux_plugin_get_generation (p);
+    e->refcount = 1;
+    return e;
+}
+
+static void plugin_entry_decref (struct plugin_entry *e)
+{
+    if (e && --e->refcount == 0) {
+        int saved_errno = errno;
+        flux_plugin_destroy (e->p);
+        free (e);
+        errno = saved_errno;
+    }
+}
+
+static void plugin_entry_destructor (void **item)
+{
+    if (*item) {
+        struct plugin_entry *e = *item;
+        e->unloaded = true;
+        plugin_entry_decref (e);
+        *item = NULL;
+    }
+}
+
+static void topic_vector_decref (struct topic_vector *v)
+{
+    if (v && --v->refcount == 0) {
+        int i;
+        for (i = 0; i < v->count; i++)
+            plugin_entry_decref (v->entries[i]);
+        free (v);
+    }
+}
+
+static void topic_vector_destructor (void **item)
+{
+    if (*item) {
+        topic_vector_decref (*item);
+        *item = NULL;
+    }
+}
+
+static struct topic_vector *topic_vector_create (struct plugstack *st,
+                                                 const char *topic)
+{
+    struct topic_vector *v;
+    struct plugin_entry *e;
+    size_t size = zlistx_size (st->plugins);
+
+    if (!(v = calloc (1, sizeof (*v) + size * sizeof (v->entries[0]))))
+        return NULL;
+    v->refcount = 1;
+    e = zlistx_first (st->plugins);
+    while (e) {
+        if (flux_plugin_match_handler (e->p, topic)) {
+            e->refcount++;
+            v->entries[v->count++] = e;
+        }
+        e = zlistx_next (st->plugins);
+    }
+    return v;
+}
+
+/*  Drop all cached topic vectors. Vectors in use by an active
+ *   plugstack_call() remain valid until that call drops its reference.
+ */
+static void plugstack_invalidate (struct plugstack *st)
+{
+    zhashx_purge (st->topics);
+}
+
+/*  Plugins may add or remove handlers at any time (e.g. from shell.init),
+ *   so check the handler generation of each plugin before trusting
+ *   the topic cache.
+ */
+static void plugstack_validate (struct plugstack *st)
+{
+    struct plugin_entry *e;
+    bool stale = false;
+
+    e = zlistx_first (st->plugins);
+    while (e) {
+        unsigned int generation = flux_plugin_get_generation (e->p);
+        if (e->generation != generation) {
+            e->generation = generation;
+            stale = true;
+        }
+        e = zlistx_next (st->plugins);
+    }
+    if (stale)
+        plugstack_invalidate (st);
+}
+
+static struct topic_vector *plugstack_lookup (struct plugstack *st,
+                                              const char *topic)
+{
+    struct topic_vector *v;
+
+    plugstack_validate (st);
+    if (!(v = zhashx_lookup (st->topics, topic))) {
+        if (!(v = topic_vector_create (st, topic)))
+            return NULL;
+        if (zhashx_insert (st->topics, topic, v) < 0) {
+            topic_vector_decref (v);
+            errno = ENOMEM;
+            return NULL;
+        }
+    }
+    return v;
+}
+
 void plugstack_unload_name (struct plugstack *st, const char *name)
 {
     void *item;
     if ((item = zhashx_lookup (st->names, name))) {
         zlistx_delete (st->plugins, item);
         zhashx_delete (st->names, name);
+        plugstack_invalidate (st);
     }
 }
 
@@ -86,14 +235,21 @@ int plugstack_plugin_aux_set (struct plugstack *st,
 int plugstack_push (struct plugstack *st, flux_plugin_t *p)
 {
     const char *name;
+    struct plugin_entry *e;
     void *item;
 
     if (!st || !p || !(name = flux_plugin_get_name (p))) {
         errno = EINVAL;
         return -1;
     }
-    if (!(item = zlistx_add_end (st->plugins, p)))
+    if (!(e = plugin_entry_create (p)))
         return -1;
+    if (!(item = zlistx_add_end (st->plugins, e))) {
+        /*  Caller retains ownership of p on failure */
+        free (e);
+        return -1;
+    }
+    plugstack_invalidate (st);
 
     /* Override any existing plugin with the same name */
     plugstack_unload_name (st, name);
@@ -107,8 +263,8 @@ void plugstack_destroy (struct plugstack *st)
 {
     if (st) {
         int saved_errno = errno;
+        zhashx_destroy (&st->topics);
         zlistx_destroy (&st->plugins);
-        zlistx_destroy (&st->current);
         zhashx_destroy (&st->names);
         zhashx_destroy (&st->aux);
         free (st->searchpath);
@@ -117,27 +273,31 @@ void plugstack_destroy (struct plugstack *st)
     }
 }
 
-static void plugin_destroy (flux_plugin_t **pp)
-{
-    flux_plugin_destroy (*pp);
-    *pp = NULL;
-}
-
 struct plugstack * plugstack_create (void)
 {
     struct plugstack *st = calloc (1, sizeof (*st));
     if (!st
         || !(st->plugins = zlistx_new ())
-        || !(st->current = zlistx_new ())
         || !(st->names = zhashx_new ())
+        || !(st->topics = zhashx_new ())
         || !(st->aux = zhashx_new ())) {
         plugstack_destroy (st);
         return NULL;
     }
-    zlistx_set_destructor (st->plugins, (czmq_destructor *) plugin_destroy);
+    zlistx_set_destructor (st->plugins, plugin_entry_destructor);
+    zhashx_set_destructor (st->topics, topic_vector_destructor);
     return (st);
 }
 
+bool plugstack_has_handler (struct plugstack *st, const char *name)
+{
+    struct topic_vector *v;
+
+    if (!st || !name || !(v = plugstack_lookup (st, name)))
+        return false;
+    return v->count > 0;
+}
+
 const char *plugstack_current_name (struct plugstack *st)
 {
     if (!st) {
@@ -146,18 +306,7 @@ const char *plugstack_current_name (struct plugstack *st)
     }
     if (!st->current)
         return NULL;
-    return flux_plugin_get_name (zlistx_first (st->current));
-}
-
-/*  Copy the plugin list, unsetting the destructor so plugins aren't
- *   destroyed on destruction of the list copy.
- */
-static zlistx_t *plugstack_list_dup (struct plugstack *st)
-{
-    zlistx_t *l = zlistx_dup (st->plugins);
-    if (l)
-        zlistx_set_destructor (l, NULL);
-    return l;
+    return flux_plugin_get_name (st->current->entry->p);
 }
 
 int plugstack_call (struct plugstack *st,
@@ -165,29 +314,36 @@ int plugstack_call (struct plugstack *st,
                     flux_plugin_arg_t *args)
 {
     int rc = 0;
-    flux_plugin_t *p = NULL;
+    int i;
+    struct topic_vector *v;
 
-    /* Duplicate list to make plugstack_call() reentrant.
-     */
-    zlistx_t *l = plugstack_list_dup (st);
-    if (!l)
+    if (!st || !name) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!(v = plugstack_lookup (st, name)))
         return -1;
 
-    p = zlistx_first (l);
-    while (p) {
-        /*  Push plugin onto the current plugin stack */
-        void * item = zlistx_add_start (st->current, p);
-        if (flux_plugin_call (p, name, args) < 0) {
+    /*  Hold a reference on the vector so that it (and the plugins it
+     *   references) survive cache invalidation by a reentrant call,
+     *   or a plugin being loaded or unloaded from a callback.
+     */
+    v->refcount++;
+    for (i = 0; i < v->count; i++) {
+        struct call_frame frame = { .entry = v->entries[i],
+                                    .prev = st->current };
+        if (frame.entry->unloaded)
+            continue;
+        st->current = &frame;
+        if (flux_plugin_call (frame.entry->p, name, args) < 0) {
             shell_log_error ("plugin '%s': %s failed",
                              plugstack_current_name (st),
                              name);
             rc = -1;
         }
-        /* Pop plugin from the current plugin stack */
-        zlistx_detach (st->current, item);
-        p = zlistx_next (l);
+        st->current = frame.prev;
     }
-    zlistx_destroy (&l);
+    topic_vector_decref (v);
     return rc;
 }
 
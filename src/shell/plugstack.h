@@ -11,6 +11,7 @@
 #ifndef _SHELL_PLUGSTACK_H
 #define _SHELL_PLUGSTACK_H
 
+#include <stdbool.h>
 #include <flux/core.h>
 
 struct plugstack * plugstack_create (void);
@@ -61,6 +62,10 @@ int plugstack_call (struct plugstack *st,
                     const char *name,
                     flux_plugin_arg_t *args);
 
+/*  Return true if any plugin in the stack has a handler for 'name'
+ */
+bool plugstack_has_handler (struct plugstack *st, const char *name);
+
 /*  Return currently active plugin name, or NULL if not in plugstack
  */
 const char * plugstack_current_name (struct plugstack *st);
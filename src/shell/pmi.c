@@ -25,9 +25,9 @@
  * variables, and subscribes to the newly created PMI_FD channel in order
  * to read PMI requests.
  *
- * The output callback pmi_fd_read_cb() reads the request from the PMI_FD
- * channel and pushes it into the PMI-1 protocol engine.  If the request
- * can be immediately answered, the shell_pmi_response_send() callback
+ * The output callback pmi_fd_cb() reads all buffered requests from the
+ * PMI_FD channel and pushes them into the PMI-1 protocol engine.  If a
+ * request can be immediately answered, the shell_pmi_response_send() callback
  * registered with the engine is invoked, which writes the response to
  * the subprocess channel.
  *
@@ -284,6 +284,9 @@ static void shell_pmi_debug_trace (void *client, const char *line)
     shell_trace ("%d: %s", task->rank, line);
 }
 
+/* Drain all complete request lines buffered for this task, so requests
+ * pipelined by a client are handled in one reactor callback.
+ */
 static void pmi_fd_cb (flux_shell_task_t *task,
                        const char *stream,
                        void *arg)
@@ -291,26 +294,29 @@ static void pmi_fd_cb (flux_shell_task_t *task,
     struct shell_pmi *pmi = arg;
     int len;
     const char *line;
+    int count = 0;
     int rc;
 
-    line = flux_subprocess_read_line (task->proc, "PMI_FD", &len);
-    if (len < 0) {
+    while ((line = flux_subprocess_read_line (task->proc, "PMI_FD", &len))) {
+        if (len == 0)
+            break;
+        count++;
+        rc = pmi_simple_server_request (pmi->server, line, task, task->rank);
+        if (rc < 0) {
+            shell_trace ("%d: S: pmi request error", task->rank);
+            return;
+        }
+        if (rc == 1) {
+            shell_trace ("%d: S: pmi finalized", task->rank);
+        }
+    }
+    if (!line) {
         shell_trace ("%d: C: pmi read error: %s",
                      task->rank, flux_strerror (errno));
         return;
     }
-    if (len == 0) {
+    if (count == 0)
         shell_trace ("%d: C: pmi EOF", task->rank);
-        return;
-    }
-    rc = pmi_simple_server_request (pmi->server, line, task, task->rank);
-    if (rc < 0) {
-        shell_trace ("%d: S: pmi request error", task->rank);
-        return;
-    }
-    if (rc == 1) {
-        shell_trace ("%d: S: pmi finalized", task->rank);
-    }
 }
 
 /* Generate 'PMI_process_mapping' key (see RFC 13) for MPI clique computation.
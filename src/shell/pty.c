@@ -83,10 +83,14 @@ static int pty_init (flux_plugin_t *p,
     if (!(t = shell_terminus_server_start (shell, shell_service)))
         return -1;
 
-    /*  Only create a session for rank 0 if the pty option was specified
+    /*  Only create a session for rank 0 if the pty option was specified.
+     *   Otherwise drop the task.exec handler, so tasks need not fork(2)
+     *   just to run it.
      */
-    if (flux_shell_getopt (shell, "pty", NULL) != 1)
+    if (flux_shell_getopt (shell, "pty", NULL) != 1) {
+        flux_plugin_remove_handler (p, "task.exec");
         return 0;
+    }
 
     /* On rank 0, open a pty for task 0 only. It is important that the
      *   pty service be started before the shell.init event, since a client
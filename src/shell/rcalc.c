@@ -22,17 +22,28 @@
 
 #include "rcalc.h"
 
-struct rankinfo {
-    int id;
-    int rank;
-    int ncores;
-    int ngpus;
+/* One R_lite entry: a set of ranks sharing the same children.
+ * Core and gpu lists are parsed once per entry, not once per rank.
+ */
+struct rlite_entry {
+    struct idset *ranks;
+    int base;                   /* nodeid of first rank in entry */
+    int nranks;
     const char *cores;
     const char *gpus;
+    int ncores;
+    int ngpus;
     cpu_set_t cpuset;
 };
 
+struct rankinfo {
+    int id;
+    int rank;
+    struct rlite_entry *entry;
+};
+
 struct allocinfo {
+    int id;
     int ncores_avail;
     int ntasks;
     int basis;
@@ -40,6 +51,8 @@ struct allocinfo {
 
 struct rcalc {
     json_t *json;
+    int nentries;
+    struct rlite_entry *entries;
     int nranks;
     int ncores;
     int ngpus;
@@ -48,181 +61,127 @@ struct rcalc {
     struct allocinfo *alloc;
 };
 
-
-static const char * nexttoken (const char *p, int sep)
-{
-    if (p)
-        p = strchr (p, sep);
-    if (p)
-        p++;
-    return (p);
-}
-
-/*
- *  Temporarily copied from src/bindings/lua/lua-affinity
+/*  Parse idset string 'str' into 'mask'.  Return 0 on success, or an
+ *   errno value on failure.
  */
-static int cstr_to_cpuset(cpu_set_t *mask, const char* str)
+static int cstr_to_cpuset (cpu_set_t *mask, const char *str)
 {
-    const char *p, *q;
-    char *endptr;
-    q = str;
-    CPU_ZERO(mask);
-
-    if (strlen (str) == 0)
-        return 0;
-
-    while (p = q, q = nexttoken(q, ','), p) {
-        unsigned long a; /* beginning of range */
-        unsigned long b; /* end of range */
-        unsigned long s; /* stride */
-        const char *c1, *c2;
-
-        a = strtoul(p, &endptr, 10);
-        if (endptr == p)
-            return EINVAL;
-        if (a >= CPU_SETSIZE)
-            return E2BIG;
-        /*
-         *  Leading zeros are an error:
-         */
-        if ((a != 0 && *p == '0') || (a == 0 && memcmp (p, "00", 2L) == 0))
-            return 1;
-
-        b = a;
-        s = 1;
-
-        c1 = nexttoken(p, '-');
-        c2 = nexttoken(p, ',');
-        if (c1 != NULL && (c2 == NULL || c1 < c2)) {
-
-            /*
-             *  Previous conversion should have used up all characters
-             *     up to next '-'
-             */
-            if (endptr != (c1-1)) {
-                return 1;
-            }
-
-            b = strtoul (c1, &endptr, 10);
-            if (endptr == c1)
-                return EINVAL;
-            if (b >= CPU_SETSIZE)
-                return E2BIG;
-
-            c1 = nexttoken(c1, ':');
-            if (c1 != NULL && (c2 == NULL || c1 < c2)) {
-                s = strtoul (c1, &endptr, 10);
-                if (endptr == c1)
-                    return EINVAL;
-                if (b >= CPU_SETSIZE)
-                    return E2BIG;
-            }
-        }
+    struct idset *ids;
+    unsigned int id;
+    int rc = 0;
 
-        if (!(a <= b))
-            return EINVAL;
-        while (a <= b) {
-            CPU_SET(a, mask);
-            a += s;
+    CPU_ZERO (mask);
+    if (!(ids = idset_decode (str)))
+        return EINVAL;
+    if (idset_last (ids) != IDSET_INVALID_ID
+        && idset_last (ids) >= CPU_SETSIZE)
+        rc = E2BIG;
+    else {
+        id = idset_first (ids);
+        while (id != IDSET_INVALID_ID) {
+            CPU_SET (id, mask);
+            id = idset_next (ids, id);
         }
     }
-
-    /*  Error if there are left over characters */
-    if (endptr && *endptr != '\0')
-        return EINVAL;
-
-    return 0;
+    idset_destroy (ids);
+    return rc;
 }
 
 static int cstr_count (const char *str)
 {
-    cpu_set_t set;
+    struct idset *ids;
+    int count;
+
     if (str == NULL)
         return 0;
-    if (cstr_to_cpuset (&set, str))
+    if (!(ids = idset_decode (str)))
         return -1;
-    return CPU_COUNT (&set);
+    count = idset_count (ids);
+    idset_destroy (ids);
+    return count;
 }
 
-static int rankinfo_get (json_t *o, struct rankinfo *ri)
+static int rlite_entry_parse (json_t *o, struct rlite_entry *e)
 {
     json_error_t error;
-    int rc = json_unpack_ex (o, &error, 0, "{s:i, s:{s:s,s?:s}}",
-                "rank", &ri->rank,
-                "children",
-                "core", &ri->cores,
-                "gpu",  &ri->gpus);
-    if (rc < 0) {
-        fprintf (stderr, "json_unpack: %s\n", error.text);
-        return -1;
-    }
-
-    if (!ri->cores || cstr_to_cpuset (&ri->cpuset, ri->cores))
-        return -1;
-
-    ri->ncores = CPU_COUNT (&ri->cpuset);
-    ri->ngpus = cstr_count (ri->gpus);
-    return (0);
-}
-
-static int expand_rank_ranges_one (json_t *out, json_t *entry)
-{
     const char *rank;
-    json_t *children;
-    struct idset *ids;
-    unsigned int id;
-    json_t *n;
 
-    if (json_unpack_ex (entry, NULL, 0,
-                        "{s:s s:o}",
+    if (json_unpack_ex (o, &error, 0, "{s:s, s:{s:s,s?:s}}",
                         "rank", &rank,
-                        "children", &children) < 0)
-        return -1;
-    if (!(ids = idset_decode (rank)))
+                        "children",
+                        "core", &e->cores,
+                        "gpu",  &e->gpus) < 0) {
+        fprintf (stderr, "json_unpack: %s\n", error.text);
         return -1;
-    id = idset_first (ids);
-    while (id != IDSET_INVALID_ID) {
-        if (!(n = json_pack ("{s:i s:O}",
-                             "rank", id,
-                             "children", children)))
-            return -1;
-        if (json_array_append_new (out, n) < 0) {
-            json_decref (n);
-            return -1;
-        }
-        id = idset_next (ids, id);
     }
-    idset_destroy (ids);
+    if (!(e->ranks = idset_decode (rank)))
+        return -1;
+    if (cstr_to_cpuset (&e->cpuset, e->cores)
+        || (e->ngpus = cstr_count (e->gpus)) < 0)
+        return -1;
+    e->ncores = CPU_COUNT (&e->cpuset);
+    e->nranks = idset_count (e->ranks);
     return 0;
 }
 
-/* Convert from R version 1 internal R_lite object to the earlier wreck R_lite
- * object understood by this module.  They are the same except Rv1 specifies
- * ranks as an idset rather than integer, allowing for compact representation.
+/*  Index R version 1 R_lite without expanding it: ranks are assigned
+ *   nodeids in R_lite order, ascending within each entry, and each rank
+ *   refers to the entry holding its children.
  */
-static json_t *expand_rank_ranges (json_t *R_lite)
+static int rcalc_index (rcalc_t *r, json_t *R_lite)
 {
-    json_t *out;
-    json_t *entry;
+    json_t *o;
     size_t index;
+    int i;
 
-    if (!(out = json_array ())) // accumulate new array
-        return NULL;
-    json_array_foreach (R_lite, index, entry) {
-        if (expand_rank_ranges_one (out, entry) < 0)
-            goto error;
+    /*  An empty R_lite has no ranks to index.  Return early, since
+     *   calloc() of zero entries may return NULL.
+     */
+    if ((r->nentries = json_array_size (R_lite)) == 0)
+        return 0;
+    if (!(r->entries = calloc (r->nentries, sizeof (struct rlite_entry))))
+        return -1;
+    json_array_foreach (R_lite, index, o) {
+        struct rlite_entry *e = &r->entries[index];
+        if (rlite_entry_parse (o, e) < 0)
+            return -1;
+        e->base = r->nranks;
+        r->nranks += e->nranks;
+        r->ncores += e->ncores * e->nranks;
+        r->ngpus += e->ngpus * e->nranks;
+    }
+    if (r->nranks == 0)
+        return 0;
+    if (!(r->ranks = calloc (r->nranks, sizeof (struct rankinfo)))
+        || !(r->alloc = calloc (r->nranks, sizeof (struct allocinfo))))
+        return -1;
+    for (i = 0; i < r->nentries; i++) {
+        struct rlite_entry *e = &r->entries[i];
+        struct rankinfo *ri = &r->ranks[e->base];
+        unsigned int id = idset_first (e->ranks);
+        while (id != IDSET_INVALID_ID) {
+            ri->id = ri - r->ranks;
+            ri->rank = id;
+            ri->entry = e;
+            ri++;
+            id = idset_next (e->ranks, id);
+        }
     }
-    return out;
-error:
-    json_decref (out);
-    return NULL;
+    return 0;
 }
 
 void rcalc_destroy (rcalc_t *r)
 {
+    int i;
+
     if (r == NULL)
         return;
     json_decref (r->json);
+    if (r->entries) {
+        for (i = 0; i < r->nentries; i++)
+            idset_destroy (r->entries[i].ranks);
+        free (r->entries);
+    }
     free (r->ranks);
     free (r->alloc);
     memset (r, 0, sizeof (*r));
@@ -231,7 +190,6 @@ void rcalc_destroy (rcalc_t *r)
 
 rcalc_t * rcalc_create_json (json_t *o)
 {
-    int i;
     int version;
     json_t *R_lite;
     rcalc_t *r = calloc (1, sizeof (*r));
@@ -243,24 +201,16 @@ rcalc_t * rcalc_create_json (json_t *o)
                         "execution",
                         "R_lite", &R_lite) < 0)
         goto fail;
-    if (version != 1) {
+    if (version != 1 || !json_is_array (R_lite)) {
         errno = EINVAL;
         goto fail;
     }
-    if (!(r->json = expand_rank_ranges (R_lite))) {
+    /*  Core and gpu strings point into R_lite, so hold a reference */
+    r->json = json_incref (R_lite);
+    if (rcalc_index (r, R_lite) < 0) {
         errno = EINVAL;
         goto fail;
     }
-    r->nranks = json_array_size (r->json);
-    r->ranks = calloc (r->nranks, sizeof (struct rankinfo));
-    r->alloc = calloc (r->nranks, sizeof (struct allocinfo));
-    for (i = 0; i < r->nranks; i++) {
-        r->ranks[i].id = i;
-        if (rankinfo_get (json_array_get (r->json, i), &r->ranks[i]) < 0)
-            goto fail;
-        r->ncores += r->ranks[i].ncores;
-        r->ngpus += r->ranks[i].ngpus;
-    }
     return (r);
 fail:
     rcalc_destroy (r);
@@ -329,24 +279,45 @@ static void allocinfo_clear (rcalc_t *r)
 {
     int i;
     memset (r->alloc, 0, sizeof (struct allocinfo) * r->nranks);
-    for (i = 0; i < r->nranks; i++)
-        r->alloc[i].ncores_avail = r->ranks[i].ncores;
+    for (i = 0; i < r->nranks; i++) {
+        r->alloc[i].id = i;
+        r->alloc[i].ncores_avail = r->ranks[i].entry->ncores;
+    }
 }
 
-static int cmp_alloc_cores (struct allocinfo *x, struct allocinfo *y)
+/*  Order by available cores, largest first, then by nodeid.
+ */
+static int cmp_alloc_cores (const void *a, const void *b)
 {
-    return (x->ncores_avail < y->ncores_avail);
+    const struct allocinfo *x = *(const struct allocinfo **) a;
+    const struct allocinfo *y = *(const struct allocinfo **) b;
+
+    if (x->ncores_avail != y->ncores_avail)
+        return x->ncores_avail < y->ncores_avail ? 1 : -1;
+    return x->id - y->id;
 }
 
 zlist_t *alloc_list_sorted (rcalc_t *r)
 {
     int i;
-    zlist_t *l = zlist_new ();
-    if (l == NULL)
+    struct allocinfo **v;
+    zlist_t *l;
+
+    if (!(v = calloc (r->nranks, sizeof (*v))))
         return (NULL);
     for (i = 0; i < r->nranks; i++)
-        zlist_append (l, &r->alloc[i]);
-    zlist_sort (l, (zlist_compare_fn *) cmp_alloc_cores);
+        v[i] = &r->alloc[i];
+    qsort (v, r->nranks, sizeof (*v), cmp_alloc_cores);
+    if ((l = zlist_new ())) {
+        for (i = 0; i < r->nranks; i++) {
+            if (zlist_append (l, v[i]) < 0) {
+                zlist_destroy (&l);
+                errno = ENOMEM;
+                break;
+            }
+        }
+    }
+    free (v);
     return (l);
 }
 
@@ -455,13 +426,31 @@ int rcalc_distribute_per_resource (rcalc_t *r, const char *name, int ntasks)
     return 0;
 }
 
+static int cmp_rank (const void *a, const void *b)
+{
+    const struct rankinfo *x = a;
+    const struct rankinfo *y = b;
+    return x->rank - y->rank;
+}
+
+/*  Find 'rank' by checking each entry's rank idset, then searching the
+ *   entry's slice of r->ranks, which is in ascending rank order.
+ */
 static struct rankinfo *rcalc_rankinfo_find (rcalc_t *r, int rank)
 {
+    struct rankinfo key = { .rank = rank };
     int i;
-    for (i = 0; i < r->nranks; i++) {
-        struct rankinfo *ri = &r->ranks[i];
-        if (ri->rank == rank)
-            return (ri);
+
+    if (rank < 0)
+        return (NULL);
+    for (i = 0; i < r->nentries; i++) {
+        struct rlite_entry *e = &r->entries[i];
+        if (idset_test (e->ranks, rank))
+            return bsearch (&key,
+                            &r->ranks[e->base],
+                            e->nranks,
+                            sizeof (struct rankinfo),
+                            cmp_rank);
     }
     return (NULL);
 }
@@ -484,18 +473,19 @@ static void rcalc_rankinfo_set (rcalc_t *r, int id,
                                 struct rcalc_rankinfo *rli)
 {
     struct rankinfo *ri = &r->ranks[id];
+    struct rlite_entry *e = ri->entry;
     struct allocinfo *ai = &r->alloc[id];
     rli->nodeid = ri->id;
     rli->rank =   ri->rank;
-    rli->ncores = ri->ncores;
+    rli->ncores = e->ncores;
     rli->ntasks = ai->ntasks;
     rli->global_basis =  ai->basis;
-    memcpy (&rli->cpuset, &ri->cpuset, sizeof (cpu_set_t));
+    memcpy (&rli->cpuset, &e->cpuset, sizeof (cpu_set_t));
     /*  Copy cores string to rli, in the very unlikely event that
      *   we get a huge cores string, indicate truncation.
      */
-    strcpy_trunc (rli->cores, sizeof (rli->cores), ri->cores);
-    strcpy_trunc (rli->gpus, sizeof (rli->gpus), ri->gpus);
+    strcpy_trunc (rli->cores, sizeof (rli->cores), e->cores);
+    strcpy_trunc (rli->gpus, sizeof (rli->gpus), e->gpus);
 }
 
 int rcalc_get_rankinfo (rcalc_t *r, int rank, struct rcalc_rankinfo *rli)
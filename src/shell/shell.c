@@ -513,6 +513,30 @@ int flux_shell_add_event_handler (flux_shell_t *shell,
     return 0;
 }
 
+/* Respond to "stats" requests with internal counters of this shell.
+ */
+static void shell_stats_cb (flux_t *h,
+                            flux_msg_handler_t *mh,
+                            const flux_msg_t *msg,
+                            void *arg)
+{
+    flux_shell_t *shell = arg;
+    json_t *o;
+
+    if (!(o = shell_eventlogger_stats (shell->ev)))
+        goto error;
+    if (flux_respond_pack (h,
+                           msg,
+                           "{s:i s:o}",
+                           "rank", shell->info->shell_rank,
+                           "eventlogger", o) < 0)
+        shell_log_errno ("flux_respond");
+    return;
+error:
+    if (flux_respond_error (h, msg, errno, NULL) < 0)
+        shell_log_errno ("flux_respond");
+}
+
 struct service_wrap_arg
 {
     flux_shell_t *shell;
@@ -1106,6 +1130,7 @@ static int shell_register_event_context (flux_shell_t *shell)
 int main (int argc, char *argv[])
 {
     flux_shell_t shell;
+    flux_cmd_t *task_cmd;
     int i;
 
     /* Initialize locale from environment
@@ -1159,11 +1184,23 @@ int main (int argc, char *argv[])
     if (!(shell.svc = shell_svc_create (&shell)))
         shell_die (1, "shell_svc_create");
 
+    if (flux_shell_service_register (&shell,
+                                     "stats",
+                                     shell_stats_cb,
+                                     &shell) < 0)
+        shell_die_errno (1, "failed to register stats service");
+
     /* Call shell initialization routines and "shell_init" plugins.
      */
     if (shell_init (&shell) < 0)
         shell_die_errno (1, "shell_init");
 
+    /* Commit eventlog appends made during initialization, e.g. output
+     *  and input eventlog headers, in one transaction before the barrier.
+     */
+    if (!shell.standalone && shell_eventlogger_flush (shell.ev) < 0)
+        shell_die_errno (1, "failed to commit initial eventlog entries");
+
     /* Barrier to ensure initialization has completed across all shells.
      */
     if (shell_barrier (&shell, "init") < 0)
@@ -1177,18 +1214,18 @@ int main (int argc, char *argv[])
         && shell_eventlogger_emit_event (shell.ev, 0, "shell.init") < 0)
             shell_die_errno (1, "failed to emit event shell.init");
 
-    /* Create tasks
+    /* Create tasks from a command with the job-wide environment
      */
     if (!(shell.tasks = zlist_new ()))
         shell_die (1, "zlist_new failed");
+    if (!(task_cmd = shell_task_cmd_create (shell.info)))
+        shell_die (1, "shell_task_cmd_create");
     for (i = 0; i < shell.info->rankinfo.ntasks; i++) {
         struct shell_task *task;
 
-        if (!(task = shell_task_create (shell.info, i)))
+        if (!(task = shell_task_create (shell.info, task_cmd, i)))
             shell_die (1, "shell_task_create index=%d", i);
 
-        task->pre_exec_cb = shell_task_exec;
-        task->pre_exec_arg = &shell;
         shell.current_task = task;
 
         /*  Call all plugin task_init callbacks:
@@ -1196,6 +1233,14 @@ int main (int argc, char *argv[])
         if (shell_task_init (&shell) < 0)
             shell_die (1, "failed to initialize taskid=%d", i);
 
+        /*  Only run task.exec callbacks in the child if a plugin has one,
+         *   so tasks may otherwise be launched without fork(2).
+         */
+        if (plugstack_has_handler (shell.plugstack, "task.exec")) {
+            task->pre_exec_cb = shell_task_exec;
+            task->pre_exec_arg = &shell;
+        }
+
         if (shell_task_start (task, shell.r, task_completion_cb, &shell) < 0) {
             int ec = 1;
             /* bash standard, 126 for permission/access denied, 127
@@ -1222,6 +1267,8 @@ int main (int argc, char *argv[])
         if (shell_task_forked (&shell) < 0)
             shell_die (1, "shell_task_forked");
     }
+    flux_cmd_destroy (task_cmd);
+
     /*  Reset current task since we've left task-specific context:
      */
     shell.current_task = NULL;
@@ -53,7 +53,14 @@ struct shell_task {
 
 void shell_task_destroy (struct shell_task *task);
 
-struct shell_task *shell_task_create (struct shell_info *info, int index);
+/* Create the command shared by all tasks of the job, with job-wide
+ * environment already set.  Tasks are created from copies of it.
+ */
+flux_cmd_t *shell_task_cmd_create (struct shell_info *info);
+
+struct shell_task *shell_task_create (struct shell_info *info,
+                                      const flux_cmd_t *cmd,
+                                      int index);
 
 int shell_task_start (struct shell_task *task,
                       flux_reactor_t *r,
@@ -13,6 +13,7 @@
 #endif
 
 #include <errno.h>
+#include <stdbool.h>
 #include <string.h>
 #include <flux/core.h>
 
@@ -64,6 +65,99 @@ static int check_name (flux_plugin_t *p, const char *s,
     return plugstack_call (st, "next.level", args);
 }
 
+static int called_replaced = 0;
+static int called_replacement = 0;
+
+static int replaced (flux_plugin_t *p, const char *s,
+                     flux_plugin_arg_t *args, void *arg)
+{
+    called_replaced++;
+    return 0;
+}
+
+static int replacement (flux_plugin_t *p, const char *s,
+                        flux_plugin_arg_t *args, void *arg)
+{
+    called_replacement++;
+    return 0;
+}
+
+/*  Replace plugin "two" with a new plugin of the same name from within
+ *   a callback, the first time only.
+ */
+static int replace_two (flux_plugin_t *p, const char *s,
+                        flux_plugin_arg_t *args, void *arg)
+{
+    struct plugstack *st = arg;
+    flux_plugin_t *p2;
+    static bool done = false;
+
+    if (done)
+        return 0;
+    done = true;
+    if (!(p2 = flux_plugin_create ())
+        || flux_plugin_set_name (p2, "two") < 0
+        || flux_plugin_add_handler (p2, "run", replacement, NULL) < 0
+        || plugstack_push (st, p2) < 0) {
+        flux_plugin_destroy (p2);
+        return -1;
+    }
+    return 0;
+}
+
+void test_handler_cache (void)
+{
+    struct plugstack *st;
+    flux_plugin_t *p1;
+    flux_plugin_t *p2;
+
+    if (!(st = plugstack_create ())
+        || !(p1 = flux_plugin_create ())
+        || !(p2 = flux_plugin_create ()))
+        BAIL_OUT ("plugstack_create/flux_plugin_create failed");
+    if (flux_plugin_set_name (p1, "one") < 0
+        || flux_plugin_set_name (p2, "two") < 0
+        || flux_plugin_add_handler (p2, "run", replaced, NULL) < 0)
+        BAIL_OUT ("failed to set up plugins");
+
+    ok (plugstack_push (st, p1) == 0 && plugstack_push (st, p2) == 0,
+        "pushed two plugins");
+    ok (plugstack_has_handler (st, "run"),
+        "plugstack_has_handler (run) is true");
+    ok (!plugstack_has_handler (st, "walk"),
+        "plugstack_has_handler (walk) is false");
+
+    ok (flux_plugin_add_handler (p1, "walk", replaced, NULL) == 0,
+        "added walk handler to plugin after push");
+    ok (plugstack_has_handler (st, "walk"),
+        "plugstack_has_handler (walk) is now true");
+    called_replaced = 0;
+    ok (plugstack_call (st, "walk", NULL) == 0 && called_replaced == 1,
+        "plugstack_call (walk) calls handler added after push");
+    ok (flux_plugin_remove_handler (p1, "walk") == 0,
+        "removed walk handler from plugin");
+    called_replaced = 0;
+    ok (plugstack_call (st, "walk", NULL) == 0 && called_replaced == 0,
+        "plugstack_call (walk) no longer calls removed handler");
+    ok (!plugstack_has_handler (st, "walk"),
+        "plugstack_has_handler (walk) is false again");
+
+    ok (flux_plugin_add_handler (p1, "run", replace_two, st) == 0,
+        "added handler that replaces plugin 'two' to plugin 'one'");
+    called_replaced = 0;
+    called_replacement = 0;
+    ok (plugstack_call (st, "run", NULL) == 0,
+        "plugstack_call (run) works when a plugin is replaced by callback");
+    ok (called_replaced == 0 && called_replacement == 0,
+        "unloaded plugin was skipped, new plugin not called until next time");
+    ok (plugstack_call (st, "run", NULL) == 0,
+        "plugstack_call (run) works again");
+    ok (called_replaced == 0 && called_replacement == 1,
+        "replacement plugin was called");
+
+    plugstack_destroy (st);
+}
+
 void test_invalid_args (struct plugstack *st, flux_plugin_t *p)
 {
     ok (plugstack_push (NULL, p) < 0 && errno == EINVAL,
@@ -254,6 +348,7 @@ int main (int argc, char **argv)
     plugstack_destroy (st);
     flux_plugin_arg_destroy (args);
 
+    test_handler_cache ();
     test_load ();
     done_testing ();
     return 0;
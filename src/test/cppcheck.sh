@@ -2,7 +2,6 @@
 cppcheck --force --inline-suppr -j 2 --std=c99 --quiet \
     --error-exitcode=1 \
     -i src/common/libev \
-    -i src/common/liblsd \
     -i src/common/libtap \
     -i src/common/libminilzo \
     -i src/bindings/python \
@@ -0,0 +1,69 @@
+#!/bin/bash
+#
+# Run a series of single-core jobs one at a time and print statistics
+#  for job shell startup latency, i.e. the time from the exec system
+#  "starting" event to the shell "shell.start" event in the exec eventlog.
+#
+declare prog=$(basename $0)
+
+declare NJOBS=100
+
+declare -r long_opts="help,jobs:,setopt:"
+declare -r short_opts="hj:o:"
+declare -r usage="\
+\n\
+Usage: $prog [OPTIONS]\n\
+Measure flux-shell startup latency for single-core jobs.\n\
+Run under a Flux instance, e.g. flux start $prog\n\
+\n\
+Options:\n\
+ -h, --help              display this messages\n\
+ -j, --jobs=NJOBS        set number of jobs to run (default=${NJOBS})\n\
+ -o, --setopt=OPT        set shell option OPT on each job, e.g.\n\
+                         -o cpu-affinity=off (may be repeated)\n"
+
+log() { local fmt=$1; shift; printf >&2 "$prog: $fmt" "$@"; }
+die() { log "$@" && exit 1; }
+
+GETOPTS=$(/usr/bin/getopt -u -o $short_opts -l $long_opts -n $prog -- $@)
+if test $? != 0; then
+    echo  "$usage"
+    exit 1
+fi
+
+eval set -- "$GETOPTS"
+while true; do
+    case "$1" in
+      -j|--jobs)            NJOBS=$2;   shift 2 ;;
+      -o|--setopt)          OPTS="$OPTS -o $2"; shift 2 ;;
+      --)                   shift ; break ;     ;;
+      -h|--help)            echo -e "$usage" ; exit 0           ;;
+      *)                    die "Invalid option '$1'\n$usage"   ;;
+    esac
+done
+
+flux getattr rank >/dev/null 2>&1 || die "must be run under Flux\n"
+
+log "On branch $(git rev-parse --abbrev-ref HEAD): $(git describe)\n"
+log "running $NJOBS single-core jobs${OPTS:+ with$OPTS}\n"
+
+for i in $(seq 1 $NJOBS); do
+    id=$(flux mini submit -n1 $OPTS true) || die "submit failed\n"
+    flux job wait-event $id clean >/dev/null || die "job $id failed\n"
+    flux job eventlog -p guest.exec.eventlog $id \
+        | awk '$2 == "starting" {t0 = $1} \
+               $2 == "shell.start" {printf "%.6f\n", $1 - t0}'
+done | sort -n | awk -v prog=$prog '
+    { t[NR] = $1; sum += $1 }
+    END {
+        if (NR == 0) {
+            printf "%s: no shell.start events found\n", prog > "/dev/stderr"
+            exit 1
+        }
+        printf "%s: shell startup over %d jobs:", prog, NR > "/dev/stderr"
+        printf " min %.3fms median %.3fms mean %.3fms max %.3fms\n",
+               t[1] * 1000, t[int((NR + 1) / 2)] * 1000,
+               sum / NR * 1000, t[NR] * 1000 > "/dev/stderr"
+    }'
+
+# vi: ts=4 sw=4 expandtab
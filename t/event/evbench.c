@@ -0,0 +1,152 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* evbench - measure event broadcast latency over the TBON
+ *
+ * Run one copy per broker, e.g. flux exec -r all evbench -n SIZE.
+ * After a barrier, the copy on rank 0 publishes COUNT events, each
+ * carrying the wallclock time of publication, and every copy reports
+ * the mean and max delay until receipt.  Since wallclock time is compared
+ * across processes, results are only meaningful when all brokers share
+ * a clock, as in the test suite.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <getopt.h>
+#include <time.h>
+#include <jansson.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/log.h"
+
+#define OPTIONS "hn:c:"
+static const struct option longopts[] = {
+    {"help",       no_argument,        0, 'h'},
+    {"nprocs",     required_argument,  0, 'n'},
+    {"count",      required_argument,  0, 'c'},
+    { 0, 0, 0, 0 },
+};
+
+void usage (void)
+{
+    fprintf (stderr,
+"Usage: evbench [-n NPROCS] [-c COUNT]\n"
+);
+    exit (1);
+}
+
+static double now_usec (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_REALTIME, &ts);
+    return ts.tv_sec * 1E6 + ts.tv_nsec / 1E3;
+}
+
+int main (int argc, char *argv[])
+{
+    flux_t *h;
+    flux_future_t *f;
+    flux_future_t **pub;
+    struct flux_match match = FLUX_MATCH_EVENT;
+    uint32_t rank;
+    int nprocs = 1;
+    int count = 100;
+    double sum = 0.;
+    double max = 0.;
+    int ch;
+    int i;
+
+    log_init ("evbench");
+
+    while ((ch = getopt_long (argc, argv, OPTIONS, longopts, NULL)) != -1) {
+        switch (ch) {
+            case 'h': /* --help */
+                usage ();
+                break;
+            case 'n': /* --nprocs N */
+                nprocs = strtoul (optarg, NULL, 10);
+                break;
+            case 'c': /* --count N */
+                count = strtoul (optarg, NULL, 10);
+                break;
+            default:
+                usage ();
+                break;
+        }
+    }
+    if (optind < argc || nprocs < 1 || count < 1)
+        usage ();
+
+    if (!(h = flux_open (NULL, 0)))
+        log_err_exit ("flux_open");
+    if (flux_get_rank (h, &rank) < 0)
+        log_err_exit ("flux_get_rank");
+    if (flux_event_subscribe (h, "evbench.ping") < 0)
+        log_err_exit ("flux_event_subscribe");
+
+    /* Ensure all subscribers are in place before the first event is sent.
+     */
+    if (!(f = flux_barrier (h, "evbench", nprocs))
+        || flux_future_get (f, NULL) < 0)
+        log_err_exit ("flux_barrier");
+    flux_future_destroy (f);
+
+    if (!(pub = calloc (count, sizeof (pub[0]))))
+        log_err_exit ("calloc");
+    if (rank == 0) {
+        for (i = 0; i < count; i++) {
+            if (!(pub[i] = flux_event_publish_pack (h,
+                                                    "evbench.ping",
+                                                    0,
+                                                    "{s:i s:f}",
+                                                    "seq", i,
+                                                    "t", now_usec ())))
+                log_err_exit ("flux_event_publish_pack");
+        }
+    }
+
+    match.topic_glob = "evbench.ping";
+    for (i = 0; i < count; i++) {
+        flux_msg_t *msg;
+        double t;
+        double delay;
+
+        if (!(msg = flux_recv (h, match, 0)))
+            log_err_exit ("flux_recv");
+        if (flux_event_unpack (msg, NULL, "{s:f}", "t", &t) < 0)
+            log_err_exit ("flux_event_unpack");
+        delay = now_usec () - t;
+        sum += delay;
+        if (delay > max)
+            max = delay;
+        flux_msg_destroy (msg);
+    }
+
+    for (i = 0; i < count; i++) {
+        if (pub[i] && flux_future_get (pub[i], NULL) < 0)
+            log_err_exit ("event publish");
+        flux_future_destroy (pub[i]);
+    }
+    free (pub);
+
+    printf ("evbench rank=%u count=%d mean=%.1fus max=%.1fus\n",
+            (unsigned int)rank, count, sum / count, max);
+
+    flux_close (h);
+    log_fini ();
+    return 0;
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
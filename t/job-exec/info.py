@@ -0,0 +1,24 @@
+###############################################################
+# Copyright 2020 Lawrence Livermore National Security, LLC
+# (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+#
+# This file is part of the Flux resource manager framework.
+# For details, see https://github.com/flux-framework.
+#
+# SPDX-License-Identifier: LGPL-3.0
+###############################################################
+
+# Usage: flux python info.py JOBID
+#
+# Print the job-exec.info response for JOBID from the local broker.
+#
+
+import sys
+import flux
+from flux.job import JobID
+
+if len(sys.argv) != 2:
+    sys.exit("Usage: info.py JOBID")
+
+h = flux.Flux()
+print(h.rpc("job-exec.info", {"id": int(JobID(sys.argv[1]))}).get_str())
@@ -0,0 +1,80 @@
+#!/bin/bash
+#
+#  Measure job start latency vs. node count for job-exec launch modes
+#
+#  Usage: start-latency.sh [-c COUNT] [-f FANOUT] NNODES...
+#
+#  For each NNODES, run COUNT jobs of /bin/true as the job shell on
+#  NNODES nodes with each of the following job-exec configurations, and
+#  report the mean and max time from the "alloc" event to the "start"
+#  event in the job eventlog:
+#
+#  testexec   mock execution (attributes.system.exec.test), no shells are
+#             launched.  This is the baseline cost of the exec protocol.
+#  flat       job shells launched directly from rank 0
+#  tree:K     job shells launched hierarchically with tree-fanout=K
+#
+#  Must be run within an instance of at least max(NNODES) brokers, with
+#  job-exec loaded on all ranks.  The job-exec module on rank 0 is
+#  reloaded with each configuration, and finally restored with its
+#  default options.
+#
+
+die() { echo "start-latency: $@" >&2; exit 1; }
+
+count=5
+fanout=2
+while getopts "c:f:" opt; do
+    case $opt in
+        c) count=$OPTARG ;;
+        f) fanout=$OPTARG ;;
+        *) die "Usage: $0 [-c COUNT] [-f FANOUT] NNODES..." ;;
+    esac
+done
+shift $((OPTIND-1))
+test $# -gt 0 || die "Usage: $0 [-c COUNT] [-f FANOUT] NNODES..."
+which jq >/dev/null 2>&1 || die "jq is required"
+
+#  Print alloc to start delay of job $1 in seconds
+start_delay() {
+    flux kvs get --raw $(flux job id --to=kvs $1).eventlog \
+        | jq -s 'map({(.name): .timestamp}) | add | .start - .alloc'
+}
+
+#  Usage: run_jobs MODE NNODES
+run_jobs() {
+    local mode=$1
+    local nnodes=$2
+    local filter='.attributes.system.exec.job_shell = "/bin/true"'
+    local ids=""
+    if test "$mode" = "testexec"; then
+        filter='.attributes.system.exec.test.run_duration = "0.001s"'
+    fi
+    for i in $(seq 1 $count); do
+        id=$(flux jobspec srun -N$nnodes /bin/true \
+            | jq "$filter" \
+            | flux job submit) || die "job submit failed"
+        flux job wait-event $id clean || die "job $id failed"
+        ids="$ids $id"
+    done
+    for id in $ids; do
+        start_delay $id
+    done | awk -v mode=$mode -v n=$nnodes '
+        { sum += $1; if ($1 > max) max = $1 }
+        END { printf "%-10s %6d %10.4f %10.4f\n", mode, n, sum/NR, max }'
+}
+
+printf "%-10s %6s %10s %10s\n" MODE NNODES MEAN MAX
+for nnodes in "$@"; do
+    run_jobs testexec $nnodes
+
+    flux module reload job-exec tree-fanout=0 || die "module reload failed"
+    run_jobs flat $nnodes
+
+    flux module reload job-exec tree-fanout=$fanout \
+        || die "module reload failed"
+    run_jobs tree:$fanout $nnodes
+done
+flux module reload job-exec || die "module reload failed"
+
+# vi: ts=4 sw=4 expandtab
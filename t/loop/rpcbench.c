@@ -0,0 +1,128 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* rpcbench - measure RPC rate over the loop connector
+ *
+ * Usage: rpcbench [count] [window]
+ *
+ * Send 'count' RPCs to a request handler on the same handle, keeping at
+ * most 'window' in flight, and report RPCs per second.  Since the loop
+ * connector has no transport cost, this mostly measures the per-RPC
+ * overhead of libflux (matchtags, message handlers, futures, dispatch).
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <flux/core.h>
+
+#include "src/common/libutil/monotime.h"
+
+struct bench {
+    flux_t *h;
+    int count;
+    int sent;
+    int received;
+};
+
+static void die (const char *s)
+{
+    fprintf (stderr, "rpcbench: %s: %s\n", s, strerror (errno));
+    exit (1);
+}
+
+static void echo_cb (flux_t *h, flux_msg_handler_t *mh,
+                     const flux_msg_t *msg, void *arg)
+{
+    if (flux_respond (h, msg, NULL) < 0)
+        die ("flux_respond");
+}
+
+static flux_future_t *produce (flux_future_t *pf, void *arg)
+{
+    struct bench *b = arg;
+
+    if (b->sent == b->count) {
+        errno = ENODATA;
+        return NULL;
+    }
+    b->sent++;
+    return flux_rpc (b->h, "bench.echo", NULL, FLUX_NODEID_ANY, 0);
+}
+
+static int consume (flux_future_t *pf, flux_future_t *f, void *arg)
+{
+    struct bench *b = arg;
+
+    if (flux_future_get (f, NULL) < 0)
+        return -1;
+    b->received++;
+    return 0;
+}
+
+static void done_cb (flux_future_t *pf, void *arg)
+{
+    if (flux_future_get (pf, NULL) < 0)
+        die ("pipeline");
+    flux_reactor_stop (flux_future_get_reactor (pf));
+}
+
+int main (int argc, char *argv[])
+{
+    struct bench b = { 0 };
+    int window = 256;
+    flux_msg_handler_t *mh;
+    struct flux_match match = FLUX_MATCH_REQUEST;
+    flux_future_t *pf;
+    struct timespec t0;
+    double elapsed;
+
+    if (argc > 3) {
+        fprintf (stderr, "Usage: rpcbench [count] [window]\n");
+        exit (1);
+    }
+    b.count = argc > 1 ? strtoul (argv[1], NULL, 10) : 100000;
+    if (argc > 2)
+        window = strtoul (argv[2], NULL, 10);
+
+    if (!(b.h = flux_open ("loop://", 0)))
+        die ("flux_open");
+    match.topic_glob = "bench.echo";
+    if (!(mh = flux_msg_handler_create (b.h, match, echo_cb, NULL)))
+        die ("flux_msg_handler_create");
+    flux_msg_handler_start (mh);
+
+    monotime (&t0);
+    if (!(pf = flux_rpc_pipeline (b.h, window, 0, produce, consume, &b))
+        || flux_future_then (pf, -1., done_cb, NULL) < 0)
+        die ("flux_rpc_pipeline");
+    if (flux_reactor_run (flux_get_reactor (b.h), 0) < 0)
+        die ("flux_reactor_run");
+    elapsed = monotime_since (t0) / 1000.;
+
+    if (b.received != b.count) {
+        fprintf (stderr, "rpcbench: received %d of %d responses\n",
+                 b.received, b.count);
+        exit (1);
+    }
+    printf ("%d RPCs (window=%d) in %.3fs: %.0f RPC/s\n",
+            b.count, window, elapsed,
+            elapsed > 0. ? b.count / elapsed : 0.);
+
+    flux_future_destroy (pf);
+    flux_msg_handler_destroy (mh);
+    flux_close (b.h);
+    exit (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
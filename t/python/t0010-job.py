@@ -28,6 +28,7 @@ import flux.kvs
 from flux import job
 from flux.job import Jobspec, JobspecV1, ffi
 from flux.job.list import VALID_ATTRS
+from flux.job.validator import ValidatorWorker
 from flux.future import Future
 
 
@@ -434,6 +435,86 @@ class TestJob(unittest.TestCase):
         valid_attrs = self.fh.rpc("job-info.list-attrs", "{}").get()["attrs"]
         self.assertEqual(set(valid_attrs), set(VALID_ATTRS))
 
+    def test_26_submit_bulk(self):
+        ids = job.submit_bulk(self.fh, [self.basic_jobspec], count=3)
+        self.assertEqual(len(ids), 3)
+        self.assertEqual(ids, sorted(set(ids)))
+
+        ids = job.submit_bulk(self.fh, [self.basic_jobspec] * 2, count=2)
+        self.assertEqual(len(ids), 4)
+        self.assertEqual(ids, sorted(set(ids)))
+        for jobid in ids:
+            jobspec = job.job_kvs(self.fh, jobid)["jobspec"]
+            self.assertEqual(jobspec["version"], 1)
+
+    def test_27_submit_bulk_async(self):
+        future = job.submit_bulk_async(self.fh, [self.basic_jobspec], count=10)
+        ids = future.get_ids()
+        self.assertEqual(len(ids), 10)
+
+    def test_28_submit_bulk_invalid(self):
+        with self.assertRaises(TypeError):
+            job.submit_bulk(self.fh, self.basic_jobspec)
+        with self.assertRaises(EnvironmentError) as error:
+            job.submit_bulk(self.fh, [])
+        self.assertEqual(error.exception.errno, errno.EINVAL)
+        with self.assertRaises(EnvironmentError) as error:
+            job.submit_bulk(self.fh, [self.basic_jobspec], count=0)
+        self.assertEqual(error.exception.errno, errno.EINVAL)
+
+        # one invalid jobspec fails the whole request
+        invalid = json.dumps({"version": 1})
+        with self.assertRaises(EnvironmentError) as error:
+            job.submit_bulk(self.fh, [self.basic_jobspec, invalid])
+        self.assertEqual(error.exception.errno, errno.EINVAL)
+        self.assertIn("jobs[1]", error.exception.strerror)
+
+    def test_29_validator_worker(self):
+        def run_worker(lines):
+            rfd, wfd = os.pipe()
+            os.write(wfd, "".join(line + "\n" for line in lines).encode())
+            os.close(wfd)
+            out = six.StringIO()
+            with os.fdopen(rfd, "rb") as infile:
+                ValidatorWorker(job.validate_jobspec, infile, out).run()
+            return [json.loads(line) for line in out.getvalue().splitlines()]
+
+        invalid = json.dumps({"version": 1})
+
+        # protocol version 2: ids are returned with each result
+        results = run_worker(
+            [
+                json.dumps({"protocol": 2}),
+                '{{"id":7,"data":{}}}'.format(self.basic_jobspec),
+                '{{"id":3,"data":{}}}'.format(invalid),
+            ]
+        )
+        self.assertEqual(results[0], {"protocol": 2})
+        self.assertEqual(results[1], {"id": 7, "errnum": 0})
+        self.assertEqual(results[2]["id"], 3)
+        self.assertEqual(results[2]["errnum"], 1)
+        self.assertIn("Missing key", results[2]["errstr"])
+
+        # protocol version 2: malformed lines do not stop the worker
+        results = run_worker(
+            [
+                json.dumps({"protocol": 2}),
+                '{"id":5,"data":',
+                json.dumps({"id": 4}),
+                "[]",
+                '{{"id":6,"data":{}}}'.format(self.basic_jobspec),
+            ]
+        )
+        self.assertEqual(len(results), 3)
+        self.assertEqual(results[1]["id"], 4)
+        self.assertEqual(results[1]["errnum"], 1)
+        self.assertEqual(results[2], {"id": 6, "errnum": 0})
+
+        # protocol version 1: one result per line, in order
+        results = run_worker([self.basic_jobspec, invalid])
+        self.assertEqual(results[0], {"errnum": 0})
+        self.assertEqual(results[1]["errnum"], 1)
+
 
 if __name__ == "__main__":
     from subflux import rerun_under_flux
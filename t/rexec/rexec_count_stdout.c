@@ -31,6 +31,8 @@ static struct optparse_option cmdopts[] = {
       .usage = "Specify rank for test" },
     { .name = "linebuffer", .key = 'l', .has_arg = 1, .arginfo = "bool",
       .usage = "Specify true/false for line buffering" },
+    { .name = "coalesce", .key = 'c', .has_arg = 1, .arginfo = "bool",
+      .usage = "Specify true/false for output coalescing" },
     OPTPARSE_TABLE_END
 };
 
@@ -128,6 +130,14 @@ int main (int argc, char *argv[])
             log_err_exit ("flux_cmd_setopt");
     }
 
+    if (optparse_getopt (opts, "coalesce", &optargp) > 0) {
+        if (strcasecmp (optargp, "true")
+            && strcasecmp (optargp, "false"))
+            log_err_exit ("invalid coalesce value");
+        if (flux_cmd_setopt (cmd, "stdout_COALESCE", optargp) < 0)
+            log_err_exit ("flux_cmd_setopt");
+    }
+
     if (!(h = flux_open (NULL, 0)))
         log_err_exit ("flux_open");
 
@@ -0,0 +1,152 @@
+/************************************************************\
+ * Copyright 2020 Lawrence Livermore National Security, LLC
+ * (c.f. AUTHORS, NOTICE.LLNS, COPYING)
+ *
+ * This file is part of the Flux resource manager framework.
+ * For details, see https://github.com/flux-framework.
+ *
+ * SPDX-License-Identifier: LGPL-3.0
+\************************************************************/
+
+/* rcalc-bench - measure the per-shell cost of rcalc on a large R
+ *
+ * Usage: rcalc-bench [nranks] [ncores] [iterations]
+ *
+ * Build a synthetic R with 'nranks' ranks of 'ncores' cores each, split
+ * into R_lite entries of 64 ranks whose core lists alternate between a
+ * dense range and a list of single cores.  Each iteration then does what
+ * one job shell does: create rcalc from the encoded R, distribute one
+ * task per core, and look up its own rank (the last one).  Report the
+ * average time per iteration.
+ */
+
+#if HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <jansson.h>
+
+#include "src/shell/rcalc.h"
+#include "src/common/libutil/monotime.h"
+
+static const int ranks_per_entry = 64;
+
+static void die (const char *s)
+{
+    fprintf (stderr, "rcalc-bench: %s: %s\n", s, strerror (errno));
+    exit (1);
+}
+
+static char *core_list (int ncores, bool dense)
+{
+    char *s;
+    int i, n = 0;
+
+    if (dense) {
+        if (asprintf (&s, "0-%d", ncores - 1) < 0)
+            die ("asprintf");
+        return s;
+    }
+    if (!(s = malloc (ncores * 8 + 1)))
+        die ("malloc");
+    for (i = 0; i < ncores; i++)
+        n += sprintf (s + n, "%s%d", i > 0 ? "," : "", i);
+    return s;
+}
+
+static char *create_R (int nranks, int ncores)
+{
+    json_t *R_lite;
+    json_t *R;
+    char *s;
+    int i;
+
+    if (!(R_lite = json_array ()))
+        die ("json_array");
+    for (i = 0; i < nranks; i += ranks_per_entry) {
+        int last = i + ranks_per_entry - 1;
+        char ranks[64];
+        char *cores = core_list (ncores, (i / ranks_per_entry) % 2 == 0);
+        json_t *entry;
+
+        snprintf (ranks, sizeof (ranks), "%d-%d",
+                  i, last < nranks ? last : nranks - 1);
+        if (!(entry = json_pack ("{s:s s:{s:s}}",
+                                 "rank", ranks,
+                                 "children", "core", cores))
+            || json_array_append_new (R_lite, entry) < 0)
+            die ("json_pack");
+        free (cores);
+    }
+    if (!(R = json_pack ("{s:i s:{s:o}}",
+                         "version", 1,
+                         "execution", "R_lite", R_lite))
+        || !(s = json_dumps (R, JSON_COMPACT)))
+        die ("json_pack");
+    json_decref (R);
+    return s;
+}
+
+int main (int argc, char *argv[])
+{
+    int nranks = 16384;
+    int ncores = 36;
+    int iterations = 10;
+    struct rcalc_rankinfo ri;
+    struct timespec t0;
+    double elapsed;
+    char *R;
+    int i;
+
+    if (argc > 4) {
+        fprintf (stderr, "Usage: rcalc-bench [nranks] [ncores] [iterations]\n");
+        exit (1);
+    }
+    if (argc > 1)
+        nranks = strtoul (argv[1], NULL, 10);
+    if (argc > 2)
+        ncores = strtoul (argv[2], NULL, 10);
+    if (argc > 3)
+        iterations = strtoul (argv[3], NULL, 10);
+    if (nranks < 1 || ncores < 1 || iterations < 1) {
+        fprintf (stderr, "rcalc-bench: invalid argument\n");
+        exit (1);
+    }
+
+    R = create_R (nranks, ncores);
+
+    monotime (&t0);
+    for (i = 0; i < iterations; i++) {
+        rcalc_t *r;
+
+        if (!(r = rcalc_create (R)))
+            die ("rcalc_create");
+        if (rcalc_distribute (r, nranks * ncores) < 0)
+            die ("rcalc_distribute");
+        if (rcalc_get_rankinfo (r, nranks - 1, &ri) < 0)
+            die ("rcalc_get_rankinfo");
+        if (ri.nodeid != nranks - 1
+            || ri.ntasks != ncores
+            || ri.global_basis != (nranks - 1) * ncores
+            || CPU_COUNT (&ri.cpuset) != ncores) {
+            fprintf (stderr, "rcalc-bench: wrong rankinfo for rank %d\n",
+                     nranks - 1);
+            exit (1);
+        }
+        rcalc_destroy (r);
+    }
+    elapsed = monotime_since (t0) / 1000.;
+
+    printf ("%d ranks x %d cores: %.3fms per shell (%d iterations)\n",
+            nranks, ncores, elapsed * 1000. / iterations, iterations);
+    free (R);
+    exit (0);
+}
+
+/*
+ * vi:tabstop=4 shiftwidth=4 expandtab
+ */
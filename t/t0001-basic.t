@@ -342,6 +342,13 @@ test_expect_success 'passing NULL to flux_log functions logs to stderr (#1191)'
         grep "err: world: No such file or directory" std.err
 '
 
+test_expect_success 'rpcbench works over loop connector' '
+	${FLUX_BUILD_DIR}/t/loop/rpcbench 10000 >rpcbench.out &&
+	grep "^10000 RPCs (window=256)" rpcbench.out &&
+	${FLUX_BUILD_DIR}/t/loop/rpcbench 1000 1 >rpcbench1.out &&
+	grep "^1000 RPCs (window=1)" rpcbench1.out
+'
+
 reactorcat=${SHARNESS_TEST_DIRECTORY}/reactor/reactorcat
 test_expect_success 'reactor: reactorcat example program works' '
 	dd if=/dev/urandom bs=1024 count=4 >reactorcat.in &&
@@ -9,6 +9,7 @@ LASTRANK=$(($SIZE-1))
 test_under_flux ${SIZE} minimal
 
 RPC=${FLUX_BUILD_DIR}/t/request/rpc
+EVBENCH=${FLUX_BUILD_DIR}/t/event/evbench
 
 test_expect_success 'heartbeat is received on all ranks' '
 	run_timeout 5 \
@@ -83,4 +84,15 @@ test_expect_success 'event.pub request with empty payload fails with EPROTO(71)'
 	${RPC} event.pub 71 </dev/null
 '
 
+test_expect_success 'burst of published events is received on all ranks' '
+	run_timeout 30 flux exec -r all $EVBENCH -n ${SIZE} -c 1000 \
+		>evbench.out &&
+	test $(grep -c "^evbench.*count=1000" evbench.out) -eq ${SIZE}
+'
+
+test_expect_success 'no events were lost by bundling' '
+	flux dmesg | grep "lost event" >lost.out;
+	test_must_be_empty lost.out
+'
+
 test_done
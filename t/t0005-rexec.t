@@ -214,13 +214,68 @@ test_expect_success 'rexec line buffering works (set to true)' '
 '
 
 # test is technically racy, but with 2200 hi outputs, probability is
-# extremely low all data is buffered in one shot.
+# extremely low all data is buffered in one shot.  Output coalescing
+# is disabled so the server does not combine the writes.
 test_expect_success 'rexec line buffering can be disabled' '
-        ${FLUX_BUILD_DIR}/t/rexec/rexec_count_stdout -r 1 -l false ${TEST_SUBPROCESS_DIR}/test_multi_echo -O -c 2200 hi > linebuffer3.out &&
+        ${FLUX_BUILD_DIR}/t/rexec/rexec_count_stdout -r 1 -l false -c false ${TEST_SUBPROCESS_DIR}/test_multi_echo -O -c 2200 hi > linebuffer3.out &&
         count=$(grep "final stdout callback count:" linebuffer3.out | awk "{print \$5}") &&
         test "$count" -gt 2
 '
 
+test_expect_success 'rexec coalesced output is complete and in order' '
+        seq 1 100000 > seq.expected &&
+        ${FLUX_BUILD_DIR}/t/rexec/rexec -r 1 seq 1 100000 > seq.out &&
+        test_cmp seq.expected seq.out
+'
+
+test_expect_success 'rexec coalesced output without line buffering' '
+        ${FLUX_BUILD_DIR}/t/rexec/rexec_count_stdout -r 1 -l false seq 1 100000 > seq2.out &&
+        grep -v "final stdout callback count" seq2.out > seq2.trimmed &&
+        test_cmp seq.expected seq2.trimmed
+'
+
+test_expect_success 'rexec coalesced output keeps partial last line' '
+        ${FLUX_BUILD_DIR}/t/rexec/rexec -r 1 printf "a\nb\nc" > partial.out &&
+        printf "a\nb\nc" > partial.expected &&
+        test_cmp partial.expected partial.out
+'
+
+test_expect_success 'rexec coalesced output of long line' '
+        ${FLUX_BUILD_DIR}/t/rexec/rexec -r 1 ${TEST_SUBPROCESS_DIR}/test_multi_echo -O -c 100000 hi > longline.out &&
+        ${TEST_SUBPROCESS_DIR}/test_multi_echo -O -c 100000 hi > longline.expected &&
+        test_cmp longline.expected longline.out
+'
+
+# Stream a large amount of stdout with each reactor backend and report
+# throughput.  Set STREAM_MB to stream more data.  These tests only run
+# with the LONGTEST prereq set.
+STREAM_MB=${STREAM_MB:-64}
+stream_stdout() {
+	start=$(date +%s.%N) &&
+	"$@" dd if=/dev/zero bs=1048576 count=${STREAM_MB} 2>/dev/null \
+	    | wc -c >stream.out &&
+	end=$(date +%s.%N) &&
+	awk -v mb=${STREAM_MB} -v t0=$start -v t1=$end \
+	    "BEGIN { printf (\"%d MB in %.2fs: %.1f MB/s\n\", mb, t1-t0, mb/(t1-t0)) }" &&
+	test $(cat stream.out) -eq $((${STREAM_MB}*1048576))
+}
+for backend in epoll linuxaio; do
+	test_expect_success LONGTEST "rexec streams ${STREAM_MB}M of stdout (${backend})" "
+		(
+			export FLUX_REACTOR_BACKEND=${backend} &&
+			stream_stdout ${FLUX_BUILD_DIR}/t/rexec/rexec -r 1
+		)
+	"
+done
+test_expect_success LONGTEST "instance streams ${STREAM_MB}M of stdout (linuxaio)" '
+	(
+		export FLUX_REACTOR_BACKEND=linuxaio &&
+		stream_stdout flux start \
+		    -o,-Sbroker.rc1_path=,-Sbroker.rc3_path= \
+		    flux exec -r 0
+	)
+'
+
 # the last line of output is "bar" without a newline.  "EOF" is output
 # from "rexec_getline", so if everything is working correctly, we
 # should see the concatenation "barEOF" at the end of the output.
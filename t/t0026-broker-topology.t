@@ -0,0 +1,75 @@
+#!/bin/sh
+#
+
+test_description='Test broker TBON topologies'
+
+# Append --logfile option if FLUX_TESTS_LOGFILE is set in environment:
+test -n "$FLUX_TESTS_LOGFILE" && set -- "$@" --logfile
+. `dirname $0`/sharness.sh
+
+EVBENCH=${FLUX_BUILD_DIR}/t/event/evbench
+ARGS="-o,-Sbroker.rc1_path=,-Sbroker.rc3_path="
+
+test_expect_success 'default topology is kary:2' '
+	echo kary:2 >default.exp &&
+	flux start -s4 ${ARGS} flux getattr tbon.topo >default.out &&
+	test_cmp default.exp default.out
+'
+test_expect_success '--k-ary option selects kary:K topology' '
+	echo kary:3 >kary3.exp &&
+	flux start -s4 ${ARGS} -o,-k3 flux getattr tbon.topo >kary3.out &&
+	test_cmp kary3.exp kary3.out
+'
+test_expect_success 'tbon.topo=binomial sets expected level attributes' '
+	cat >binomial.exp <<-EOT &&
+	0: 0 3 7
+	1: 1 3 0
+	2: 1 3 1
+	3: 2 3 0
+	4: 1 3 3
+	5: 2 3 0
+	6: 2 3 1
+	7: 3 3 0
+	EOT
+	flux start -s8 ${ARGS} -o,-Stbon.topo=binomial \
+		flux exec -l -r all sh -c "echo \
+			\$(flux getattr tbon.level) \
+			\$(flux getattr tbon.maxlevel) \
+			\$(flux getattr tbon.descendants)" \
+		| sort -n >binomial.out &&
+	test_cmp binomial.exp binomial.out
+'
+test_expect_success 'tbon.topo=flat puts all ranks at level 1' '
+	flux start -s8 ${ARGS} -o,-Stbon.topo=flat \
+		flux exec -r all flux getattr tbon.level >flat.out &&
+	test $(grep -c "^1$" flat.out) -eq 7 &&
+	test $(grep -c "^0$" flat.out) -eq 1
+'
+test_expect_success 'requests are routed to every rank of a binomial tree' '
+	flux start -s8 ${ARGS} -o,-Stbon.topo=binomial \
+		flux exec -r all flux getattr rank >route.out &&
+	test $(wc -l <route.out) -eq 8
+'
+test_expect_success 'overlay.lspeer reports descendants of child peers' '
+	flux start -s8 ${ARGS} -o,-Stbon.topo=binomial \
+		flux python -c "import flux; print(flux.Flux().rpc(\"overlay.lspeer\").get())" >lspeer.out &&
+	grep descendants lspeer.out
+'
+test_expect_success 'invalid tbon.topo fails' '
+	test_must_fail flux start -s2 ${ARGS} -o,-Stbon.topo=foo /bin/true
+'
+
+# Event broadcast latency for each shape.
+# N.B. latency is reported for information only, not checked.
+for topo in kary:2 kary:8 binomial flat; do
+	test_expect_success "event broadcast latency with tbon.topo=$topo" '
+		flux start -s8 ${ARGS} -o,-Stbon.topo=$topo \
+			sh -c "flux exec -r all flux module load barrier && \
+			       flux exec -r all $EVBENCH -n 8 -c 100" \
+			>evbench.$topo.out &&
+		cat evbench.$topo.out &&
+		test $(grep -c "^evbench" evbench.$topo.out) -eq 8
+	'
+done
+
+test_done
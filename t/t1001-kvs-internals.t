@@ -486,6 +486,21 @@ test_expect_success 'kvs: clear stats globally' '
         flux exec -n sh -c "flux module stats --parse \"namespace.primary.#no-op stores\" kvs | grep -q 0"
 '
 
+test_expect_success 'kvs: repeated lookups hit lookup cache' '
+        flux kvs put $DIR.lookupcache=42 &&
+        flux module stats -c kvs &&
+        flux kvs get $DIR.lookupcache &&
+        flux kvs get $DIR.lookupcache &&
+        test $(flux module stats --parse "cache.#lookup cache hits" kvs) -ge 1
+'
+
+test_expect_success 'kvs: repeated lookups of missing key hit lookup cache' '
+        flux module stats -c kvs &&
+        test_must_fail flux kvs get $DIR.lookupcache-missing &&
+        test_must_fail flux kvs get $DIR.lookupcache-missing &&
+        test $(flux module stats --parse "cache.#lookup cache hits" kvs) -ge 1
+'
+
 #
 # test fence api
 #
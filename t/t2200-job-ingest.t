@@ -49,6 +49,18 @@ test_invalid ()
     return ${rc}
 }
 
+# submit job $2 $1 times, and report the rate
+submit_rate ()
+{
+    local count=$1
+    local t0=$(date +%s.%N)
+    ${SUBMITBENCH} ${SUBMITBENCH_OPT_R} -r ${count} $2 &&
+    local t1=$(date +%s.%N) &&
+    echo "${count} ${t0} ${t1}" \
+        | awk '{ printf "%d jobs in %.2fs: %.1f jobs/s\n", \
+                 $1, $3-$2, $1/($3-$2) }'
+}
+
 # load|reload ingest modules (in proper order) with specified arguments
 ingest_module ()
 {
@@ -82,6 +94,12 @@ test_expect_success 'job-ingest: job-ingest fails with bad validator path' '
 	test_must_fail flux module load job-ingest validator=/noexist
 '
 
+test_expect_success 'job-ingest: job-ingest fails with bad native validator args' '
+	test_must_fail flux module load job-ingest validator-args=--foo &&
+	test_must_fail flux module load job-ingest \
+		validator-args=--require-version,2
+'
+
 test_expect_success 'job-ingest: load job-ingest && job-info' '
 	ingest_module load \
 		validator=${BINDINGS_VALIDATOR} &&
@@ -158,6 +176,52 @@ test_expect_success 'job-ingest: submit job 100 times, reuse signature' '
 	${SUBMITBENCH} ${SUBMITBENCH_OPT_R} -r 100 use_case_2.6.json
 '
 
+test_expect_success 'job-ingest: submit-bulk creates count jobs per jobspec' '
+	flux python -c "import flux, flux.job, sys; \
+		js = [open(sys.argv[1]).read()] * 2; \
+		ids = flux.job.submit_bulk(flux.Flux(), js, count=50); \
+		print(len(ids))" basic.json >bulk.out &&
+	test "$(cat bulk.out)" = "100"
+'
+
+test_expect_success 'job-ingest: submit-bulk with an invalid jobspec fails' '
+	${Y2J} <${JOBSPEC}/invalid/missing_tasks.yaml >bulk_invalid.json &&
+	test_must_fail flux python -c "import flux, flux.job, sys; \
+		js = [open(f).read() for f in sys.argv[1:]]; \
+		flux.job.submit_bulk(flux.Flux(), js, count=2)" \
+		basic.json bulk_invalid.json 2>bulk_invalid.err &&
+	grep "jobs\[1\]" bulk_invalid.err
+'
+
+test_expect_success 'job-ingest: invalid bulk-max option is rejected' '
+	flux module remove job-ingest &&
+	test_must_fail flux module load job-ingest bulk-max=0 &&
+	test_must_fail flux module load job-ingest bulk-max=foo &&
+	flux module load job-ingest
+'
+
+test_expect_success 'job-ingest: submit-bulk over bulk-max fails with E2BIG' '
+	ingest_module reload bulk-max=10 &&
+	flux python -c "import flux, flux.job, sys; \
+		js = [open(sys.argv[1]).read()] * 2; \
+		ids = flux.job.submit_bulk(flux.Flux(), js, count=5); \
+		print(len(ids))" basic.json >bulk_max.out &&
+	test "$(cat bulk_max.out)" = "10" &&
+	test_must_fail flux python -c "import flux, flux.job, sys; \
+		js = [open(sys.argv[1]).read()] * 2; \
+		flux.job.submit_bulk(flux.Flux(), js, count=6)" \
+		basic.json 2>bulk_max.err &&
+	grep "exceeds maximum of 10" bulk_max.err
+'
+
+test_expect_success 'job-ingest: reload with default bulk-max' '
+	ingest_module reload
+'
+
+test_expect_success 'submit-bulk request with empty payload fails with EPROTO(71)' '
+	${RPC} job-ingest.submit-bulk 71 </dev/null
+'
+
 test_expect_success HAVE_FLUX_SECURITY 'job-ingest: submit user != signed user fails' '
 	! FLUX_HANDLE_USERID=9999 flux job submit basic.json 2>baduser.out &&
 	grep -q "signer=$(id -u) != requestor=9999" baduser.out
@@ -182,6 +246,10 @@ test_expect_success 'job-ingest: v1 jobspecs accepted with v1 requirement' '
 	test_valid ${JOBSPEC}/valid_v1/*
 '
 
+test_expect_success 'job-ingest: python validator uses protocol version 2' '
+	flux dmesg | grep "validate-jobspec.py: using protocol version 2"
+'
+
 test_expect_success 'job-ingest: test non-python validator' '
 	ingest_module reload \
 		validator=${FAKE_VALIDATOR}
@@ -191,6 +259,14 @@ test_expect_success 'job-ingest: submit succeeds with non-python validator' '
     flux job submit basic.json
 '
 
+test_expect_success 'job-ingest: non-python validator uses protocol version 1' '
+	flux dmesg | grep "fake-validate.sh: using protocol version 1"
+'
+
+test_expect_success 'job-ingest: submit burst of jobs with protocol version 1' '
+	${SUBMITBENCH} -r 500 use_case_2.6.json
+'
+
 test_expect_success 'job-ingest: test python jsonschema validator' '
 	ingest_module reload \
 		validator=${JSONSCHEMA_VALIDATOR} validator-args=--schema,${SCHEMA}
@@ -208,6 +284,48 @@ test_expect_success 'job-ingest: invalid jobs rejected by jsonschema validator'
 	test_invalid ${JOBSPEC}/invalid/*
 '
 
+test_expect_success 'job-ingest: submit burst of jobs with protocol version 2' '
+	${SUBMITBENCH} -r 500 use_case_2.6.json
+'
+
+test_expect_success 'job-ingest: reload with native validator' '
+	ingest_module reload
+'
+
+test_expect_success 'job-ingest: YAML jobspec is rejected by native validator' '
+	test_must_fail flux job submit ${JOBSPEC}/valid/basic.yaml
+'
+
+test_expect_success 'job-ingest: valid jobspecs accepted by native validator' '
+	test_valid ${JOBSPEC}/valid/*
+'
+
+test_expect_success 'job-ingest: invalid jobs rejected by native validator' '
+	test_invalid ${JOBSPEC}/invalid/*
+'
+
+test_expect_success 'job-ingest: native validator reports expected error' '
+	${Y2J} <${JOBSPEC}/invalid/missing_tasks.yaml >missing_tasks.json &&
+	test_must_fail flux job submit missing_tasks.json 2>native.err &&
+	grep "Missing key (tasks)" native.err
+'
+
+test_expect_success 'job-ingest: native validator with version 1 enforced' '
+	ingest_module reload validator-args="--require-version,1" &&
+	test_valid ${JOBSPEC}/valid_v1/* &&
+	test_must_fail flux job submit basic.json
+'
+
+test_expect_success LONGTEST 'job-ingest: submit 100000 jobs with native validator' '
+	ingest_module reload &&
+	submit_rate 100000 use_case_2.6.json
+'
+
+test_expect_success LONGTEST 'job-ingest: submit 100000 jobs with python validator' '
+	ingest_module reload validator=${BINDINGS_VALIDATOR} &&
+	submit_rate 100000 use_case_2.6.json
+'
+
 test_expect_success 'job-ingest: validator unexpected exit is handled' '
 	ingest_module reload \
 		validator=${BAD_VALIDATOR} &&
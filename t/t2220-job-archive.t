@@ -208,6 +208,19 @@ test_expect_success 'job-archive: all jobs stored' '
         test $count -eq 5
 '
 
+test_expect_success 'job-archive: db uses WAL journal mode' '
+        ${QUERYCMD} ${ARCHIVEDB} "PRAGMA journal_mode;" > journal.out &&
+        grep "journal_mode = wal" journal.out
+'
+
+test_expect_success 'job-archive: db has userid and t_inactive indexes' '
+        ${QUERYCMD} ${ARCHIVEDB} \
+            "select name from sqlite_master where type=\"index\";" \
+            > index.out &&
+        grep "name = idx_jobs_userid" index.out &&
+        grep "name = idx_jobs_t_inactive" index.out
+'
+
 test_expect_success 'job-archive: reload module' '
         flux module reload job-archive
 '
@@ -270,4 +283,21 @@ test_expect_success 'job-archive: both db exists after module unloaded' '
         test $count -eq 8
 '
 
+test_expect_success 'job-archive: load module with long period' '
+        flux module load job-archive dbpath=${ARCHIVEDB}-NEW period=1h
+'
+
+test_expect_success 'job-archive: job stored promptly after it becomes inactive' '
+        jobid=`flux mini submit hostname` &&
+        fj_wait_event $jobid clean &&
+        wait_jobid_state $jobid inactive &&
+        wait_db $jobid ${ARCHIVEDB}-NEW &&
+        db_check_entries $jobid ${ARCHIVEDB}-NEW &&
+        db_check_values_run $jobid ${ARCHIVEDB}-NEW
+'
+
+test_expect_success 'job-archive: unload module' '
+        flux module unload job-archive
+'
+
 test_done
@@ -0,0 +1,115 @@
+#!/bin/sh
+
+test_description='Test hierarchical launch of job shells by job-exec'
+
+. $(dirname $0)/sharness.sh
+
+skip_all_unless_have jq
+
+#  Configure dummy job shell and tree launch with fanout 1, so that
+#   shells are launched in a chain, the deepest possible tree.
+if ! test -f tree.toml; then
+	cat <<-EOF >tree.toml
+	[exec]
+	job-shell = "$SHARNESS_TEST_SRCDIR/job-exec/dummy.sh"
+	tree-fanout = 1
+	EOF
+fi
+
+export FLUX_CONF_DIR=$(pwd)
+BULK_EXEC=${FLUX_BUILD_DIR}/src/modules/job-exec/bulk-exec
+test_under_flux 4 job
+
+flux setattr log-stderr-level 1
+
+test_expect_success 'job-exec: module is loaded on all ranks' '
+	flux exec -r all flux module list > modules.out &&
+	test $(grep -c job-exec modules.out) -eq 4
+'
+test_expect_success 'job-exec: tree launch runs shell on all ranks' '
+	id=$(flux jobspec srun -N4 \
+	    "flux kvs put test1.\$BROKER_RANK=\$JOB_SHELL_RANK" \
+	    | flux job submit) &&
+	flux job wait-event $id clean &&
+	kvsdir=$(flux job id --to=kvs $id).guest &&
+	test $(flux kvs get ${kvsdir}.test1.0) = 0 &&
+	test $(flux kvs get ${kvsdir}.test1.1) = 1 &&
+	test $(flux kvs get ${kvsdir}.test1.2) = 2 &&
+	test $(flux kvs get ${kvsdir}.test1.3) = 3
+'
+test_expect_success 'job-exec: tree launch forwards output to rank 0' '
+	id=$(flux jobspec srun -N4 "echo tree output from \$BROKER_RANK" \
+	     | flux job submit) &&
+	flux job wait-event $id clean &&
+	flux dmesg | grep "tree output from 3"
+'
+test_expect_success 'job-exec: tree launch reports maximum exit code' '
+	id=$(flux jobspec srun -N4 "exit \$JOB_SHELL_RANK" | flux job submit) &&
+	flux job wait-event -vt 10 $id finish | grep status=768
+'
+test_expect_success 'job-exec: tree launch: invalid job shell is an exception' '
+	id=$(flux jobspec srun -N4 /bin/true \
+	     | $jq ".attributes.system.exec.job_shell = \"/notthere\"" \
+	     | flux job submit) &&
+	flux job wait-event -vt 10 $id exception &&
+	flux job wait-event -vt 10 $id clean
+'
+test_expect_success 'job-exec: tree launch: job exception kills shells' '
+	id=$(flux jobspec srun -N4 sleep 300 | flux job submit) &&
+	flux job wait-event -vt 5 $id start &&
+	flux job cancel $id &&
+	flux job wait-event -vt 5 $id clean &&
+	flux job eventlog $id | grep status=15
+'
+test_expect_success 'job-exec: tree launch works with tree-fanout=2' '
+	flux module reload job-exec tree-fanout=2 &&
+	id=$(flux jobspec srun -N3 "exit \$JOB_SHELL_RANK" | flux job submit) &&
+	flux job wait-event -vt 10 $id finish | grep status=512
+'
+test_expect_success 'job-exec: invalid tree-fanout is rejected' '
+	test_expect_code 1 flux module reload job-exec tree-fanout=-1 &&
+	flux module load job-exec
+'
+test_expect_success 'job-exec: tree launch forwards output text of each rank' '
+	${BULK_EXEC} --tree-fanout=1 -r 1-3 echo tree-output >output.out &&
+	test_debug "cat output.out" &&
+	grep "^1: tree-output$" output.out &&
+	grep "^2: tree-output$" output.out &&
+	grep "^3: tree-output$" output.out
+'
+test_expect_success 'job-exec: tree launch forwards errno of a failed rank' '
+	test_might_fail ${BULK_EXEC} --tree-fanout=1 -r 3 /nonexistent/cmd \
+		2>error.err &&
+	test_debug "cat error.err" &&
+	grep "3: No such file or directory" error.err
+'
+test_expect_success 'job-exec: create tree launch test command' '
+	cat <<-EOF >sleeper.sh &&
+	#!/bin/sh
+	exec sleep 3217
+	EOF
+	chmod +x sleeper.sh
+'
+test_expect_success NO_CHAIN_LINT 'job-exec: tree launch is killed when requestor disconnects' '
+	${BULK_EXEC} --tree-fanout=1 -r 1-3 $(pwd)/sleeper.sh &
+	pid=$! &&
+	count=0 &&
+	while test $(pgrep -fc "sleep 3217") -lt 3; do
+	    count=$((count+1)) &&
+	    test $count -lt 100 || return 1
+	    sleep 0.1
+	done &&
+	kill -9 $pid &&
+	count=0 &&
+	while pgrep -f "sleep 3217" >/dev/null; do
+	    count=$((count+1)) &&
+	    test $count -lt 100 || return 1
+	    sleep 0.1
+	done
+'
+test_expect_success 'job-exec: start latency benchmark runs' '
+	$SHARNESS_TEST_SRCDIR/job-exec/start-latency.sh -c 1 1 4 >bench.out &&
+	test_debug "cat bench.out" &&
+	test $(grep -c "^tree:2 " bench.out) -eq 2
+'
+test_done
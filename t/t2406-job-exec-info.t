@@ -0,0 +1,56 @@
+#!/bin/sh
+
+test_description='Test job-exec.info service for job shells'
+
+. $(dirname $0)/sharness.sh
+
+skip_all_unless_have jq
+
+test_under_flux 4 job
+
+flux setattr log-stderr-level 1
+
+INFO="flux python ${SHARNESS_TEST_SRCDIR}/job-exec/info.py"
+
+test_expect_success 'job-exec.info: start a job on all ranks' '
+	id=$(flux mini submit -N4 sleep 300) &&
+	flux job wait-event -vt 10 $id start
+'
+test_expect_success 'job-exec.info: rank 0 returns jobspec and R' '
+	$INFO $id >info.0 &&
+	test $($jq -r .id <info.0) = $(flux job id $id) &&
+	test $($jq -r .userid <info.0) = $(id -u) &&
+	$jq -r .jobspec <info.0 | $jq -e .tasks &&
+	$jq -r .R <info.0 | $jq -e .execution
+'
+test_expect_success 'job-exec.info: other ranks return the same data' '
+	for rank in 1 2 3; do
+		flux exec -n -r $rank $INFO $id >info.$rank &&
+		test_cmp info.0 info.$rank || return 1
+	done
+'
+test_expect_success 'job-exec.info: cancel job' '
+	flux job cancel $id &&
+	flux job wait-event -vt 10 $id clean
+'
+test_expect_success 'job-exec.info: unknown job fails on rank 0' '
+	test_must_fail $INFO 1234
+'
+test_expect_success 'job-exec.info: unknown job fails on rank 3' '
+	test_must_fail flux exec -n -r 3 $INFO 1234
+'
+test_expect_success 'job-exec.info: other users are denied' '
+	id=$(flux mini submit -N4 sleep 300) &&
+	flux job wait-event -vt 10 $id start &&
+	flux exec -n -r 3 $INFO $id &&
+	test_must_fail flux exec -n -r 3 sh -c "FLUX_HANDLE_USERID=9999 \
+	    FLUX_HANDLE_ROLEMASK=0x2 $INFO $id" &&
+	test_must_fail sh -c "FLUX_HANDLE_USERID=9999 \
+	    FLUX_HANDLE_ROLEMASK=0x2 $INFO $id" &&
+	flux job cancel $id
+'
+test_expect_success 'job-exec.info: jobs still run after job-exec reload' '
+	flux module reload job-exec &&
+	flux mini run -N4 /bin/true
+'
+test_done
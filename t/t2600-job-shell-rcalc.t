@@ -8,6 +8,7 @@ test_description='Test shell resource calculator (rcalc) functionality'
 INPUTDIR=$SHARNESS_TEST_SRCDIR/shell/input
 OUTPUTDIR=$SHARNESS_TEST_SRCDIR/shell/output
 rcalc=${SHARNESS_TEST_DIRECTORY}/shell/rcalc
+rcalc_bench=${SHARNESS_TEST_DIRECTORY}/shell/rcalc-bench
 
 test_expect_success 'rcalc test utility is built' '
     test -x ${rcalc}
@@ -43,4 +44,9 @@ for file in ${OUTPUTDIR}/per-resource/*.expected; do
     '
 done
 
+test_expect_success 'rcalc finds last rank of a 16k rank R' '
+    ${rcalc_bench} 16384 36 1 >bench.out &&
+    grep "^16384 ranks x 36 cores" bench.out
+'
+
 test_done
@@ -202,4 +202,16 @@ test_expect_success 'job-shell: shell kill event: kill(2) failure logged' '
 	grep "signal 199: Invalid argument" kill5.log &&
 	grep status=$((15+128<<8)) kill5.finish.out
 '
+test_expect_success 'job-shell: task command is searched for in job PATH' '
+	mkdir -p jobpath &&
+	cat >jobpath/jobpath-only-cmd <<-EOT &&
+	#!/bin/sh
+	echo found in job PATH
+	EOT
+	chmod +x jobpath/jobpath-only-cmd &&
+	test_must_fail which jobpath-only-cmd &&
+	flux mini run --env=PATH=$(pwd)/jobpath:$PATH jobpath-only-cmd \
+		>jobpath.out &&
+	grep "found in job PATH" jobpath.out
+'
 test_done
@@ -61,6 +61,25 @@ test_expect_success 'flux-shell: invalid option is ignored' '
     test_debug "cat invalid.out" &&
     grep "invalid option" invalid.out
 '
+test_expect_success 'resource.topo-get returns local topology XML' '
+    flux python -c "import flux; \
+        print(flux.Flux().rpc(\"resource.topo-get\").get()[\"xml\"])" \
+        >topo.xml &&
+    grep "<topology" topo.xml
+'
+test_expect_success 'resource.topo-get works on rank 1' '
+    flux exec -r 1 flux python -c "import flux; \
+        print(flux.Flux().rpc(\"resource.topo-get\").get()[\"xml\"])" \
+        >topo1.xml &&
+    grep "<topology" topo1.xml
+'
+test_expect_success 'flux-shell: affinity uses cached topology' '
+    flux mini run -o verbose=2 -n1 -c1 $CPUS_ALLOWED_COUNT \
+        >cached.out 2>cached.err &&
+    test_debug "cat cached.err" &&
+    test "$(cat cached.out)" = "1" &&
+    ! grep "no cached topology" cached.err
+'
 test_expect_success 'flux-shell: CUDA_VISIBLE_DEVICES=-1 set by default' '
     flux mini run printenv CUDA_VISIBLE_DEVICES >default-gpubind.out 2>&1 &&
     test_debug "cat default-gpubind.out" &&
@@ -325,4 +325,75 @@ test_expect_success NO_CHAIN_LINT 'job-shell: job attach waits if no kvs output
         flux job cancel $id &&
         ! wait $pid
 '
+
+#
+# output tree tests
+#
+
+test_expect_success 'job-shell: output of all shells arrives with output.fanout=1' '
+        flux mini run -N4 -n8 --label-io -o output.fanout=1 \
+             ${TEST_SUBPROCESS_DIR}/test_echo -P -O -E baz >out29 2>err29 &&
+        test $(grep -c stdout:baz out29) -eq 8 &&
+        test $(grep -c stderr:baz err29) -eq 8
+'
+
+test_expect_success 'job-shell: file output of all shells with output.fanout=2' '
+        flux mini run -N4 -n8 --output=out30 -o output.fanout=2 \
+             ${TEST_SUBPROCESS_DIR}/test_echo -P -O baz &&
+        test $(grep -c stdout:baz out30) -eq 8
+'
+
+test_expect_success 'job-shell: chatty tasks keep per-task order through tree' '
+        flux mini run -N4 -n4 --label-io -o output.fanout=1 \
+             seq 1 20000 >out31 &&
+        test $(wc -l <out31) -eq 80000 &&
+        for rank in 0 1 2 3; do
+                grep "^$rank: " out31 | cut -d" " -f2 >seq31.$rank &&
+                seq 1 20000 | test_cmp - seq31.$rank || return 1
+        done
+'
+
+test_expect_success 'job-shell: invalid output.fanout is an error' '
+        test_must_fail flux mini run -o output.fanout=0 hostname
+'
+
+#
+# per-node output files
+#
+
+test_expect_success 'job-shell: {{node.id}} writes one output file per shell' '
+        flux mini run -N4 -n8 --output=out32.{{node.id}} \
+             ${TEST_SUBPROCESS_DIR}/test_echo -P -O -E baz &&
+        for node in 0 1 2 3; do
+                test $(grep -c stdout:baz out32.$node) -eq 2 &&
+                test $(grep -c stderr:baz out32.$node) -eq 2 || return 1
+        done
+'
+
+test_expect_success 'job-shell: per-node output files are labeled by task rank' '
+        flux mini run -N2 -n4 --label-io --output=out33.{{node.id}} \
+             ${TEST_SUBPROCESS_DIR}/test_echo -P -O baz &&
+        grep "^0: stdout:baz" out33.0 &&
+        grep "^1: stdout:baz" out33.0 &&
+        grep "^2: stdout:baz" out33.1 &&
+        grep "^3: stdout:baz" out33.1
+'
+
+test_expect_success 'job-shell: per-node stdout with stderr to the KVS' '
+        flux mini run -N2 -n2 --output=out34.{{node.id}} \
+             -o output.stderr.type=kvs \
+             ${TEST_SUBPROCESS_DIR}/test_echo -P -O -E baz 2>err34 &&
+        grep stdout:baz out34.0 &&
+        grep stdout:baz out34.1 &&
+        test $(grep -c stderr:baz err34) -eq 2
+'
+
+test_expect_success 'job-shell: redirect events list each per-node file' '
+        id=$(flux mini submit -N2 -n4 --output=out35.{{node.id}} \
+             ${TEST_SUBPROCESS_DIR}/test_echo -P -O baz) &&
+        flux job wait-event $id clean &&
+        flux job eventlog -p guest.output $id > eventlog35.out &&
+        grep redirect eventlog35.out | grep "0-1" | grep out35.0 &&
+        grep redirect eventlog35.out | grep "2-3" | grep out35.1
+'
 test_done
@@ -202,6 +202,66 @@ test_expect_success 'flux-shell: task stdin via file, try to pipe into stdin fai
         flux job cancel $id
 '
 
+#
+# input tree tests
+#
+
+test_expect_success 'flux-shell: input file is broadcast to all nodes' '
+        flux mini run -N4 -n8 --input=input_stdin_file --label-io \
+             ${TEST_SUBPROCESS_DIR}/test_echo -O -n > tree1.out &&
+        for i in $(seq 0 7); do
+            grep "^$i: foo" tree1.out &&
+            grep "^$i: doh" tree1.out || return 1
+        done
+'
+
+test_expect_success 'flux-shell: input file is relayed through a chain of shells' '
+        flux mini run -N4 -n4 -o input.fanout=1 \
+             --input=input_stdin_file --label-io \
+             ${TEST_SUBPROCESS_DIR}/test_echo -O -n > tree2.out &&
+        test $(grep -c foo tree2.out) -eq 4 &&
+        test $(grep -c doh tree2.out) -eq 4
+'
+
+test_expect_success 'flux-shell: piped stdin is broadcast to all nodes' '
+        id=$(flux mini submit -N4 -n4 -o input.fanout=2 \
+             ${TEST_SUBPROCESS_DIR}/test_echo -O -n) &&
+        flux job attach -l $id < input_stdin_file > tree3.out &&
+        test $(grep -c foo tree3.out) -eq 4 &&
+        test $(grep -c doh tree3.out) -eq 4
+'
+
+test_expect_success 'flux-shell: large input file reaches every task' '
+        ${LPTEST} 79 2000 > tree_input &&
+        flux mini run -N4 -n8 --input=tree_input \
+             ${TEST_SUBPROCESS_DIR}/test_echo -O -n > tree4.out &&
+        test $(wc -l < tree4.out) -eq 16000
+'
+
+test_expect_success 'flux-shell: input.kvs=false skips guest.input' '
+        id=$(flux mini submit -n2 -o input.kvs=false \
+             --input=input_stdin_file \
+             ${TEST_SUBPROCESS_DIR}/test_echo -O -n) &&
+        flux job attach $id > tree5.out &&
+        test $(grep -c foo tree5.out) -eq 2 &&
+        test_must_fail flux job eventlog -p guest.input $id
+'
+
+test_expect_success 'flux-shell: leader exits after a non-leader shell dies' '
+	name="shellkill" &&
+	cat <<-EOF >${name}.sh &&
+	#!/bin/sh
+	if test \$FLUX_TASK_RANK -eq 1; then kill -9 \$PPID; fi
+	EOF
+	chmod +x ${name}.sh &&
+	id=$(flux mini submit -N2 -n2 ./${name}.sh) &&
+	flux job wait-event -t 30 ${id} clean
+'
+
+test_expect_success 'flux-shell: invalid input.fanout is an error' '
+        test_must_fail flux mini run -n1 -o input.fanout=0 echo foo
+'
+
 #
 # corner case tests
 #
@@ -39,4 +39,39 @@ test_expect_success 'flux-shell: plugin can add event context' '
 		-m event-test=foo ${id} shell.init
 
 '
+shell_stats() {
+	flux python -c "import flux, os, sys; \
+		from flux.job import JobID; \
+		topic = \"{}-shell-{}.stats\".format(os.getuid(), \
+			int(JobID(sys.argv[1]))); \
+		print(flux.Flux().rpc(topic, nodeid=0).get_str())" $1
+}
+test_expect_success HAVE_JQ 'flux-shell: stats service reports eventlog commits' '
+	id=$(flux mini submit -n1 -N1 sleep 30) &&
+	flux job wait-event -vt 5 -p guest.exec.eventlog \
+		-m leader-rank=0 ${id} shell.start &&
+	shell_stats ${id} >stats.out &&
+	test_debug "cat stats.out" &&
+	jq -e ".rank == 0" <stats.out &&
+	jq -e ".eventlogger.appends > 0" <stats.out &&
+	jq -e ".eventlogger.commits > 0" <stats.out &&
+	jq -e ".eventlogger.errors == 0" <stats.out &&
+	flux job cancel ${id}
+'
+test_expect_success HAVE_JQ 'flux-shell: init eventlog appends share a commit' '
+	id=$(flux mini submit -n1 -N1 sleep 30) &&
+	flux job wait-event -vt 5 -p guest.exec.eventlog ${id} shell.start &&
+	shell_stats ${id} >stats2.out &&
+	test_debug "cat stats2.out" &&
+	jq -e ".eventlogger.commits < .eventlogger.appends" <stats2.out &&
+	flux job cancel ${id}
+'
+test_expect_success 'flux-shell: output and input eventlogs are complete' '
+	echo foo >input.txt &&
+	id=$(flux mini submit --input=input.txt -n2 cat) &&
+	flux job attach ${id} >cat.out &&
+	test $(grep -c foo cat.out) -eq 2 &&
+	flux job eventlog -p guest.input ${id} | grep header &&
+	flux job eventlog -p guest.output ${id} | grep header
+'
 test_done